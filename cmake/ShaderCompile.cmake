@@ -120,7 +120,28 @@ function(HLSL_TO_SPIRV INPUT_HLSL SHADER_STAGE ENTRY_POINT OUTPUT_BINARY)
     )
 endfunction()
 
+# compile HLSL shader to SPIR-V with preprocessor defines, the variant name is appended to the output file name
+function(HLSL_TO_SPIRV_VARIANT INPUT_HLSL VARIANT SHADER_STAGE ENTRY_POINT DEFINES OUTPUT_BINARY)
+    DIRECTX_SHADER_STAGE(${SHADER_STAGE} DIRECTX_STAGE)
+    OPENGL_SHADER_STAGE(${SHADER_STAGE} OPENGL_STAGE)
+    SHADER_OUTPUT_DIR(${INPUT_HLSL} OUTPUT_DIR)
+    get_filename_component(INPUT_FILE_NAME ${INPUT_HLSL} NAME_WE)
+    set(OUTPUT_SPIRV ${OUTPUT_DIR}/${INPUT_FILE_NAME}_${VARIANT}.${OPENGL_STAGE}.spv)
+    set(${OUTPUT_BINARY} ${OUTPUT_SPIRV} PARENT_SCOPE)
 
+    set(DEFINE_ARGS "")
+    foreach (DEFINE ${DEFINES})
+        list(APPEND DEFINE_ARGS -D ${DEFINE})
+    endforeach ()
+
+    add_custom_command(
+        OUTPUT ${OUTPUT_SPIRV}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+        COMMAND ${VULKAN_DXC_EXECUTABLE} -spirv -T ${DIRECTX_STAGE}_6_0 -E ${ENTRY_POINT} -Fo ${OUTPUT_SPIRV} ${INPUT_HLSL} -DENABLE_SPIRV_CODEGEN=ON ${DEFINE_ARGS}
+        WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
+        DEPENDS ${INPUT_HLSL}
+    )
+endfunction()
 
 # shader compilation with automatic source&binary type detection
 function(compile_shader INPUT_FILE GRAPHICS_API SHADER_STAGE ENTRY_POINT)
@@ -137,6 +158,21 @@ function(compile_shader INPUT_FILE GRAPHICS_API SHADER_STAGE ENTRY_POINT)
     set(SHADER_BINARY_OUTPUT ${SHADER_BINARY_OUTPUT} PARENT_SCOPE)
 endfunction()
 
+# same as compile_shader, for one variant of the shader. DEFINES is a list, the binary is named after the variant.
+function(compile_shader_variant INPUT_FILE VARIANT DEFINES GRAPHICS_API SHADER_STAGE ENTRY_POINT)
+    SHADER_BINARY_TYPE(${GRAPHICS_API} BINARY_TYPE)
+    SHADER_SOURCE_TYPE(${INPUT_FILE} SOURCE_TYPE)
+
+    if (${SOURCE_TYPE} STREQUAL "hlsl" AND ${BINARY_TYPE} STREQUAL "spirv")
+        HLSL_TO_SPIRV_VARIANT(${INPUT_FILE} ${VARIANT} ${SHADER_STAGE} ${ENTRY_POINT} "${DEFINES}" SHADER_BINARY)
+    else()
+        message(FATAL_ERROR "Unsupported shader source type: ${SOURCE_TYPE} and binary type: ${BINARY_TYPE}")
+    endif()
+
+    list(APPEND SHADER_BINARY_OUTPUT ${SHADER_BINARY})
+    set(SHADER_BINARY_OUTPUT ${SHADER_BINARY_OUTPUT} PARENT_SCOPE)
+endfunction()
+
 # add shader dependencies to specified target
 function(add_shader_dependencies PROJECT_TARGET)
     if (NOT SHADER_BINARY_OUTPUT)
@@ -303,11 +303,14 @@ void SampleApp::Initialize()
         lightTransform->RotateAroundAxis(gore::Vector3::Right, gore::math::constants::PI_4);
     }
 
+    // the three files are parsed in parallel on the job system
+    std::vector<gore::gfx::MeshLoadRequest> meshLoadRequests;
+
     {
         gore::GameObject* gameObject = scene->NewObject();
         gameObject->SetName("cube");
         gore::gfx::MeshRenderer* meshRenderer = gameObject->AddComponent<MeshRenderer>();
-        meshRenderer->LoadMesh("cube.gltf");
+        meshLoadRequests.push_back({.name = "cube.gltf", .meshRenderer = meshRenderer});
         meshRenderer->SetMaterial(forwardMat);
         // meshRenderer->SetDynamicBuffer(m_UnifiedDynamicBufferHandle);
         // meshRenderer->SetDynamicBufferOffset(0);
@@ -320,7 +323,7 @@ void SampleApp::Initialize()
         gore::GameObject* gameObject = scene->NewObject();
         gameObject->SetName("teapot");
         gore::gfx::MeshRenderer* meshRenderer = gameObject->AddComponent<MeshRenderer>();
-        meshRenderer->LoadMesh("teapot.gltf");
+        meshLoadRequests.push_back({.name = "teapot.gltf", .meshRenderer = meshRenderer});
     }
 
     {
@@ -328,11 +331,14 @@ void SampleApp::Initialize()
         gameObject->SetName("rock");
 
         gore::gfx::MeshRenderer* meshRenderer = gameObject->AddComponent<MeshRenderer>();
-        meshRenderer->LoadMesh("rock.gltf");
+        meshLoadRequests.push_back({.name = "rock.gltf", .meshRenderer = meshRenderer});
 
         gore::Transform* transform = gameObject->GetTransform();
         transform->SetLocalPosition(gore::Vector3::Left * 10.0f);
     }
+
+    renderContext.LoadMeshesToMeshRenderers(meshLoadRequests);
+
     // gore::GameObject* gameObject = scene->NewObject();
     // gameObject->SetName("TestObject O, T&R&S");
 
@@ -7,9 +7,11 @@
 #include <algorithm>
 
 #include "Core/Time.h"
+#include "Core/JobSystem.h"
 #include "Rendering/RenderSystem.h"
 #include "Windowing/Window.h"
 #include "Scene/Scene.h"
+#include "Object/TransformHierarchy.h"
 #include "Input/GLFW/GLFWInputSystem.h"
 
 #include "Profiler/microprofile.h"
@@ -17,6 +19,7 @@
 MICROPROFILE_DEFINE(g_PlayerLoop, "Loop", "PlayerLoop", MP_AUTO);
 MICROPROFILE_DEFINE(g_AppUpdate, "Loop", "AppUpdate", MP_AUTO);
 MICROPROFILE_DEFINE(g_SceneUpdate, "Loop", "SceneUpdate", MP_AUTO);
+MICROPROFILE_DEFINE(g_TransformUpdate, "Loop", "TransformUpdate", MP_AUTO);
 MICROPROFILE_DEFINE(g_RenderSystemUpdate, "Loop", "RenderSystemUpdate", MP_AUTO);
 MICROPROFILE_DEFINE(g_AppInitialize, "System", "AppInitialize", MP_AUTO);
 
@@ -31,6 +34,7 @@ App::App(int argc, char** argv) :
     m_TimeSystem(nullptr),
     m_InputSystem(nullptr),
     m_RenderSystem(nullptr),
+    m_JobSystem(nullptr),
     m_Window(nullptr)
 {
     g_App = this;
@@ -61,6 +65,8 @@ int App::Run(int width, int height, const char* title)
     {   
         MICROPROFILE_SCOPE(g_AppInitialize);
         glfwInit();
+
+        m_JobSystem = new JobSystem(JobSystem::GetDefaultWorkerCount());
         
         m_Window = new Window(this, width, height);
         m_Window->SetTitle(title);
@@ -69,7 +75,14 @@ int App::Run(int width, int height, const char* title)
         m_InputSystem = new GLFWInputSystem(this);
         m_InputSystem->Initialize();
         
-        m_RenderSystem = new RenderSystem(this);
+        // which InstanceDataStoragePolicy is used can be picked on the command line to compare them
+        RenderSystemCreateInfo renderSystemCreateInfo = {};
+        if (HasArg("pushConstantInstanceData"))
+            renderSystemCreateInfo.instanceDataStoragePolicy = InstanceDataStoragePolicy::PerDrawPushConstant;
+        else if (HasArg("structuredBufferInstanceData"))
+            renderSystemCreateInfo.instanceDataStoragePolicy = InstanceDataStoragePolicy::PersistentStructuredBuffer;
+
+        m_RenderSystem = new RenderSystem(this, renderSystemCreateInfo);
         m_RenderSystem->Initialize();
         
         Initialize();
@@ -98,6 +111,11 @@ int App::Run(int width, int height, const char* title)
             scene->Update();
         }
 
+        {
+            MICROPROFILE_SCOPE(g_TransformUpdate);
+            TransformHierarchy::Get().UpdateWorldTransforms(*m_JobSystem);
+        }
+
         {
             MICROPROFILE_SCOPE(g_RenderSystemUpdate);
             m_RenderSystem->Update();
@@ -118,6 +136,7 @@ int App::Run(int width, int height, const char* title)
     delete m_TimeSystem;
     delete m_RenderSystem;
     delete m_InputSystem;
+    delete m_JobSystem;
 
     delete m_Window;
 
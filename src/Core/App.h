@@ -16,6 +16,7 @@ class Window;
 class Time;
 class InputSystem;
 class RenderSystem;
+class JobSystem;
 
 ENGINE_CLASS(App)
 {
@@ -55,6 +56,7 @@ protected:
     Time* m_TimeSystem;
     InputSystem* m_InputSystem;
     RenderSystem* m_RenderSystem;
+    JobSystem* m_JobSystem;
 
 private:
     Window* m_Window;
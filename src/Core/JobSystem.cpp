@@ -0,0 +1,253 @@
+#include "Prefix.h"
+
+#include "JobSystem.h"
+
+#include "Profiler/microprofile.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+MICROPROFILE_DEFINE(g_JobSystemWait, "JobSystem", "Wait", MP_AUTO);
+
+namespace gore
+{
+
+SINGLETON_IMPL(JobSystem)
+
+// which JobSystem queue the current thread owns, threads unknown to the JobSystem share queue 0
+static thread_local const JobSystem* t_JobSystem = nullptr;
+static thread_local uint32_t t_QueueIndex        = 0;
+
+JobSystem::JobSystem(uint32_t workerCount) :
+    m_Workers(),
+    m_Queues(),
+    m_QueuedJobs(0),
+    m_Quit(false),
+    m_SleepMutex(),
+    m_WakeCondition()
+{
+    g_Instance = this;
+
+    t_JobSystem  = this;
+    t_QueueIndex = 0;
+
+    for (uint32_t i = 0; i < workerCount + 1; ++i)
+    {
+        m_Queues.push_back(std::make_unique<JobQueue>());
+    }
+
+    m_Workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        m_Workers.emplace_back(&JobSystem::WorkerMain, this, i + 1);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(m_SleepMutex);
+        m_Quit.store(true);
+    }
+    m_WakeCondition.notify_all();
+
+    for (auto& worker : m_Workers)
+    {
+        worker.join();
+    }
+
+    assert(m_QueuedJobs.load() == 0 && "JobSystem destroyed with jobs still queued");
+
+    if (t_JobSystem == this)
+        t_JobSystem = nullptr;
+
+    g_Instance = nullptr;
+}
+
+uint32_t JobSystem::GetDefaultWorkerCount()
+{
+    // the main thread also runs jobs while it waits
+    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+uint32_t JobSystem::GetCurrentQueueIndex() const
+{
+    return t_JobSystem == this ? t_QueueIndex : 0;
+}
+
+void JobSystem::Schedule(JobFunc func, JobCounter* counter /* = nullptr */)
+{
+    if (counter != nullptr)
+        counter->m_Value.fetch_add(1, std::memory_order_relaxed);
+
+    Push(Job{std::move(func), counter});
+}
+
+void JobSystem::ScheduleAfter(JobCounter& dependency, JobFunc func, JobCounter* counter /* = nullptr */)
+{
+    if (counter != nullptr)
+        counter->m_Value.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        // Execute takes the same lock before it releases the continuations, so checking the value here is race free
+        std::lock_guard lock(dependency.m_ContinuationMutex);
+        if (!dependency.IsDone())
+        {
+            dependency.m_Continuations.push_back(JobCounter::Continuation{std::move(func), counter});
+            return;
+        }
+    }
+
+    Push(Job{std::move(func), counter});
+}
+
+void JobSystem::Push(Job&& job)
+{
+    JobQueue& queue = *m_Queues[GetCurrentQueueIndex()];
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+
+    m_QueuedJobs.fetch_add(1, std::memory_order_release);
+
+    // take the sleep mutex so a worker can not miss the wake up between its check and its wait
+    {
+        std::lock_guard lock(m_SleepMutex);
+    }
+    m_WakeCondition.notify_one();
+}
+
+bool JobSystem::TryPop(uint32_t queueIndex, Job& job)
+{
+    JobQueue& queue = *m_Queues[queueIndex];
+    std::lock_guard lock(queue.mutex);
+    if (queue.jobs.empty())
+        return false;
+
+    // LIFO on the own queue keeps the data of the job we just pushed hot in cache
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobSystem::TrySteal(uint32_t thiefIndex, Job& job)
+{
+    const auto queueCount = static_cast<uint32_t>(m_Queues.size());
+    for (uint32_t i = 1; i < queueCount; ++i)
+    {
+        JobQueue& queue = *m_Queues[(thiefIndex + i) % queueCount];
+        std::lock_guard lock(queue.mutex);
+        if (queue.jobs.empty())
+            continue;
+
+        // steal the oldest job, which tends to be the biggest piece of work left
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::TryRunOneJob()
+{
+    uint32_t queueIndex = GetCurrentQueueIndex();
+
+    Job job;
+    if (!TryPop(queueIndex, job) && !TrySteal(queueIndex, job))
+        return false;
+
+    Execute(job);
+    return true;
+}
+
+void JobSystem::Execute(Job& job)
+{
+    job.func();
+
+    JobCounter* counter = job.counter;
+    if (counter == nullptr)
+        return;
+
+    std::vector<JobCounter::Continuation> continuations;
+    {
+        std::lock_guard lock(counter->m_ContinuationMutex);
+        if (counter->m_Value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            continuations.swap(counter->m_Continuations);
+    }
+
+    for (auto& continuation : continuations)
+    {
+        Push(Job{std::move(continuation.func), continuation.counter});
+    }
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+    MICROPROFILE_SCOPE(g_JobSystemWait);
+
+    while (!counter.IsDone())
+    {
+        if (!TryRunOneJob())
+            std::this_thread::yield();
+    }
+
+    // the job that did the last decrement might still hold the lock
+    std::lock_guard lock(counter.m_ContinuationMutex);
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t chunkSize, const RangeFunc& func)
+{
+    if (count == 0)
+        return;
+
+    chunkSize           = std::max(chunkSize, 1u);
+    uint32_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+    // not worth going through the queues
+    if (chunkCount == 1 || m_Workers.empty())
+    {
+        func(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        uint32_t begin = chunk * chunkSize;
+        uint32_t end   = std::min(begin + chunkSize, count);
+        Schedule([&func, begin, end]() { func(begin, end); }, &counter);
+    }
+
+    Wait(counter);
+}
+
+void JobSystem::WorkerMain(uint32_t queueIndex)
+{
+    t_JobSystem  = this;
+    t_QueueIndex = queueIndex;
+
+    std::string threadName = "Job Worker " + std::to_string(queueIndex);
+    MicroProfileOnThreadCreate(threadName.c_str());
+
+    while (true)
+    {
+        if (TryRunOneJob())
+            continue;
+
+        std::unique_lock lock(m_SleepMutex);
+        m_WakeCondition.wait(lock, [this]()
+                             { return m_Quit.load() || m_QueuedJobs.load(std::memory_order_acquire) != 0; });
+
+        if (m_Quit.load())
+            break;
+    }
+
+    MicroProfileOnThreadExit();
+}
+
+} // namespace gore
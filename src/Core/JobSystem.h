@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Export.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gore
+{
+
+using JobFunc   = std::function<void()>;
+using RangeFunc = std::function<void(uint32_t begin, uint32_t end)>;
+
+// Counts the jobs that are still in flight. Scheduling a job with a counter increments it,
+// the counter is decremented when the job has finished running.
+// Jobs can also be scheduled to start once a counter drops to zero, which is how dependencies are expressed.
+ENGINE_CLASS(JobCounter) final
+{
+public:
+    JobCounter() = default;
+    ~JobCounter() = default;
+
+    NON_COPYABLE(JobCounter);
+
+    [[nodiscard]] bool IsDone() const { return m_Value.load(std::memory_order_acquire) == 0; }
+    [[nodiscard]] uint32_t GetValue() const { return m_Value.load(std::memory_order_acquire); }
+
+private:
+    friend class JobSystem;
+
+    struct Continuation
+    {
+        JobFunc func;
+        JobCounter* counter;
+    };
+
+    std::atomic<uint32_t> m_Value = 0;
+
+    // also guards the last decrement, so a waiter can not destroy the counter while it is still in use
+    mutable std::mutex m_ContinuationMutex;
+    std::vector<Continuation> m_Continuations;
+};
+
+// Work stealing job system.
+// Every worker owns a deque: it pushes and pops its own jobs at the back and steals from the front of the others.
+// The thread that creates the JobSystem takes slot 0, it only runs jobs while it waits on a counter.
+ENGINE_CLASS(JobSystem) final
+{
+    SINGLETON(JobSystem)
+
+public:
+    // workerCount does not include the thread that creates the JobSystem
+    explicit JobSystem(uint32_t workerCount);
+    ~JobSystem();
+
+    [[nodiscard]] uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+    [[nodiscard]] uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Queues.size()); }
+
+    void Schedule(JobFunc func, JobCounter* counter = nullptr);
+    // func is only scheduled once dependency reaches zero, counter is incremented right away
+    void ScheduleAfter(JobCounter& dependency, JobFunc func, JobCounter* counter = nullptr);
+
+    // Runs other jobs on the calling thread until counter reaches zero
+    void Wait(const JobCounter& counter);
+
+    // Calls func on [0, count) split in chunks of chunkSize items and waits for all of them.
+    void ParallelFor(uint32_t count, uint32_t chunkSize, const RangeFunc& func);
+
+    [[nodiscard]] static uint32_t GetDefaultWorkerCount();
+
+private:
+    struct Job
+    {
+        JobFunc func;
+        JobCounter* counter;
+    };
+
+    struct JobQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void Push(Job&& job);
+    bool TryPop(uint32_t queueIndex, Job& job);
+    bool TrySteal(uint32_t thiefIndex, Job& job);
+    bool TryRunOneJob();
+    void Execute(Job& job);
+
+    void WorkerMain(uint32_t queueIndex);
+
+    [[nodiscard]] uint32_t GetCurrentQueueIndex() const;
+
+private:
+    std::vector<std::thread> m_Workers;
+    std::vector<std::unique_ptr<JobQueue>> m_Queues;
+
+    // number of jobs sitting in any queue, workers go to sleep when it is zero
+    std::atomic<uint32_t> m_QueuedJobs;
+    std::atomic<bool> m_Quit;
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WakeCondition;
+};
+
+} // namespace gore
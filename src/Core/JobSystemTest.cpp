@@ -0,0 +1,113 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Core/JobSystem.h"
+
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace gore::test
+{
+
+TEST_CASE("Jobs run and counters reach zero", "[JobSystem]")
+{
+    JobSystem jobSystem(3);
+    REQUIRE(JobSystem::GetInstance() == &jobSystem);
+
+    std::atomic<int> sum = 0;
+    JobCounter counter;
+    for (int i = 1; i <= 1000; ++i)
+    {
+        jobSystem.Schedule([&sum, i]() { sum += i; }, &counter);
+    }
+    jobSystem.Wait(counter);
+
+    REQUIRE(counter.IsDone());
+    REQUIRE(sum == 500500);
+}
+
+TEST_CASE("Dependent jobs start after their dependency", "[JobSystem]")
+{
+    JobSystem jobSystem(3);
+
+    std::atomic<int> stage = 0;
+    std::atomic<bool> orderViolated = false;
+
+    JobCounter first;
+    JobCounter second;
+    JobCounter third;
+
+    for (int i = 0; i < 64; ++i)
+    {
+        jobSystem.Schedule([&]()
+                           {
+                               std::this_thread::sleep_for(std::chrono::microseconds(50));
+                               if (stage.load() != 0)
+                                   orderViolated = true; },
+                           &first);
+    }
+
+    jobSystem.ScheduleAfter(first, [&]() { stage = 1; }, &second);
+    jobSystem.ScheduleAfter(second, [&]() { stage = 2; }, &third);
+
+    // the counter of a continuation is incremented right away, so waiting on it covers the whole chain
+    REQUIRE(third.GetValue() == 1);
+    jobSystem.Wait(third);
+
+    REQUIRE_FALSE(orderViolated);
+    REQUIRE(stage == 2);
+
+    SECTION("Depending on a finished counter runs right away")
+    {
+        JobCounter done;
+        jobSystem.ScheduleAfter(first, [&]() { stage = 3; }, &done);
+        jobSystem.Wait(done);
+        REQUIRE(stage == 3);
+    }
+}
+
+TEST_CASE("Jobs scheduled by jobs are stolen by other workers", "[JobSystem]")
+{
+    JobSystem jobSystem(3);
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+
+    JobCounter counter;
+    jobSystem.Schedule([&]()
+                       {
+                           // everything lands on the deque of a single worker, the rest has to steal
+                           for (int i = 0; i < 256; ++i)
+                           {
+                               jobSystem.Schedule([&]()
+                                                  {
+                                                      std::this_thread::sleep_for(std::chrono::microseconds(100));
+                                                      std::lock_guard lock(mutex);
+                                                      threads.insert(std::this_thread::get_id()); },
+                                                  &counter);
+                           } },
+                       &counter);
+    jobSystem.Wait(counter);
+
+    REQUIRE(threads.size() > 1);
+}
+
+TEST_CASE("ParallelFor covers the whole range once", "[JobSystem]")
+{
+    JobSystem jobSystem(3);
+
+    std::vector<int> values(100003, 0);
+    jobSystem.ParallelFor(static_cast<uint32_t>(values.size()), 1000, [&values](uint32_t begin, uint32_t end)
+                          {
+                              for (uint32_t i = begin; i < end; ++i)
+                                  values[i] += 1; });
+
+    REQUIRE(std::accumulate(values.begin(), values.end(), 0) == static_cast<int>(values.size()));
+}
+
+} // namespace gore::test
+#endif
@@ -265,7 +265,12 @@ Device::Device(PhysicalDevice physicalDevice) :
     vk::PhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures;
     bufferDeviceAddressFeatures.bufferDeviceAddress = VK_TRUE;    
 
+    // the AsyncUploader tells the graphics queue when the transfer queue is done with it
+    vk::PhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures;
+    timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+
     bufferDeviceAddressFeatures.pNext = &dynamicRenderingFeatures;
+    dynamicRenderingFeatures.pNext    = &timelineSemaphoreFeatures;
 
     enabledFeatures2.pNext = &bufferDeviceAddressFeatures;
 
@@ -54,6 +54,7 @@ DEVICE_EXTENSION(VK_KHR_create_renderpass2)
 DEVICE_EXTENSION(VK_KHR_dedicated_allocation)
 DEVICE_EXTENSION(VK_KHR_depth_stencil_resolve)
 DEVICE_EXTENSION(VK_KHR_descriptor_update_template)
+DEVICE_EXTENSION(VK_KHR_draw_indirect_count)
 DEVICE_EXTENSION(VK_KHR_driver_properties)
 DEVICE_EXTENSION(VK_KHR_get_memory_requirements2)
 DEVICE_EXTENSION(VK_KHR_image_format_list)
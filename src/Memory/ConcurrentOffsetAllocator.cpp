@@ -0,0 +1,237 @@
+#include "Prefix.h"
+
+#include "ConcurrentOffsetAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace gore
+{
+namespace SmallFloat = OffsetAllocator::SmallFloat;
+
+static constexpr uint32_t k_InvalidThreadIndex = UINT32_MAX;
+
+// Shared by every ConcurrentOffsetAllocator. The index of an exited thread is handed out again once the magazines
+// it had in every allocator went back, the lock keeps allocators from going away while that happens.
+struct ConcurrentOffsetAllocator::ThreadRegistry
+{
+    std::mutex mutex;
+    std::vector<ConcurrentOffsetAllocator*> allocators;
+    std::vector<uint32_t> freeThreadIndices;
+    uint32_t nextThreadIndex = 0;
+
+    static ThreadRegistry& Get()
+    {
+        static ThreadRegistry s_Registry;
+        return s_Registry;
+    }
+};
+
+// Lives as long as the thread it belongs to
+struct ConcurrentOffsetAllocator::ThreadIndex
+{
+    ThreadIndex();
+    ~ThreadIndex();
+
+    uint32_t index;
+};
+
+ConcurrentOffsetAllocator::ThreadIndex::ThreadIndex() :
+    index(k_InvalidThreadIndex)
+{
+    ThreadRegistry& registry = ThreadRegistry::Get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (registry.freeThreadIndices.empty() == false)
+    {
+        index = registry.freeThreadIndices.back();
+        registry.freeThreadIndices.pop_back();
+    }
+    else if (registry.nextThreadIndex < k_MaxThreadCount)
+    {
+        index = registry.nextThreadIndex++;
+    }
+}
+
+ConcurrentOffsetAllocator::ThreadIndex::~ThreadIndex()
+{
+    if (index == k_InvalidThreadIndex)
+        return;
+
+    ThreadRegistry& registry = ThreadRegistry::Get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (ConcurrentOffsetAllocator* allocator : registry.allocators)
+        allocator->ReleaseThreadCache(index);
+
+    registry.freeThreadIndices.push_back(index);
+}
+
+uint32_t ConcurrentOffsetAllocator::GetThreadIndex()
+{
+    static thread_local ThreadIndex t_ThreadIndex;
+    return t_ThreadIndex.index;
+}
+
+ConcurrentOffsetAllocator::ThreadCache::ThreadCache(uint32_t binCount) :
+    magazines(new Magazine[binCount])
+{
+}
+
+ConcurrentOffsetAllocator::ThreadCache::~ThreadCache()
+{
+    delete[] magazines;
+}
+
+ConcurrentOffsetAllocator::ConcurrentOffsetAllocator(uint32_t size, uint32_t maxAllocs, uint32_t maxCachedSize) :
+    m_Mutex(),
+    m_Allocator(size, maxAllocs),
+    m_MaxCachedSize(maxCachedSize),
+    m_BinCount(maxCachedSize > 0 ? SmallFloat::uintToFloatRoundUp(maxCachedSize) + 1 : 0),
+    m_ThreadCaches()
+{
+    ThreadRegistry& registry = ThreadRegistry::Get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.allocators.push_back(this);
+}
+
+ConcurrentOffsetAllocator::~ConcurrentOffsetAllocator()
+{
+    {
+        ThreadRegistry& registry = ThreadRegistry::Get();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.allocators.erase(std::find(registry.allocators.begin(), registry.allocators.end(), this));
+    }
+
+    // the shared allocator goes away as well, nothing needs to be given back
+    for (std::atomic<ThreadCache*>& threadCache : m_ThreadCaches)
+        delete threadCache.load(std::memory_order_acquire);
+}
+
+ConcurrentOffsetAllocator::ThreadCache* ConcurrentOffsetAllocator::GetThreadCache()
+{
+    uint32_t threadIndex = GetThreadIndex();
+    if (threadIndex >= k_MaxThreadCount || m_BinCount == 0)
+        return nullptr;
+
+    // only this thread ever writes its slot, Trim reads it from another one
+    ThreadCache* threadCache = m_ThreadCaches[threadIndex].load(std::memory_order_relaxed);
+    if (threadCache == nullptr)
+    {
+        threadCache = new ThreadCache(m_BinCount);
+        m_ThreadCaches[threadIndex].store(threadCache, std::memory_order_release);
+    }
+
+    return threadCache;
+}
+
+void ConcurrentOffsetAllocator::ReleaseThreadCache(uint32_t threadIndex)
+{
+    ThreadCache* threadCache = m_ThreadCaches[threadIndex].exchange(nullptr, std::memory_order_acq_rel);
+    if (threadCache == nullptr)
+        return;
+
+    for (uint32_t bin = 0; bin < m_BinCount; ++bin)
+    {
+        Magazine& magazine = threadCache->magazines[bin];
+        if (magazine.count > 0)
+            Drain(magazine, magazine.count);
+    }
+
+    delete threadCache;
+}
+
+void ConcurrentOffsetAllocator::Refill(Magazine& magazine, uint32_t binSize)
+{
+    // half full, so the next frees do not drain right away
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    while (magazine.count < k_MagazineCapacity / 2)
+    {
+        OffsetAllocator::Allocation allocation = m_Allocator.allocate(binSize);
+        if (allocation.offset == OffsetAllocator::Allocation::NO_SPACE)
+            break;
+
+        magazine.allocations[magazine.count++] = allocation;
+    }
+}
+
+void ConcurrentOffsetAllocator::Drain(Magazine& magazine, uint32_t count)
+{
+    // the oldest ones go back, the ones freed last are the most likely to still be in cache for the caller
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (uint32_t i = 0; i < count; ++i)
+        m_Allocator.free(magazine.allocations[i]);
+
+    magazine.count -= count;
+    for (uint32_t i = 0; i < magazine.count; ++i)
+        magazine.allocations[i] = magazine.allocations[i + count];
+}
+
+OffsetAllocator::Allocation ConcurrentOffsetAllocator::Allocate(uint32_t size)
+{
+    bool cached              = size > 0 && size <= m_MaxCachedSize;
+    uint32_t bin             = cached ? SmallFloat::uintToFloatRoundUp(size) : 0;
+    ThreadCache* threadCache = cached ? GetThreadCache() : nullptr;
+    if (threadCache == nullptr)
+    {
+        // any thread may free it into a magazine, where it has to be as big as the other allocations of its bin
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Allocator.allocate(cached ? SmallFloat::floatToUint(bin) : size);
+    }
+
+    Magazine& magazine = threadCache->magazines[bin];
+    if (magazine.count == 0)
+    {
+        Refill(magazine, SmallFloat::floatToUint(bin));
+        if (magazine.count == 0)
+            return {};
+    }
+
+    return magazine.allocations[--magazine.count];
+}
+
+void ConcurrentOffsetAllocator::Free(OffsetAllocator::Allocation allocation, uint32_t size)
+{
+    if (allocation.offset == OffsetAllocator::Allocation::NO_SPACE)
+        return;
+
+    ThreadCache* threadCache = size > 0 && size <= m_MaxCachedSize ? GetThreadCache() : nullptr;
+    if (threadCache == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Allocator.free(allocation);
+        return;
+    }
+
+    Magazine& magazine = threadCache->magazines[SmallFloat::uintToFloatRoundUp(size)];
+    if (magazine.count == k_MagazineCapacity)
+        Drain(magazine, k_MagazineCapacity / 2);
+
+    magazine.allocations[magazine.count++] = allocation;
+}
+
+void ConcurrentOffsetAllocator::Trim()
+{
+    // threads exiting meanwhile give their magazines back under the same lock
+    ThreadRegistry& registry = ThreadRegistry::Get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (std::atomic<ThreadCache*>& slot : m_ThreadCaches)
+    {
+        ThreadCache* threadCache = slot.load(std::memory_order_acquire);
+        if (threadCache == nullptr)
+            continue;
+
+        for (uint32_t bin = 0; bin < m_BinCount; ++bin)
+        {
+            Magazine& magazine = threadCache->magazines[bin];
+            if (magazine.count > 0)
+                Drain(magazine, magazine.count);
+        }
+    }
+}
+
+OffsetAllocator::StorageReport ConcurrentOffsetAllocator::GetStorageReport()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Allocator.storageReport();
+}
+} // namespace gore
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Export.h"
+
+#include "OffsetAllocator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace gore
+{
+// Thread safe front end of OffsetAllocator::Allocator.
+// Sizes up to maxCachedSize are rounded up to the size of their OffsetAllocator bin. They are served from a magazine
+// the calling thread owns for that bin, so allocating and freeing them takes no lock. An empty magazine is refilled
+// and a full one drained with a batch of allocations under the lock of the shared allocator. Bigger sizes always go
+// through the lock.
+// Free space sitting in magazines is not visible to other threads until Trim hands it back, or until the thread
+// exits and gives its magazines back to every allocator.
+ENGINE_CLASS(ConcurrentOffsetAllocator) final
+{
+public:
+    // Threads beyond this count running at once have no magazines and always take the lock
+    static constexpr uint32_t k_MaxThreadCount   = 64;
+    static constexpr uint32_t k_MagazineCapacity = 32;
+
+    explicit ConcurrentOffsetAllocator(uint32_t size, uint32_t maxAllocs = 128 * 1024, uint32_t maxCachedSize = 4096);
+    ~ConcurrentOffsetAllocator();
+
+    NON_COPYABLE(ConcurrentOffsetAllocator);
+
+    [[nodiscard]] OffsetAllocator::Allocation Allocate(uint32_t size);
+    // size has to be the size the allocation was made with, it picks the magazine the allocation goes back to
+    void Free(OffsetAllocator::Allocation allocation, uint32_t size);
+
+    // Returns what every magazine holds to the shared allocator, only while no other thread allocates or frees
+    void Trim();
+
+    // Space in magazines counts as used
+    [[nodiscard]] OffsetAllocator::StorageReport GetStorageReport();
+    [[nodiscard]] uint32_t GetMaxCachedSize() const { return m_MaxCachedSize; }
+
+private:
+    struct Magazine
+    {
+        OffsetAllocator::Allocation allocations[k_MagazineCapacity];
+        uint32_t count = 0;
+    };
+
+    // Only touched by the thread it belongs to, one magazine per bin up to maxCachedSize
+    struct ThreadCache
+    {
+        explicit ThreadCache(uint32_t binCount);
+        ~ThreadCache();
+
+        Magazine* magazines;
+    };
+
+    // Hands out the indices of the threads using any ConcurrentOffsetAllocator, see ConcurrentOffsetAllocator.cpp
+    struct ThreadRegistry;
+    struct ThreadIndex;
+
+    static uint32_t GetThreadIndex();
+
+    ThreadCache* GetThreadCache();
+    // Gives the magazines of an exiting thread back to the shared allocator
+    void ReleaseThreadCache(uint32_t threadIndex);
+    void Refill(Magazine& magazine, uint32_t binSize);
+    void Drain(Magazine& magazine, uint32_t count);
+
+    std::mutex m_Mutex;
+    OffsetAllocator::Allocator m_Allocator;
+
+    uint32_t m_MaxCachedSize;
+    uint32_t m_BinCount;
+
+    std::atomic<ThreadCache*> m_ThreadCaches[k_MaxThreadCount];
+};
+} // namespace gore
@@ -1,3 +1,5 @@
+#pragma once
+
 // (C) Sebastian Aaltonen 2023
 // MIT License (see file: LICENSE)
 
@@ -23,6 +25,14 @@ namespace OffsetAllocator
     static constexpr uint32 LEAF_BINS_INDEX_MASK = 0x7;
     static constexpr uint32 NUM_LEAF_BINS = NUM_TOP_BINS * BINS_PER_LEAF;
 
+    // Sizes as the bins of the allocator see them: the bin index of a size rounded up or down, and the size of a bin
+    namespace SmallFloat
+    {
+        uint32 uintToFloatRoundUp(uint32 size);
+        uint32 uintToFloatRoundDown(uint32 size);
+        uint32 floatToUint(uint32 floatValue);
+    }
+
     struct Allocation
     {
         static constexpr uint32 NO_SPACE = 0xffffffff;
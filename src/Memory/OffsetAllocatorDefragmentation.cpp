@@ -0,0 +1,41 @@
+#include "OffsetAllocatorDefragmentation.h"
+
+#include <algorithm>
+
+namespace gore
+{
+std::vector<DefragmentationMove> PlanDefragmentation(OffsetAllocator::Allocator& allocator, std::span<const DefragmentationCandidate> candidates, uint32_t moveBudget)
+{
+    std::vector<DefragmentationCandidate> sorted(candidates.begin(), candidates.end());
+    std::sort(sorted.begin(), sorted.end(), [](const DefragmentationCandidate& a, const DefragmentationCandidate& b)
+              { return a.allocation.offset > b.allocation.offset; });
+
+    std::vector<DefragmentationMove> moves;
+    uint32_t movedSize = 0;
+    for (const DefragmentationCandidate& candidate : sorted)
+    {
+        const uint32_t size = allocator.allocationSize(candidate.allocation);
+        if (size == 0)
+            continue;
+
+        // smaller ones further down may still fit into what is left of the budget
+        if (movedSize + size > moveBudget)
+            continue;
+
+        OffsetAllocator::Allocation target = allocator.allocate(size);
+        if (target.offset == OffsetAllocator::Allocation::NO_SPACE)
+            continue;
+
+        if (target.offset > candidate.allocation.offset)
+        {
+            allocator.free(target);
+            continue;
+        }
+
+        moves.push_back({candidate.allocation, target, size, candidate.userData});
+        movedSize += size;
+    }
+
+    return moves;
+}
+} // namespace gore
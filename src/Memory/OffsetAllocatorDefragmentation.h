@@ -0,0 +1,33 @@
+#pragma once
+
+#include "OffsetAllocator.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace gore
+{
+// A live allocation of the heap, userData tells the caller which of its objects owns it
+struct DefragmentationCandidate
+{
+    OffsetAllocator::Allocation allocation = {};
+    uint32_t userData                      = 0;
+};
+
+// Copy size units from from.offset to to.offset, then point the object at to.offset. from stays allocated until the
+// caller frees it, after the copy and after nothing reads the old place anymore.
+struct DefragmentationMove
+{
+    OffsetAllocator::Allocation from = {};
+    OffsetAllocator::Allocation to   = {};
+    uint32_t size                    = 0;
+    uint32_t userData                = 0;
+};
+
+// Plans one incremental step of compaction for a heap managed by an OffsetAllocator. Allocations are taken from the
+// top of the heap down and moved when the allocator finds room for them further down, skipping the ones that do not
+// fit into what is left of moveBudget units. Moving everything out of the top lets the free space there grow back together
+// once the old places are freed. The new places are allocated in allocator already, nothing is freed.
+std::vector<DefragmentationMove> PlanDefragmentation(OffsetAllocator::Allocator& allocator, std::span<const DefragmentationCandidate> candidates, uint32_t moveBudget);
+} // namespace gore
@@ -0,0 +1,203 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+
+#include "OffsetAllocatorDefragmentation.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace gore::test
+{
+// Objects of a simulated heap, an object is dead when its allocation has no space
+struct SimulatedHeap
+{
+    explicit SimulatedHeap(uint32_t size) :
+        allocator(size)
+    {
+    }
+
+    bool Allocate(uint32_t size)
+    {
+        OffsetAllocator::Allocation allocation = allocator.allocate(size);
+        if (allocation.offset == OffsetAllocator::Allocation::NO_SPACE)
+            return false;
+
+        objects.push_back(allocation);
+        return true;
+    }
+
+    void Free(std::mt19937& random)
+    {
+        std::vector<uint32_t> alive = GetAlive();
+        if (alive.empty())
+            return;
+
+        uint32_t victim = alive[random() % alive.size()];
+        allocator.free(objects[victim]);
+        objects[victim] = {};
+    }
+
+    std::vector<uint32_t> GetAlive() const
+    {
+        std::vector<uint32_t> alive;
+        for (uint32_t i = 0; i < objects.size(); ++i)
+        {
+            if (objects[i].offset != OffsetAllocator::Allocation::NO_SPACE)
+                alive.push_back(i);
+        }
+        return alive;
+    }
+
+    // Copies are instant here, so the old places can be freed right away
+    uint32_t Defragment(uint32_t budget)
+    {
+        std::vector<DefragmentationCandidate> candidates;
+        for (uint32_t i : GetAlive())
+            candidates.push_back({objects[i], i});
+
+        std::vector<DefragmentationMove> moves = PlanDefragmentation(allocator, candidates, budget);
+
+        uint32_t movedSize = 0;
+        for (const DefragmentationMove& move : moves)
+        {
+            REQUIRE(move.to.offset < move.from.offset);
+            REQUIRE(objects[move.userData].offset == move.from.offset);
+
+            objects[move.userData] = move.to;
+            allocator.free(move.from);
+            movedSize += move.size;
+        }
+        REQUIRE(movedSize <= budget);
+        return movedSize;
+    }
+
+    bool HasOverlaps() const
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;
+        for (uint32_t i : GetAlive())
+            ranges.push_back({objects[i].offset, allocator.allocationSize(objects[i])});
+
+        std::sort(ranges.begin(), ranges.end());
+        for (size_t i = 1; i < ranges.size(); ++i)
+        {
+            if (ranges[i - 1].first + ranges[i - 1].second > ranges[i].first)
+                return true;
+        }
+        return false;
+    }
+
+    uint32_t GetLargestFreeRegion() const
+    {
+        return allocator.storageReport().largestFreeRegion;
+    }
+
+    OffsetAllocator::Allocator allocator;
+    std::vector<OffsetAllocator::Allocation> objects;
+};
+
+TEST_CASE("Planned moves only go down and stay within the budget", "[OffsetAllocatorDefragmentation]")
+{
+    // sizes the allocator's bins represent exactly, so every hole fits one allocation
+    OffsetAllocator::Allocator allocator(2048);
+
+    std::vector<OffsetAllocator::Allocation> allocations;
+    for (uint32_t i = 0; i < 8; ++i)
+        allocations.push_back(allocator.allocate(128));
+
+    // holes at the bottom, objects at the top
+    allocator.free(allocations[0]);
+    allocator.free(allocations[1]);
+    allocator.free(allocations[3]);
+
+    std::vector<DefragmentationCandidate> candidates;
+    for (uint32_t i : {2u, 4u, 5u, 6u, 7u})
+        candidates.push_back({allocations[i], i});
+
+    std::vector<DefragmentationMove> moves = PlanDefragmentation(allocator, candidates, 300);
+    REQUIRE(moves.size() == 2);
+
+    // from the top down
+    REQUIRE(moves[0].userData == 7);
+    REQUIRE(moves[1].userData == 6);
+    for (const DefragmentationMove& move : moves)
+    {
+        REQUIRE(move.size == 128);
+        REQUIRE(move.to.offset < move.from.offset);
+        REQUIRE(move.from.offset == allocations[move.userData].offset);
+    }
+
+    SECTION("Nothing moves without a budget")
+    {
+        REQUIRE(PlanDefragmentation(allocator, candidates, 0).empty());
+    }
+}
+
+TEST_CASE("Incremental defragmentation under churn", "[OffsetAllocatorDefragmentation]")
+{
+    constexpr uint32_t heapSize     = 1024 * 1024;
+    constexpr uint32_t frameCount   = 600;
+    constexpr uint32_t budget       = 16 * 1024;
+
+    SimulatedHeap compacted(heapSize);
+    SimulatedHeap fragmented(heapSize);
+
+    // both heaps see the same requests, only one of them is compacted every frame. The heap is kept about three
+    // quarters full while objects of mixed sizes stream in and out.
+    std::mt19937 random(3);
+    uint32_t failedAllocations[2] = {};
+    // summed over the frames, the biggest object each heap could still place on average
+    uint64_t largestFreeRegionSum[2] = {};
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        for (uint32_t op = 0; op < 8; ++op)
+        {
+            uint32_t roll = random();
+            if (frame < 100 || roll % 2 == 0)
+            {
+                uint32_t size = 256 + roll % (16 * 1024);
+                if (heapSize - compacted.allocator.storageReport().totalFreeSpace > heapSize / 4 * 3)
+                    continue;
+
+                failedAllocations[0] += fragmented.Allocate(size) ? 0 : 1;
+                failedAllocations[1] += compacted.Allocate(size) ? 0 : 1;
+            }
+            else
+            {
+                std::mt19937 freeRandom(roll);
+                compacted.Free(freeRandom);
+                freeRandom.seed(roll);
+                fragmented.Free(freeRandom);
+            }
+        }
+
+        compacted.Defragment(budget);
+
+        largestFreeRegionSum[0] += fragmented.GetLargestFreeRegion();
+        largestFreeRegionSum[1] += compacted.GetLargestFreeRegion();
+    }
+    REQUIRE(compacted.HasOverlaps() == false);
+    REQUIRE(fragmented.HasOverlaps() == false);
+
+    // a single frame may be a bin behind, on average compaction keeps clearly bigger holes
+    uint64_t fragmentedAverage = largestFreeRegionSum[0] / frameCount;
+    uint64_t compactedAverage  = largestFreeRegionSum[1] / frameCount;
+    CAPTURE(fragmentedAverage, compactedAverage, failedAllocations[0], failedAllocations[1]);
+    REQUIRE(compactedAverage > fragmentedAverage + fragmentedAverage / 10);
+    REQUIRE(failedAllocations[1] <= failedAllocations[0]);
+
+    // once streaming calms down, compaction keeps going within the budget until the free space is back together
+    uint32_t before = compacted.GetLargestFreeRegion();
+    for (uint32_t frame = 0; frame < 200; ++frame)
+        compacted.Defragment(budget);
+    uint32_t after = compacted.GetLargestFreeRegion();
+    CAPTURE(before, after);
+
+    REQUIRE(compacted.HasOverlaps() == false);
+    REQUIRE(after >= before);
+    REQUIRE(after >= fragmented.GetLargestFreeRegion());
+}
+
+} // namespace gore::test
+#endif
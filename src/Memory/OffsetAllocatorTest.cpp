@@ -3,6 +3,7 @@
 #ifdef ENABLE_TEST
 
 #include "OffsetAllocator.h"
+#include "ConcurrentOffsetAllocator.h"
 
 namespace OffsetAllocator
 {
@@ -14,6 +15,16 @@ extern uint32_t floatToUint(uint32_t floatValue);
 } // namespace SmallFloat
 } // namespace OffsetAllocator
 
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 TEST_CASE("numbers", "[SmallFloat]")
 {
     SECTION("uintToFloat")
@@ -253,4 +264,286 @@ TEST_CASE("allocate", "[offsetAllocator]")
         allocator.free(validateAll);
     }
 }
+
+// A thread keeps a few allocations alive and replaces one of them per iteration, mostly small ones with an
+// occasional big one that has to take the lock
+template <typename AllocateFunc, typename FreeFunc>
+static void RunAllocations(uint32_t threadIndex, uint32_t iterations, AllocateFunc&& allocate, FreeFunc&& free,
+                           std::vector<std::vector<std::pair<OffsetAllocator::Allocation, uint32_t>>>* alive = nullptr)
+{
+    std::vector<std::pair<OffsetAllocator::Allocation, uint32_t>> allocations(16);
+    uint32_t random = threadIndex * 7919 + 1;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        random = random * 1664525 + 1013904223;
+
+        auto& [allocation, size] = allocations[(random >> 8) % allocations.size()];
+        free(allocation, size);
+
+        size       = (random >> 16) % 64 == 0 ? 16 * 1024 : 16 + (random >> 20) % 512;
+        allocation = allocate(size);
+    }
+
+    if (alive != nullptr)
+    {
+        (*alive)[threadIndex] = allocations;
+        return;
+    }
+
+    for (const auto& [allocation, size] : allocations)
+        free(allocation, size);
+}
+
+template <typename AllocateFunc, typename FreeFunc>
+static void RunAllocationThreads(uint32_t threadCount, uint32_t iterations, AllocateFunc&& allocate, FreeFunc&& free,
+                                 std::vector<std::vector<std::pair<OffsetAllocator::Allocation, uint32_t>>>* alive = nullptr)
+{
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; ++t)
+        threads.emplace_back([&, t]() { RunAllocations(t, iterations, allocate, free, alive); });
+    for (auto& thread : threads)
+        thread.join();
+}
+
+// Threads that stay alive across the samples of a benchmark, so it measures the magazines they keep and not
+// starting threads
+class AllocationWorkers
+{
+public:
+    explicit AllocationWorkers(uint32_t threadCount)
+    {
+        for (uint32_t t = 0; t < threadCount; ++t)
+            m_Threads.emplace_back([this, t]() { WorkerLoop(t); });
+    }
+
+    ~AllocationWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Exit = true;
+        }
+        m_Start.notify_all();
+
+        for (auto& thread : m_Threads)
+            thread.join();
+    }
+
+    // Runs work on every thread with its index and waits until all are done
+    void Run(const std::function<void(uint32_t)>& work)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Work    = &work;
+        m_Running = static_cast<uint32_t>(m_Threads.size());
+        ++m_Generation;
+        m_Start.notify_all();
+        m_Done.wait(lock, [this]() { return m_Running == 0; });
+    }
+
+private:
+    void WorkerLoop(uint32_t threadIndex)
+    {
+        uint64_t generation = 0;
+        while (true)
+        {
+            const std::function<void(uint32_t)>* work;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Start.wait(lock, [&]() { return m_Exit || m_Generation != generation; });
+                if (m_Exit)
+                    return;
+
+                generation = m_Generation;
+                work       = m_Work;
+            }
+
+            (*work)(threadIndex);
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (--m_Running == 0)
+                m_Done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> m_Threads;
+    std::mutex m_Mutex;
+    std::condition_variable m_Start;
+    std::condition_variable m_Done;
+    const std::function<void(uint32_t)>* m_Work = nullptr;
+    uint64_t m_Generation                      = 0;
+    uint32_t m_Running                         = 0;
+    bool m_Exit                                = false;
+};
+
+TEST_CASE("concurrent", "[OffsetAllocator]")
+{
+    constexpr uint32_t threadCount = 8;
+    gore::ConcurrentOffsetAllocator allocator(1024 * 1024 * 64);
+
+    std::vector<std::vector<std::pair<OffsetAllocator::Allocation, uint32_t>>> alive(threadCount);
+    RunAllocationThreads(
+        threadCount, 20000,
+        [&](uint32_t size) { return allocator.Allocate(size); },
+        [&](OffsetAllocator::Allocation allocation, uint32_t size) { allocator.Free(allocation, size); },
+        &alive);
+
+    // what every thread still holds never overlaps
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (const auto& allocations : alive)
+    {
+        for (const auto& [allocation, size] : allocations)
+        {
+            REQUIRE(allocation.offset != OffsetAllocator::Allocation::NO_SPACE);
+            ranges.push_back({allocation.offset, size});
+        }
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+    for (size_t i = 1; i < ranges.size(); ++i)
+        REQUIRE(ranges[i - 1].first + ranges[i - 1].second <= ranges[i].first);
+
+    // the space comes back once the magazines are trimmed
+    for (const auto& allocations : alive)
+    {
+        for (const auto& [allocation, size] : allocations)
+            allocator.Free(allocation, size);
+    }
+    allocator.Trim();
+
+    OffsetAllocator::StorageReport report = allocator.GetStorageReport();
+    REQUIRE(report.totalFreeSpace == 1024 * 1024 * 64);
+    REQUIRE(report.largestFreeRegion == 1024 * 1024 * 64);
+}
+
+TEST_CASE("exited threads give their magazines back", "[OffsetAllocator]")
+{
+    constexpr uint32_t size = 1024 * 1024;
+    gore::ConcurrentOffsetAllocator allocator(size);
+
+    // more threads than there are thread indices, one after the other, so every one reuses the index of the last
+    constexpr uint32_t threadCount = gore::ConcurrentOffsetAllocator::k_MaxThreadCount * 2;
+    std::vector<uint32_t> freeSpaceWhileRunning(threadCount);
+    for (uint32_t t = 0; t < threadCount; ++t)
+    {
+        std::thread thread(
+            [&, t]()
+            {
+                OffsetAllocator::Allocation allocation = allocator.Allocate(64);
+                allocator.Free(allocation, 64);
+                freeSpaceWhileRunning[t] = allocator.GetStorageReport().totalFreeSpace;
+            });
+        thread.join();
+
+        // the magazine refilled by the allocation went back when the thread exited
+        REQUIRE(allocator.GetStorageReport().totalFreeSpace == size);
+    }
+
+    // every thread had a magazine holding some space
+    for (uint32_t freeSpace : freeSpaceWhileRunning)
+        REQUIRE(freeSpace < size);
+}
+
+TEST_CASE("allocations of threads without magazines can be freed into one", "[OffsetAllocator]")
+{
+    constexpr uint32_t size = 1024 * 1024 * 16;
+    gore::ConcurrentOffsetAllocator allocator(size);
+
+    // all alive at once, so some of them get no thread index
+    constexpr uint32_t threadCount = gore::ConcurrentOffsetAllocator::k_MaxThreadCount + 16;
+    constexpr uint32_t slotSize    = 64;
+    std::vector<std::vector<std::pair<OffsetAllocator::Allocation, uint32_t>>> slots(threadCount);
+    AllocationWorkers workers(threadCount);
+
+    // every round a thread frees what another one allocated in the last round and fills the slot again
+    for (uint32_t round = 0; round < 8; ++round)
+    {
+        workers.Run(
+            [&](uint32_t threadIndex)
+            {
+                auto& slot      = slots[(threadIndex + round) % threadCount];
+                uint32_t random = threadIndex * 7919 + round + 1;
+                for (const auto& [allocation, allocationSize] : slot)
+                    allocator.Free(allocation, allocationSize);
+
+                slot.clear();
+                for (uint32_t i = 0; i < slotSize; ++i)
+                {
+                    random                  = random * 1664525 + 1013904223;
+                    uint32_t allocationSize = 16 + (random >> 16) % 512;
+                    slot.push_back({allocator.Allocate(allocationSize), allocationSize});
+                }
+            });
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (const auto& slot : slots)
+    {
+        for (const auto& [allocation, allocationSize] : slot)
+        {
+            REQUIRE(allocation.offset != OffsetAllocator::Allocation::NO_SPACE);
+            ranges.push_back({allocation.offset, allocationSize});
+        }
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+    for (size_t i = 1; i < ranges.size(); ++i)
+        REQUIRE(ranges[i - 1].first + ranges[i - 1].second <= ranges[i].first);
+
+    for (const auto& slot : slots)
+    {
+        for (const auto& [allocation, allocationSize] : slot)
+            allocator.Free(allocation, allocationSize);
+    }
+    allocator.Trim();
+    REQUIRE(allocator.GetStorageReport().totalFreeSpace == size);
+}
+
+TEST_CASE("contention", "[OffsetAllocator][.benchmark]")
+{
+    constexpr uint32_t iterations = 100000;
+
+    for (uint32_t threadCount = 1; threadCount <= 16; threadCount *= 2)
+    {
+        OffsetAllocator::Allocator lockedAllocator(1024 * 1024 * 256);
+        std::mutex mutex;
+        gore::ConcurrentOffsetAllocator concurrentAllocator(1024 * 1024 * 256);
+        AllocationWorkers workers(threadCount);
+
+        std::function<void(uint32_t)> lockedWork = [&](uint32_t threadIndex)
+        {
+            RunAllocations(
+                threadIndex, iterations,
+                [&](uint32_t size)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    return lockedAllocator.allocate(size);
+                },
+                [&](OffsetAllocator::Allocation allocation, uint32_t)
+                {
+                    if (allocation.offset == OffsetAllocator::Allocation::NO_SPACE)
+                        return;
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    lockedAllocator.free(allocation);
+                });
+        };
+
+        std::function<void(uint32_t)> magazineWork = [&](uint32_t threadIndex)
+        {
+            RunAllocations(
+                threadIndex, iterations,
+                [&](uint32_t size) { return concurrentAllocator.Allocate(size); },
+                [&](OffsetAllocator::Allocation allocation, uint32_t size) { concurrentAllocator.Free(allocation, size); });
+        };
+
+        BENCHMARK("Single lock, " + std::to_string(threadCount) + " threads")
+        {
+            workers.Run(lockedWork);
+        };
+
+        BENCHMARK("Thread magazines, " + std::to_string(threadCount) + " threads")
+        {
+            workers.Run(magazineWork);
+        };
+    }
+}
 #endif
\ No newline at end of file
@@ -12,17 +12,20 @@ namespace gore
 
 Transform::Transform(gore::GameObject* gameObject) :
     Component(gameObject),
-    m_LocalTQS(),
     m_Parent(nullptr),
-    m_Children()
+    m_Children(),
+    m_HierarchyIndex(TransformHierarchy::Get().AddNode(this))
 {
 }
 
-Transform::~Transform() = default;
+Transform::~Transform()
+{
+    TransformHierarchy::Get().RemoveNode(m_HierarchyIndex);
+}
 
 void Transform::SetLocalEulerAngles(const Vector3& eulerAngles)
 {
-    m_LocalTQS.q = Quaternion::FromYawPitchRoll(eulerAngles.y, eulerAngles.x, eulerAngles.z);
+    SetLocalRotation(Quaternion::FromYawPitchRoll(eulerAngles.y, eulerAngles.x, eulerAngles.z));
 }
 
 void Transform::Start()
@@ -120,11 +123,11 @@ void Transform::SetWorldPosition(const Vector3& position)
 {
     if (m_Parent == nullptr)
     {
-        m_LocalTQS.t = position;
+        SetLocalPosition(position);
         return;
     }
 
-    m_LocalTQS.t = m_Parent->InverseTransformPoint(position);
+    SetLocalPosition(m_Parent->InverseTransformPoint(position));
 }
 
 Vector3 Transform::GetWorldScale() const
@@ -136,11 +139,11 @@ void Transform::SetWorldScale(const Vector3& scale)
 {
     if (m_Parent == nullptr)
     {
-        m_LocalTQS.s = scale;
+        SetLocalScale(scale);
         return;
     }
 
-    m_LocalTQS.s = m_Parent->InverseTransformVector3(scale);
+    SetLocalScale(m_Parent->InverseTransformVector3(scale));
 }
 
 Quaternion Transform::GetWorldRotation() const
@@ -152,22 +155,22 @@ void Transform::SetWorldRotation(const Quaternion& rotation)
 {
     if (m_Parent == nullptr)
     {
-        m_LocalTQS.q = rotation;
+        SetLocalRotation(rotation);
         return;
     }
 
     auto parentRotation = m_Parent->GetWorldRotation();
-    m_LocalTQS.q        = rotation * parentRotation.Inverse();
+    SetLocalRotation(rotation * parentRotation.Inverse());
 }
 
 void Transform::RotateAroundAxis(const Vector3& axis, float angle)
 {
-    m_LocalTQS.q = Quaternion::FromAxisAngle(axis, angle) * m_LocalTQS.q;
+    SetLocalRotation(Quaternion::FromAxisAngle(axis, angle) * GetLocalRotation());
 }
 
 Matrix4x4 Transform::GetLocalToWorldMatrix() const
 {
-    return CAST_FROM_SIMD_MATRIX_HELPER(Matrix4x4, rtm::matrix_from_qvv(static_cast<TQS::SIMDValueType>(GetLocalToWorldTQS())));
+    return TransformHierarchy::Get().GetLocalToWorldMatrix(m_HierarchyIndex);
 }
 
 Matrix4x4 Transform::GetLocalToWorldMatrixIgnoreScale() const
@@ -212,12 +215,16 @@ void Transform::SetParent(Transform* newParent, bool reCalculateLocalTQS /* = tr
         newParent->m_Children.push_back(this);
     }
 
+    TransformHierarchy& hierarchy = TransformHierarchy::Get();
     if (reCalculateLocalTQS)
     {
-        m_LocalTQS = newParent == nullptr ? this->GetLocalToWorldTQS() : TQS::Mul(this->GetLocalToWorldTQS(), newParent->GetWorldToLocalTQS());
+        hierarchy.SetLocalTQS(m_HierarchyIndex, newParent == nullptr ? this->GetLocalToWorldTQS() : TQS::Mul(this->GetLocalToWorldTQS(), newParent->GetWorldToLocalTQS()));
     }
 
     m_Parent = newParent;
+
+    hierarchy.MarkHierarchyChanged();
+    hierarchy.MarkDirty(m_HierarchyIndex);
 }
 
 int Transform::GetSiblingIndex() const
@@ -239,20 +246,7 @@ int Transform::GetSiblingIndex() const
 
 TQS Transform::GetLocalToWorldTQS() const
 {
-    if (m_Parent == nullptr)
-    {
-        return m_LocalTQS;
-    }
-
-    const Transform* current = m_Parent;
-    TQS result               = m_LocalTQS;
-
-    while (current != nullptr)
-    {
-        result  = TQS::Mul(result, current->m_LocalTQS);
-        current = current->m_Parent;
-    }
-    return result;
+    return TransformHierarchy::Get().GetLocalToWorldTQS(m_HierarchyIndex);
 }
 
 TQS Transform::GetWorldToLocalTQS() const
@@ -8,6 +8,8 @@
 #include "Math/Types.h"
 #include "Math/TQS.h"
 
+#include "Object/TransformHierarchy.h"
+
 #include <vector>
 #include <iterator>
 
@@ -54,14 +56,21 @@ public:
 
 public:
     // clang-format off
-    [[nodiscard]] Vector3 GetLocalPosition() const { return m_LocalTQS.t; }
-    void SetLocalPosition(const Vector3& position) { m_LocalTQS.t = position; }
+    [[nodiscard]] Vector3 GetLocalPosition() const { return GetLocalTQS().t; }
+    void SetLocalPosition(const Vector3& position) { TQS tqs = GetLocalTQS(); tqs.t = position; SetLocalTQS(tqs); }
+
+    [[nodiscard]] Vector3 GetLocalScale() const { return GetLocalTQS().s; }
+    void SetLocalScale(const Vector3& scale) { TQS tqs = GetLocalTQS(); tqs.s = scale; SetLocalTQS(tqs); }
 
-    [[nodiscard]] Vector3 GetLocalScale() const { return m_LocalTQS.s; }
-    void SetLocalScale(const Vector3& scale) { m_LocalTQS.s = scale; }
+    [[nodiscard]] Quaternion GetLocalRotation() const { return GetLocalTQS().q; }
+    void SetLocalRotation(const Quaternion& rotation) { TQS tqs = GetLocalTQS(); tqs.q = rotation; SetLocalTQS(tqs); }
 
-    [[nodiscard]] Quaternion GetLocalRotation() const { return m_LocalTQS.q; }
-    void SetLocalRotation(const Quaternion& rotation) { m_LocalTQS.q = rotation; }
+    [[nodiscard]] TQS GetLocalTQS() const { return TransformHierarchy::Get().GetLocalTQS(m_HierarchyIndex); }
+    void SetLocalTQS(const TQS& tqs) { TransformHierarchy::Get().SetLocalTQS(m_HierarchyIndex, tqs); }
+
+    // slot of the system tracking this transform, see TransformHierarchy::SetChangeListener
+    [[nodiscard]] uint32_t GetChangeSlot() const { return TransformHierarchy::Get().GetChangeSlot(m_HierarchyIndex); }
+    void SetChangeSlot(uint32_t changeSlot) { TransformHierarchy::Get().SetChangeSlot(m_HierarchyIndex, changeSlot); }
     // clang-format on
 
     [[nodiscard]] Vector3 GetLocalEulerAngles() const;
@@ -98,10 +107,13 @@ public:
     [[nodiscard]] TQS GetWorldToLocalTQS() const;
 
 private:
+    friend class TransformHierarchy;
+
     Transform* m_Parent;
     std::vector<Transform*> m_Children;
 
-    TQS m_LocalTQS;
+    // local TQS and the cached world transform live in the TransformHierarchy
+    TransformHierarchy::NodeIndex m_HierarchyIndex;
 };
 
 } // namespace gore
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "Prefix.h"
+
+#include "TransformHierarchy.h"
+#include "Transform.h"
+
+#include "Core/JobSystem.h"
+
+#include <cassert>
+
+namespace gore
+{
+
+TransformHierarchy::TransformHierarchy() :
+    m_Owner(),
+    m_ParentIndex(),
+    m_LocalTQS(),
+    m_WorldTQS(),
+    m_WorldMatrix(),
+    m_DirtyFlags(),
+    m_ChangeSlot(),
+    m_ChangeListener(nullptr),
+    m_LevelOffsets(1, 0),
+    m_OrderDirty(false),
+    m_DirtyStack()
+{
+}
+
+TransformHierarchy::~TransformHierarchy() = default;
+
+TransformHierarchy& TransformHierarchy::Get()
+{
+    static TransformHierarchy s_Hierarchy;
+    return s_Hierarchy;
+}
+
+TransformHierarchy::NodeIndex TransformHierarchy::AddNode(Transform* owner)
+{
+    auto node = static_cast<NodeIndex>(m_Owner.size());
+
+    m_Owner.push_back(owner);
+    m_ParentIndex.push_back(k_InvalidNode);
+    m_LocalTQS.emplace_back();
+    m_WorldTQS.emplace_back();
+    m_WorldMatrix.push_back(Matrix4x4::Identity);
+    m_DirtyFlags.push_back(0);
+    m_ChangeSlot.push_back(k_NoChangeSlot);
+
+    // a new node is always a root, which sits at depth 0
+    m_OrderDirty = true;
+    return node;
+}
+
+void TransformHierarchy::RemoveNode(NodeIndex node)
+{
+    assert(node < m_Owner.size());
+
+    if (m_ChangeSlot[node] != k_NoChangeSlot && m_ChangeListener != nullptr)
+        m_ChangeListener->OnTransformRemoved(m_ChangeSlot[node]);
+
+    // swap and pop, the moved node gets its new index written back
+    auto last = static_cast<NodeIndex>(m_Owner.size() - 1);
+    if (node != last)
+    {
+        m_Owner[node]       = m_Owner[last];
+        m_ParentIndex[node] = m_ParentIndex[last];
+        m_LocalTQS[node]    = m_LocalTQS[last];
+        m_WorldTQS[node]    = m_WorldTQS[last];
+        m_WorldMatrix[node] = m_WorldMatrix[last];
+        m_DirtyFlags[node]  = m_DirtyFlags[last];
+        m_ChangeSlot[node]  = m_ChangeSlot[last];
+
+        m_Owner[node]->m_HierarchyIndex = node;
+    }
+
+    m_Owner.pop_back();
+    m_ParentIndex.pop_back();
+    m_LocalTQS.pop_back();
+    m_WorldTQS.pop_back();
+    m_WorldMatrix.pop_back();
+    m_DirtyFlags.pop_back();
+    m_ChangeSlot.pop_back();
+
+    m_OrderDirty = true;
+}
+
+void TransformHierarchy::MarkDirty(NodeIndex node)
+{
+    // A node whose world TQS is dirty always has all its descendants dirty as well,
+    // so we can stop the push down as soon as we hit one.
+    if (m_DirtyFlags[node] & WorldTQSDirty)
+        return;
+
+    std::vector<NodeIndex>& stack = m_DirtyStack;
+    stack.clear();
+    stack.push_back(node);
+
+    while (!stack.empty())
+    {
+        NodeIndex current = stack.back();
+        stack.pop_back();
+
+        m_DirtyFlags[current] = AllDirty;
+        if (m_ChangeSlot[current] != k_NoChangeSlot && m_ChangeListener != nullptr)
+            m_ChangeListener->OnTransformChanged(m_ChangeSlot[current]);
+
+        for (const Transform* child : *m_Owner[current])
+        {
+            if (!(m_DirtyFlags[child->m_HierarchyIndex] & WorldTQSDirty))
+                stack.push_back(child->m_HierarchyIndex);
+        }
+    }
+}
+
+const TQS& TransformHierarchy::GetLocalToWorldTQS(NodeIndex node)
+{
+    if (m_DirtyFlags[node] & WorldTQSDirty)
+    {
+        // Do not rely on m_ParentIndex here, it might be stale until the next RebuildOrder
+        const Transform* parent = m_Owner[node]->m_Parent;
+        m_WorldTQS[node]        = parent == nullptr ?
+                                      m_LocalTQS[node] :
+                                      TQS::Mul(m_LocalTQS[node], GetLocalToWorldTQS(parent->m_HierarchyIndex));
+        m_DirtyFlags[node] &= ~WorldTQSDirty;
+    }
+    return m_WorldTQS[node];
+}
+
+const Matrix4x4& TransformHierarchy::GetLocalToWorldMatrix(NodeIndex node)
+{
+    if (m_DirtyFlags[node] & WorldMatrixDirty)
+    {
+        m_WorldMatrix[node] = GetLocalToWorldTQS(node).ToMatrix4x4();
+        m_DirtyFlags[node] &= ~WorldMatrixDirty;
+    }
+    return m_WorldMatrix[node];
+}
+
+void TransformHierarchy::UpdateWorldTransforms()
+{
+    if (m_OrderDirty)
+        RebuildOrder();
+
+    UpdateNodeRange(0, static_cast<NodeIndex>(m_Owner.size()));
+}
+
+void TransformHierarchy::UpdateWorldTransforms(JobSystem& jobSystem)
+{
+    if (m_OrderDirty)
+        RebuildOrder();
+
+    for (uint32_t level = 0; level < GetLevelCount(); ++level)
+    {
+        NodeIndex levelBegin = m_LevelOffsets[level];
+        NodeIndex levelEnd   = m_LevelOffsets[level + 1];
+
+        jobSystem.ParallelFor(levelEnd - levelBegin, k_NodesPerChunk, [this, levelBegin](uint32_t begin, uint32_t end)
+                               { UpdateNodeRange(levelBegin + begin, levelBegin + end); });
+    }
+}
+
+void TransformHierarchy::UpdateNodeRange(NodeIndex begin, NodeIndex end)
+{
+    for (NodeIndex node = begin; node < end; ++node)
+    {
+        if (m_DirtyFlags[node] != 0)
+            UpdateNode(node);
+    }
+}
+
+void TransformHierarchy::UpdateNode(NodeIndex node)
+{
+    // parents are stored before their children, so the parent is always up to date at this point
+    if (m_DirtyFlags[node] & WorldTQSDirty)
+    {
+        NodeIndex parent = m_ParentIndex[node];
+        m_WorldTQS[node] = parent == k_InvalidNode ?
+                               m_LocalTQS[node] :
+                               TQS::Mul(m_LocalTQS[node], m_WorldTQS[parent]);
+    }
+
+    m_WorldMatrix[node] = m_WorldTQS[node].ToMatrix4x4();
+    m_DirtyFlags[node]  = 0;
+}
+
+void TransformHierarchy::RebuildOrder()
+{
+    const auto nodeCount = static_cast<NodeIndex>(m_Owner.size());
+
+    // breadth first from every root gives us a depth sorted order with parents before children
+    std::vector<NodeIndex> order;
+    order.reserve(nodeCount);
+    for (NodeIndex node = 0; node < nodeCount; ++node)
+    {
+        if (m_Owner[node]->m_Parent == nullptr)
+            order.push_back(node);
+    }
+
+    m_LevelOffsets.clear();
+    m_LevelOffsets.push_back(0);
+
+    size_t levelBegin = 0;
+    while (levelBegin < order.size())
+    {
+        size_t levelEnd = order.size();
+        for (size_t i = levelBegin; i < levelEnd; ++i)
+        {
+            for (const Transform* child : *m_Owner[order[i]])
+                order.push_back(child->m_HierarchyIndex);
+        }
+        m_LevelOffsets.push_back(static_cast<uint32_t>(levelEnd));
+        levelBegin = levelEnd;
+    }
+
+    assert(order.size() == nodeCount && "Transform hierarchy contains nodes that are not reachable from a root");
+
+    std::vector<Transform*> owner(nodeCount);
+    std::vector<TQS> localTQS(nodeCount);
+    std::vector<TQS> worldTQS(nodeCount);
+    std::vector<Matrix4x4> worldMatrix(nodeCount);
+    std::vector<uint8_t> dirtyFlags(nodeCount);
+    std::vector<uint32_t> changeSlot(nodeCount);
+
+    for (NodeIndex newIndex = 0; newIndex < nodeCount; ++newIndex)
+    {
+        NodeIndex oldIndex = order[newIndex];
+
+        owner[newIndex]       = m_Owner[oldIndex];
+        localTQS[newIndex]    = m_LocalTQS[oldIndex];
+        worldTQS[newIndex]    = m_WorldTQS[oldIndex];
+        worldMatrix[newIndex] = m_WorldMatrix[oldIndex];
+        dirtyFlags[newIndex]  = m_DirtyFlags[oldIndex];
+        changeSlot[newIndex]  = m_ChangeSlot[oldIndex];
+
+        owner[newIndex]->m_HierarchyIndex = newIndex;
+    }
+
+    m_Owner       = std::move(owner);
+    m_LocalTQS    = std::move(localTQS);
+    m_WorldTQS    = std::move(worldTQS);
+    m_WorldMatrix = std::move(worldMatrix);
+    m_DirtyFlags  = std::move(dirtyFlags);
+    m_ChangeSlot  = std::move(changeSlot);
+
+    // the owners now carry their new indices, so the parent indices can be resolved directly
+    for (NodeIndex node = 0; node < nodeCount; ++node)
+    {
+        const Transform* parent = m_Owner[node]->m_Parent;
+        m_ParentIndex[node]     = parent == nullptr ? k_InvalidNode : parent->m_HierarchyIndex;
+    }
+
+    m_OrderDirty = false;
+}
+
+} // namespace gore
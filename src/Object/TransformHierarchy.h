@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Export.h"
+
+#include "Math/Types.h"
+#include "Math/TQS.h"
+
+#include <vector>
+
+namespace gore
+{
+
+class Transform;
+class JobSystem;
+
+// Told about the nodes that have a change slot, see TransformHierarchy::SetChangeSlot
+class TransformChangeListener
+{
+public:
+    virtual ~TransformChangeListener() = default;
+
+    // The world transform of the node is about to change, it is up to date again after UpdateWorldTransforms
+    virtual void OnTransformChanged(uint32_t changeSlot) = 0;
+    // The transform is being destroyed
+    virtual void OnTransformRemoved(uint32_t changeSlot) = 0;
+};
+
+// Flat storage for every Transform in the engine.
+// Nodes are kept in structure-of-arrays form and sorted by hierarchy depth, so that a parent
+// always comes before its children and the world transforms can be refreshed in one linear pass.
+// Each node caches its local-to-world TQS and matrix, which are only recomputed when the node
+// (or one of its ancestors) is marked dirty.
+ENGINE_CLASS(TransformHierarchy) final
+{
+public:
+    using NodeIndex = uint32_t;
+    static constexpr NodeIndex k_InvalidNode = ~0u;
+    static constexpr uint32_t k_NoChangeSlot = ~0u;
+
+    NON_COPYABLE(TransformHierarchy);
+
+    TransformHierarchy();
+    ~TransformHierarchy();
+
+    [[nodiscard]] static TransformHierarchy& Get();
+
+public:
+    NodeIndex AddNode(Transform * owner);
+    void RemoveNode(NodeIndex node);
+
+    // Must be called whenever the parent of a node changes, the depth order is rebuilt lazily.
+    void MarkHierarchyChanged() { m_OrderDirty = true; }
+
+    // Marks the node and all of its descendants as dirty.
+    void MarkDirty(NodeIndex node);
+
+    [[nodiscard]] const TQS& GetLocalTQS(NodeIndex node) const { return m_LocalTQS[node]; }
+    void SetLocalTQS(NodeIndex node, const TQS& tqs)
+    {
+        m_LocalTQS[node] = tqs;
+        MarkDirty(node);
+    }
+
+    // Lazily resolves a dirty node by walking up until a clean ancestor is found.
+    [[nodiscard]] const TQS& GetLocalToWorldTQS(NodeIndex node);
+    [[nodiscard]] const Matrix4x4& GetLocalToWorldMatrix(NodeIndex node);
+
+    // Brings every world transform up to date in a single pass over the depth sorted arrays.
+    void UpdateWorldTransforms();
+    // Same as above, but each depth level is split in chunks that are updated on the job system.
+    // Levels are processed in order, nodes within a level only read their parent so no locking is needed.
+    void UpdateWorldTransforms(JobSystem & jobSystem);
+
+    // A node with a change slot reports to the change listener whenever it or one of its ancestors is marked dirty,
+    // so a system can track the transforms it cares about by its own slot instead of looking at all of them
+    void SetChangeListener(TransformChangeListener * listener) { m_ChangeListener = listener; }
+    void SetChangeSlot(NodeIndex node, uint32_t changeSlot) { m_ChangeSlot[node] = changeSlot; }
+    [[nodiscard]] uint32_t GetChangeSlot(NodeIndex node) const { return m_ChangeSlot[node]; }
+
+    [[nodiscard]] uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_Owner.size()); }
+    [[nodiscard]] uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_LevelOffsets.size()) - 1; }
+
+private:
+    enum DirtyFlags : uint8_t
+    {
+        WorldTQSDirty    = 1 << 0,
+        WorldMatrixDirty = 1 << 1,
+        AllDirty         = WorldTQSDirty | WorldMatrixDirty
+    };
+
+    static constexpr uint32_t k_NodesPerChunk = 2048;
+
+    void RebuildOrder();
+    void UpdateNodeRange(NodeIndex begin, NodeIndex end);
+    void UpdateNode(NodeIndex node);
+
+private:
+    // owner, for write back of the node index when the order changes
+    std::vector<Transform*> m_Owner;
+    std::vector<NodeIndex> m_ParentIndex;
+
+    std::vector<TQS> m_LocalTQS;
+    std::vector<TQS> m_WorldTQS;
+    std::vector<Matrix4x4> m_WorldMatrix;
+    std::vector<uint8_t> m_DirtyFlags;
+    std::vector<uint32_t> m_ChangeSlot;
+
+    TransformChangeListener* m_ChangeListener;
+
+    // m_LevelOffsets[d] is the first node at depth d, the last element is the node count
+    std::vector<uint32_t> m_LevelOffsets;
+    // m_ParentIndex and m_LevelOffsets are only valid while the order is clean
+    bool m_OrderDirty;
+
+    // scratch for MarkDirty, kept so pushing dirty flags down does not allocate
+    std::vector<NodeIndex> m_DirtyStack;
+};
+
+} // namespace gore
@@ -0,0 +1,176 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Core/JobSystem.h"
+#include "Object/GameObject.h"
+#include "Object/Transform.h"
+#include "Object/TransformHierarchy.h"
+#include "Scene/Scene.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace gore::test
+{
+
+// The old per query parent chain walk, kept here as the reference and the baseline for the benchmark
+static TQS WalkParentChain(const Transform* transform)
+{
+    TQS result = transform->GetLocalTQS();
+    for (const Transform* current = transform->GetParent(); current != nullptr; current = current->GetParent())
+        result = TQS::Mul(result, current->GetLocalTQS());
+    return result;
+}
+
+static bool ApproxEqual(const Vector3& a, const Vector3& b)
+{
+    constexpr float epsilon = 1e-3f;
+    return std::abs(a.x - b.x) < epsilon && std::abs(a.y - b.y) < epsilon && std::abs(a.z - b.z) < epsilon;
+}
+
+// Builds nodeCount / depth chains, each of them depth levels deep
+static std::vector<Transform*> BuildChains(Scene& scene, int nodeCount, int depth)
+{
+    std::vector<Transform*> transforms;
+    transforms.reserve(nodeCount);
+
+    for (int i = 0; i < nodeCount; ++i)
+    {
+        Transform* transform = scene.NewObject()->GetTransform();
+        transform->SetLocalPosition(Vector3(1.0f, static_cast<float>(i % 7), 0.5f));
+        transform->SetLocalRotation(Quaternion::FromAxisAngle(Vector3::Up, 0.1f * static_cast<float>(i % 5)));
+
+        if (i % depth != 0)
+            transform->SetParent(transforms.back(), false);
+
+        transforms.push_back(transform);
+    }
+
+    return transforms;
+}
+
+TEST_CASE("World transforms match the parent chain walk", "[TransformHierarchy]")
+{
+    Scene scene("TransformHierarchyTest");
+    auto transforms = BuildChains(scene, 64, 8);
+
+    SECTION("Lazy query")
+    {
+        for (auto* transform : transforms)
+            REQUIRE(ApproxEqual(transform->GetWorldPosition(), WalkParentChain(transform).t));
+    }
+
+    SECTION("Linear update")
+    {
+        TransformHierarchy::Get().UpdateWorldTransforms();
+        for (auto* transform : transforms)
+            REQUIRE(ApproxEqual(transform->GetWorldPosition(), WalkParentChain(transform).t));
+    }
+
+    SECTION("Dirty flag is pushed down to children")
+    {
+        TransformHierarchy::Get().UpdateWorldTransforms();
+        transforms[0]->SetLocalPosition(Vector3(10.0f, 0.0f, 0.0f));
+
+        TransformHierarchy::Get().UpdateWorldTransforms();
+        for (auto* transform : transforms)
+            REQUIRE(ApproxEqual(transform->GetWorldPosition(), WalkParentChain(transform).t));
+    }
+
+    SECTION("Reparent and destroy")
+    {
+        TransformHierarchy::Get().UpdateWorldTransforms();
+        transforms[3]->SetParent(transforms[12], false);
+        transforms[20]->GetGameObject()->Destroy();
+        transforms.erase(transforms.begin() + 20, transforms.begin() + 24);
+
+        TransformHierarchy::Get().UpdateWorldTransforms();
+        for (auto* transform : transforms)
+            REQUIRE(ApproxEqual(transform->GetWorldPosition(), WalkParentChain(transform).t));
+    }
+}
+
+TEST_CASE("Parallel update matches the linear update", "[TransformHierarchy]")
+{
+    Scene scene("TransformHierarchyParallelTest");
+    auto transforms = BuildChains(scene, 20000, 6);
+
+    JobSystem jobSystem(3);
+    TransformHierarchy::Get().UpdateWorldTransforms(jobSystem);
+    for (auto* transform : transforms)
+        REQUIRE(ApproxEqual(transform->GetWorldPosition(), WalkParentChain(transform).t));
+
+    transforms[0]->SetLocalPosition(Vector3(-4.0f, 2.0f, 0.0f));
+    transforms[6000]->SetParent(transforms[1], false);
+
+    TransformHierarchy::Get().UpdateWorldTransforms(jobSystem);
+    for (auto* transform : transforms)
+        REQUIRE(ApproxEqual(transform->GetWorldPosition(), WalkParentChain(transform).t));
+}
+
+TEST_CASE("Transform hierarchy benchmark", "[TransformHierarchy][.benchmark]")
+{
+    constexpr int nodeCount = 100000;
+
+    for (int depth : {1, 2, 4, 8, 16})
+    {
+        Scene scene("TransformHierarchyBenchmark");
+        auto transforms = BuildChains(scene, nodeCount, depth);
+        TransformHierarchy& hierarchy = TransformHierarchy::Get();
+
+        BENCHMARK("Pointer chasing, depth " + std::to_string(depth))
+        {
+            float sum = 0.0f;
+            for (auto* transform : transforms)
+                sum += WalkParentChain(transform).t.x;
+            return sum;
+        };
+
+        BENCHMARK("Linear update, depth " + std::to_string(depth))
+        {
+            // every root moves, which makes the whole hierarchy dirty
+            for (int i = 0; i < nodeCount; i += depth)
+                transforms[i]->SetLocalPosition(Vector3(static_cast<float>(i), 0.0f, 0.0f));
+
+            hierarchy.UpdateWorldTransforms();
+
+            float sum = 0.0f;
+            for (auto* transform : transforms)
+                sum += transform->GetWorldPosition().x;
+            return sum;
+        };
+    }
+}
+
+TEST_CASE("Parallel transform update scaling", "[TransformHierarchy][.benchmark]")
+{
+    constexpr int nodeCount = 200000;
+    constexpr int depth     = 8;
+
+    Scene scene("TransformHierarchyScaling");
+    auto transforms = BuildChains(scene, nodeCount, depth);
+    TransformHierarchy& hierarchy = TransformHierarchy::Get();
+
+    uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        // the calling thread works as well
+        JobSystem jobSystem(threads - 1);
+
+        BENCHMARK("Parallel update, " + std::to_string(threads) + " threads")
+        {
+            for (int i = 0; i < nodeCount; i += depth)
+                transforms[i]->SetLocalPosition(Vector3(static_cast<float>(i), 0.0f, 0.0f));
+
+            hierarchy.UpdateWorldTransforms(jobSystem);
+            return hierarchy.GetNodeCount();
+        };
+    }
+}
+
+} // namespace gore::test
+#endif
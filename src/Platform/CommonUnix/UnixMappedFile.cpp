@@ -0,0 +1,46 @@
+#include "Prefix.h"
+
+#include "Platform/MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gore
+{
+
+MappedFile MapFile(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return {};
+
+    MappedFile file;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+    {
+        void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            file.data = data;
+            file.size = static_cast<size_t>(fileStat.st_size);
+        }
+    }
+
+    // the mapping stays valid without the descriptor
+    close(fd);
+
+    return file;
+}
+
+void UnmapFile(MappedFile& file)
+{
+    if (file.data != nullptr)
+        munmap(const_cast<void*>(file.data), file.size);
+
+    file = {};
+}
+
+} // namespace gore
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+namespace gore
+{
+
+// A read only view of a whole file, data is nullptr when the file could not be mapped
+struct MappedFile
+{
+    const void* data = nullptr;
+    size_t size      = 0;
+    void* handle     = nullptr;
+};
+
+MappedFile MapFile(const char* path);
+void UnmapFile(MappedFile& file);
+
+}
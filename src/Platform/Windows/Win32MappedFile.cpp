@@ -0,0 +1,55 @@
+#include "Prefix.h"
+
+#include "Platform/MappedFile.h"
+
+#include <windows.h>
+
+namespace gore
+{
+
+MappedFile MapFile(const char* path)
+{
+    HANDLE fileHandle = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return {};
+
+    MappedFile file;
+
+    LARGE_INTEGER fileSize;
+    if (::GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+    {
+        HANDLE mappingHandle = ::CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle != nullptr)
+        {
+            void* data = ::MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+            if (data != nullptr)
+            {
+                file.data   = data;
+                file.size   = static_cast<size_t>(fileSize.QuadPart);
+                file.handle = mappingHandle;
+            }
+            else
+            {
+                ::CloseHandle(mappingHandle);
+            }
+        }
+    }
+
+    // the mapping keeps the file open
+    ::CloseHandle(fileHandle);
+
+    return file;
+}
+
+void UnmapFile(MappedFile& file)
+{
+    if (file.data != nullptr)
+    {
+        ::UnmapViewOfFile(file.data);
+        ::CloseHandle(reinterpret_cast<HANDLE>(file.handle));
+    }
+
+    file = {};
+}
+
+} // namespace gore
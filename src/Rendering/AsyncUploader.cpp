@@ -0,0 +1,382 @@
+#include "AsyncUploader.h"
+
+#include "Graphics/Device.h"
+
+#include "Rendering/RenderContext.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace gore::gfx
+{
+// texel data of every format the textures use starts at a multiple of this in the staging buffer
+static constexpr uint32_t k_StagingAlignment = 16;
+
+static uint32_t AlignUp(uint32_t value, uint32_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static vk::ImageMemoryBarrier GetImageBarrier(vk::Image image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+                                              vk::AccessFlags srcAccessMask, vk::AccessFlags dstAccessMask,
+                                              uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED)
+{
+    vk::ImageMemoryBarrier imageBarrier;
+    imageBarrier.srcAccessMask       = srcAccessMask;
+    imageBarrier.dstAccessMask       = dstAccessMask;
+    imageBarrier.oldLayout           = oldLayout;
+    imageBarrier.newLayout           = newLayout;
+    imageBarrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+    imageBarrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+    imageBarrier.image               = image;
+    imageBarrier.subresourceRange    = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+    return imageBarrier;
+}
+
+static vk::BufferMemoryBarrier GetBufferBarrier(vk::Buffer buffer, vk::AccessFlags srcAccessMask, vk::AccessFlags dstAccessMask,
+                                                uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED)
+{
+    return vk::BufferMemoryBarrier(srcAccessMask, dstAccessMask, srcQueueFamilyIndex, dstQueueFamilyIndex, buffer, 0, VK_WHOLE_SIZE);
+}
+
+static vk::Semaphore CreateTimelineSemaphore(const Device& device, const char* name)
+{
+    vk::SemaphoreTypeCreateInfo timelineCreateInfo(vk::SemaphoreType::eTimeline, 0);
+    vk::SemaphoreCreateInfo createInfo({}, &timelineCreateInfo);
+
+    vk::Semaphore semaphore = (*device.Get()).createSemaphore(createInfo);
+    device.SetName(reinterpret_cast<uint64_t>(static_cast<VkSemaphore>(semaphore)), vk::ObjectType::eSemaphore, name);
+    return semaphore;
+}
+
+AsyncUploader::AsyncUploader(RenderContext& renderContext, const Device& device, const AsyncUploaderDesc& desc) :
+    m_RenderContext(renderContext),
+    m_Device(device),
+    m_Desc(desc),
+    m_TransferQueue(VK_NULL_HANDLE),
+    m_GraphicsQueue(VK_NULL_HANDLE),
+    m_TransferCommandPool(VK_NULL_HANDLE),
+    m_GraphicsCommandPool(VK_NULL_HANDLE),
+    m_TransferSemaphore(VK_NULL_HANDLE),
+    m_AcquireSemaphore(VK_NULL_HANDLE),
+    m_TransferValue(0),
+    m_AcquireValue(0),
+    m_AcquiredTransferValue(0),
+    m_RequestMutex(),
+    m_TextureRequests(),
+    m_BufferRequests(),
+    m_PendingTextures(),
+    m_Batches(),
+    m_Acquires(),
+    m_UploadedByteSize(0)
+{
+    vk::Device vkDevice = *m_Device.Get();
+
+    // the first queue of each family, the same ones the renderer submits to
+    m_TransferQueue = vkDevice.getQueue(desc.transferQueueFamilyIndex, 0);
+    m_GraphicsQueue = vkDevice.getQueue(desc.graphicsQueueFamilyIndex, 0);
+
+    m_TransferCommandPool = vkDevice.createCommandPool({vk::CommandPoolCreateFlagBits::eTransient, desc.transferQueueFamilyIndex});
+    m_GraphicsCommandPool = vkDevice.createCommandPool({vk::CommandPoolCreateFlagBits::eTransient, desc.graphicsQueueFamilyIndex});
+
+    m_TransferSemaphore = CreateTimelineSemaphore(m_Device, "AsyncUploader Transfer");
+    m_AcquireSemaphore  = CreateTimelineSemaphore(m_Device, "AsyncUploader Acquire");
+}
+
+AsyncUploader::~AsyncUploader()
+{
+    Flush();
+
+    vk::Device vkDevice = *m_Device.Get();
+    vkDevice.destroyCommandPool(m_TransferCommandPool);
+    vkDevice.destroyCommandPool(m_GraphicsCommandPool);
+    vkDevice.destroySemaphore(m_TransferSemaphore);
+    vkDevice.destroySemaphore(m_AcquireSemaphore);
+}
+
+void AsyncUploader::UploadTexture(TextureHandle handle, std::vector<uint8_t>&& data)
+{
+    assert(data.empty() == false);
+
+    std::lock_guard<std::mutex> lock(m_RequestMutex);
+
+    m_TextureRequests.push_back({handle, std::move(data)});
+    m_PendingTextures.push_back(handle);
+}
+
+uint64_t AsyncUploader::UploadBuffer(BufferHandle handle, std::vector<uint8_t>&& data, uint32_t dstOffset)
+{
+    assert(data.empty() == false);
+
+    std::lock_guard<std::mutex> lock(m_RequestMutex);
+
+    m_BufferRequests.push_back({handle, dstOffset, std::move(data)});
+
+    // goes out with the next batch
+    return m_TransferValue + 1;
+}
+
+bool AsyncUploader::IsResident(TextureHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_RequestMutex);
+
+    return std::find(m_PendingTextures.begin(), m_PendingTextures.end(), handle) == m_PendingTextures.end();
+}
+
+uint32_t AsyncUploader::GetPendingTextureCount() const
+{
+    std::lock_guard<std::mutex> lock(m_RequestMutex);
+
+    return static_cast<uint32_t>(m_PendingTextures.size());
+}
+
+bool AsyncUploader::Update()
+{
+    vk::Device vkDevice = *m_Device.Get();
+
+    // polled, the frame never waits for the transfer queue
+    bool becameResident = AcquireBatches(vkDevice.getSemaphoreCounterValue(m_TransferSemaphore));
+    FreeAcquires(vkDevice.getSemaphoreCounterValue(m_AcquireSemaphore));
+
+    std::vector<TextureRequest> textureRequests;
+    std::vector<BufferRequest> bufferRequests;
+    uint64_t transferValue = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_RequestMutex);
+        if (m_TextureRequests.empty() && m_BufferRequests.empty())
+            return becameResident;
+
+        textureRequests.swap(m_TextureRequests);
+        bufferRequests.swap(m_BufferRequests);
+        transferValue = ++m_TransferValue;
+    }
+
+    SubmitBatch(transferValue, textureRequests, bufferRequests);
+
+    return becameResident;
+}
+
+void AsyncUploader::Flush()
+{
+    vk::Device vkDevice = *m_Device.Get();
+
+    uint64_t transferValue = m_TransferValue;
+    VK_CHECK_RESULT(vkDevice.waitSemaphores(vk::SemaphoreWaitInfo({}, 1, &m_TransferSemaphore, &transferValue), UINT64_MAX));
+    AcquireBatches(transferValue);
+
+    VK_CHECK_RESULT(vkDevice.waitSemaphores(vk::SemaphoreWaitInfo({}, 1, &m_AcquireSemaphore, &m_AcquireValue), UINT64_MAX));
+    FreeAcquires(m_AcquireValue);
+}
+
+void AsyncUploader::SubmitBatch(uint64_t transferValue, std::vector<TextureRequest>& textureRequests, std::vector<BufferRequest>& bufferRequests)
+{
+    const bool transfersOwnership = m_Desc.transferQueueFamilyIndex != m_Desc.graphicsQueueFamilyIndex;
+
+    // every request back to back in a staging buffer of the batch
+    uint32_t byteSize = 0;
+    for (const TextureRequest& request : textureRequests)
+        byteSize = AlignUp(byteSize, k_StagingAlignment) + static_cast<uint32_t>(request.data.size());
+    for (const BufferRequest& request : bufferRequests)
+        byteSize = AlignUp(byteSize, k_StagingAlignment) + static_cast<uint32_t>(request.data.size());
+
+    Batch batch;
+    batch.transferValue = transferValue;
+    batch.stagingBuffer = m_RenderContext.CreateBuffer({
+        .debugName = "AsyncUploader Staging Buffer",
+        .byteSize  = byteSize,
+        .usage     = BufferUsage::TransferSrc,
+        .memUsage  = MemoryUsage::CPU_TO_GPU,
+    });
+
+    const Buffer& stagingBuffer = m_RenderContext.GetBuffer(batch.stagingBuffer);
+    uint8_t* mappedData         = static_cast<uint8_t*>(MapVulkanBuffer(stagingBuffer));
+
+    vk::Device vkDevice = *m_Device.Get();
+    batch.commandBuffer = vkDevice.allocateCommandBuffers({m_TransferCommandPool, vk::CommandBufferLevel::ePrimary, 1})[0];
+    batch.commandBuffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+
+    std::vector<vk::ImageMemoryBarrier> imageBarriers;
+    for (const TextureRequest& request : textureRequests)
+    {
+        vk::Image image = m_RenderContext.GetTexture(request.handle).image;
+        batch.images.push_back(image);
+        batch.textures.push_back(request.handle);
+        imageBarriers.push_back(GetImageBarrier(image, vk::ImageLayout::ePreinitialized, vk::ImageLayout::eTransferDstOptimal, {}, vk::AccessFlagBits::eTransferWrite));
+    }
+
+    batch.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, imageBarriers);
+
+    uint32_t stagingOffset = 0;
+    for (const TextureRequest& request : textureRequests)
+    {
+        const TextureDesc& textureDesc = m_RenderContext.GetTextureDesc(request.handle);
+
+        stagingOffset = AlignUp(stagingOffset, k_StagingAlignment);
+        memcpy(mappedData + stagingOffset, request.data.data(), request.data.size());
+
+        vk::BufferImageCopy region(stagingOffset, 0, 0,
+                                   vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+                                   vk::Offset3D(0, 0, 0),
+                                   vk::Extent3D(textureDesc.width, textureDesc.height, 1));
+        batch.commandBuffer.copyBufferToImage(stagingBuffer.vkBuffer, m_RenderContext.GetTexture(request.handle).image, vk::ImageLayout::eTransferDstOptimal, region);
+
+        stagingOffset += static_cast<uint32_t>(request.data.size());
+    }
+
+    for (const BufferRequest& request : bufferRequests)
+    {
+        vk::Buffer buffer = m_RenderContext.GetBuffer(request.handle).vkBuffer;
+        if (std::find(batch.buffers.begin(), batch.buffers.end(), buffer) == batch.buffers.end())
+            batch.buffers.push_back(buffer);
+
+        stagingOffset = AlignUp(stagingOffset, k_StagingAlignment);
+        memcpy(mappedData + stagingOffset, request.data.data(), request.data.size());
+
+        batch.commandBuffer.copyBuffer(stagingBuffer.vkBuffer, buffer, vk::BufferCopy(stagingOffset, request.dstOffset, request.data.size()));
+
+        stagingOffset += static_cast<uint32_t>(request.data.size());
+    }
+
+    FlushVulkanBuffer(stagingBuffer, byteSize);
+    UnmapVulkanBuffer(stagingBuffer);
+
+    // released to the graphics queue family, AcquireBatches records the other half with the same layouts
+    std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+    imageBarriers.clear();
+    for (vk::Image image : batch.images)
+    {
+        if (transfersOwnership)
+            imageBarriers.push_back(GetImageBarrier(image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                                    vk::AccessFlagBits::eTransferWrite, {}, m_Desc.transferQueueFamilyIndex, m_Desc.graphicsQueueFamilyIndex));
+        else
+            imageBarriers.push_back(GetImageBarrier(image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                                    vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead));
+    }
+    for (vk::Buffer buffer : batch.buffers)
+    {
+        if (transfersOwnership)
+            bufferBarriers.push_back(GetBufferBarrier(buffer, vk::AccessFlagBits::eTransferWrite, {}, m_Desc.transferQueueFamilyIndex, m_Desc.graphicsQueueFamilyIndex));
+        else
+            bufferBarriers.push_back(GetBufferBarrier(buffer, vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead));
+    }
+
+    batch.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                        transfersOwnership ? vk::PipelineStageFlagBits::eBottomOfPipe : vk::PipelineStageFlagBits::eAllCommands,
+                                        {}, {}, bufferBarriers, imageBarriers);
+    batch.commandBuffer.end();
+
+    vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo;
+    timelineSubmitInfo.signalSemaphoreValueCount = 1;
+    timelineSubmitInfo.pSignalSemaphoreValues    = &transferValue;
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.pNext                = &timelineSubmitInfo;
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.pCommandBuffers      = &batch.commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &m_TransferSemaphore;
+
+    VK_CHECK_RESULT(m_TransferQueue.submit(1, &submitInfo, VK_NULL_HANDLE));
+
+    m_UploadedByteSize += byteSize;
+    m_Batches.push_back(std::move(batch));
+}
+
+bool AsyncUploader::AcquireBatches(uint64_t completedTransferValue)
+{
+    // batches are submitted in order of their value
+    size_t completedCount = 0;
+    while (completedCount < m_Batches.size() && m_Batches[completedCount].transferValue <= completedTransferValue)
+        completedCount++;
+
+    if (completedCount == 0)
+        return false;
+
+    vk::Device vkDevice = *m_Device.Get();
+
+    Acquire acquire;
+    acquire.acquireValue = ++m_AcquireValue;
+
+    // with a single queue family there is no ownership to take, the submit only orders the graphics queue after
+    // the transfers
+    if (m_Desc.transferQueueFamilyIndex != m_Desc.graphicsQueueFamilyIndex)
+    {
+        std::vector<vk::ImageMemoryBarrier> imageBarriers;
+        std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+        for (size_t i = 0; i < completedCount; ++i)
+        {
+            for (vk::Image image : m_Batches[i].images)
+                imageBarriers.push_back(GetImageBarrier(image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                                        {}, vk::AccessFlagBits::eShaderRead, m_Desc.transferQueueFamilyIndex, m_Desc.graphicsQueueFamilyIndex));
+            for (vk::Buffer buffer : m_Batches[i].buffers)
+                bufferBarriers.push_back(GetBufferBarrier(buffer, {}, vk::AccessFlagBits::eMemoryRead, m_Desc.transferQueueFamilyIndex, m_Desc.graphicsQueueFamilyIndex));
+        }
+
+        acquire.commandBuffer = vkDevice.allocateCommandBuffers({m_GraphicsCommandPool, vk::CommandBufferLevel::ePrimary, 1})[0];
+        acquire.commandBuffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+        acquire.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands, {}, {}, bufferBarriers, imageBarriers);
+        acquire.commandBuffer.end();
+    }
+
+    uint64_t waitValue               = m_Batches[completedCount - 1].transferValue;
+    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+
+    vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo;
+    timelineSubmitInfo.waitSemaphoreValueCount   = 1;
+    timelineSubmitInfo.pWaitSemaphoreValues      = &waitValue;
+    timelineSubmitInfo.signalSemaphoreValueCount = 1;
+    timelineSubmitInfo.pSignalSemaphoreValues    = &acquire.acquireValue;
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.pNext                = &timelineSubmitInfo;
+    submitInfo.waitSemaphoreCount   = 1;
+    submitInfo.pWaitSemaphores      = &m_TransferSemaphore;
+    submitInfo.pWaitDstStageMask    = &waitStage;
+    submitInfo.commandBufferCount   = acquire.commandBuffer ? 1 : 0;
+    submitInfo.pCommandBuffers      = &acquire.commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &m_AcquireSemaphore;
+
+    VK_CHECK_RESULT(m_GraphicsQueue.submit(1, &submitInfo, VK_NULL_HANDLE));
+    m_Acquires.push_back(acquire);
+
+    // the transfer queue is done with them, only the acquire is left for the graphics queue
+    bool becameResident = false;
+    {
+        std::lock_guard<std::mutex> lock(m_RequestMutex);
+        for (size_t i = 0; i < completedCount; ++i)
+        {
+            for (TextureHandle texture : m_Batches[i].textures)
+                std::erase(m_PendingTextures, texture);
+            becameResident |= !m_Batches[i].textures.empty();
+        }
+    }
+
+    for (size_t i = 0; i < completedCount; ++i)
+    {
+        vkDevice.freeCommandBuffers(m_TransferCommandPool, m_Batches[i].commandBuffer);
+        m_RenderContext.DestroyBuffer(m_Batches[i].stagingBuffer);
+    }
+    m_Batches.erase(m_Batches.begin(), m_Batches.begin() + completedCount);
+
+    m_AcquiredTransferValue.store(waitValue, std::memory_order_release);
+
+    return becameResident;
+}
+
+void AsyncUploader::FreeAcquires(uint64_t completedAcquireValue)
+{
+    vk::Device vkDevice = *m_Device.Get();
+
+    std::erase_if(m_Acquires, [&vkDevice, this, completedAcquireValue](const Acquire& acquire)
+    {
+        if (acquire.acquireValue > completedAcquireValue)
+            return false;
+
+        if (acquire.commandBuffer)
+            vkDevice.freeCommandBuffers(m_GraphicsCommandPool, acquire.commandBuffer);
+        return true;
+    });
+}
+} // namespace gore::gfx
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Prefix.h"
+#include "Export.h"
+
+#include "Rendering/Buffer.h"
+#include "Rendering/Texture.h"
+
+#include "Graphics/Vulkan/VulkanIncludes.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace gore::gfx
+{
+class Device;
+class RenderContext;
+
+struct AsyncUploaderDesc final
+{
+    uint32_t transferQueueFamilyIndex = 0;
+    uint32_t graphicsQueueFamilyIndex = 0;
+};
+
+// Uploads textures and buffers on the transfer queue without a frame waiting for them. Requests can be made from any
+// thread, Update submits what was requested since the last call as one batch with a staging buffer of its own. The
+// batch hands what it wrote over to the graphics queue family and signals a timeline semaphore; once the CPU sees it
+// is done, the graphics queue takes the ownership in a submit that waits on the same value. Textures are resident
+// from then on, the RenderContext binds its fallback texture in their place until then.
+ENGINE_CLASS(AsyncUploader) final
+{
+public:
+    AsyncUploader(RenderContext& renderContext, const Device& device, const AsyncUploaderDesc& desc);
+    ~AsyncUploader();
+
+    NON_COPYABLE(AsyncUploader);
+
+    // The texture has to be created without data, it stays in the preinitialized layout until the upload
+    void UploadTexture(TextureHandle handle, std::vector<uint8_t>&& data);
+    // The graphics queue must not use the buffer before IsComplete returns true for the returned ticket
+    uint64_t UploadBuffer(BufferHandle handle, std::vector<uint8_t>&& data, uint32_t dstOffset = 0);
+
+    // Once per frame on the render thread, returns true when textures became resident
+    bool Update();
+    // Waits for every batch and takes them over, only when the GPU is about to be idle anyway
+    void Flush();
+
+    [[nodiscard]] bool IsResident(TextureHandle handle) const;
+    [[nodiscard]] bool IsComplete(uint64_t ticket) const { return m_AcquiredTransferValue.load(std::memory_order_acquire) >= ticket; }
+    [[nodiscard]] uint32_t GetPendingTextureCount() const;
+    [[nodiscard]] uint64_t GetUploadedByteSize() const { return m_UploadedByteSize; }
+
+private:
+    struct TextureRequest
+    {
+        TextureHandle handle;
+        std::vector<uint8_t> data;
+    };
+
+    struct BufferRequest
+    {
+        BufferHandle handle;
+        uint32_t dstOffset = 0;
+        std::vector<uint8_t> data;
+    };
+
+    struct Batch
+    {
+        uint64_t transferValue = 0;
+        vk::CommandBuffer commandBuffer;
+        BufferHandle stagingBuffer;
+        std::vector<vk::Image> images;
+        std::vector<vk::Buffer> buffers;
+        std::vector<TextureHandle> textures;
+    };
+
+    struct Acquire
+    {
+        uint64_t acquireValue = 0;
+        vk::CommandBuffer commandBuffer;
+    };
+
+    void SubmitBatch(uint64_t transferValue, std::vector<TextureRequest>& textureRequests, std::vector<BufferRequest>& bufferRequests);
+    bool AcquireBatches(uint64_t completedTransferValue);
+    void FreeAcquires(uint64_t completedAcquireValue);
+
+    RenderContext& m_RenderContext;
+    const Device& m_Device;
+    AsyncUploaderDesc m_Desc;
+
+    vk::Queue m_TransferQueue;
+    vk::Queue m_GraphicsQueue;
+    vk::CommandPool m_TransferCommandPool;
+    vk::CommandPool m_GraphicsCommandPool;
+
+    // counts the batches copied on the transfer queue and the submits taking them over on the graphics queue
+    vk::Semaphore m_TransferSemaphore;
+    vk::Semaphore m_AcquireSemaphore;
+    uint64_t m_TransferValue;
+    uint64_t m_AcquireValue;
+    std::atomic<uint64_t> m_AcquiredTransferValue;
+
+    mutable std::mutex m_RequestMutex;
+    std::vector<TextureRequest> m_TextureRequests;
+    std::vector<BufferRequest> m_BufferRequests;
+    std::vector<TextureHandle> m_PendingTextures;
+
+    std::vector<Batch> m_Batches;
+    std::vector<Acquire> m_Acquires;
+
+    uint64_t m_UploadedByteSize;
+};
+} // namespace gore::gfx
@@ -84,4 +84,9 @@ struct BindGroup final
 };
 
 using BindGroupHandle = Handle<BindGroup>;
+
+inline vk::DescriptorSet GetNativeHandle(const BindGroup& bindGroup)
+{
+    return bindGroup.set;
+}
 } // namespace gore::gfx
\ No newline at end of file
@@ -17,11 +17,9 @@ bool IsMappableVulkanBuffer(const Buffer& buffer)
 
 void* MapVulkanBuffer(const Buffer& buffer)
 {
-    if (IsMappableVulkanBuffer(buffer))
-    {
-        assert(buffer.vmaAllocationInfo.pMappedData != nullptr);
+    // host visible buffers are only mapped for good when they were created with VMA_ALLOCATION_CREATE_MAPPED_BIT
+    if (buffer.vmaAllocationInfo.pMappedData != nullptr)
         return buffer.vmaAllocationInfo.pMappedData;
-    }
 
     void* data;
     vmaMapMemory(buffer.vmaAllocator, buffer.vmaAllocation, &data);
@@ -30,7 +28,8 @@ void* MapVulkanBuffer(const Buffer& buffer)
 
 void UnmapVulkanBuffer(const Buffer& buffer)
 {
-    vmaUnmapMemory(buffer.vmaAllocator, buffer.vmaAllocation);
+    if (buffer.vmaAllocationInfo.pMappedData == nullptr)
+        vmaUnmapMemory(buffer.vmaAllocator, buffer.vmaAllocation);
 }
 
 void FlushVulkanBuffer(const Buffer& buffer, const uint32_t size = 0)
@@ -29,6 +29,11 @@ struct Buffer
 
 using BufferHandle = Handle<Buffer>;
 
+inline VkBuffer GetNativeHandle(const Buffer& buffer)
+{
+    return buffer.vkBuffer;
+}
+
 void ClearVulkanBuffer(VmaAllocator allocator, VkBuffer buffer, VmaAllocation allocation);
 
 bool IsMappableVulkanBuffer(const Buffer& buffer);
@@ -0,0 +1,169 @@
+#include "BufferArena.h"
+
+#include "Rendering/RenderContext.h"
+
+#include "Memory/OffsetAllocatorDefragmentation.h"
+
+#include <cassert>
+
+namespace gore::gfx
+{
+BufferArena::BufferArena(RenderContext* renderContext, const BufferArenaDesc& desc) :
+    m_RenderContext(renderContext),
+    m_Desc(desc),
+    m_BlockUnitCount(desc.blockByteSize / desc.alignment),
+    m_Blocks(),
+    m_AllocationCount(0),
+    m_AllocatedByteSize(0),
+    m_DefragmentationPending(false)
+{
+    assert(desc.alignment > 0 && m_BlockUnitCount > 0);
+}
+
+BufferArena::~BufferArena()
+{
+    for (Block& block : m_Blocks)
+    {
+        DestroyBlockBuffer(block.buffer);
+    }
+}
+
+BufferHandle BufferArena::CreateBlockBuffer(uint32_t byteSize)
+{
+    if (m_RenderContext == nullptr)
+        return {};
+
+    return m_RenderContext->CreateBuffer({
+        .debugName = m_Desc.debugName,
+        .byteSize  = byteSize,
+        .usage     = m_Desc.usage,
+        .memUsage  = MemoryUsage::GPU,
+    });
+}
+
+void BufferArena::DestroyBlockBuffer(BufferHandle buffer)
+{
+    if (m_RenderContext != nullptr && buffer.empty() == false)
+        m_RenderContext->DestroyBuffer(buffer);
+}
+
+BufferRange BufferArena::Allocate(uint32_t byteSize)
+{
+    BufferRange range;
+    if (byteSize == 0)
+        return range;
+
+    const uint32_t unitCount = (byteSize + m_Desc.alignment - 1) / m_Desc.alignment;
+
+    // too big to share a block
+    if (unitCount > m_BlockUnitCount)
+    {
+        range.buffer   = CreateBlockBuffer(byteSize);
+        range.byteSize = byteSize;
+        if (m_RenderContext != nullptr && range.buffer.empty())
+            return {};
+
+        m_AllocationCount++;
+        m_AllocatedByteSize += byteSize;
+        return range;
+    }
+
+    OffsetAllocator::Allocation allocation;
+    uint32_t blockIndex = 0;
+    for (; blockIndex < m_Blocks.size(); ++blockIndex)
+    {
+        allocation = m_Blocks[blockIndex].allocator->allocate(unitCount);
+        if (allocation.offset != OffsetAllocator::Allocation::NO_SPACE)
+            break;
+    }
+
+    if (blockIndex == m_Blocks.size())
+    {
+        Block block;
+        block.buffer = CreateBlockBuffer(m_BlockUnitCount * m_Desc.alignment);
+        if (m_RenderContext != nullptr && block.buffer.empty())
+            return {};
+
+        block.allocator = std::make_unique<OffsetAllocator::Allocator>(m_BlockUnitCount, m_Desc.maxAllocationsPerBlock);
+        allocation      = block.allocator->allocate(unitCount);
+        m_Blocks.push_back(std::move(block));
+    }
+
+    range.buffer     = m_Blocks[blockIndex].buffer;
+    range.byteOffset = allocation.offset * m_Desc.alignment;
+    range.byteSize   = byteSize;
+    range.block      = blockIndex;
+    range.metadata   = allocation.metadata;
+
+    m_AllocationCount++;
+    m_AllocatedByteSize += byteSize;
+    return range;
+}
+
+void BufferArena::Free(const BufferRange& range)
+{
+    if (range.empty())
+        return;
+
+    assert(m_AllocationCount > 0);
+    m_AllocationCount--;
+    m_AllocatedByteSize -= range.byteSize;
+
+    if (range.block == BufferRange::k_DedicatedBlock)
+    {
+        DestroyBlockBuffer(range.buffer);
+        return;
+    }
+
+    // blocks stay around once created, the next mesh most likely needs the space again
+    assert(range.block < m_Blocks.size());
+    m_Blocks[range.block].allocator->free({range.byteOffset / m_Desc.alignment, range.metadata});
+    m_DefragmentationPending = true;
+}
+
+std::vector<BufferRangeMove> BufferArena::Defragment(std::span<const BufferRange> ranges, uint32_t byteBudget)
+{
+    std::vector<BufferRangeMove> moves;
+    if (m_DefragmentationPending == false)
+        return moves;
+
+    uint32_t unitBudget = byteBudget / m_Desc.alignment;
+    std::vector<DefragmentationCandidate> candidates;
+    std::vector<vk::BufferCopy> copies;
+    for (uint32_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
+    {
+        candidates.clear();
+        for (uint32_t i = 0; i < ranges.size(); ++i)
+        {
+            if (ranges[i].block == blockIndex && ranges[i].empty() == false)
+                candidates.push_back({{ranges[i].byteOffset / m_Desc.alignment, ranges[i].metadata}, i});
+        }
+
+        // ranges only move within their block, the copies stay in one buffer
+        Block& block = m_Blocks[blockIndex];
+        copies.clear();
+        for (const DefragmentationMove& move : PlanDefragmentation(*block.allocator, candidates, unitBudget))
+        {
+            const BufferRange& from = ranges[move.userData];
+            BufferRange to          = from;
+            to.byteOffset           = move.to.offset * m_Desc.alignment;
+            to.metadata             = move.to.metadata;
+
+            moves.push_back({move.userData, from, to});
+            copies.emplace_back(from.byteOffset, to.byteOffset, from.byteSize);
+            unitBudget -= move.size;
+
+            m_AllocationCount++;
+            m_AllocatedByteSize += from.byteSize;
+        }
+
+        if (m_RenderContext != nullptr && copies.empty() == false)
+            m_RenderContext->CopyBuffer(block.buffer, block.buffer, copies);
+    }
+
+    // nothing fits further down until more is freed
+    m_DefragmentationPending = moves.empty() == false;
+
+    return moves;
+}
+} // namespace gore::gfx
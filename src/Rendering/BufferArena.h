@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Prefix.h"
+#include "Export.h"
+
+#include "Rendering/Buffer.h"
+
+#include "Memory/OffsetAllocator.h"
+
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace gore::gfx
+{
+class RenderContext;
+
+struct BufferArenaDesc final
+{
+    const char* debugName = "Noname BufferArena";
+    BufferUsage usage     = BufferUsage::Vertex;
+    // Ranges start at multiples of the alignment. Vertex arenas use the vertex stride, so a range starts at vertex
+    // byteOffset / stride and can be drawn with the vertexOffset of a Draw without binding at an offset.
+    uint32_t alignment              = 4;
+    uint32_t blockByteSize          = 32 * 1024 * 1024;
+    uint32_t maxAllocationsPerBlock = 16 * 1024;
+};
+
+struct BufferRange final
+{
+    static constexpr uint32_t k_DedicatedBlock = UINT32_MAX;
+
+    BufferHandle buffer = {};
+    uint32_t byteOffset = 0;
+    uint32_t byteSize   = 0;
+
+    // Where the range came from, arena is the index of the arena in the RenderContext that owns it
+    uint32_t arena    = 0;
+    uint32_t block    = k_DedicatedBlock;
+    uint32_t metadata = OffsetAllocator::Allocation::NO_SPACE;
+
+    [[nodiscard]] bool empty() const { return byteSize == 0; }
+};
+
+// Where Defragment moved a range, index is the position of the range in the ranges it was given
+struct BufferRangeMove final
+{
+    uint32_t index   = 0;
+    BufferRange from = {};
+    BufferRange to   = {};
+};
+
+// Sub-allocates small buffers from a few large blocks with OffsetAllocator, so meshes share vertex and index buffers
+// instead of making a VMA allocation each. A new block is created when no block has room, ranges bigger than a block
+// get a buffer of their own. Without a render context the blocks have no GPU buffer, the bookkeeping works the same.
+ENGINE_CLASS(BufferArena) final
+{
+public:
+    BufferArena(RenderContext* renderContext, const BufferArenaDesc& desc);
+    ~BufferArena();
+
+    NON_COPYABLE(BufferArena);
+
+    // The range is empty when byteSize is 0 or the block could not be created
+    [[nodiscard]] BufferRange Allocate(uint32_t byteSize);
+    // Right away, ranges that frames in flight may still read go through RenderContext::RetireBufferRange
+    void Free(const BufferRange& range);
+
+    // Moves ranges into free space further down their block, copying at most byteBudget bytes, see
+    // PlanDefragmentation. ranges are the live ranges of this arena whose owners can be patched, dedicated ones never
+    // move. The copies are queued on the render context. The new places are allocated, the old ones stay allocated
+    // until the caller frees them, once no frame in flight reads them anymore.
+    // Returns nothing without planning anything until a range was freed since the last call that moved nothing.
+    std::vector<BufferRangeMove> Defragment(std::span<const BufferRange> ranges, uint32_t byteBudget);
+
+    [[nodiscard]] const BufferArenaDesc& GetDesc() const { return m_Desc; }
+    [[nodiscard]] uint32_t GetBlockCount() const { return static_cast<uint32_t>(m_Blocks.size()); }
+    [[nodiscard]] uint32_t GetAllocationCount() const { return m_AllocationCount; }
+    [[nodiscard]] uint64_t GetAllocatedByteSize() const { return m_AllocatedByteSize; }
+    [[nodiscard]] bool IsDefragmentationPending() const { return m_DefragmentationPending; }
+
+private:
+    struct Block
+    {
+        BufferHandle buffer;
+        std::unique_ptr<OffsetAllocator::Allocator> allocator;
+    };
+
+    BufferHandle CreateBlockBuffer(uint32_t byteSize);
+    void DestroyBlockBuffer(BufferHandle buffer);
+
+    RenderContext* m_RenderContext;
+    BufferArenaDesc m_Desc;
+    uint32_t m_BlockUnitCount;
+
+    std::vector<Block> m_Blocks;
+
+    uint32_t m_AllocationCount;
+    uint64_t m_AllocatedByteSize;
+
+    bool m_DefragmentationPending;
+};
+} // namespace gore::gfx
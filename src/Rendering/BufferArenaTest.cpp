@@ -0,0 +1,172 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/BufferArena.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::gfx;
+
+static bool Overlaps(const BufferRange& a, const BufferRange& b)
+{
+    return a.block == b.block && a.byteOffset < b.byteOffset + b.byteSize && b.byteOffset < a.byteOffset + a.byteSize;
+}
+
+TEST_CASE("Buffer ranges are sub-allocated from shared blocks", "[BufferArena]")
+{
+    // 32 byte vertices, 64 of them per block
+    BufferArena arena(nullptr, {.usage = BufferUsage::Vertex, .alignment = 32, .blockByteSize = 64 * 32});
+
+    BufferRange cube  = arena.Allocate(24 * 32);
+    BufferRange quad  = arena.Allocate(4 * 32);
+    BufferRange empty = arena.Allocate(0);
+    REQUIRE(cube.empty() == false);
+    REQUIRE(quad.empty() == false);
+    REQUIRE(empty.empty());
+
+    REQUIRE(arena.GetBlockCount() == 1);
+    REQUIRE(cube.block == quad.block);
+    REQUIRE(Overlaps(cube, quad) == false);
+    REQUIRE(cube.byteOffset % 32 == 0);
+    REQUIRE(quad.byteOffset % 32 == 0);
+    REQUIRE(arena.GetAllocationCount() == 2);
+    REQUIRE(arena.GetAllocatedByteSize() == 28 * 32);
+
+    SECTION("Sizes are rounded up to the alignment")
+    {
+        BufferRange odd  = arena.Allocate(33);
+        BufferRange next = arena.Allocate(32);
+        REQUIRE(odd.byteSize == 33);
+        REQUIRE(Overlaps({.byteOffset = odd.byteOffset, .byteSize = 64, .block = odd.block}, next) == false);
+    }
+
+    SECTION("A full block adds another one")
+    {
+        BufferRange big = arena.Allocate(48 * 32);
+        REQUIRE(arena.GetBlockCount() == 2);
+        REQUIRE(big.block == 1);
+        REQUIRE(big.byteOffset == 0);
+    }
+
+    SECTION("Ranges bigger than a block are dedicated")
+    {
+        BufferRange huge = arena.Allocate(65 * 32);
+        REQUIRE(huge.block == BufferRange::k_DedicatedBlock);
+        REQUIRE(huge.byteOffset == 0);
+        REQUIRE(arena.GetBlockCount() == 1);
+
+        arena.Free(huge);
+        REQUIRE(arena.GetAllocationCount() == 2);
+    }
+
+    SECTION("Freed space is reused")
+    {
+        arena.Free(cube);
+        arena.Free(quad);
+        REQUIRE(arena.GetAllocationCount() == 0);
+        REQUIRE(arena.GetAllocatedByteSize() == 0);
+
+        BufferRange whole = arena.Allocate(64 * 32);
+        REQUIRE(whole.block == 0);
+        REQUIRE(arena.GetBlockCount() == 1);
+    }
+}
+
+TEST_CASE("Buffer ranges never overlap under churn", "[BufferArena]")
+{
+    BufferArena arena(nullptr, {.usage = BufferUsage::Index, .alignment = 4, .blockByteSize = 64 * 1024});
+
+    std::mt19937 random(5);
+    std::vector<BufferRange> ranges;
+    for (uint32_t i = 0; i < 4000; ++i)
+    {
+        if (!ranges.empty() && random() % 3 == 0)
+        {
+            size_t victim = random() % ranges.size();
+            arena.Free(ranges[victim]);
+            ranges[victim] = ranges.back();
+            ranges.pop_back();
+        }
+        else
+        {
+            BufferRange range = arena.Allocate(2 * (1 + random() % 3000));
+            REQUIRE(range.empty() == false);
+            REQUIRE(range.byteOffset % 4 == 0);
+            ranges.push_back(range);
+        }
+    }
+
+    REQUIRE(arena.GetAllocationCount() == ranges.size());
+
+    std::sort(ranges.begin(), ranges.end(), [](const BufferRange& a, const BufferRange& b)
+              { return a.block != b.block ? a.block < b.block : a.byteOffset < b.byteOffset; });
+    for (size_t i = 1; i < ranges.size(); ++i)
+    {
+        REQUIRE(Overlaps(ranges[i - 1], ranges[i]) == false);
+    }
+}
+
+TEST_CASE("Defragmentation moves ranges down their block", "[BufferArena]")
+{
+    // 32 byte vertices, 64 of them per block
+    BufferArena arena(nullptr, {.usage = BufferUsage::Vertex, .alignment = 32, .blockByteSize = 64 * 32});
+
+    std::vector<BufferRange> ranges;
+    for (uint32_t i = 0; i < 8; ++i)
+        ranges.push_back(arena.Allocate(8 * 32));
+
+    // nothing was freed, nothing is planned
+    REQUIRE(arena.Defragment(ranges, UINT32_MAX).empty());
+
+    // a gap at the bottom of the block
+    for (uint32_t i = 0; i < 4; ++i)
+        arena.Free(ranges[i]);
+    std::vector<BufferRange> live = {ranges[4], ranges[5], ranges[6], ranges[7]};
+
+    SECTION("Everything within the budget moves")
+    {
+        std::vector<BufferRangeMove> moves = arena.Defragment(live, UINT32_MAX);
+        REQUIRE(moves.size() == 4);
+        for (const BufferRangeMove& move : moves)
+        {
+            REQUIRE(move.from.byteOffset == live[move.index].byteOffset);
+            REQUIRE(move.to.byteOffset < move.from.byteOffset);
+            REQUIRE(move.to.block == move.from.block);
+            REQUIRE(move.to.byteSize == move.from.byteSize);
+            live[move.index] = move.to;
+        }
+
+        // the old places stay allocated until they are freed
+        REQUIRE(arena.GetAllocationCount() == 8);
+        for (const BufferRangeMove& move : moves)
+            arena.Free(move.from);
+        REQUIRE(arena.GetAllocationCount() == 4);
+
+        std::sort(live.begin(), live.end(), [](const BufferRange& a, const BufferRange& b) { return a.byteOffset < b.byteOffset; });
+        for (size_t i = 1; i < live.size(); ++i)
+            REQUIRE(Overlaps(live[i - 1], live[i]) == false);
+
+        // the top half of the block is one free region again
+        REQUIRE(live.back().byteOffset + live.back().byteSize <= 32 * 32);
+
+        // nothing is left to move
+        REQUIRE(arena.Defragment(live, UINT32_MAX).empty());
+        BufferRange top = arena.Allocate(32 * 32);
+        REQUIRE(top.block == 0);
+        REQUIRE(arena.GetBlockCount() == 1);
+    }
+
+    SECTION("The budget limits the bytes moved")
+    {
+        std::vector<BufferRangeMove> moves = arena.Defragment(live, 8 * 32);
+        REQUIRE(moves.size() == 1);
+        REQUIRE(moves[0].index == 3);
+    }
+}
+
+} // namespace gore::test
+#endif
@@ -2,8 +2,27 @@
 
 #include "Rendering/RenderContext.h"
 
+#include <cstring>
+
 namespace gore::renderer
 {
+GraphicsPipelineHandle Pass::GetShader(const VertexLayout& layout) const
+{
+    if (layout.IsVertex())
+        return shader;
+
+    // the shaders read position, uv and normal, there is nothing to bind to the ones a layout leaves out
+    if (layout.channels != ShaderChannel::Default)
+        return {};
+
+    for (const PassVariant& variant : variants)
+    {
+        if (variant.compression == layout.compression)
+            return variant.shader;
+    }
+    return {};
+}
+
 Material::Material() noexcept :
     m_Passes(),
     m_AlphaMode(AlphaMode::Opaque),
@@ -16,4 +35,17 @@ void Material::AddPass(const Pass& pass)
     m_Passes.push_back(pass);
 }
 
+bool Material::TryGetPassByName(const char* name, Pass& pass) const
+{
+    for (const Pass& candidate : m_Passes)
+    {
+        if (candidate.name != nullptr && strcmp(candidate.name, name) == 0)
+        {
+            pass = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
 } // namespace gore::renderer
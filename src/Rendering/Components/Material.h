@@ -6,6 +6,10 @@
 #include "Rendering/Pipeline.h"
 #include "Rendering/BindGroup.h"
 #include "Rendering/DynamicBuffer.h"
+#include "Rendering/Utils/VertexLayout.h"
+
+#include <vector>
+
 namespace gore::renderer
 {
 using namespace gore::gfx;
@@ -25,11 +29,23 @@ struct PassID
     const char* k_GBufferPassName = "GBufferPass";
 };
 
+// The pipeline of a pass for vertices packed with compression, its vertex shader decodes them
+struct PassVariant
+{
+    VertexCompressionDesc compression;
+    GraphicsPipelineHandle shader = {};
+};
+
 struct Pass
 {
     const char* name              = nullptr;
     GraphicsPipelineHandle shader = {};
     BindGroupHandle bindGroup[3]  = {};
+    // shader reads Vertex, these read the Default channels packed otherwise
+    std::vector<PassVariant> variants;
+
+    // The pipeline reading vertices in layout, empty if the pass has none for it
+    [[nodiscard]] GraphicsPipelineHandle GetShader(const VertexLayout& layout) const;
 
     inline bool operator==(const Pass& other) const
     {
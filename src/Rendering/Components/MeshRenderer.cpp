@@ -1,6 +1,12 @@
 #include "MeshRenderer.h"
 
 #include "Rendering/RenderContext.h"
+#include "Rendering/DrawStream/DrawCache.h"
+#include "Rendering/UnifiedGeometryBuffer/UnifiedGeometryBuffer.h"
+#include "Rendering/System/GPUTransformChangeSystem.h"
+
+#include "Object/GameObject.h"
+#include "Object/Transform.h"
 
 namespace gore::renderer
 {
@@ -13,27 +19,86 @@ MeshRenderer::MeshRenderer(GameObject* GameObject) noexcept :
     m_IndexBuffer(),
     m_IndexCount(0),
     m_IndexOffset(0),
+    m_PositionScale(Vector3::One),
+    m_PositionOffset(Vector3::Zero),
+    m_VertexLayout(CreateVertexLayout()),
+    m_SubMeshes(),
+    m_Geometry(),
+    m_UnifiedMeshIndex(UnifiedGeometryBuffer::k_InvalidMesh),
     m_DynamicBuffer(),
     m_DynamicBufferOffset(0)
 {
     // m_RendererHandle = MeshRendererSystem::GetInstance()->GetRendererHandle();
+    MarkDrawsDirty();
+
+    // the slot goes away with the transform, which is destroyed before the other components of its game object
+    if (GPUTransformChangeSystem* transformChangeSystem = GPUTransformChangeSystem::GetInstance())
+        transformChangeSystem->AddTransform(GetGameObject()->GetTransform());
 }
 
 MeshRenderer::~MeshRenderer()
 {
     // MeshRendererSystem::GetInstance()->FreeRendererHandle(m_RendererHandle);
+    if (DrawCache* drawCache = DrawCache::GetInstance())
+        drawCache->OnRendererRemoved(this);
+
+    SetGeometry(nullptr);
+    if (UnifiedGeometryBuffer* geometryBuffer = UnifiedGeometryBuffer::GetInstance())
+        geometryBuffer->RemoveMesh(m_UnifiedMeshIndex);
+}
+
+void MeshRenderer::SetGeometry(std::shared_ptr<MeshGeometry> geometry)
+{
+    if (m_Geometry != nullptr)
+        std::erase(m_Geometry->renderers, this);
+
+    m_Geometry = std::move(geometry);
+    if (m_Geometry != nullptr)
+        m_Geometry->renderers.push_back(this);
+}
+
+void MeshRenderer::OnGeometryMoved(const BufferRange& from, const BufferRange& to, bool vertices)
+{
+    // ranges only move within their block, the buffer stays the same
+    int64_t byteDistance = static_cast<int64_t>(to.byteOffset) - static_cast<int64_t>(from.byteOffset);
+    if (vertices)
+        SetVertexOffset(static_cast<uint32_t>(m_VertexOffset + byteDistance / m_Geometry->vertexStride));
+    else if (m_IndexType != IndexType::None)
+        SetIndexOffset(static_cast<uint32_t>(m_IndexOffset + byteDistance / GetIndexTypeSize(m_IndexType)));
+}
+
+void MeshRenderer::MarkDrawsDirty()
+{
+    if (DrawCache* drawCache = DrawCache::GetInstance())
+        drawCache->OnRendererChanged(this);
 }
 
 bool MeshRenderer::IsValid() const
 {
-    return m_VertexBuffer.empty() == false 
-        && m_IndexBuffer.empty() == false
+    // meshes without indices draw their vertices in order
+    bool hasIndices = m_IndexType != IndexType::None;
+    return m_VertexBuffer.empty() == false
         && m_VertexCount > 0
-        && m_IndexCount > 0;
+        && (hasIndices == false || (m_IndexBuffer.empty() == false && m_IndexCount > 0));
 }
 
 void MeshRenderer::Start()
 {
+    // renderers made before the system are registered once they start, a transform added before keeps its slot
+    if (GPUTransformChangeSystem* transformChangeSystem = GPUTransformChangeSystem::GetInstance())
+    {
+        transformChangeSystem->AddTransform(GetGameObject()->GetTransform());
+        UploadPositionDequantization();
+    }
+}
+
+void MeshRenderer::UploadPositionDequantization()
+{
+    // without a slot there is nothing to write it to yet, Start does once the transform has one
+    GPUTransformChangeSystem* transformChangeSystem = GPUTransformChangeSystem::GetInstance();
+    uint32_t slot                                   = GetGameObject()->GetTransform()->GetChangeSlot();
+    if (transformChangeSystem != nullptr && slot != TransformHierarchy::k_NoChangeSlot)
+        transformChangeSystem->SetPositionDequantization(slot, m_PositionScale, m_PositionOffset);
 }
 
 void MeshRenderer::Update()
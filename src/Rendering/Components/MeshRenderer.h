@@ -6,10 +6,21 @@
 #include "Object/Component.h"
 
 #include "Rendering/Buffer.h"
+#include "Rendering/BufferArena.h"
 #include "Rendering/DynamicBuffer.h"
 #include "Rendering/BindGroup.h"
 #include "Rendering/Components/Material.h"
+#include "Rendering/Components/SubMesh.h"
 #include "Rendering/Utils/GeometryUtils.h"
+#include "Rendering/Utils/VertexLayout.h"
+
+#include <memory>
+#include <vector>
+
+namespace gore::gfx
+{
+struct MeshGeometry;
+} // namespace gore::gfx
 
 namespace gore::renderer
 {
@@ -42,20 +53,45 @@ public:
     [[nodiscard]] bool HasVertexData() const;
     [[nodiscard]] bool HasIndexData() const;
 
-    [[nodiscard]] Material& GetMaterial() { return m_Material; }
-    void SetMaterial(const Material& material) { m_Material = material; }
-
-    GETTER_SETTER(IndexType, IndexType)
-    GETTER_SETTER(DynamicBufferHandle, DynamicBuffer)
-    GETTER_SETTER(uint32_t, DynamicBufferOffset)
-
-    GETTER_SETTER(BufferHandle, VertexBuffer)
-    GETTER_SETTER(uint32_t, VertexCount)
-    GETTER_SETTER(uint32_t, VertexOffset)
-
-    GETTER_SETTER(BufferHandle, IndexBuffer)
-    GETTER_SETTER(uint32_t, IndexCount)
-    GETTER_SETTER(uint32_t, IndexOffset)
+    // Changing the material has to go through SetMaterial, so the cached draws of this renderer get patched
+    [[nodiscard]] const Material& GetMaterial() const { return m_Material; }
+    void SetMaterial(const Material& material) { m_Material = material; MarkDrawsDirty(); }
+
+    GETTER_SETTER_NOTIFY(IndexType, IndexType, MarkDrawsDirty)
+    GETTER_SETTER_NOTIFY(DynamicBufferHandle, DynamicBuffer, MarkDrawsDirty)
+    GETTER_SETTER_NOTIFY(uint32_t, DynamicBufferOffset, MarkDrawsDirty)
+
+    GETTER_SETTER_NOTIFY(BufferHandle, VertexBuffer, MarkDrawsDirty)
+    GETTER_SETTER_NOTIFY(uint32_t, VertexCount, MarkDrawsDirty)
+    GETTER_SETTER_NOTIFY(uint32_t, VertexOffset, MarkDrawsDirty)
+
+    GETTER_SETTER_NOTIFY(BufferHandle, IndexBuffer, MarkDrawsDirty)
+    GETTER_SETTER_NOTIFY(uint32_t, IndexCount, MarkDrawsDirty)
+    GETTER_SETTER_NOTIFY(uint32_t, IndexOffset, MarkDrawsDirty)
+
+    // Positions are attribute * PositionScale + PositionOffset, which only differs for quantized positions. They go to
+    // the shaders with the transform, see GPUTransformChangeSystem::SetPositionDequantization.
+    GETTER_SETTER_NOTIFY(Vector3, PositionScale, UploadPositionDequantization)
+    GETTER_SETTER_NOTIFY(Vector3, PositionOffset, UploadPositionDequantization)
+
+    // How the vertices are packed, the draws take the pipeline of their pass that reads this layout
+    [[nodiscard]] const VertexLayout& GetVertexLayout() const { return m_VertexLayout; }
+    void SetVertexLayout(const VertexLayout& vertexLayout) { m_VertexLayout = vertexLayout; MarkDrawsDirty(); }
+
+    // Parts of the mesh drawn one draw each, their offsets count from VertexOffset and IndexOffset. Without any the
+    // whole mesh is one draw.
+    [[nodiscard]] const std::vector<SubMesh>& GetSubMeshes() const { return m_SubMeshes; }
+    void SetSubMeshes(std::vector<SubMesh> subMeshes) { m_SubMeshes = std::move(subMeshes); MarkDrawsDirty(); }
+
+    // The arena ranges VertexBuffer and IndexBuffer point into, shared with the other renderers drawing parts of the
+    // same upload. They are freed with the last of them and moved by RenderContext::DefragmentMeshGeometry.
+    [[nodiscard]] const std::shared_ptr<MeshGeometry>& GetGeometry() const { return m_Geometry; }
+    void SetGeometry(std::shared_ptr<MeshGeometry> geometry);
+    // Shifts VertexOffset or IndexOffset by as far as the vertex or index range of the geometry moved
+    void OnGeometryMoved(const BufferRange& from, const BufferRange& to, bool vertices);
+
+    // Index of the mesh in the UnifiedGeometryBuffer, renderers with one are drawn indirectly by the opaque forward pass
+    GETTER_SETTER_NOTIFY(uint32_t, UnifiedMeshIndex, MarkDrawsDirty)
     
     GETTER_SETTER(BindGroupHandle, BindGroup)
 
@@ -63,6 +99,9 @@ public:
     void Update() override;
 
 private:
+    void MarkDrawsDirty();
+    void UploadPositionDequantization();
+
     void DeleteCPUMeshData();
     void DeleteGPUData();
 
@@ -82,6 +121,15 @@ private:
     uint32_t m_IndexCount;
     uint32_t m_IndexOffset;
 
+    Vector3 m_PositionScale;
+    Vector3 m_PositionOffset;
+    VertexLayout m_VertexLayout;
+
+    std::vector<SubMesh> m_SubMeshes;
+
+    std::shared_ptr<MeshGeometry> m_Geometry;
+    uint32_t m_UnifiedMeshIndex;
+
     // Material data
     BindGroupHandle m_BindGroup;
 };
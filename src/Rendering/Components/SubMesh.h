@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Prefix.h"
+
+#include <cstdint>
+
+namespace gore::renderer
+{
+// One glTF primitive of a mesh. Its offsets are in vertices and indices from the start of the mesh, so all the
+// sub-meshes of a mesh live in the same vertex and index ranges and each of them is drawn with a draw of its own.
+struct SubMesh final
+{
+    uint32_t vertexOffset = 0;
+    uint32_t vertexCount  = 0;
+    uint32_t indexOffset  = 0;
+    uint32_t indexCount   = 0;
+};
+} // namespace gore::renderer
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "Handle.h"
+
+#include <atomic>
+#include <algorithm>
+#include <optional>
+#include <cassert>
+
+namespace gore
+{
+// Pool that can be created from and destroyed on any thread.
+// Entries live in fixed size chunks which are never moved or freed before clear(), so a reference returned by
+// getObject stays valid while other threads grow the pool. Destroyed entries go to a lock-free free list whose head
+// carries the generation of the entry it points at: destroy bumps the generation before pushing, so a head that was
+// popped and pushed again never compares equal to a stale one (ABA).
+// The lowest bit of the generation is set while the entry holds an object. Handles carry the generation of a live
+// entry, so comparing it alone tells whether the handle is valid, without reading the objects another thread may be
+// creating or destroying.
+// The caller still has to make sure a handle is not destroyed while another thread is using it.
+template <typename ObjectDesc, typename ImplObjectType, uint32_t ChunkSizeLog2 = 10, uint32_t MaxChunkCount = 256>
+class ConcurrentPool
+{
+    static constexpr uint32_t kListEndSentinel = 0xffffffff;
+    static constexpr uint32_t kChunkSize       = 1u << ChunkSizeLog2;
+    static constexpr uint32_t kMaxObjects      = kChunkSize * MaxChunkCount;
+    static constexpr uint32_t kAliveBit        = 1;
+
+    struct PoolEntry
+    {
+        std::optional<ObjectDesc> objDesc;
+        std::optional<ImplObjectType> object;
+        std::atomic<uint32_t> gen      = 0;
+        std::atomic<uint32_t> nextFree = kListEndSentinel;
+    };
+
+    struct Chunk
+    {
+        PoolEntry entries[kChunkSize];
+    };
+
+    static uint64_t packHead(uint32_t index, uint32_t gen)
+    {
+        return (static_cast<uint64_t>(gen) << 32) | index;
+    }
+    static uint32_t headIndex(uint64_t head)
+    {
+        return static_cast<uint32_t>(head);
+    }
+
+    std::atomic<Chunk*> _chunks[MaxChunkCount] = {};
+    std::atomic<uint64_t> _freeListHead        = packHead(kListEndSentinel, 0);
+    std::atomic<uint32_t> _numUsedEntries      = 0;
+    std::atomic<uint32_t> _numObjects          = 0;
+
+    PoolEntry& getEntry(uint32_t index)
+    {
+        return _chunks[index >> ChunkSizeLog2].load(std::memory_order_acquire)->entries[index & (kChunkSize - 1)];
+    }
+    const PoolEntry& getEntry(uint32_t index) const
+    {
+        return _chunks[index >> ChunkSizeLog2].load(std::memory_order_acquire)->entries[index & (kChunkSize - 1)];
+    }
+
+    // nullptr for indices that were never handed out or whose chunk another thread is still allocating
+    const PoolEntry* findEntry(Handle<ImplObjectType> handle) const
+    {
+        if (handle.empty() || handle.index() >= kMaxObjects)
+            return nullptr;
+
+        const Chunk* chunk = _chunks[handle.index() >> ChunkSizeLog2].load(std::memory_order_acquire);
+        if (chunk == nullptr)
+            return nullptr;
+
+        const PoolEntry& entry = chunk->entries[handle.index() & (kChunkSize - 1)];
+        // pairs with the release in create, the object is constructed once its generation is seen
+        return handle.gen() == entry.gen.load(std::memory_order_acquire) ? &entry : nullptr;
+    }
+
+    void ensureChunk(uint32_t chunkIndex)
+    {
+        if (_chunks[chunkIndex].load(std::memory_order_acquire) != nullptr)
+            return;
+
+        // several threads can race for the same chunk, only one allocation is kept
+        Chunk* chunk    = new Chunk();
+        Chunk* expected = nullptr;
+        if (!_chunks[chunkIndex].compare_exchange_strong(expected, chunk, std::memory_order_acq_rel))
+            delete chunk;
+    }
+
+    uint32_t popFreeEntry()
+    {
+        uint64_t head = _freeListHead.load(std::memory_order_acquire);
+        while (headIndex(head) != kListEndSentinel)
+        {
+            // the entry can be popped by another thread meanwhile, then the head changed and the exchange fails
+            const uint32_t next = getEntry(headIndex(head)).nextFree.load(std::memory_order_relaxed);
+            const uint32_t gen  = next == kListEndSentinel ? 0 : getEntry(next).gen.load(std::memory_order_relaxed);
+            if (_freeListHead.compare_exchange_weak(head, packHead(next, gen), std::memory_order_acq_rel, std::memory_order_acquire))
+                return headIndex(head);
+        }
+        return kListEndSentinel;
+    }
+
+    void pushFreeEntry(uint32_t index, uint32_t gen)
+    {
+        PoolEntry& entry = getEntry(index);
+        uint64_t head    = _freeListHead.load(std::memory_order_relaxed);
+        do
+        {
+            entry.nextFree.store(headIndex(head), std::memory_order_relaxed);
+        } while (!_freeListHead.compare_exchange_weak(head, packHead(index, gen), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+public:
+    ConcurrentPool() = default;
+    ~ConcurrentPool()
+    {
+        clear();
+    }
+
+    ConcurrentPool(const ConcurrentPool&)            = delete;
+    ConcurrentPool& operator=(const ConcurrentPool&) = delete;
+
+    // Returns an empty handle when all MaxChunkCount chunks are used
+    Handle<ImplObjectType> create(ObjectDesc&& desc, ImplObjectType&& obj)
+    {
+        uint32_t idx = popFreeEntry();
+        if (idx == kListEndSentinel)
+        {
+            idx = _numUsedEntries.fetch_add(1, std::memory_order_relaxed);
+            if (idx >= kMaxObjects)
+            {
+                assert(false && "ConcurrentPool is full");
+                return {};
+            }
+            ensureChunk(idx >> ChunkSizeLog2);
+        }
+
+        PoolEntry& entry = getEntry(idx);
+        entry.objDesc.emplace(std::move(desc));
+        entry.object.emplace(std::move(obj));
+
+        // the alive bit publishes the object, a dead generation is never 0 once the bit is set
+        const uint32_t gen = entry.gen.load(std::memory_order_relaxed) | kAliveBit;
+        entry.gen.store(gen, std::memory_order_release);
+        _numObjects.fetch_add(1, std::memory_order_relaxed);
+        return Handle<ImplObjectType>(idx, gen);
+    }
+    void destroy(Handle<ImplObjectType> handle)
+    {
+        if (handle.empty())
+            return;
+        const uint32_t index = handle.index();
+        assert(index < kMaxObjects && index < _numUsedEntries.load(std::memory_order_relaxed));
+
+        PoolEntry& entry = getEntry(index);
+        assert(handle.gen() == entry.gen.load(std::memory_order_relaxed)); // double deletion
+
+        // the next generation with the alive bit cleared, handles of this one stop matching before the object goes
+        const uint32_t gen = handle.gen() + 1;
+        entry.gen.store(gen, std::memory_order_release);
+        entry.objDesc.reset();
+        entry.object.reset();
+        _numObjects.fetch_sub(1, std::memory_order_relaxed);
+        pushFreeEntry(index, gen);
+    }
+    // Wait-free, a chunk pointer load and an index
+    const ImplObjectType& getObject(Handle<ImplObjectType> handle) const
+    {
+        assert(!handle.empty());
+        const PoolEntry& entry = getEntry(handle.index());
+        assert(handle.gen() == entry.gen.load(std::memory_order_relaxed));
+        return *entry.object;
+    }
+    ImplObjectType& getObject(Handle<ImplObjectType> handle)
+    {
+        assert(!handle.empty());
+        PoolEntry& entry = getEntry(handle.index());
+        assert(handle.gen() == entry.gen.load(std::memory_order_relaxed));
+        return *entry.object;
+    }
+    const ImplObjectType* getObjectPtr(Handle<ImplObjectType> handle) const
+    {
+        const PoolEntry* entry = findEntry(handle);
+        return entry ? &*entry->object : nullptr;
+    }
+    ImplObjectType* getObjectPtr(Handle<ImplObjectType> handle)
+    {
+        const PoolEntry* entry = findEntry(handle);
+        return entry ? const_cast<ImplObjectType*>(&*entry->object) : nullptr;
+    }
+    const ObjectDesc& getObjectDesc(Handle<ImplObjectType> handle) const
+    {
+        assert(!handle.empty());
+        const PoolEntry& entry = getEntry(handle.index());
+        assert(handle.gen() == entry.gen.load(std::memory_order_relaxed));
+        return *entry.objDesc;
+    }
+    const ObjectDesc* getObjectDescPtr(Handle<ImplObjectType> handle) const
+    {
+        const PoolEntry* entry = findEntry(handle);
+        return entry ? &*entry->objDesc : nullptr;
+    }
+    // Not thread-safe, for shutdown
+    template <typename Func>
+    void forEach(Func&& func)
+    {
+        const uint32_t numUsedEntries = std::min(_numUsedEntries.load(std::memory_order_acquire), kMaxObjects);
+        for (uint32_t idx = 0; idx < numUsedEntries; idx++)
+        {
+            PoolEntry& entry = getEntry(idx);
+            if (entry.gen.load(std::memory_order_relaxed) & kAliveBit)
+                func(*entry.object, *entry.objDesc);
+        }
+    }
+    // Not thread-safe, outstanding handles and references are invalidated
+    void clear()
+    {
+        for (auto& chunk : _chunks)
+        {
+            delete chunk.exchange(nullptr, std::memory_order_relaxed);
+        }
+        _freeListHead.store(packHead(kListEndSentinel, 0), std::memory_order_relaxed);
+        _numUsedEntries.store(0, std::memory_order_relaxed);
+        _numObjects.store(0, std::memory_order_relaxed);
+    }
+    uint32_t num() const
+    {
+        return _numObjects.load(std::memory_order_relaxed);
+    }
+};
+} // namespace gore
@@ -0,0 +1,189 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/ConcurrentPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace gore::test
+{
+struct ConcurrentTestObject
+{
+    uint32_t owner;
+    uint32_t value;
+};
+
+using TestConcurrentPool = ConcurrentPool<uint32_t, ConcurrentTestObject, 6, 64>;
+
+TEST_CASE("ConcurrentPool behaves like Pool on one thread", "[ConcurrentPool]")
+{
+    TestConcurrentPool pool;
+
+    auto first  = pool.create(1, {0, 10});
+    auto second = pool.create(2, {0, 20});
+    REQUIRE(pool.num() == 2);
+    REQUIRE(pool.getObject(first).value == 10);
+    REQUIRE(pool.getObjectDesc(second) == 2);
+
+    pool.destroy(first);
+    REQUIRE(pool.num() == 1);
+    REQUIRE(pool.getObjectPtr(first) == nullptr);
+    REQUIRE(pool.getObjectDescPtr(first) == nullptr);
+
+    // the entry is reused with a new generation
+    auto third = pool.create(3, {0, 30});
+    REQUIRE(third.index() == first.index());
+    REQUIRE(third.gen() != first.gen());
+    REQUIRE(pool.getObjectPtr(third)->value == 30);
+
+    // references stay put while the pool grows by whole chunks
+    const ConcurrentTestObject* secondObject = &pool.getObject(second);
+    for (uint32_t i = 0; i < 1000; ++i)
+        pool.create(0, {0, i});
+    REQUIRE(&pool.getObject(second) == secondObject);
+    REQUIRE(pool.num() == 1002);
+
+    uint32_t visited = 0;
+    pool.forEach([&visited](const ConcurrentTestObject&, uint32_t) { visited++; });
+    REQUIRE(visited == 1002);
+
+    pool.clear();
+    REQUIRE(pool.num() == 0);
+}
+
+TEST_CASE("ConcurrentPool handles never collide across threads", "[ConcurrentPool]")
+{
+    constexpr uint32_t threadCount    = 8;
+    constexpr uint32_t iterationCount = 20000;
+    constexpr uint32_t maxLiveHandles = 64;
+
+    TestConcurrentPool pool;
+
+    struct ThreadResult
+    {
+        std::vector<Handle<ConcurrentTestObject>> created;
+        std::vector<Handle<ConcurrentTestObject>> alive;
+        uint32_t mismatches = 0;
+    };
+    std::vector<ThreadResult> results(threadCount);
+
+    auto worker = [&pool, &results](uint32_t t)
+    {
+        ThreadResult& result = results[t];
+        std::mt19937 random(t + 1);
+        for (uint32_t i = 0; i < iterationCount; ++i)
+        {
+            bool destroy = !result.alive.empty() && (result.alive.size() >= maxLiveHandles || random() % 2 == 0);
+            if (destroy)
+            {
+                size_t victim = random() % result.alive.size();
+                auto handle   = result.alive[victim];
+
+                // nobody else may have written into an entry this thread owns
+                const ConcurrentTestObject& object = pool.getObject(handle);
+                if (object.owner != t || pool.getObjectDesc(handle) != object.value)
+                    result.mismatches++;
+
+                pool.destroy(handle);
+                result.alive[victim] = result.alive.back();
+                result.alive.pop_back();
+            }
+            else
+            {
+                auto handle = pool.create(uint32_t(i), {t, i});
+                result.created.push_back(handle);
+                result.alive.push_back(handle);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; ++t)
+        threads.emplace_back(worker, t);
+    for (auto& thread : threads)
+        thread.join();
+
+    uint32_t aliveCount = 0;
+    std::vector<uint64_t> createdHandles;
+    for (uint32_t t = 0; t < threadCount; ++t)
+    {
+        REQUIRE(results[t].mismatches == 0);
+        aliveCount += static_cast<uint32_t>(results[t].alive.size());
+        for (auto handle : results[t].created)
+        {
+            createdHandles.push_back((uint64_t(handle.index()) << 32) | handle.gen());
+        }
+        for (auto handle : results[t].alive)
+        {
+            REQUIRE(pool.getObject(handle).owner == t);
+        }
+    }
+    REQUIRE(pool.num() == aliveCount);
+
+    // every create handed out an index and generation pair no other create got
+    std::sort(createdHandles.begin(), createdHandles.end());
+    REQUIRE(std::adjacent_find(createdHandles.begin(), createdHandles.end()) == createdHandles.end());
+}
+
+TEST_CASE("ConcurrentPool stale handles stay invalid while other threads reuse their entries", "[ConcurrentPool]")
+{
+    constexpr uint32_t staleCount     = 64;
+    constexpr uint32_t readerCount    = 4;
+    constexpr uint32_t iterationCount = 20000;
+
+    TestConcurrentPool pool;
+
+    std::vector<Handle<ConcurrentTestObject>> staleHandles;
+    for (uint32_t i = 0; i < staleCount; ++i)
+        staleHandles.push_back(pool.create(uint32_t(i), {0, i}));
+    for (auto handle : staleHandles)
+        pool.destroy(handle);
+
+    // the writer keeps creating objects in the entries of the stale handles while the readers look them up
+    std::atomic<bool> writing = true;
+    std::thread writer(
+        [&]()
+        {
+            std::vector<Handle<ConcurrentTestObject>> alive;
+            for (uint32_t i = 0; i < iterationCount; ++i)
+            {
+                alive.push_back(pool.create(uint32_t(i), {1, i}));
+                if (alive.size() == staleCount)
+                {
+                    for (auto handle : alive)
+                        pool.destroy(handle);
+                    alive.clear();
+                }
+            }
+            writing = false;
+        });
+
+    std::vector<uint32_t> found(readerCount, 0);
+    std::vector<std::thread> readers;
+    for (uint32_t r = 0; r < readerCount; ++r)
+    {
+        readers.emplace_back(
+            [&, r]()
+            {
+                while (writing)
+                {
+                    for (auto handle : staleHandles)
+                        found[r] += pool.getObjectPtr(handle) != nullptr || pool.getObjectDescPtr(handle) != nullptr;
+                }
+            });
+    }
+
+    writer.join();
+    for (auto& reader : readers)
+        reader.join();
+
+    for (uint32_t count : found)
+        REQUIRE(count == 0);
+}
+
+} // namespace gore::test
+#endif
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "Handle.h"
+
+#include <vector>
+#include <span>
+#include <unordered_map>
+#include <type_traits>
+#include <cstring>
+#include <cassert>
+
+// Checks on the lookup paths, a stale handle in release reads whatever lives in the slot now
+#if ENGINE_DEBUG
+    #define DENSE_POOL_CHECK(condition) assert(condition)
+#else
+    #define DENSE_POOL_CHECK(condition) ((void)0)
+#endif
+
+namespace gore
+{
+// Objects that can be found by their API handle declare 'GetNativeHandle(const T&)' next to T, found by ADL
+template <typename ImplObjectType>
+concept HasNativeHandle = requires(const ImplObjectType& obj) {
+    GetNativeHandle(obj);
+};
+
+// Same interface as Pool, but live objects and their descs are kept contiguous so iterating them touches no
+// destroyed entries. Handles point at a sparse slot which holds the index into the dense arrays, destroy moves the
+// last object into the hole. Pointers and references to objects are only stable until the next create or destroy.
+template <typename ObjectDesc, typename ImplObjectType>
+class DensePool
+{
+    static constexpr uint32_t kListEndSentinel = 0xffffffff;
+    struct Slot
+    {
+        uint32_t denseIndex = kListEndSentinel;
+        uint32_t gen        = 1;
+        uint32_t nextFree   = kListEndSentinel;
+    };
+
+    std::vector<Slot> _slots;
+    std::vector<uint32_t> _denseToSlot;
+    std::vector<ObjectDesc> _descs;
+    std::vector<ImplObjectType> _objects;
+    std::unordered_map<uint64_t, uint32_t> _nativeToSlot;
+    uint32_t _freeListHead = kListEndSentinel;
+
+    template <typename NativeHandle>
+    static uint64_t getNativeKey(const NativeHandle& nativeHandle)
+    {
+        // vulkan handles are pointers or 64 bit integers depending on the platform
+        static_assert(std::is_trivially_copyable_v<NativeHandle> && sizeof(NativeHandle) <= sizeof(uint64_t));
+        uint64_t key = 0;
+        memcpy(&key, &nativeHandle, sizeof(NativeHandle));
+        return key;
+    }
+
+    void addNativeHandle(uint32_t slotIndex)
+    {
+        if constexpr (HasNativeHandle<ImplObjectType>)
+        {
+            // objects without an API object yet all share the null handle, those are not searchable
+            const uint64_t key = getNativeKey(GetNativeHandle(_objects[_slots[slotIndex].denseIndex]));
+            if (key != 0)
+                _nativeToSlot[key] = slotIndex;
+        }
+    }
+
+    void removeNativeHandle(uint32_t slotIndex)
+    {
+        if constexpr (HasNativeHandle<ImplObjectType>)
+        {
+            const uint64_t key = getNativeKey(GetNativeHandle(_objects[_slots[slotIndex].denseIndex]));
+            auto it            = _nativeToSlot.find(key);
+            if (key != 0 && it != _nativeToSlot.end() && it->second == slotIndex)
+                _nativeToSlot.erase(it);
+        }
+    }
+
+    bool isAlive(Handle<ImplObjectType> handle) const
+    {
+        return !handle.empty() && handle.index() < _slots.size() && _slots[handle.index()].gen == handle.gen()
+            && _slots[handle.index()].denseIndex != kListEndSentinel;
+    }
+
+    uint32_t getDenseIndex(Handle<ImplObjectType> handle) const
+    {
+        DENSE_POOL_CHECK(!handle.empty());
+        DENSE_POOL_CHECK(handle.index() < _slots.size());
+        DENSE_POOL_CHECK(handle.gen() == _slots[handle.index()].gen); // accessing deleted object
+        return _slots[handle.index()].denseIndex;
+    }
+
+public:
+    Handle<ImplObjectType> create(ObjectDesc&& desc, ImplObjectType&& obj)
+    {
+        uint32_t idx = 0;
+        if (_freeListHead != kListEndSentinel)
+        {
+            idx           = _freeListHead;
+            _freeListHead = _slots[idx].nextFree;
+        }
+        else
+        {
+            idx = (uint32_t)_slots.size();
+            _slots.emplace_back();
+        }
+
+        _slots[idx].denseIndex = (uint32_t)_objects.size();
+        _slots[idx].nextFree   = kListEndSentinel;
+        _denseToSlot.push_back(idx);
+        _descs.emplace_back(std::move(desc));
+        _objects.emplace_back(std::move(obj));
+        addNativeHandle(idx);
+
+        return Handle<ImplObjectType>(idx, _slots[idx].gen);
+    }
+    void destroy(Handle<ImplObjectType> handle)
+    {
+        if (handle.empty())
+            return;
+        assert(isAlive(handle)); // double deletion
+
+        const uint32_t slotIndex  = handle.index();
+        const uint32_t denseIndex = _slots[slotIndex].denseIndex;
+        const uint32_t lastIndex  = (uint32_t)_objects.size() - 1;
+        removeNativeHandle(slotIndex);
+
+        if (denseIndex != lastIndex)
+        {
+            _objects[denseIndex]     = std::move(_objects[lastIndex]);
+            _descs[denseIndex]       = std::move(_descs[lastIndex]);
+            _denseToSlot[denseIndex] = _denseToSlot[lastIndex];
+
+            _slots[_denseToSlot[denseIndex]].denseIndex = denseIndex;
+        }
+        _objects.pop_back();
+        _descs.pop_back();
+        _denseToSlot.pop_back();
+
+        Slot& slot      = _slots[slotIndex];
+        slot.denseIndex = kListEndSentinel;
+        // a handle with gen 0 is empty, skip it when the counter wraps
+        slot.gen        = slot.gen + 1 == 0 ? 1 : slot.gen + 1;
+        slot.nextFree   = _freeListHead;
+        _freeListHead   = slotIndex;
+    }
+    bool valid(Handle<ImplObjectType> handle) const
+    {
+        return isAlive(handle);
+    }
+    const ImplObjectType& getObject(Handle<ImplObjectType> handle) const
+    {
+        return _objects[getDenseIndex(handle)];
+    }
+    ImplObjectType& getObject(Handle<ImplObjectType> handle)
+    {
+        return _objects[getDenseIndex(handle)];
+    }
+    // The Ptr variants always validate and return nullptr for empty or stale handles
+    const ImplObjectType* getObjectPtr(Handle<ImplObjectType> handle) const
+    {
+        return isAlive(handle) ? &_objects[_slots[handle.index()].denseIndex] : nullptr;
+    }
+    ImplObjectType* getObjectPtr(Handle<ImplObjectType> handle)
+    {
+        return isAlive(handle) ? &_objects[_slots[handle.index()].denseIndex] : nullptr;
+    }
+    const ObjectDesc& getObjectDesc(Handle<ImplObjectType> handle) const
+    {
+        return _descs[getDenseIndex(handle)];
+    }
+    ObjectDesc& getObjectDesc(Handle<ImplObjectType> handle)
+    {
+        return _descs[getDenseIndex(handle)];
+    }
+    const ObjectDesc* getObjectDescPtr(Handle<ImplObjectType> handle) const
+    {
+        return isAlive(handle) ? &_descs[_slots[handle.index()].denseIndex] : nullptr;
+    }
+    ObjectDesc* getObjectDescPtr(Handle<ImplObjectType> handle)
+    {
+        return isAlive(handle) ? &_descs[_slots[handle.index()].denseIndex] : nullptr;
+    }
+    // obj has to point into this pool, e.g. a pointer returned by getObjectPtr or taken while iterating
+    Handle<ImplObjectType> getObjectHandle(const ImplObjectType* obj) const
+    {
+        if (!obj || _objects.empty() || obj < _objects.data() || obj >= _objects.data() + _objects.size())
+            return {};
+
+        const uint32_t slotIndex = _denseToSlot[(uint32_t)(obj - _objects.data())];
+        return Handle<ImplObjectType>(slotIndex, _slots[slotIndex].gen);
+    }
+    // Reverse lookup from the API object, e.g. a VkBuffer coming back from a validation message or a capture
+    template <typename NativeHandle>
+        requires HasNativeHandle<ImplObjectType>
+    Handle<ImplObjectType> getObjectHandleFromNative(const NativeHandle& nativeHandle) const
+    {
+        auto it = _nativeToSlot.find(getNativeKey(nativeHandle));
+        if (it == _nativeToSlot.end())
+            return {};
+
+        return Handle<ImplObjectType>(it->second, _slots[it->second].gen);
+    }
+    // Re-keys the reverse lookup after the API object of a live object was replaced in place, previousNativeHandle is
+    // the one it had before
+    template <typename NativeHandle>
+        requires HasNativeHandle<ImplObjectType>
+    void updateNativeHandle(Handle<ImplObjectType> handle, const NativeHandle& previousNativeHandle)
+    {
+        DENSE_POOL_CHECK(isAlive(handle));
+        const uint32_t slotIndex = handle.index();
+
+        auto it = _nativeToSlot.find(getNativeKey(previousNativeHandle));
+        if (it != _nativeToSlot.end() && it->second == slotIndex)
+            _nativeToSlot.erase(it);
+        addNativeHandle(slotIndex);
+    }
+    // Handle of the object at position denseIndex of objects()
+    Handle<ImplObjectType> getHandle(uint32_t denseIndex) const
+    {
+        DENSE_POOL_CHECK(denseIndex < _denseToSlot.size());
+        const uint32_t slotIndex = _denseToSlot[denseIndex];
+        return Handle<ImplObjectType>(slotIndex, _slots[slotIndex].gen);
+    }
+    // Live objects only, objects()[i] was created with descs()[i]
+    std::span<ImplObjectType> objects()
+    {
+        return _objects;
+    }
+    std::span<const ImplObjectType> objects() const
+    {
+        return _objects;
+    }
+    std::span<ObjectDesc> descs()
+    {
+        return _descs;
+    }
+    std::span<const ObjectDesc> descs() const
+    {
+        return _descs;
+    }
+    auto begin()
+    {
+        return _objects.begin();
+    }
+    auto end()
+    {
+        return _objects.end();
+    }
+    auto begin() const
+    {
+        return _objects.begin();
+    }
+    auto end() const
+    {
+        return _objects.end();
+    }
+    void reserve(uint32_t count)
+    {
+        _slots.reserve(count);
+        _denseToSlot.reserve(count);
+        _descs.reserve(count);
+        _objects.reserve(count);
+    }
+    void clear()
+    {
+        _slots.clear();
+        _denseToSlot.clear();
+        _descs.clear();
+        _objects.clear();
+        _nativeToSlot.clear();
+        _freeListHead = kListEndSentinel;
+    }
+    uint32_t num() const
+    {
+        return (uint32_t)_objects.size();
+    }
+};
+} // namespace gore
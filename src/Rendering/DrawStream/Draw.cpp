@@ -1,10 +1,17 @@
 #include "Draw.h"
+#include "DrawSortKey.h"
 
 
 #include "Object/GameObject.h"
+#include "Object/Transform.h"
 
 #include "Rendering/Components/Material.h"
 #include "Rendering/Components/MeshRenderer.h"
+#include "Rendering/RenderContextHelper.h"
+#include "Rendering/UnifiedGeometryBuffer/UnifiedGeometryBuffer.h"
+
+#include <cassert>
+#include <span>
 
 namespace gore::renderer
 {
@@ -13,57 +20,97 @@ bool MatchDrawFilter(const Pass& pass, const DrawCreateInfo& info)
     return pass.name == info.passName;
 }
 
-void PrepareDrawDataAndSort(DrawCreateInfo& info
-    , std::vector<GameObject*>& gameObjects
-    , std::vector<Draw>& sortedDrawData
-    , Material* overrideMaterial)
+// The slot of the transform in the GPUTransformChangeSystem, which every renderer registers its transform with
+static uint32_t GetPerObjectDataIndex(const MeshRenderer& renderer)
 {
-    auto& renderContext = *RenderContext::GetInstance();
+    return renderer.GetGameObject()->GetTransform()->GetChangeSlot();
+}
 
-    for (uint32_t i = 0; i < gameObjects.size(); i++)
+uint32_t AppendRendererDraws(const DrawCreateInfo& info
+    , const MeshRenderer& renderer
+    , std::vector<Draw>& drawData
+    , const Material* overrideMaterial)
+{
+    if (renderer.IsValid() == false)
+        return 0;
+
+    if (info.skipUnifiedGeometry && renderer.GetUnifiedMeshIndex() != UnifiedGeometryBuffer::k_InvalidMesh)
+        return 0;
+
+    // without a slot the shaders would read the matrices of another object
+    uint32_t perObjectDataIndex = GetPerObjectDataIndex(renderer);
+    assert(perObjectDataIndex != TransformHierarchy::k_NoChangeSlot);
+    if (perObjectDataIndex == TransformHierarchy::k_NoChangeSlot)
+        return 0;
+
+    auto handle = overrideMaterial ? overrideMaterial->GetDynamicBuffer() : renderer.GetDynamicBuffer();
+
+    // a mesh without sub-meshes is drawn as a whole
+    SubMesh wholeMesh = {0, renderer.GetVertexCount(), 0, renderer.GetIndexCount()};
+    std::span<const SubMesh> subMeshes = renderer.GetSubMeshes();
+    if (subMeshes.empty())
+        subMeshes = {&wholeMesh, 1};
+
+    uint32_t drawCount       = 0;
+    const Material& material = overrideMaterial ? *overrideMaterial : renderer.GetMaterial();
+    for (const auto& pass : material.GetPasses())
     {
-        MeshRenderer* renderer = gameObjects[i]->GetComponent<MeshRenderer>();
-        if (renderer == nullptr)
+        if (MatchDrawFilter(pass, info) == false)
             continue;
 
-        if (renderer->IsValid() == false)
+        // packed vertices are drawn by the variant of the pass decoding them
+        GraphicsPipelineHandle shader = pass.GetShader(renderer.GetVertexLayout());
+        if (shader.empty() && pass.shader.empty() == false)
             continue;
 
-        auto handle         = overrideMaterial? overrideMaterial->GetDynamicBuffer() : renderer->GetDynamicBuffer();
-
-        Material& material = overrideMaterial ? *overrideMaterial : renderer->GetMaterial();
-        for (const auto& pass : material.GetPasses())
+        for (const SubMesh& subMesh : subMeshes)
         {
-            if (MatchDrawFilter(pass, info) == false)
-                continue;
-
             Draw draw;
             // assert(pass.shader.empty() == false);
 
-            draw.shader       = pass.shader;
+            draw.shader       = shader;
             draw.bindGroup[0] = pass.bindGroup[0];
             draw.bindGroup[1] = pass.bindGroup[1];
             draw.bindGroup[2] = pass.bindGroup[2];
 
             draw.dynamicBuffer       = handle;
-            draw.dynamicBufferOffset = renderer->GetDynamicBufferOffset();
+            draw.dynamicBufferOffset = perObjectDataIndex;
 
-            draw.vertexBuffer = renderer->GetVertexBuffer();
-            draw.vertexCount  = renderer->GetVertexCount();
-            draw.vertexOffset = renderer->GetVertexOffset();
+            draw.vertexBuffer = renderer.GetVertexBuffer();
+            draw.vertexCount  = subMesh.vertexCount;
+            draw.vertexOffset = renderer.GetVertexOffset() + subMesh.vertexOffset;
 
-            draw.indexBuffer = renderer->GetIndexBuffer();
-            draw.indexCount  = renderer->GetIndexCount();
-            draw.indexOffset = renderer->GetIndexOffset();
+            draw.indexBuffer = renderer.GetIndexBuffer();
+            draw.indexType   = renderer.GetIndexType();
+            draw.indexCount  = subMesh.indexCount;
+            draw.indexOffset = renderer.GetIndexOffset() + subMesh.indexOffset;
 
-            // TODO: instance Batch
+            // copies of the same mesh are merged into one instanced draw by BatchDraws
             draw.instanceCount = 1;
 
-            sortedDrawData.push_back(draw);
+            drawData.push_back(draw);
+            drawCount++;
         }
     }
 
-    std::sort(sortedDrawData.begin(), sortedDrawData.end(), DrawSorter());
+    return drawCount;
+}
+
+void PrepareDrawDataAndSort(DrawCreateInfo& info
+    , std::vector<GameObject*>& gameObjects
+    , std::vector<Draw>& sortedDrawData
+    , Material* overrideMaterial)
+{
+    for (uint32_t i = 0; i < gameObjects.size(); i++)
+    {
+        MeshRenderer* renderer = gameObjects[i]->GetComponent<MeshRenderer>();
+        if (renderer == nullptr)
+            continue;
+
+        AppendRendererDraws(info, *renderer, sortedDrawData, overrideMaterial);
+    }
+
+    SortDraws(sortedDrawData);
 }
 
 void ScheduleDraws(RenderContext& renderContext, const std::unordered_map<DrawKey, std::vector<Draw>>& drawData, const DrawKey& key, vk::CommandBuffer commandBuffer)
@@ -81,13 +128,15 @@ void ScheduleDraws(RenderContext& renderContext, const std::unordered_map<DrawKe
         if (draw.vertexBuffer.empty() == false)
         {
             auto& vertexBuffer = renderContext.GetBuffer(draw.vertexBuffer);
-            commandBuffer.bindVertexBuffers(0, {vertexBuffer.vkBuffer}, {draw.vertexOffset});
+            // the offsets are in vertices and indices and go to the draw, buffers shared by several meshes are bound at 0
+            commandBuffer.bindVertexBuffers(0, {vertexBuffer.vkBuffer}, {0});
         }
 
-        if (draw.indexBuffer.empty() == false)
+        bool indexed = draw.indexBuffer.empty() == false && draw.indexType != IndexType::None;
+        if (indexed)
         {
             auto& indexBuffer = renderContext.GetBuffer(draw.indexBuffer);
-            commandBuffer.bindIndexBuffer(indexBuffer.vkBuffer, draw.indexOffset, vk::IndexType::eUint16);
+            commandBuffer.bindIndexBuffer(indexBuffer.vkBuffer, 0, VulkanHelper::GetVkIndexType(draw.indexType));
         }
 
         if (draw.bindGroup[0].empty() == false)
@@ -114,7 +163,7 @@ void ScheduleDraws(RenderContext& renderContext, const std::unordered_map<DrawKe
             commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipeline.layout, 3, {dynamicBuffer.set}, {draw.dynamicBufferOffset});
         }
 
-        if (draw.indexBuffer.empty() == false)
+        if (indexed)
         {
             commandBuffer.drawIndexed(draw.indexCount, draw.instanceCount, draw.indexOffset, draw.vertexOffset, draw.instanceOffset);
         }
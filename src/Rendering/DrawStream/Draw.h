@@ -30,6 +30,8 @@ struct DrawCreateInfo
 {
     std::string passName = "";
     AlphaMode alphaMode  = AlphaMode::Opaque;
+    // renderers whose mesh is in the UnifiedGeometryBuffer are left out, they are drawn indirectly instead
+    bool skipUnifiedGeometry = false;
 };
 
 struct DrawKey
@@ -63,10 +65,11 @@ struct Draw
     DynamicBufferHandle dynamicBuffer = {};
     BufferHandle vertexBuffer         = {}; // BufferHandle vertexBuffers[3], VertexBuffer could be an array of buffers for instancing or multiple vertex buffers, but for now we only need one
     BufferHandle indexBuffer          = {};
+    IndexType indexType               = IndexType::None; // 16 and 32 bit indices share the index arena, None draws vertexCount vertices without indices
     uint32_t indexCount               = 0;
-    uint32_t indexOffset              = 0;
+    uint32_t indexOffset              = 0; // first index, meshes sharing a BufferArena block differ only in their offsets
     uint32_t vertexCount              = 0;
-    uint32_t vertexOffset             = 0;
+    uint32_t vertexOffset             = 0; // in vertices as well, buffers are always bound at 0
     uint32_t instanceCount            = 0;
     uint32_t instanceOffset           = 0;
     uint32_t dynamicBufferOffset      = 0;
@@ -96,25 +99,31 @@ struct DrawSorter
         if (a.dynamicBuffer.index() != b.dynamicBuffer.index())
             return a.dynamicBuffer.index() < b.dynamicBuffer.index();
 
-        if (a.dynamicBufferOffset != b.dynamicBufferOffset)
-            return a.dynamicBufferOffset < b.dynamicBufferOffset;
-
         if (a.vertexBuffer.index() != b.vertexBuffer.index())
             return a.vertexBuffer.index() < b.vertexBuffer.index();
 
         if (a.indexBuffer.index() != b.indexBuffer.index())
             return a.indexBuffer.index() < b.indexBuffer.index();
 
+        if (a.indexType != b.indexType)
+            return a.indexType < b.indexType;
+
         if (a.vertexOffset != b.vertexOffset)
             return a.vertexOffset < b.vertexOffset;
 
         if (a.indexOffset != b.indexOffset)
             return a.indexOffset < b.indexOffset;
 
+        // the per object data goes last, so copies of the same mesh end up next to each other and can be instanced
+        if (a.dynamicBufferOffset != b.dynamicBufferOffset)
+            return a.dynamicBufferOffset < b.dynamicBufferOffset;
+
         return false;
     }
 };
 
+// Appends one Draw per pass of the renderer's material (or the override material) that matches info
+uint32_t AppendRendererDraws(const DrawCreateInfo& info, const MeshRenderer& renderer, std::vector<Draw>& drawData, const Material* overrideMaterial = nullptr);
 void PrepareDrawDataAndSort(DrawCreateInfo& info, std::vector<GameObject*>& gameObjects, std::vector<Draw>& sortedDrawData, Material* overrideMaterial = nullptr);
 bool MatchDrawFilter(const Pass& pass, const DrawCreateInfo& info);
 void ScheduleDraws(RenderContext& renderContext, const std::unordered_map<DrawKey, std::vector<Draw>>& drawData, const DrawKey& key, vk::CommandBuffer commandBuffer);
@@ -0,0 +1,84 @@
+#include "DrawBatch.h"
+
+namespace gore::renderer
+{
+bool CanInstanceTogether(const Draw& a, const Draw& b)
+{
+    return a.shader == b.shader
+        && a.bindGroup[0] == b.bindGroup[0]
+        && a.bindGroup[1] == b.bindGroup[1]
+        && a.bindGroup[2] == b.bindGroup[2]
+        && a.dynamicBuffer == b.dynamicBuffer
+        && a.vertexBuffer == b.vertexBuffer
+        && a.indexBuffer == b.indexBuffer
+        && a.indexType == b.indexType
+        && a.indexCount == b.indexCount
+        && a.indexOffset == b.indexOffset
+        && a.vertexCount == b.vertexCount
+        && a.vertexOffset == b.vertexOffset;
+}
+
+static uint32_t CountStateChanges(const Draw& lastDraw, const Draw& draw)
+{
+    return (lastDraw.shader != draw.shader)
+         + (lastDraw.bindGroup[0] != draw.bindGroup[0])
+         + (lastDraw.bindGroup[1] != draw.bindGroup[1])
+         + (lastDraw.bindGroup[2] != draw.bindGroup[2])
+         + (lastDraw.dynamicBuffer != draw.dynamicBuffer || lastDraw.dynamicBufferOffset != draw.dynamicBufferOffset)
+         + (lastDraw.vertexBuffer != draw.vertexBuffer)
+         + (lastDraw.indexBuffer != draw.indexBuffer || lastDraw.indexType != draw.indexType);
+}
+
+static uint32_t CountStateChanges(const std::vector<Draw>& draws)
+{
+    uint32_t stateChangeCount = 0;
+    Draw lastDraw             = {};
+    for (const Draw& draw : draws)
+    {
+        stateChangeCount += CountStateChanges(lastDraw, draw);
+        lastDraw = draw;
+    }
+    return stateChangeCount;
+}
+
+void BatchDraws(const std::vector<Draw>& sortedDraws, std::vector<Draw>& batchedDraws, std::vector<uint32_t>& instanceIndices, DrawBatchStats* stats,
+                bool mergeInstances)
+{
+    batchedDraws.clear();
+    instanceIndices.clear();
+    instanceIndices.reserve(sortedDraws.size());
+
+    size_t runBegin = 0;
+    while (runBegin < sortedDraws.size())
+    {
+        const Draw& first = sortedDraws[runBegin];
+
+        size_t runEnd = runBegin + 1;
+        while (mergeInstances && runEnd < sortedDraws.size() && CanInstanceTogether(first, sortedDraws[runEnd]))
+        {
+            runEnd++;
+        }
+
+        Draw batch           = first;
+        batch.instanceOffset = static_cast<uint32_t>(instanceIndices.size());
+        batch.instanceCount  = 0;
+        for (size_t i = runBegin; i < runEnd; ++i)
+        {
+            // a draw that already was instanced brings all of its instances along
+            instanceIndices.insert(instanceIndices.end(), sortedDraws[i].instanceCount, sortedDraws[i].dynamicBufferOffset);
+            batch.instanceCount += sortedDraws[i].instanceCount;
+        }
+
+        batchedDraws.push_back(batch);
+        runBegin = runEnd;
+    }
+
+    if (stats != nullptr)
+    {
+        stats->drawCount               = static_cast<uint32_t>(sortedDraws.size());
+        stats->batchedDrawCount        = static_cast<uint32_t>(batchedDraws.size());
+        stats->stateChangeCount        = CountStateChanges(sortedDraws);
+        stats->batchedStateChangeCount = CountStateChanges(batchedDraws);
+    }
+}
+} // namespace gore::renderer
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Prefix.h"
+
+#include "Draw.h"
+
+#include <vector>
+
+namespace gore::renderer
+{
+// What batching saved, state changes count every pipeline, bind group, buffer and per object data switch between neighbours
+struct DrawBatchStats
+{
+    uint32_t drawCount               = 0;
+    uint32_t batchedDrawCount        = 0;
+    uint32_t stateChangeCount        = 0;
+    uint32_t batchedStateChangeCount = 0;
+};
+
+// Two draws can share an instanced draw when everything but their per object data matches
+bool CanInstanceTogether(const Draw& a, const Draw& b);
+
+// Collapses every run of draws that can be instanced together into one draw with instanceCount set to the run length.
+// The per object data index (dynamicBufferOffset) of every instance goes to instanceIndices, a batch finds its
+// instances at [instanceOffset, instanceOffset + instanceCount). A batch keeps the per object data of its first draw,
+// so a run of one draw comes out unchanged. sortedDraws has to be sorted with DrawSorter.
+// Without mergeInstances every draw stays on its own, for per object data that can only be bound per draw.
+void BatchDraws(const std::vector<Draw>& sortedDraws, std::vector<Draw>& batchedDraws, std::vector<uint32_t>& instanceIndices, DrawBatchStats* stats = nullptr,
+                bool mergeInstances = true);
+} // namespace gore::renderer
@@ -0,0 +1,166 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/DrawStream/DrawBatch.h"
+#include "Rendering/DrawStream/DrawSortKey.h"
+#include "Rendering/DrawStream/DrawStream.h"
+#include "Rendering/DrawStream/InstanceDataBinding.h"
+#include "Rendering/Pool.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::renderer;
+
+TEST_CASE("Copies of the same mesh are merged into instanced draws", "[DrawBatch]")
+{
+    Pool<int, GraphicsPipeline> pipelines;
+    Pool<int, Buffer> buffers;
+
+    std::vector<GraphicsPipelineHandle> pipelineHandles = {pipelines.create(0, GraphicsPipeline{}), pipelines.create(0, GraphicsPipeline{})};
+    std::vector<BufferHandle> meshBuffers               = {buffers.create(0, Buffer{}), buffers.create(0, Buffer{}), buffers.create(0, Buffer{})};
+
+    // 3 meshes with 2 pipelines, every object has its own per object data
+    std::mt19937 random(11);
+    std::vector<Draw> draws(3000);
+    for (uint32_t i = 0; i < draws.size(); ++i)
+    {
+        Draw& draw               = draws[i];
+        draw.shader              = pipelineHandles[random() % pipelineHandles.size()];
+        draw.vertexBuffer        = meshBuffers[random() % meshBuffers.size()];
+        draw.indexBuffer         = draw.vertexBuffer;
+        draw.indexType           = IndexType::UINT16;
+        draw.indexCount          = 36;
+        draw.instanceCount       = 1;
+        draw.dynamicBufferOffset = i;
+    }
+    SortDraws(draws);
+
+    std::vector<Draw> batchedDraws;
+    std::vector<uint32_t> instanceIndices;
+    DrawBatchStats stats;
+    BatchDraws(draws, batchedDraws, instanceIndices, &stats);
+
+    REQUIRE(batchedDraws.size() == 6);
+    REQUIRE(instanceIndices.size() == draws.size());
+    REQUIRE(stats.drawCount == 3000);
+    REQUIRE(stats.batchedDrawCount == 6);
+    REQUIRE(stats.batchedStateChangeCount < stats.stateChangeCount);
+
+    // expanding the batches again gives back the sorted draws
+    size_t drawIndex = 0;
+    for (const Draw& batch : batchedDraws)
+    {
+        for (uint32_t instance = 0; instance < batch.instanceCount; ++instance, ++drawIndex)
+        {
+            REQUIRE(CanInstanceTogether(batch, draws[drawIndex]));
+            REQUIRE(instanceIndices[batch.instanceOffset + instance] == draws[drawIndex].dynamicBufferOffset);
+        }
+    }
+    REQUIRE(drawIndex == draws.size());
+
+    SECTION("Draws that differ are left alone")
+    {
+        draws.resize(4);
+        draws[1].indexCount = 12;
+        draws[3].instanceCount = 3;
+
+        BatchDraws(draws, batchedDraws, instanceIndices, &stats);
+
+        REQUIRE(batchedDraws.size() == 3);
+        REQUIRE(batchedDraws[0].instanceCount == 1);
+        REQUIRE(batchedDraws[0].dynamicBufferOffset == draws[0].dynamicBufferOffset);
+        REQUIRE(batchedDraws[2].instanceCount == 4);
+        REQUIRE(instanceIndices.size() == 6);
+        REQUIRE(instanceIndices[5] == draws[3].dynamicBufferOffset);
+    }
+
+    SECTION("Draws stay on their own without merging instances")
+    {
+        BatchDraws(draws, batchedDraws, instanceIndices, &stats, false);
+
+        REQUIRE(batchedDraws.size() == draws.size());
+        REQUIRE(instanceIndices.size() == draws.size());
+        REQUIRE(stats.batchedDrawCount == stats.drawCount);
+        REQUIRE(stats.batchedStateChangeCount == stats.stateChangeCount);
+        for (size_t i = 0; i < draws.size(); ++i)
+        {
+            REQUIRE(batchedDraws[i].instanceCount == 1);
+            REQUIRE(batchedDraws[i].dynamicBufferOffset == draws[i].dynamicBufferOffset);
+        }
+    }
+}
+
+TEST_CASE("Instance data storage policy benchmark", "[DrawBatch][.benchmark]")
+{
+    Pool<int, GraphicsPipeline> pipelines;
+    Pool<int, Buffer> buffers;
+
+    std::vector<GraphicsPipelineHandle> pipelineHandles = {pipelines.create(0, GraphicsPipeline{}), pipelines.create(0, GraphicsPipeline{})};
+    std::vector<BufferHandle> meshBuffers;
+    for (int i = 0; i < 16; ++i)
+        meshBuffers.push_back(buffers.create(0, Buffer{}));
+
+    // what a frame costs on the CPU and how many bytes of per object data it binds or pushes, the GPU side is not measured here
+    for (uint32_t objectCount : {10000u, 50000u, 200000u})
+    {
+        std::mt19937 random(5);
+        std::vector<Draw> draws(objectCount);
+        for (uint32_t i = 0; i < objectCount; ++i)
+        {
+            Draw& draw               = draws[i];
+            draw.shader              = pipelineHandles[random() % pipelineHandles.size()];
+            draw.vertexBuffer        = meshBuffers[random() % meshBuffers.size()];
+            draw.indexBuffer         = draw.vertexBuffer;
+            draw.indexCount          = 36;
+            draw.instanceCount       = 1;
+            draw.dynamicBufferOffset = i;
+        }
+        SortDraws(draws);
+
+        for (InstanceDataStoragePolicy policy : {InstanceDataStoragePolicy::PersistentDynamicUniformBuffer,
+                                                 InstanceDataStoragePolicy::PerDrawPushConstant,
+                                                 InstanceDataStoragePolicy::PersistentStructuredBuffer})
+        {
+            std::string name = policy == InstanceDataStoragePolicy::PersistentDynamicUniformBuffer ? "Dynamic uniform buffer"
+                             : policy == InstanceDataStoragePolicy::PerDrawPushConstant            ? "Push constant"
+                                                                                                   : "Structured buffer";
+            bool mergeInstances = policy == InstanceDataStoragePolicy::PersistentStructuredBuffer;
+
+            std::vector<Draw> batchedDraws;
+            std::vector<uint32_t> instanceIndices;
+            BatchDraws(draws, batchedDraws, instanceIndices, nullptr, mergeInstances);
+
+            // a dynamic offset or 64 bytes of push constants per draw, the structured buffer pushes where its indices start per pipeline
+            size_t boundByteSize = 0;
+            if (policy == InstanceDataStoragePolicy::PersistentDynamicUniformBuffer)
+                boundByteSize = batchedDraws.size() * sizeof(uint32_t);
+            else if (policy == InstanceDataStoragePolicy::PerDrawPushConstant)
+                boundByteSize = batchedDraws.size() * 64;
+            else
+                boundByteSize = pipelineHandles.size() * sizeof(uint32_t);
+
+            WARN(name + ", " + std::to_string(objectCount) + " objects: " + std::to_string(batchedDraws.size()) + " draws, "
+                 + std::to_string(boundByteSize) + " bytes bound per frame, "
+                 + std::to_string(mergeInstances ? instanceIndices.size() * sizeof(uint32_t) : 0) + " bytes of instance indices uploaded when the draws change");
+
+            utils::LinearArena arena;
+            DrawStream stream;
+            BENCHMARK(name + " batch and encode, " + std::to_string(objectCount) + " objects")
+            {
+                BatchDraws(draws, batchedDraws, instanceIndices, nullptr, mergeInstances);
+                arena.Reset();
+                CreateDrawStreamFromDrawData(batchedDraws, arena, stream, DrawStreamEncoding::Compact);
+                return stream.data.size();
+            };
+        }
+    }
+}
+
+} // namespace gore::test
+#endif
@@ -0,0 +1,308 @@
+#include "DrawCache.h"
+#include "DrawSortKey.h"
+
+#include "Core/JobSystem.h"
+#include "Object/GameObject.h"
+#include "Scene/Scene.h"
+
+#include "Rendering/Components/MeshRenderer.h"
+
+#include "Profiler/microprofile.h"
+
+#include <algorithm>
+
+MICROPROFILE_DEFINE(g_DrawCacheRebuild, "RenderSystemLoop", "DrawCacheRebuild", MP_BLUE);
+MICROPROFILE_DEFINE(g_DrawCachePatch, "RenderSystemLoop", "DrawCachePatch", MP_BLUE);
+
+namespace gore::renderer
+{
+SINGLETON_IMPL(DrawCache)
+
+// Sorts draws with DrawSorter and keeps owners in the same order
+static void SortDrawsWithOwners(std::vector<Draw>& draws, std::vector<const MeshRenderer*>& owners)
+{
+    std::vector<uint32_t> order;
+    SortDrawIndices(draws, order);
+
+    std::vector<Draw> sortedDraws;
+    std::vector<const MeshRenderer*> sortedOwners;
+    sortedDraws.reserve(draws.size());
+    sortedOwners.reserve(owners.size());
+    for (uint32_t index : order)
+    {
+        sortedDraws.push_back(draws[index]);
+        sortedOwners.push_back(owners[index]);
+    }
+
+    draws.swap(sortedDraws);
+    owners.swap(sortedOwners);
+}
+
+DrawCache::DrawCache() :
+    m_DrawLists(),
+    m_ChangedRenderers(),
+    m_RemovedRenderers(),
+    m_Scene(nullptr),
+    m_NeedsFullRebuild(true),
+    m_MaxSubStreamCount(1),
+    m_MinDrawsPerSubStream(k_DefaultMinDrawsPerSubStream),
+    m_DrawStreamEncoding(DrawStreamEncoding::Full),
+    m_Instancing(true),
+    m_StreamArena(),
+    m_FullRebuildCount(0),
+    m_IncrementalPatchCount(0),
+    m_EncodeCount(0)
+{
+    g_Instance = this;
+}
+
+DrawCache::~DrawCache()
+{
+    g_Instance = nullptr;
+}
+
+void DrawCache::AddDrawList(const DrawCreateInfo& info, const Material* overrideMaterial)
+{
+    DrawKey key   = {};
+    key.passName  = info.passName;
+    key.alphaMode = info.alphaMode;
+
+    DrawList& drawList        = m_DrawLists[key];
+    drawList.info             = info;
+    drawList.overrideMaterial = overrideMaterial;
+
+    m_NeedsFullRebuild = true;
+}
+
+void DrawCache::OnRendererChanged(MeshRenderer* renderer)
+{
+    m_ChangedRenderers.insert(renderer);
+}
+
+void DrawCache::OnRendererRemoved(MeshRenderer* renderer)
+{
+    // the address might be reused by a new renderer before the next Update, which then shows up as changed again
+    m_ChangedRenderers.erase(renderer);
+    m_RemovedRenderers.insert(renderer);
+}
+
+void DrawCache::Update(Scene* scene)
+{
+    if (scene != m_Scene)
+    {
+        m_Scene            = scene;
+        m_NeedsFullRebuild = true;
+    }
+
+    if (m_NeedsFullRebuild)
+    {
+        Rebuild(scene);
+    }
+    else if (!m_ChangedRenderers.empty() || !m_RemovedRenderers.empty())
+    {
+        Patch(scene);
+    }
+
+    m_ChangedRenderers.clear();
+    m_RemovedRenderers.clear();
+}
+
+DrawStream* DrawCache::GetDrawStream(const DrawKey& key)
+{
+    auto it = m_DrawLists.find(key);
+    return it == m_DrawLists.end() ? nullptr : &it->second.drawStream;
+}
+
+std::vector<DrawStream>* DrawCache::GetDrawSubStreams(const DrawKey& key)
+{
+    auto it = m_DrawLists.find(key);
+    return it == m_DrawLists.end() ? nullptr : &it->second.subStreams;
+}
+
+void DrawCache::SetSubStreamSplit(uint32_t maxRangeCount, uint32_t minDrawsPerRange)
+{
+    m_MaxSubStreamCount    = maxRangeCount;
+    m_MinDrawsPerSubStream = minDrawsPerRange;
+
+    EncodeDrawLists();
+}
+
+void DrawCache::SetDrawStreamEncoding(DrawStreamEncoding encoding)
+{
+    m_DrawStreamEncoding = encoding;
+
+    EncodeDrawLists();
+}
+
+void DrawCache::SetInstancing(bool enabled)
+{
+    m_Instancing = enabled;
+
+    EncodeDrawLists();
+}
+
+std::vector<DrawKey> DrawCache::GetDrawKeys() const
+{
+    std::vector<DrawKey> keys;
+    keys.reserve(m_DrawLists.size());
+    for (const auto& [key, drawList] : m_DrawLists)
+        keys.push_back(key);
+    return keys;
+}
+
+const std::vector<Draw>* DrawCache::GetBatchedDraws(const DrawKey& key) const
+{
+    auto it = m_DrawLists.find(key);
+    return it == m_DrawLists.end() ? nullptr : &it->second.batchedDraws;
+}
+
+const std::vector<uint32_t>* DrawCache::GetInstanceIndices(const DrawKey& key) const
+{
+    auto it = m_DrawLists.find(key);
+    return it == m_DrawLists.end() ? nullptr : &it->second.instanceIndices;
+}
+
+const DrawBatchStats* DrawCache::GetBatchStats(const DrawKey& key) const
+{
+    auto it = m_DrawLists.find(key);
+    return it == m_DrawLists.end() ? nullptr : &it->second.batchStats;
+}
+
+const std::vector<Draw>* DrawCache::GetDraws(const DrawKey& key) const
+{
+    auto it = m_DrawLists.find(key);
+    return it == m_DrawLists.end() ? nullptr : &it->second.draws;
+}
+
+void DrawCache::Rebuild(Scene* scene)
+{
+    MICROPROFILE_SCOPE(g_DrawCacheRebuild);
+
+    for (auto& [key, drawList] : m_DrawLists)
+    {
+        drawList.draws.clear();
+        drawList.owners.clear();
+        if (scene == nullptr)
+            continue;
+
+        for (GameObject* gameObject : scene->GetGameObjects())
+        {
+            MeshRenderer* renderer = gameObject->GetComponent<MeshRenderer>();
+            if (renderer == nullptr)
+                continue;
+
+            uint32_t drawCount = AppendRendererDraws(drawList.info, *renderer, drawList.draws, drawList.overrideMaterial);
+            drawList.owners.insert(drawList.owners.end(), drawCount, renderer);
+        }
+
+        SortDrawsWithOwners(drawList.draws, drawList.owners);
+    }
+
+    EncodeDrawLists();
+
+    m_NeedsFullRebuild = false;
+    m_FullRebuildCount++;
+    MICROPROFILE_COUNTER_ADD("DrawCache/FullRebuild", 1);
+}
+
+void DrawCache::Patch(Scene* scene)
+{
+    MICROPROFILE_SCOPE(g_DrawCachePatch);
+
+    for (auto& [key, drawList] : m_DrawLists)
+    {
+        PatchDrawList(drawList, scene);
+    }
+
+    EncodeDrawLists();
+
+    m_IncrementalPatchCount++;
+    MICROPROFILE_COUNTER_ADD("DrawCache/IncrementalPatch", 1);
+}
+
+void DrawCache::PatchDrawList(DrawList& drawList, Scene* scene)
+{
+    // draws of the changed renderers, sorted on their own
+    std::vector<Draw> newDraws;
+    std::vector<const MeshRenderer*> newOwners;
+    for (MeshRenderer* renderer : m_ChangedRenderers)
+    {
+        if (renderer->GetGameObject()->GetScene() != scene)
+            continue;
+
+        uint32_t drawCount = AppendRendererDraws(drawList.info, *renderer, newDraws, drawList.overrideMaterial);
+        newOwners.insert(newOwners.end(), drawCount, renderer);
+    }
+    SortDrawsWithOwners(newDraws, newOwners);
+
+    auto isStale = [this](const MeshRenderer* owner)
+    {
+        return m_RemovedRenderers.contains(owner) || m_ChangedRenderers.contains(const_cast<MeshRenderer*>(owner));
+    };
+
+    // single merge pass: drop the stale draws and insert the new ones in order
+    std::vector<Draw> draws;
+    std::vector<const MeshRenderer*> owners;
+    draws.reserve(drawList.draws.size() + newDraws.size());
+    owners.reserve(drawList.owners.size() + newOwners.size());
+
+    size_t oldIndex = 0;
+    size_t newIndex = 0;
+    while (oldIndex < drawList.draws.size() || newIndex < newDraws.size())
+    {
+        if (oldIndex < drawList.draws.size() && isStale(drawList.owners[oldIndex]))
+        {
+            oldIndex++;
+            continue;
+        }
+
+        bool takeNew = oldIndex == drawList.draws.size()
+                    || (newIndex < newDraws.size() && DrawSorter()(newDraws[newIndex], drawList.draws[oldIndex]));
+
+        if (takeNew)
+        {
+            draws.push_back(newDraws[newIndex]);
+            owners.push_back(newOwners[newIndex]);
+            newIndex++;
+        }
+        else
+        {
+            draws.push_back(drawList.draws[oldIndex]);
+            owners.push_back(drawList.owners[oldIndex]);
+            oldIndex++;
+        }
+    }
+
+    drawList.draws.swap(draws);
+    drawList.owners.swap(owners);
+}
+
+void DrawCache::EncodeDrawLists()
+{
+    // the streams of the last encode have been recorded by now, their memory is reused instead of freed
+    m_StreamArena.Reset();
+
+    DrawBatchStats totalStats = {};
+    for (auto& [key, drawList] : m_DrawLists)
+    {
+        BatchDraws(drawList.draws, drawList.batchedDraws, drawList.instanceIndices, &drawList.batchStats, m_Instancing);
+
+        totalStats.drawCount += drawList.batchStats.drawCount;
+        totalStats.batchedDrawCount += drawList.batchStats.batchedDrawCount;
+        totalStats.stateChangeCount += drawList.batchStats.stateChangeCount;
+        totalStats.batchedStateChangeCount += drawList.batchStats.batchedStateChangeCount;
+
+        CreateDrawStreamFromDrawData(drawList.batchedDraws, m_StreamArena, drawList.drawStream, m_DrawStreamEncoding);
+
+        auto ranges = SplitDrawData(static_cast<uint32_t>(drawList.batchedDraws.size()), m_MaxSubStreamCount, m_MinDrawsPerSubStream);
+        CreateDrawStreamsFromDrawData(drawList.batchedDraws, ranges, m_StreamArena, drawList.subStreams, JobSystem::GetInstance(), m_DrawStreamEncoding);
+    }
+
+    m_EncodeCount++;
+
+    MICROPROFILE_COUNTER_SET("DrawCache/Draws", totalStats.drawCount);
+    MICROPROFILE_COUNTER_SET("DrawCache/InstancedDraws", totalStats.batchedDrawCount);
+    MICROPROFILE_COUNTER_SET("DrawCache/StateChanges", totalStats.stateChangeCount);
+    MICROPROFILE_COUNTER_SET("DrawCache/InstancedStateChanges", totalStats.batchedStateChangeCount);
+}
+} // namespace gore::renderer
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Prefix.h"
+#include "Export.h"
+
+#include "Draw.h"
+#include "DrawBatch.h"
+#include "DrawStream.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace gore
+{
+class Scene;
+} // namespace gore
+
+namespace gore::renderer
+{
+class MeshRenderer;
+
+// Keeps the sorted draw list and the encoded DrawStream of every registered DrawKey across frames.
+// MeshRenderers report themselves when they are created, destroyed, or when their material or mesh changes.
+// Update() then only patches the draws of those renderers, a static scene costs nothing.
+ENGINE_CLASS(DrawCache) final
+{
+    SINGLETON(DrawCache)
+
+public:
+    DrawCache();
+    ~DrawCache();
+
+    void AddDrawList(const DrawCreateInfo& info, const Material* overrideMaterial = nullptr);
+
+    void Update(Scene * scene);
+
+    [[nodiscard]] DrawStream* GetDrawStream(const DrawKey& key);
+    // The same draws split into self-contained sub-streams, so each of them can be recorded on its own thread
+    [[nodiscard]] std::vector<DrawStream>* GetDrawSubStreams(const DrawKey& key);
+    [[nodiscard]] const std::vector<Draw>* GetDraws(const DrawKey& key) const;
+    // The draws the streams are encoded from, copies of the same mesh merged into instanced draws
+    [[nodiscard]] const std::vector<Draw>* GetBatchedDraws(const DrawKey& key) const;
+    // Per object data index of every instance, indexed by the instanceOffset of the batched draws
+    [[nodiscard]] const std::vector<uint32_t>* GetInstanceIndices(const DrawKey& key) const;
+    [[nodiscard]] const DrawBatchStats* GetBatchStats(const DrawKey& key) const;
+
+    void OnRendererChanged(MeshRenderer * renderer);
+    void OnRendererRemoved(MeshRenderer * renderer);
+
+    // Throws away everything, the next Update walks the whole scene again
+    void Invalidate() { m_NeedsFullRebuild = true; }
+
+    // recording a secondary command buffer has a fixed cost, short ranges are not worth a job
+    static constexpr uint32_t k_DefaultMinDrawsPerSubStream = 256;
+
+    // Draw lists are split into at most maxRangeCount sub-streams of at least minDrawsPerRange draws
+    void SetSubStreamSplit(uint32_t maxRangeCount, uint32_t minDrawsPerRange = k_DefaultMinDrawsPerSubStream);
+    void SetDrawStreamEncoding(DrawStreamEncoding encoding);
+    // Copies of the same mesh are only merged into instanced draws when the shaders can look up per object data by instance
+    void SetInstancing(bool enabled);
+
+    [[nodiscard]] std::vector<DrawKey> GetDrawKeys() const;
+
+    GETTER(uint32_t, FullRebuildCount)
+    GETTER(uint32_t, IncrementalPatchCount)
+    // Goes up whenever a renderer was added, removed or changed its mesh or material, or everything was rebuilt
+    [[nodiscard]] uint32_t GetChangeCount() const { return m_FullRebuildCount + m_IncrementalPatchCount; }
+    // Goes up whenever the streams and instance indices are made again
+    GETTER(uint32_t, EncodeCount)
+
+private:
+    struct DrawList
+    {
+        DrawCreateInfo info               = {};
+        const Material* overrideMaterial  = nullptr;
+        // draws and owners are kept in the same order, sorted with DrawSorter
+        std::vector<Draw> draws           = {};
+        std::vector<const MeshRenderer*> owners = {};
+        std::vector<Draw> batchedDraws    = {};
+        std::vector<uint32_t> instanceIndices = {};
+        DrawBatchStats batchStats         = {};
+        DrawStream drawStream             = {};
+        std::vector<DrawStream> subStreams = {};
+    };
+
+    void Rebuild(Scene * scene);
+    void Patch(Scene * scene);
+    void PatchDrawList(DrawList & drawList, Scene * scene);
+    // Batches and encodes every draw list again, all of them share one arena that is rewound first
+    void EncodeDrawLists();
+
+private:
+    std::unordered_map<DrawKey, DrawList> m_DrawLists;
+
+    std::unordered_set<MeshRenderer*> m_ChangedRenderers;
+    std::unordered_set<const MeshRenderer*> m_RemovedRenderers;
+
+    Scene* m_Scene;
+    bool m_NeedsFullRebuild;
+
+    uint32_t m_MaxSubStreamCount;
+    uint32_t m_MinDrawsPerSubStream;
+    DrawStreamEncoding m_DrawStreamEncoding;
+    bool m_Instancing;
+
+    // backs the bytes of every DrawStream above
+    utils::LinearArena m_StreamArena;
+
+    uint32_t m_FullRebuildCount;
+    uint32_t m_IncrementalPatchCount;
+    uint32_t m_EncodeCount;
+};
+} // namespace gore::renderer
@@ -0,0 +1,122 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/DrawStream/DrawCache.h"
+#include "Rendering/Components/MeshRenderer.h"
+#include "Rendering/Pool.h"
+#include "Rendering/System/GPUTransformChangeSystem.h"
+
+#include "Object/GameObject.h"
+#include "Scene/Scene.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::renderer;
+
+// Handles can only be made by a Pool, the objects behind them are never touched by the cache
+struct FakeHandles
+{
+    Pool<int, GraphicsPipeline> pipelines;
+    Pool<int, Buffer> buffers;
+
+    GraphicsPipelineHandle NewPipeline() { return pipelines.create(0, GraphicsPipeline{}); }
+    BufferHandle NewBuffer() { return buffers.create(0, Buffer{}); }
+};
+
+static Material MakeMaterial(GraphicsPipelineHandle shader)
+{
+    Material material;
+    Pass pass   = {};
+    pass.name   = "ForwardPass";
+    pass.shader = shader;
+    material.AddPass(pass);
+    return material;
+}
+
+static MeshRenderer* NewRenderer(Scene& scene, FakeHandles& handles, const Material& material)
+{
+    MeshRenderer* renderer = scene.NewObject()->AddComponent<MeshRenderer>();
+    renderer->SetVertexBuffer(handles.NewBuffer());
+    renderer->SetVertexCount(3);
+    renderer->SetIndexBuffer(handles.NewBuffer());
+    renderer->SetIndexType(IndexType::UINT16);
+    renderer->SetIndexCount(3);
+    renderer->SetMaterial(material);
+    return renderer;
+}
+
+TEST_CASE("DrawCache only patches what changed", "[DrawCache]")
+{
+    FakeHandles handles;
+    std::vector<GraphicsPipelineHandle> pipelines = {handles.NewPipeline(), handles.NewPipeline(), handles.NewPipeline()};
+
+    DrawCache drawCache;
+    DrawCreateInfo info = {};
+    info.passName       = "ForwardPass";
+    drawCache.AddDrawList(info);
+
+    DrawKey key   = {};
+    key.passName  = info.passName;
+    key.alphaMode = info.alphaMode;
+
+    // renderers are only drawn with a slot for their transform
+    GPUTransformChangeSystem transformChangeSystem;
+    Scene scene("DrawCacheTest");
+    std::vector<MeshRenderer*> renderers;
+    for (int i = 0; i < 32; ++i)
+    {
+        renderers.push_back(NewRenderer(scene, handles, MakeMaterial(pipelines[i % 2])));
+    }
+
+    drawCache.Update(&scene);
+    REQUIRE(drawCache.GetFullRebuildCount() == 1);
+    REQUIRE(drawCache.GetDraws(key)->size() == 32);
+    REQUIRE(drawCache.GetDrawStream(key)->data.empty() == false);
+
+    SECTION("A static scene does nothing")
+    {
+        drawCache.Update(&scene);
+        drawCache.Update(&scene);
+        REQUIRE(drawCache.GetFullRebuildCount() == 1);
+        REQUIRE(drawCache.GetIncrementalPatchCount() == 0);
+    }
+
+    SECTION("Changes are patched in sorted order")
+    {
+        renderers[3]->SetMaterial(MakeMaterial(pipelines[2]));
+        NewRenderer(scene, handles, MakeMaterial(pipelines[0]));
+        renderers[10]->GetGameObject()->Destroy();
+
+        drawCache.Update(&scene);
+        REQUIRE(drawCache.GetFullRebuildCount() == 1);
+        REQUIRE(drawCache.GetIncrementalPatchCount() == 1);
+
+        const std::vector<Draw>& draws = *drawCache.GetDraws(key);
+        REQUIRE(draws.size() == 32);
+        REQUIRE(std::is_sorted(draws.begin(), draws.end(), DrawSorter()));
+        REQUIRE(draws.back().shader == pipelines[2]);
+
+        // patched result has the same draws as building everything from scratch
+        std::vector<Draw> expected;
+        std::vector<GameObject*> gameObjects = scene.GetGameObjects();
+        PrepareDrawDataAndSort(info, gameObjects, expected);
+        REQUIRE(expected.size() == draws.size());
+        for (size_t i = 0; i < draws.size(); ++i)
+        {
+            REQUIRE(draws[i].shader == expected[i].shader);
+        }
+    }
+
+    SECTION("Switching scenes rebuilds")
+    {
+        Scene otherScene("DrawCacheOtherScene");
+        drawCache.Update(&otherScene);
+        REQUIRE(drawCache.GetFullRebuildCount() == 2);
+        REQUIRE(drawCache.GetDraws(key)->empty());
+    }
+}
+} // namespace gore::test
+#endif
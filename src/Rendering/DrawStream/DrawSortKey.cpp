@@ -0,0 +1,185 @@
+#include "DrawSortKey.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <numeric>
+
+namespace gore::renderer
+{
+// below this, the setup of the radix sort costs more than it saves
+static constexpr size_t k_MinRadixSortCount = 64;
+static constexpr uint32_t k_RadixBits       = 8;
+static constexpr uint32_t k_RadixSize       = 1u << k_RadixBits;
+static constexpr uint32_t k_RadixPassCount  = 64 / k_RadixBits;
+
+struct DrawSortItem
+{
+    uint64_t key;
+    uint32_t index;
+};
+
+// Same fields and priority as DrawSorter
+static inline std::array<uint32_t, DrawSortKeyLayout::k_FieldCount> GetSortFields(const Draw& draw)
+{
+    return {
+        draw.shader.index(),
+        draw.bindGroup[0].index(),
+        draw.bindGroup[1].index(),
+        draw.bindGroup[2].index(),
+        draw.dynamicBuffer.index(),
+        draw.vertexBuffer.index(),
+        draw.indexBuffer.index(),
+        static_cast<uint32_t>(draw.indexType),
+        draw.vertexOffset,
+        draw.indexOffset,
+        draw.dynamicBufferOffset,
+    };
+}
+
+DrawSortKeyLayout CreateDrawSortKeyLayout(const std::vector<Draw>& draws)
+{
+    std::array<uint32_t, DrawSortKeyLayout::k_FieldCount> maxValues = {};
+    for (const Draw& draw : draws)
+    {
+        auto fields = GetSortFields(draw);
+        for (uint32_t i = 0; i < DrawSortKeyLayout::k_FieldCount; ++i)
+        {
+            maxValues[i] = std::max(maxValues[i], fields[i]);
+        }
+    }
+
+    DrawSortKeyLayout layout = {};
+    for (uint32_t i = 0; i < DrawSortKeyLayout::k_FieldCount; ++i)
+    {
+        layout.bits[i] = static_cast<uint8_t>(std::bit_width(maxValues[i]));
+        layout.totalBits += layout.bits[i];
+    }
+
+    return layout;
+}
+
+// Packs the fields from the top of the key down, whatever does not fit in 64 bits is cut off
+static inline uint64_t CreateSortKey(const Draw& draw, const DrawSortKeyLayout& layout)
+{
+    // every field is 0 in every draw, there is nothing to shift down
+    if (layout.totalBits == 0)
+        return 0;
+
+    auto fields = GetSortFields(draw);
+
+    uint64_t key       = 0;
+    uint32_t freeBits = 64;
+    for (uint32_t i = 0; i < DrawSortKeyLayout::k_FieldCount && freeBits > 0; ++i)
+    {
+        uint32_t bits = layout.bits[i];
+        if (bits <= freeBits)
+        {
+            freeBits -= bits;
+            key |= static_cast<uint64_t>(fields[i]) << freeBits;
+        }
+        else
+        {
+            key |= static_cast<uint64_t>(fields[i]) >> (bits - freeBits);
+            freeBits = 0;
+        }
+    }
+
+    // keep the used bits at the bottom so the passes over the unused digits can be skipped
+    return layout.totalBits < 64 ? key >> (64 - layout.totalBits) : key;
+}
+
+void SortDrawIndices(const std::vector<Draw>& draws, std::vector<uint32_t>& order)
+{
+    order.resize(draws.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    auto drawSorter = [&draws](uint32_t a, uint32_t b)
+    { return DrawSorter()(draws[a], draws[b]); };
+
+    if (draws.size() < k_MinRadixSortCount)
+    {
+        std::stable_sort(order.begin(), order.end(), drawSorter);
+        return;
+    }
+
+    DrawSortKeyLayout layout = CreateDrawSortKeyLayout(draws);
+
+    // all the histograms are built in a single pass over the keys
+    std::vector<DrawSortItem> items(draws.size());
+    std::array<std::array<uint32_t, k_RadixSize>, k_RadixPassCount> histograms = {};
+    for (uint32_t i = 0; i < draws.size(); ++i)
+    {
+        uint64_t key = CreateSortKey(draws[i], layout);
+        items[i]     = {key, i};
+
+        for (uint32_t pass = 0; pass < k_RadixPassCount; ++pass)
+        {
+            histograms[pass][(key >> (pass * k_RadixBits)) & (k_RadixSize - 1)]++;
+        }
+    }
+
+    // least significant digit first, every pass is a stable counting sort
+    std::vector<DrawSortItem> scratch(items.size());
+    for (uint32_t pass = 0; pass < k_RadixPassCount; ++pass)
+    {
+        auto& histogram = histograms[pass];
+        uint32_t shift  = pass * k_RadixBits;
+
+        // nothing to do when every key has the same digit
+        if (histogram[(items[0].key >> shift) & (k_RadixSize - 1)] == items.size())
+            continue;
+
+        uint32_t offset = 0;
+        for (uint32_t& count : histogram)
+        {
+            uint32_t bucketSize = count;
+            count               = offset;
+            offset += bucketSize;
+        }
+
+        for (const DrawSortItem& item : items)
+        {
+            scratch[histogram[(item.key >> shift) & (k_RadixSize - 1)]++] = item;
+        }
+
+        items.swap(scratch);
+    }
+
+    for (uint32_t i = 0; i < items.size(); ++i)
+    {
+        order[i] = items[i].index;
+    }
+
+    if (layout.totalBits <= 64)
+        return;
+
+    // the key only covers the most significant fields, the rest breaks ties within runs of equal keys
+    size_t runBegin = 0;
+    for (size_t i = 1; i <= items.size(); ++i)
+    {
+        if (i < items.size() && items[i].key == items[runBegin].key)
+            continue;
+
+        if (i - runBegin > 1)
+            std::stable_sort(order.begin() + runBegin, order.begin() + i, drawSorter);
+
+        runBegin = i;
+    }
+}
+
+void SortDraws(std::vector<Draw>& draws)
+{
+    std::vector<uint32_t> order;
+    SortDrawIndices(draws, order);
+
+    std::vector<Draw> sortedDraws;
+    sortedDraws.reserve(draws.size());
+    for (uint32_t index : order)
+    {
+        sortedDraws.push_back(draws[index]);
+    }
+
+    draws.swap(sortedDraws);
+}
+} // namespace gore::renderer
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Prefix.h"
+
+#include "Draw.h"
+
+#include <vector>
+
+namespace gore::renderer
+{
+// Radix sort replacement for std::sort with DrawSorter.
+// Every field DrawSorter looks at is packed into a 64 bit key, most significant field first.
+// Each field only gets as many bits as the biggest value in the draw list needs.
+// When the fields need more than 64 bits, the key holds the top 64 of them and the draws
+// sharing a key are sorted with DrawSorter afterwards, so the result always matches DrawSorter.
+// Draws that compare equal keep their input order.
+struct DrawSortKeyLayout
+{
+    static constexpr uint32_t k_FieldCount = 11;
+
+    uint8_t bits[k_FieldCount] = {};
+    uint32_t totalBits         = 0;
+};
+
+DrawSortKeyLayout CreateDrawSortKeyLayout(const std::vector<Draw>& draws);
+
+// Fills order with the indices of draws in DrawSorter order
+void SortDrawIndices(const std::vector<Draw>& draws, std::vector<uint32_t>& order);
+// Sorts the draws with a single gather at the end
+void SortDraws(std::vector<Draw>& draws);
+} // namespace gore::renderer
@@ -0,0 +1,169 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/DrawStream/DrawSortKey.h"
+#include "Rendering/Pool.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::renderer;
+
+// A bunch of live handles of every kind a draw references
+struct SortTestHandles
+{
+    Pool<int, GraphicsPipeline> pipelines;
+    Pool<int, BindGroup> bindGroups;
+    Pool<int, DynamicBuffer> dynamicBuffers;
+    Pool<int, Buffer> buffers;
+
+    std::vector<GraphicsPipelineHandle> pipelineHandles;
+    std::vector<BindGroupHandle> bindGroupHandles;
+    std::vector<DynamicBufferHandle> dynamicBufferHandles;
+    std::vector<BufferHandle> bufferHandles;
+
+    SortTestHandles(int pipelineCount, int bindGroupCount, int dynamicBufferCount, int bufferCount)
+    {
+        for (int i = 0; i < pipelineCount; ++i)
+            pipelineHandles.push_back(pipelines.create(0, GraphicsPipeline{}));
+        for (int i = 0; i < bindGroupCount; ++i)
+            bindGroupHandles.push_back(bindGroups.create(0, BindGroup{}));
+        for (int i = 0; i < dynamicBufferCount; ++i)
+            dynamicBufferHandles.push_back(dynamicBuffers.create(0, DynamicBuffer{}));
+        for (int i = 0; i < bufferCount; ++i)
+            bufferHandles.push_back(buffers.create(0, Buffer{}));
+    }
+};
+
+static std::vector<Draw> MakeRandomDraws(const SortTestHandles& handles, size_t count, uint32_t maxOffset, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    auto pick = [&random](const auto& values) { return values[random() % values.size()]; };
+
+    std::vector<Draw> draws(count);
+    for (Draw& draw : draws)
+    {
+        draw.shader              = pick(handles.pipelineHandles);
+        draw.bindGroup[0]        = pick(handles.bindGroupHandles);
+        draw.bindGroup[1]        = pick(handles.bindGroupHandles);
+        draw.bindGroup[2]        = pick(handles.bindGroupHandles);
+        draw.dynamicBuffer       = pick(handles.dynamicBufferHandles);
+        draw.dynamicBufferOffset = (random() % 16) * 256;
+        draw.vertexBuffer        = pick(handles.bufferHandles);
+        draw.indexBuffer         = pick(handles.bufferHandles);
+        draw.indexType           = random() % 2 == 0 ? IndexType::UINT16 : IndexType::UINT32;
+        draw.vertexOffset        = random() % (maxOffset + 1);
+        draw.indexOffset         = random() % (maxOffset + 1);
+        draw.indexCount          = 3;
+    }
+    return draws;
+}
+
+static std::vector<uint32_t> ReferenceOrder(const std::vector<Draw>& draws)
+{
+    std::vector<uint32_t> order(draws.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&draws](uint32_t a, uint32_t b)
+                     { return DrawSorter()(draws[a], draws[b]); });
+    return order;
+}
+
+TEST_CASE("Radix sorted draws match DrawSorter", "[DrawSortKey]")
+{
+    SortTestHandles handles(8, 32, 4, 64);
+    std::vector<uint32_t> order;
+
+    SECTION("Key fits in 64 bits")
+    {
+        auto draws = MakeRandomDraws(handles, 5000, 255, 1);
+        REQUIRE(CreateDrawSortKeyLayout(draws).totalBits <= 64);
+
+        SortDrawIndices(draws, order);
+        REQUIRE(order == ReferenceOrder(draws));
+    }
+
+    SECTION("Key needs more than 64 bits")
+    {
+        auto draws = MakeRandomDraws(handles, 5000, 1u << 30, 2);
+        REQUIRE(CreateDrawSortKeyLayout(draws).totalBits > 64);
+
+        SortDrawIndices(draws, order);
+        REQUIRE(order == ReferenceOrder(draws));
+    }
+
+    SECTION("Duplicates keep their input order")
+    {
+        SortTestHandles fewHandles(2, 2, 1, 2);
+        auto draws = MakeRandomDraws(fewHandles, 2000, 0, 3);
+
+        SortDrawIndices(draws, order);
+        REQUIRE(order == ReferenceOrder(draws));
+    }
+
+    SECTION("Draws without any sort field set")
+    {
+        std::vector<Draw> draws(200);
+        REQUIRE(CreateDrawSortKeyLayout(draws).totalBits == 0);
+
+        SortDrawIndices(draws, order);
+        REQUIRE(order == ReferenceOrder(draws));
+    }
+
+    SECTION("Small lists")
+    {
+        for (size_t count : {0, 1, 2, 63, 64, 65})
+        {
+            auto draws = MakeRandomDraws(handles, count, 1024, 4);
+            SortDrawIndices(draws, order);
+            REQUIRE(order == ReferenceOrder(draws));
+        }
+    }
+
+    SECTION("SortDraws gathers the draws in order")
+    {
+        auto draws    = MakeRandomDraws(handles, 1000, 4096, 5);
+        auto expected = ReferenceOrder(draws);
+        auto original = draws;
+
+        SortDraws(draws);
+        for (size_t i = 0; i < draws.size(); ++i)
+        {
+            REQUIRE(draws[i].shader == original[expected[i]].shader);
+            REQUIRE(draws[i].vertexOffset == original[expected[i]].vertexOffset);
+            REQUIRE(draws[i].indexOffset == original[expected[i]].indexOffset);
+        }
+    }
+}
+
+TEST_CASE("Draw sort benchmark", "[DrawSortKey][.benchmark]")
+{
+    SortTestHandles handles(64, 256, 4, 1024);
+
+    for (size_t count : {10000, 100000, 1000000})
+    {
+        auto draws = MakeRandomDraws(handles, count, 1u << 16, 42);
+
+        BENCHMARK("std::sort with DrawSorter, " + std::to_string(count) + " draws")
+        {
+            auto sorted = draws;
+            std::sort(sorted.begin(), sorted.end(), DrawSorter());
+            return sorted.size();
+        };
+
+        BENCHMARK("Radix sort, " + std::to_string(count) + " draws")
+        {
+            auto sorted = draws;
+            SortDraws(sorted);
+            return sorted.size();
+        };
+    }
+}
+
+} // namespace gore::test
+#endif
@@ -1,11 +1,21 @@
 #include "DrawStream.h"
 
+#include "Core/JobSystem.h"
+
+#include "Rendering/GPUData/PerDrawData.h"
+#include "Rendering/RenderContextHelper.h"
+
 #include "Utilities/BitWriter.h"
 #include "Utilities/BitReader.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
 namespace gore::renderer
 {
-static inline void WriteDraw(BitWriter& writer, const DrawStateMask mask, const Draw draw)
+static inline void WriteDraw(BitWriter& writer, const DrawStateMask mask, const Draw& draw)
 {
     if (mask.mask == 0)
     {
@@ -14,247 +24,670 @@ static inline void WriteDraw(BitWriter& writer, const DrawStateMask mask, const
 
     if (mask.shader != 0)
     {
-        writer.Write(draw.shader);
+        writer.WriteUnchecked(draw.shader);
     }
 
     if (mask.bindgroup0 != 0)
     {
-        writer.Write(draw.bindGroup[0]);
+        writer.WriteUnchecked(draw.bindGroup[0]);
     }
 
     if (mask.bindgroup1 != 0)
     {
-        writer.Write(draw.bindGroup[1]);
+        writer.WriteUnchecked(draw.bindGroup[1]);
     }
 
     if (mask.bindgroup2 != 0)
     {
-        writer.Write(draw.bindGroup[2]);
+        writer.WriteUnchecked(draw.bindGroup[2]);
     }
 
     if (mask.indexBuffer != 0)
     {
-        writer.Write(draw.indexBuffer);
+        writer.WriteUnchecked(draw.indexBuffer);
     }
 
     if (mask.vertexBuffer != 0)
     {
-        writer.Write(draw.vertexBuffer);
+        writer.WriteUnchecked(draw.vertexBuffer);
     }
 
     if (mask.dynamicBuffer != 0)
     {
-        writer.Write(draw.dynamicBuffer);
+        writer.WriteUnchecked(draw.dynamicBuffer);
     }
 
     if (mask.indexOffset != 0)
     {
-        writer.Write(draw.indexOffset);
+        writer.WriteUnchecked(draw.indexOffset);
     }
 
     if (mask.vertexOffset != 0)
     {
-        writer.Write(draw.vertexOffset);
+        writer.WriteUnchecked(draw.vertexOffset);
     }
 
     if (mask.instanceOffset != 0)
     {
-        writer.Write(draw.instanceOffset);
+        writer.WriteUnchecked(draw.instanceOffset);
     }
 
     if (mask.instanceCount != 0)
     {
-        writer.Write(draw.instanceCount);
+        writer.WriteUnchecked(draw.instanceCount);
     }
 
     if (mask.dynamicBufferOffset != 0)
     {
-        writer.Write(draw.dynamicBufferOffset);
+        writer.WriteUnchecked(draw.dynamicBufferOffset);
     }
 
     if (mask.indexCount != 0)
     {
-        writer.Write(draw.indexCount);
+        writer.WriteUnchecked(draw.indexCount);
+    }
+
+    if (mask.indexType != 0)
+    {
+        writer.WriteUnchecked(draw.indexType);
+    }
+
+    if (mask.vertexCount != 0)
+    {
+        writer.WriteUnchecked(draw.vertexCount);
     }
 }
 
-void CreateDrawStreamFromDrawData(const std::vector<Draw>& drawData, DrawStream& drawStream)
+static inline DrawStateMask GetChangedState(const Draw& lastDraw, const Draw& draw)
 {
-    if (drawData.empty())
+    DrawStateMask mask = {};
+
+    mask.shader              = lastDraw.shader != draw.shader;
+    mask.bindgroup0          = lastDraw.bindGroup[0] != draw.bindGroup[0];
+    mask.bindgroup1          = lastDraw.bindGroup[1] != draw.bindGroup[1];
+    mask.bindgroup2          = lastDraw.bindGroup[2] != draw.bindGroup[2];
+    mask.indexBuffer         = lastDraw.indexBuffer != draw.indexBuffer;
+    mask.vertexBuffer        = lastDraw.vertexBuffer != draw.vertexBuffer;
+    mask.dynamicBuffer       = lastDraw.dynamicBuffer != draw.dynamicBuffer;
+    mask.indexOffset         = lastDraw.indexOffset != draw.indexOffset;
+    mask.vertexOffset        = lastDraw.vertexOffset != draw.vertexOffset;
+    mask.instanceOffset      = lastDraw.instanceOffset != draw.instanceOffset;
+    mask.instanceCount       = lastDraw.instanceCount != draw.instanceCount;
+    mask.dynamicBufferOffset = lastDraw.dynamicBufferOffset != draw.dynamicBufferOffset;
+    mask.indexCount          = lastDraw.indexCount != draw.indexCount;
+    mask.indexType           = lastDraw.indexType != draw.indexType;
+    mask.vertexCount         = lastDraw.vertexCount != draw.vertexCount;
+
+    return mask;
+}
+
+// Compact encoding
+
+// the only flag in the one byte header of a compact stream
+static constexpr uint8_t k_CompactNarrowHandles = 1 << 0;
+
+static constexpr size_t k_CompactHeaderSize  = 1;
+static constexpr size_t k_MaxVarUIntSize     = 5;
+static constexpr uint32_t k_HandleFieldCount = 7;
+static constexpr uint32_t k_ValueFieldCount  = 7;
+
+static_assert(sizeof(BufferHandle) == 2 * sizeof(uint32_t), "Handles are expected to be an index and a generation");
+
+static inline uint32_t ZigZagEncode(int32_t value)
+{
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+static inline int32_t ZigZagDecode(uint32_t value)
+{
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+static inline void WriteVarUInt(BitWriter& writer, uint32_t value)
+{
+    while (value >= 0x80)
     {
-        return;
+        writer.WriteUnchecked(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
     }
+    writer.WriteUnchecked(static_cast<uint8_t>(value));
+}
 
-    // Calculate the size of the draw stream
-    const int maxPerDrawByteSize = sizeof(DrawStateMask) + sizeof(Draw);
-    const size_t maxSize         = maxPerDrawByteSize * drawData.size();
+// Deltas between sorted neighbours are small, the wrap around of the subtraction is undone by the decoder
+static inline void WriteDelta(BitWriter& writer, uint32_t lastValue, uint32_t value)
+{
+    WriteVarUInt(writer, ZigZagEncode(static_cast<int32_t>(value - lastValue)));
+}
 
-    // Loop through the draw data and create the draw stream
-    Draw lastDraw = drawData[0];
-    bool first    = true;
+template <typename ObjectType>
+static inline void WriteCompactHandle(BitWriter& writer, const Handle<ObjectType>& handle, bool narrowHandles)
+{
+    if (narrowHandles)
+    {
+        writer.WriteUnchecked(static_cast<uint16_t>(handle.index()));
+        writer.WriteUnchecked(static_cast<uint16_t>(handle.gen()));
+    }
+    else
+    {
+        writer.WriteUnchecked(handle);
+    }
+}
 
-    BitWriter writer(maxSize);
-    DrawStateMask mask = {};
+static inline void WriteCompactDraw(BitWriter& writer, const DrawStateMask mask, const Draw& lastDraw, const Draw& draw, bool narrowHandles)
+{
+    writer.WriteUnchecked(static_cast<uint16_t>(mask.mask));
 
-    for (const auto& draw : drawData)
+    if (mask.shader != 0)
     {
-        mask.mask = 0;
+        WriteCompactHandle(writer, draw.shader, narrowHandles);
+    }
 
-        if (first)
-        {
-            mask.shader              = draw.shader.empty() == false;
-            mask.bindgroup0          = draw.bindGroup[0].empty() == false;
-            mask.bindgroup1          = draw.bindGroup[1].empty() == false;
-            mask.bindgroup2          = draw.bindGroup[2].empty() == false;
-            mask.indexBuffer         = draw.indexBuffer.empty() == false;
-            mask.vertexBuffer        = draw.vertexBuffer.empty() == false;
-            mask.dynamicBuffer       = draw.dynamicBuffer.empty() == false;
-            mask.indexOffset         = draw.indexOffset != 0;
-            mask.vertexOffset        = draw.vertexOffset != 0;
-            mask.instanceOffset      = draw.instanceOffset != 0;
-            mask.instanceCount       = draw.instanceCount != 0;
-            mask.dynamicBufferOffset = draw.dynamicBufferOffset != 0;
-            mask.indexCount          = draw.indexCount != 0;
-
-            if (mask.mask != 0)
-                writer.Write(mask);
-
-            WriteDraw(writer, mask, draw);
+    if (mask.bindgroup0 != 0)
+    {
+        WriteCompactHandle(writer, draw.bindGroup[0], narrowHandles);
+    }
 
-            lastDraw = draw;
+    if (mask.bindgroup1 != 0)
+    {
+        WriteCompactHandle(writer, draw.bindGroup[1], narrowHandles);
+    }
 
-            first = false;
-            continue;
-        }
+    if (mask.bindgroup2 != 0)
+    {
+        WriteCompactHandle(writer, draw.bindGroup[2], narrowHandles);
+    }
 
-        mask.shader              = lastDraw.shader != draw.shader;
-        mask.bindgroup0          = lastDraw.bindGroup[0] != draw.bindGroup[0];
-        mask.bindgroup1          = lastDraw.bindGroup[1] != draw.bindGroup[1];
-        mask.bindgroup2          = lastDraw.bindGroup[2] != draw.bindGroup[2];
-        mask.indexBuffer         = lastDraw.indexBuffer != draw.indexBuffer;
-        mask.vertexBuffer        = lastDraw.vertexBuffer != draw.vertexBuffer;
-        mask.dynamicBuffer       = lastDraw.dynamicBuffer != draw.dynamicBuffer;
-        mask.indexOffset         = lastDraw.indexOffset != draw.indexOffset;
-        mask.vertexOffset        = lastDraw.vertexOffset != draw.vertexOffset;
-        mask.instanceOffset      = lastDraw.instanceOffset != draw.instanceOffset;
-        mask.instanceCount       = lastDraw.instanceCount != draw.instanceCount;
-        mask.dynamicBufferOffset = lastDraw.dynamicBufferOffset != draw.dynamicBufferOffset;
-        mask.indexCount          = lastDraw.indexCount != draw.indexCount;
-        
-        writer.Write(mask);
-        WriteDraw(writer, mask, draw);
+    if (mask.indexBuffer != 0)
+    {
+        WriteCompactHandle(writer, draw.indexBuffer, narrowHandles);
+    }
+
+    if (mask.vertexBuffer != 0)
+    {
+        WriteCompactHandle(writer, draw.vertexBuffer, narrowHandles);
+    }
+
+    if (mask.dynamicBuffer != 0)
+    {
+        WriteCompactHandle(writer, draw.dynamicBuffer, narrowHandles);
+    }
+
+    if (mask.indexOffset != 0)
+    {
+        WriteDelta(writer, lastDraw.indexOffset, draw.indexOffset);
     }
 
-    writer.ShrinkToFit();
+    if (mask.vertexOffset != 0)
+    {
+        WriteDelta(writer, lastDraw.vertexOffset, draw.vertexOffset);
+    }
 
-    drawStream.data.assign(writer.GetData(), writer.GetData() + writer.GetByteWritten());
+    if (mask.instanceOffset != 0)
+    {
+        WriteDelta(writer, lastDraw.instanceOffset, draw.instanceOffset);
+    }
+
+    if (mask.instanceCount != 0)
+    {
+        WriteDelta(writer, lastDraw.instanceCount, draw.instanceCount);
+    }
+
+    if (mask.dynamicBufferOffset != 0)
+    {
+        WriteDelta(writer, lastDraw.dynamicBufferOffset, draw.dynamicBufferOffset);
+    }
+
+    if (mask.indexCount != 0)
+    {
+        WriteDelta(writer, lastDraw.indexCount, draw.indexCount);
+    }
+
+    if (mask.indexType != 0)
+    {
+        writer.WriteUnchecked(draw.indexType);
+    }
+
+    if (mask.vertexCount != 0)
+    {
+        WriteDelta(writer, lastDraw.vertexCount, draw.vertexCount);
+    }
 }
 
-void ScheduleDrawStream(RenderContext& renderContext, DrawStream& drawStream, vk::CommandBuffer commandBuffer, GraphicsPipelineHandle overridePipeline)
+template <typename ObjectType>
+static inline bool IsNarrowHandle(const Handle<ObjectType>& handle)
 {
-    BitReader reader(drawStream.data.data(), drawStream.data.size());
+    return handle.index() <= UINT16_MAX && handle.gen() <= UINT16_MAX;
+}
 
-    DrawStateMask mask = {};
+static bool CanUseNarrowHandles(const std::vector<Draw>& drawData, DrawStreamRange range)
+{
+    for (uint32_t drawIndex = range.begin; drawIndex < range.end; ++drawIndex)
+    {
+        const Draw& draw = drawData[drawIndex];
+        bool narrow      = IsNarrowHandle(draw.shader)
+                      && IsNarrowHandle(draw.bindGroup[0])
+                      && IsNarrowHandle(draw.bindGroup[1])
+                      && IsNarrowHandle(draw.bindGroup[2])
+                      && IsNarrowHandle(draw.indexBuffer)
+                      && IsNarrowHandle(draw.vertexBuffer)
+                      && IsNarrowHandle(draw.dynamicBuffer);
+        if (!narrow)
+            return false;
+    }
+    return true;
+}
 
-    GraphicsPipeline graphicsPipeline = {};
-    uint32_t indexOffset              = 0;
-    uint32_t vertexOffset             = 0;
-    uint32_t instanceOffset           = 0;
-    uint32_t instanceCount            = 0;
-    uint32_t dynamicBufferOffset      = 0;
-    uint32_t indexCount               = 0;
+// The worst case of a range, every draw changing every field
+static size_t GetMaxEncodedSize(uint32_t drawCount, DrawStreamEncoding encoding)
+{
+    if (encoding == DrawStreamEncoding::Compact)
+    {
+        constexpr size_t maxBytesPerDraw = sizeof(uint16_t) + k_HandleFieldCount * sizeof(BufferHandle) + k_ValueFieldCount * k_MaxVarUIntSize + sizeof(IndexType);
+        return k_CompactHeaderSize + maxBytesPerDraw * drawCount;
+    }
+
+    return (sizeof(DrawStateMask) + sizeof(Draw)) * drawCount;
+}
+
+// Encodes the draws of range into buffer, which has to hold GetMaxEncodedSize bytes. Returns the bytes written.
+static size_t EncodeDraws(const std::vector<Draw>& drawData, DrawStreamRange range, DrawStreamEncoding encoding, uint8_t* buffer, size_t byteCount)
+{
+    // Every range starts from an empty state, so the stream does not depend on the draws before it
+    Draw lastDraw = {};
+
+    BitWriter writer(buffer, byteCount);
 
-    while (reader.GetBitsRemaining() > 0)
+    if (encoding == DrawStreamEncoding::Compact)
     {
-        mask = reader.Read<DrawStateMask>();
+        bool narrowHandles = CanUseNarrowHandles(drawData, range);
+        writer.WriteUnchecked(narrowHandles ? k_CompactNarrowHandles : uint8_t(0));
 
-        if (mask.shader != 0)
+        for (uint32_t drawIndex = range.begin; drawIndex < range.end; ++drawIndex)
         {
-            auto shaderHandle = overridePipeline.empty() ? reader.Read<GraphicsPipelineHandle>() : overridePipeline;
-            graphicsPipeline  = renderContext.GetGraphicsPipeline(shaderHandle);
-            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipeline.pipeline);
+            const Draw& draw = drawData[drawIndex];
+            WriteCompactDraw(writer, GetChangedState(lastDraw, draw), lastDraw, draw, narrowHandles);
+            lastDraw = draw;
         }
 
-        if (mask.bindgroup0 != 0)
+        return writer.GetByteWritten();
+    }
+
+    for (uint32_t drawIndex = range.begin; drawIndex < range.end; ++drawIndex)
+    {
+        const Draw& draw   = drawData[drawIndex];
+        DrawStateMask mask = GetChangedState(lastDraw, draw);
+
+        // the mask is written even when nothing changed, the draw itself still has to be replayed
+        writer.WriteUnchecked(mask);
+        WriteDraw(writer, mask, draw);
+
+        lastDraw = draw;
+    }
+
+    return writer.GetByteWritten();
+}
+
+void CreateDrawStreamFromDrawData(const std::vector<Draw>& drawData, utils::LinearArena& arena, DrawStream& drawStream, DrawStreamEncoding encoding)
+{
+    CreateDrawStreamFromDrawData(drawData, {0, static_cast<uint32_t>(drawData.size())}, arena, drawStream, encoding);
+}
+
+void CreateDrawStreamFromDrawData(const std::vector<Draw>& drawData, DrawStreamRange range, utils::LinearArena& arena, DrawStream& drawStream, DrawStreamEncoding encoding)
+{
+    drawStream.encoding = encoding;
+
+    if (range.begin >= range.end)
+    {
+        drawStream.data = {};
+        return;
+    }
+
+    // encode straight into the arena and hand the unused end back, the bytes are never copied
+    const size_t maxSize = GetMaxEncodedSize(range.GetDrawCount(), encoding);
+    uint8_t* buffer      = arena.Allocate(maxSize, alignof(DrawStateMask));
+    size_t byteWritten   = EncodeDraws(drawData, range, encoding, buffer, maxSize);
+    arena.Trim(buffer, maxSize, byteWritten);
+
+    drawStream.data = {buffer, byteWritten};
+}
+
+std::vector<DrawStreamRange> SplitDrawData(uint32_t drawCount, uint32_t maxRangeCount, uint32_t minDrawsPerRange)
+{
+    std::vector<DrawStreamRange> ranges;
+    if (drawCount == 0)
+    {
+        return ranges;
+    }
+
+    minDrawsPerRange    = std::max(minDrawsPerRange, 1u);
+    uint32_t rangeCount = std::clamp(drawCount / minDrawsPerRange, 1u, std::max(maxRangeCount, 1u));
+
+    // spread the remainder over the first ranges, so no two ranges differ by more than one draw
+    uint32_t rangeSize = drawCount / rangeCount;
+    uint32_t remainder = drawCount % rangeCount;
+
+    uint32_t begin = 0;
+    for (uint32_t i = 0; i < rangeCount; ++i)
+    {
+        uint32_t end = begin + rangeSize + (i < remainder ? 1 : 0);
+        ranges.push_back({begin, end});
+        begin = end;
+    }
+
+    return ranges;
+}
+
+void CreateDrawStreamsFromDrawData(const std::vector<Draw>& drawData, const std::vector<DrawStreamRange>& ranges, utils::LinearArena& arena, std::vector<DrawStream>& drawStreams, JobSystem* jobSystem, DrawStreamEncoding encoding)
+{
+    drawStreams.resize(ranges.size());
+
+    if (jobSystem == nullptr)
+    {
+        for (size_t i = 0; i < ranges.size(); ++i)
         {
-            auto bindGroupHandle = reader.Read<BindGroupHandle>();
-            auto& bindGroup      = renderContext.GetBindGroup(bindGroupHandle);
-            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipeline.layout, 0, {bindGroup.set}, {});
+            CreateDrawStreamFromDrawData(drawData, ranges[i], arena, drawStreams[i], encoding);
         }
+        return;
+    }
+
+    // The arena is only touched on this thread, every job encodes into the worst case buffer it was given.
+    // Those can not be trimmed afterwards, the arena gets the space back on its next Reset.
+    std::vector<uint8_t*> buffers(ranges.size());
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        buffers[i] = arena.Allocate(GetMaxEncodedSize(ranges[i].GetDrawCount(), encoding), alignof(DrawStateMask));
+    }
+
+    jobSystem->ParallelFor(static_cast<uint32_t>(ranges.size()), 1, [&](uint32_t begin, uint32_t end)
+                           {
+                               for (uint32_t i = begin; i < end; ++i)
+                               {
+                                   const DrawStreamRange& range = ranges[i];
+                                   drawStreams[i].encoding      = encoding;
+                                   if (range.begin >= range.end)
+                                   {
+                                       drawStreams[i].data = {};
+                                       continue;
+                                   }
+
+                                   size_t byteWritten  = EncodeDraws(drawData, range, encoding, buffers[i], GetMaxEncodedSize(range.GetDrawCount(), encoding));
+                                   drawStreams[i].data = {buffers[i], byteWritten};
+                               } });
+}
+
+// Reads the draws of a Full stream, Next applies the changes of one draw to draw and returns which fields changed
+class FullDrawStreamReader final
+{
+public:
+    explicit FullDrawStreamReader(const DrawStream& drawStream) :
+        m_Reader(const_cast<uint8_t*>(drawStream.data.data()), drawStream.data.size())
+    {
+    }
+
+    [[nodiscard]] bool IsDone() const { return m_Reader.GetBitsRemaining() == 0; }
+
+    DrawStateMask Next(Draw& draw)
+    {
+        DrawStateMask mask = m_Reader.Read<DrawStateMask>();
 
+        if (mask.shader != 0)
+            draw.shader = m_Reader.Read<GraphicsPipelineHandle>();
+        if (mask.bindgroup0 != 0)
+            draw.bindGroup[0] = m_Reader.Read<BindGroupHandle>();
         if (mask.bindgroup1 != 0)
-        {
-            auto bindGroupHandle = reader.Read<BindGroupHandle>();
-            auto& bindGroup      = renderContext.GetBindGroup(bindGroupHandle);
-            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipeline.layout, 1, {bindGroup.set}, {});
-        }
+            draw.bindGroup[1] = m_Reader.Read<BindGroupHandle>();
+        if (mask.bindgroup2 != 0)
+            draw.bindGroup[2] = m_Reader.Read<BindGroupHandle>();
+        if (mask.indexBuffer != 0)
+            draw.indexBuffer = m_Reader.Read<BufferHandle>();
+        if (mask.vertexBuffer != 0)
+            draw.vertexBuffer = m_Reader.Read<BufferHandle>();
+        if (mask.dynamicBuffer != 0)
+            draw.dynamicBuffer = m_Reader.Read<DynamicBufferHandle>();
+        if (mask.indexOffset != 0)
+            draw.indexOffset = m_Reader.Read<uint32_t>();
+        if (mask.vertexOffset != 0)
+            draw.vertexOffset = m_Reader.Read<uint32_t>();
+        if (mask.instanceOffset != 0)
+            draw.instanceOffset = m_Reader.Read<uint32_t>();
+        if (mask.instanceCount != 0)
+            draw.instanceCount = m_Reader.Read<uint32_t>();
+        if (mask.dynamicBufferOffset != 0)
+            draw.dynamicBufferOffset = m_Reader.Read<uint32_t>();
+        if (mask.indexCount != 0)
+            draw.indexCount = m_Reader.Read<uint32_t>();
+        if (mask.indexType != 0)
+            draw.indexType = m_Reader.Read<IndexType>();
+        if (mask.vertexCount != 0)
+            draw.vertexCount = m_Reader.Read<uint32_t>();
+
+        return mask;
+    }
+
+private:
+    BitReader m_Reader;
+};
+
+// Reads the draws of a Compact stream. The encoder sized everything, so the reader trusts the stream and does no bounds checks.
+// Whether handles are narrow is a template parameter, which keeps that test out of the loop.
+template <bool NarrowHandles>
+class CompactDrawStreamReader final
+{
+public:
+    explicit CompactDrawStreamReader(const DrawStream& drawStream) :
+        m_Cursor(drawStream.data.data() + k_CompactHeaderSize),
+        m_End(drawStream.data.data() + drawStream.data.size())
+    {
+    }
+
+    [[nodiscard]] bool IsDone() const { return m_Cursor == m_End; }
 
+    DrawStateMask Next(Draw& draw)
+    {
+        DrawStateMask mask = {};
+        mask.mask          = Read<uint16_t>();
+
+        if (mask.shader != 0)
+            ReadHandle(draw.shader);
+        if (mask.bindgroup0 != 0)
+            ReadHandle(draw.bindGroup[0]);
+        if (mask.bindgroup1 != 0)
+            ReadHandle(draw.bindGroup[1]);
         if (mask.bindgroup2 != 0)
+            ReadHandle(draw.bindGroup[2]);
+        if (mask.indexBuffer != 0)
+            ReadHandle(draw.indexBuffer);
+        if (mask.vertexBuffer != 0)
+            ReadHandle(draw.vertexBuffer);
+        if (mask.dynamicBuffer != 0)
+            ReadHandle(draw.dynamicBuffer);
+        if (mask.indexOffset != 0)
+            draw.indexOffset += ReadDelta();
+        if (mask.vertexOffset != 0)
+            draw.vertexOffset += ReadDelta();
+        if (mask.instanceOffset != 0)
+            draw.instanceOffset += ReadDelta();
+        if (mask.instanceCount != 0)
+            draw.instanceCount += ReadDelta();
+        if (mask.dynamicBufferOffset != 0)
+            draw.dynamicBufferOffset += ReadDelta();
+        if (mask.indexCount != 0)
+            draw.indexCount += ReadDelta();
+        if (mask.indexType != 0)
+            draw.indexType = Read<IndexType>();
+        if (mask.vertexCount != 0)
+            draw.vertexCount += ReadDelta();
+
+        return mask;
+    }
+
+private:
+    template <typename T>
+    T Read()
+    {
+        T value;
+        std::memcpy(&value, m_Cursor, sizeof(T));
+        m_Cursor += sizeof(T);
+        return value;
+    }
+
+    template <typename ObjectType>
+    void ReadHandle(Handle<ObjectType>& handle)
+    {
+        static_assert(std::is_trivially_copyable_v<Handle<ObjectType>>);
+
+        if constexpr (NarrowHandles)
         {
-            auto bindGroupHandle = reader.Read<BindGroupHandle>();
-            auto& bindGroup      = renderContext.GetBindGroup(bindGroupHandle);
-            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipeline.layout, 2, {bindGroup.set}, {});
+            // Handles can only be made by their Pool, so the index and generation are copied over the handle instead
+            uint32_t fields[2] = {Read<uint16_t>(), Read<uint16_t>()};
+            std::memcpy(&handle, fields, sizeof(handle));
         }
-
-        if (mask.indexBuffer != 0)
+        else
         {
-            auto bufferHandle = reader.Read<BufferHandle>();
-            auto& buffer      = renderContext.GetBuffer(bufferHandle);
-            commandBuffer.bindIndexBuffer(buffer.vkBuffer, 0, vk::IndexType::eUint16);
+            handle = Read<Handle<ObjectType>>();
         }
+    }
 
-        if (mask.vertexBuffer != 0)
+    uint32_t ReadDelta()
+    {
+        // most deltas fit in a single byte
+        uint32_t byte  = *m_Cursor++;
+        uint32_t value = byte & 0x7F;
+        for (uint32_t shift = 7; byte & 0x80; shift += 7)
         {
-            auto bufferHandle = reader.Read<BufferHandle>();
-            auto& buffer      = renderContext.GetBuffer(bufferHandle);
-            commandBuffer.bindVertexBuffers(0, {buffer.vkBuffer}, {0});
+            byte = *m_Cursor++;
+            value |= (byte & 0x7F) << shift;
         }
+        return static_cast<uint32_t>(ZigZagDecode(value));
+    }
 
-        if (mask.dynamicBuffer != 0)
+private:
+    const uint8_t* m_Cursor;
+    const uint8_t* m_End;
+};
+
+// Calls func(mask, draw) for every draw of the stream, with the full state of the draw and the fields that changed
+template <typename Reader, typename Func>
+static void ReadDraws(Reader reader, Func&& func)
+{
+    Draw draw = {};
+    while (!reader.IsDone())
+    {
+        DrawStateMask mask = reader.Next(draw);
+        func(mask, draw);
+    }
+}
+
+template <typename Func>
+static void ReadDrawStream(const DrawStream& drawStream, Func&& func)
+{
+    if (drawStream.data.empty())
+        return;
+
+    if (drawStream.encoding == DrawStreamEncoding::Full)
+    {
+        ReadDraws(FullDrawStreamReader(drawStream), func);
+    }
+    else if (drawStream.data[0] & k_CompactNarrowHandles)
+    {
+        ReadDraws(CompactDrawStreamReader<true>(drawStream), func);
+    }
+    else
+    {
+        ReadDraws(CompactDrawStreamReader<false>(drawStream), func);
+    }
+}
+
+void DecodeDrawStream(const DrawStream& drawStream, std::vector<Draw>& drawData)
+{
+    ReadDrawStream(drawStream, [&drawData](DrawStateMask, const Draw& draw)
+                   { drawData.push_back(draw); });
+}
+
+void ScheduleDrawStream(RenderContext& renderContext, DrawStream& drawStream, vk::CommandBuffer commandBuffer, GraphicsPipelineHandle overridePipeline,
+                        const InstanceDataBinding& instanceDataBinding)
+{
+    GraphicsPipeline graphicsPipeline = {};
+
+    ReadDrawStream(drawStream, [&](DrawStateMask mask, const Draw& draw)
+                   {
+        if (mask.shader != 0)
         {
-            auto dynamicBufferHandle = reader.Read<DynamicBufferHandle>();
-            auto& dynamicBuffer      = renderContext.GetDynamicBuffer(dynamicBufferHandle);
-            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipeline.layout, 3, {dynamicBuffer.set}, {0});
+            // the handle in the stream has been read either way, the override only replaces what gets bound
+            auto shaderHandle = overridePipeline.empty() ? draw.shader : overridePipeline;
+            graphicsPipeline  = renderContext.GetGraphicsPipeline(shaderHandle);
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipeline.pipeline);
+
+            if (instanceDataBinding.policy == InstanceDataStoragePolicy::PersistentStructuredBuffer)
+            {
+                // the same for every draw of the stream, instances find their slot through firstInstance
+                commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipeline.layout, 3, {instanceDataBinding.instanceSet}, {});
+                commandBuffer.pushConstants(graphicsPipeline.layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(uint32_t), &instanceDataBinding.instanceIndexBase);
+            }
         }
 
-        if (mask.indexOffset != 0)
+        if (mask.bindgroup0 != 0)
         {
-            indexOffset = reader.Read<uint32_t>();
+            auto& bindGroup = renderContext.GetBindGroup(draw.bindGroup[0]);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipeline.layout, 0, {bindGroup.set}, {});
         }
 
-        if (mask.vertexOffset != 0)
+        if (mask.bindgroup1 != 0)
         {
-            vertexOffset = reader.Read<uint32_t>();
+            auto& bindGroup = renderContext.GetBindGroup(draw.bindGroup[1]);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipeline.layout, 1, {bindGroup.set}, {});
         }
 
-        if (mask.instanceOffset != 0)
+        if (mask.bindgroup2 != 0)
         {
-            instanceOffset = reader.Read<uint32_t>();
+            auto& bindGroup = renderContext.GetBindGroup(draw.bindGroup[2]);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipeline.layout, 2, {bindGroup.set}, {});
         }
 
-        if (mask.instanceCount != 0)
+        // the index type is part of the binding, 16 and 32 bit indices can live in the same buffer
+        bool indexed = draw.indexBuffer.empty() == false && draw.indexType != IndexType::None;
+        if ((mask.indexBuffer != 0 || mask.indexType != 0) && indexed)
         {
-            instanceCount = reader.Read<uint32_t>();
+            auto& buffer = renderContext.GetBuffer(draw.indexBuffer);
+            commandBuffer.bindIndexBuffer(buffer.vkBuffer, 0, VulkanHelper::GetVkIndexType(draw.indexType));
         }
 
-        if (mask.dynamicBufferOffset != 0)
+        if (mask.vertexBuffer != 0)
         {
-            dynamicBufferOffset = reader.Read<uint32_t>();
+            auto& buffer = renderContext.GetBuffer(draw.vertexBuffer);
+            commandBuffer.bindVertexBuffers(0, {buffer.vkBuffer}, {0});
         }
 
-        if (mask.indexCount != 0)
+        switch (instanceDataBinding.policy)
         {
-            indexCount = reader.Read<uint32_t>();
+            case InstanceDataStoragePolicy::PerDrawPushConstant:
+                // a new pipeline may not keep what was pushed for the last one
+                if (mask.shader != 0 || mask.dynamicBufferOffset != 0)
+                {
+                    const TransformData& transform = instanceDataBinding.transforms[draw.dynamicBufferOffset];
+                    PerDrawData perDrawData        = {transform.localToWorld, transform.positionScale, transform.positionOffset};
+                    commandBuffer.pushConstants(graphicsPipeline.layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(PerDrawData), &perDrawData);
+                }
+                break;
+            case InstanceDataStoragePolicy::PersistentStructuredBuffer:
+                break;
+            default:
+                if ((mask.dynamicBuffer != 0 || mask.dynamicBufferOffset != 0) && draw.dynamicBuffer.empty() == false)
+                {
+                    auto& dynamicBuffer = renderContext.GetDynamicBuffer(draw.dynamicBuffer);
+                    uint32_t offset     = draw.dynamicBufferOffset * instanceDataBinding.dynamicOffsetStride;
+                    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipeline.layout, 3, {dynamicBuffer.set}, {offset});
+                }
+                break;
         }
 
-        if (mask.indexCount != 0)
+        if (indexed)
         {
-            commandBuffer.drawIndexed(indexCount, instanceCount, indexOffset, vertexOffset, instanceOffset);
+            commandBuffer.drawIndexed(draw.indexCount, draw.instanceCount, draw.indexOffset, draw.vertexOffset, draw.instanceOffset);
         }
         else
         {
-            commandBuffer.draw(indexCount, instanceCount, vertexOffset, instanceOffset);
-        }
-    }
+            commandBuffer.draw(draw.vertexCount, draw.instanceCount, draw.vertexOffset, draw.instanceOffset);
+        } });
 }
-} // namespace gore::renderer
\ No newline at end of file
+} // namespace gore::renderer
@@ -2,10 +2,19 @@
 
 #include "Prefix.h"
 #include "Draw.h"
+#include "InstanceDataBinding.h"
 
+#include "Utilities/Allocator/LinearArena.h"
+
+#include <span>
 #include <vector>
 #include <unordered_map>
 
+namespace gore
+{
+class JobSystem;
+} // namespace gore
+
 namespace gore::renderer
 {
 union DrawStateMask
@@ -25,19 +34,52 @@ union DrawStateMask
         uint32_t instanceCount : 1;
         uint32_t dynamicBufferOffset : 1;
         uint32_t indexCount : 1;
+        uint32_t indexType : 1;
+        uint32_t vertexCount : 1;
 
-        uint32_t pack : 19;
+        uint32_t pack : 17;
     };
 
     uint32_t mask;
 };
 static_assert(sizeof(DrawStateMask) == 4, "DrawStateMask should be 4 bytes");
 
+enum class DrawStreamEncoding : uint8_t
+{
+    // Every changed field is written as is, behind a 32-bit DrawStateMask
+    Full,
+    // 16-bit mask, zig-zag LEB128 deltas for offsets and counts, 16-bit handles when every handle of the stream fits
+    Compact,
+};
+
+// The encoded bytes live in the LinearArena the stream was created with, they are valid until that arena is reset
 struct DrawStream final
 {
-    std::vector<uint8_t> data;
+    std::span<const uint8_t> data;
+    DrawStreamEncoding encoding = DrawStreamEncoding::Full;
 };
 
-void CreateDrawStreamFromDrawData(const std::vector<Draw>& drawData, DrawStream& drawStream);
-void ScheduleDrawStream(RenderContext& renderContext, DrawStream& drawStream, vk::CommandBuffer commandBuffer, GraphicsPipelineHandle overridePipeline = {});
+// [begin, end) of a sorted draw list
+struct DrawStreamRange final
+{
+    uint32_t begin = 0;
+    uint32_t end   = 0;
+
+    [[nodiscard]] uint32_t GetDrawCount() const { return end - begin; }
+};
+
+void CreateDrawStreamFromDrawData(const std::vector<Draw>& drawData, utils::LinearArena& arena, DrawStream& drawStream, DrawStreamEncoding encoding = DrawStreamEncoding::Full);
+// Encodes only the draws of range. The stream starts from an empty state, so it can be replayed into its own command buffer.
+void CreateDrawStreamFromDrawData(const std::vector<Draw>& drawData, DrawStreamRange range, utils::LinearArena& arena, DrawStream& drawStream, DrawStreamEncoding encoding = DrawStreamEncoding::Full);
+
+// Splits drawCount draws into at most maxRangeCount contiguous ranges of at least minDrawsPerRange draws, a short list stays in one range
+std::vector<DrawStreamRange> SplitDrawData(uint32_t drawCount, uint32_t maxRangeCount, uint32_t minDrawsPerRange);
+// One DrawStream per range, encoded on the JobSystem when one is given
+void CreateDrawStreamsFromDrawData(const std::vector<Draw>& drawData, const std::vector<DrawStreamRange>& ranges, utils::LinearArena& arena, std::vector<DrawStream>& drawStreams, JobSystem* jobSystem = nullptr, DrawStreamEncoding encoding = DrawStreamEncoding::Full);
+
+// Turns a DrawStream back into the draws it was encoded from
+void DecodeDrawStream(const DrawStream& drawStream, std::vector<Draw>& drawData);
+// Pipelines bound here have to be created for the policy of instanceDataBinding, see InstanceDataStoragePolicy
+void ScheduleDrawStream(RenderContext& renderContext, DrawStream& drawStream, vk::CommandBuffer commandBuffer, GraphicsPipelineHandle overridePipeline = {},
+                        const InstanceDataBinding& instanceDataBinding = {});
 } // namespace gore::renderer   
\ No newline at end of file
@@ -0,0 +1,377 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Core/JobSystem.h"
+#include "Rendering/DrawStream/DrawSortKey.h"
+#include "Rendering/DrawStream/DrawStream.h"
+#include "Rendering/Pool.h"
+#include "Utilities/BitWriter.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::renderer;
+
+static bool DrawEqual(const Draw& a, const Draw& b)
+{
+    return a.shader == b.shader
+        && a.bindGroup[0] == b.bindGroup[0]
+        && a.bindGroup[1] == b.bindGroup[1]
+        && a.bindGroup[2] == b.bindGroup[2]
+        && a.dynamicBuffer == b.dynamicBuffer
+        && a.vertexBuffer == b.vertexBuffer
+        && a.indexBuffer == b.indexBuffer
+        && a.indexType == b.indexType
+        && a.indexCount == b.indexCount
+        && a.indexOffset == b.indexOffset
+        && a.vertexCount == b.vertexCount
+        && a.vertexOffset == b.vertexOffset
+        && a.instanceCount == b.instanceCount
+        && a.instanceOffset == b.instanceOffset
+        && a.dynamicBufferOffset == b.dynamicBufferOffset;
+}
+
+// Sorted draws that share state with their neighbours, like a real frame does
+static std::vector<Draw> MakeSortedDraws(size_t count)
+{
+    // handles stay valid values after their pool is gone, nothing here looks the objects up
+    Pool<int, GraphicsPipeline> pipelines;
+    Pool<int, BindGroup> bindGroups;
+    Pool<int, Buffer> buffers;
+
+    std::vector<GraphicsPipelineHandle> pipelineHandles = {pipelines.create(0, GraphicsPipeline{}), pipelines.create(0, GraphicsPipeline{})};
+    std::vector<BindGroupHandle> bindGroupHandles       = {bindGroups.create(0, BindGroup{}), bindGroups.create(0, BindGroup{}), bindGroups.create(0, BindGroup{})};
+    std::vector<BufferHandle> bufferHandles;
+    for (int i = 0; i < 8; ++i)
+        bufferHandles.push_back(buffers.create(0, Buffer{}));
+
+    std::mt19937 random(7);
+    std::vector<Draw> draws(count);
+    for (Draw& draw : draws)
+    {
+        draw.shader        = pipelineHandles[random() % pipelineHandles.size()];
+        draw.bindGroup[0]  = bindGroupHandles[random() % bindGroupHandles.size()];
+        draw.vertexBuffer  = bufferHandles[random() % bufferHandles.size()];
+        draw.indexBuffer   = bufferHandles[random() % bufferHandles.size()];
+        draw.indexType     = random() % 4 == 0 ? IndexType::UINT32 : IndexType::UINT16;
+        draw.indexCount    = 3 * (1 + random() % 4);
+        draw.vertexCount   = 4 * (1 + random() % 64);
+        draw.indexOffset   = random() % 2 == 0 ? 0 : 3 * (random() % 100);
+        draw.instanceCount = 1;
+    }
+
+    SortDraws(draws);
+    return draws;
+}
+
+TEST_CASE("Draw lists are split into contiguous ranges", "[DrawStream]")
+{
+    SECTION("Ranges cover every draw once")
+    {
+        auto ranges = SplitDrawData(1000, 3, 10);
+        REQUIRE(ranges.size() == 3);
+        REQUIRE(ranges.front().begin == 0);
+        REQUIRE(ranges.back().end == 1000);
+        for (size_t i = 1; i < ranges.size(); ++i)
+            REQUIRE(ranges[i].begin == ranges[i - 1].end);
+
+        // the remainder is spread, no range is more than one draw bigger than another
+        REQUIRE(ranges[0].GetDrawCount() == 334);
+        REQUIRE(ranges[2].GetDrawCount() == 333);
+    }
+
+    SECTION("Short lists use fewer ranges")
+    {
+        REQUIRE(SplitDrawData(0, 8, 256).empty());
+        REQUIRE(SplitDrawData(100, 8, 256).size() == 1);
+        REQUIRE(SplitDrawData(600, 8, 256).size() == 2);
+        REQUIRE(SplitDrawData(600, 0, 0).size() == 1);
+    }
+}
+
+TEST_CASE("Sub-streams decode to the draws of their range", "[DrawStream]")
+{
+    auto draws = MakeSortedDraws(1000);
+    utils::LinearArena arena;
+
+    DrawStream fullStream;
+    CreateDrawStreamFromDrawData(draws, arena, fullStream);
+
+    std::vector<Draw> decoded;
+    DecodeDrawStream(fullStream, decoded);
+    REQUIRE(decoded.size() == draws.size());
+    for (size_t i = 0; i < draws.size(); ++i)
+        REQUIRE(DrawEqual(decoded[i], draws[i]));
+
+    auto ranges = SplitDrawData(static_cast<uint32_t>(draws.size()), 5, 64);
+    REQUIRE(ranges.size() == 5);
+
+    std::vector<DrawStream> subStreams;
+    SECTION("Serial encoding")
+    {
+        CreateDrawStreamsFromDrawData(draws, ranges, arena, subStreams);
+    }
+
+    SECTION("Parallel encoding")
+    {
+        JobSystem jobSystem(3);
+        CreateDrawStreamsFromDrawData(draws, ranges, arena, subStreams, &jobSystem);
+    }
+
+    REQUIRE(subStreams.size() == ranges.size());
+
+    // every sub-stream is decoded from an empty state, as a fresh command buffer would replay it
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        std::vector<Draw> rangeDraws;
+        DecodeDrawStream(subStreams[i], rangeDraws);
+
+        REQUIRE(rangeDraws.size() == ranges[i].GetDrawCount());
+        for (uint32_t j = 0; j < rangeDraws.size(); ++j)
+            REQUIRE(DrawEqual(rangeDraws[j], draws[ranges[i].begin + j]));
+    }
+}
+
+static void RequireRoundTrip(const std::vector<Draw>& draws, DrawStreamEncoding encoding)
+{
+    utils::LinearArena arena;
+    DrawStream stream;
+    CreateDrawStreamFromDrawData(draws, arena, stream, encoding);
+    REQUIRE(stream.encoding == encoding);
+
+    std::vector<Draw> decoded;
+    DecodeDrawStream(stream, decoded);
+    REQUIRE(decoded.size() == draws.size());
+    for (size_t i = 0; i < draws.size(); ++i)
+        REQUIRE(DrawEqual(decoded[i], draws[i]));
+}
+
+TEST_CASE("Compact draw streams decode to the same draws as full ones", "[DrawStream]")
+{
+    SECTION("Sorted draws")
+    {
+        auto draws = MakeSortedDraws(1000);
+        RequireRoundTrip(draws, DrawStreamEncoding::Full);
+        RequireRoundTrip(draws, DrawStreamEncoding::Compact);
+
+        utils::LinearArena arena;
+        DrawStream fullStream;
+        DrawStream compactStream;
+        CreateDrawStreamFromDrawData(draws, arena, fullStream, DrawStreamEncoding::Full);
+        CreateDrawStreamFromDrawData(draws, arena, compactStream, DrawStreamEncoding::Compact);
+        REQUIRE(compactStream.data.size() < fullStream.data.size());
+    }
+
+    SECTION("Large and negative deltas")
+    {
+        std::vector<Draw> draws(6);
+        draws[1].indexOffset    = UINT32_MAX;
+        draws[1].indexCount     = 3;
+        draws[2].indexOffset    = 0;
+        draws[2].vertexOffset   = 1u << 31;
+        draws[3].vertexOffset   = 5;
+        draws[3].instanceCount  = 1000000;
+        draws[4].instanceOffset = 70000;
+        // the last draw is identical to the one before, it has to be replayed all the same
+        draws[5] = draws[4];
+
+        RequireRoundTrip(draws, DrawStreamEncoding::Full);
+        RequireRoundTrip(draws, DrawStreamEncoding::Compact);
+    }
+
+    SECTION("Index types and draws without indices")
+    {
+        // 16 and 32 bit indices of the same buffer, then draws that only have vertices
+        std::vector<Draw> draws(6);
+        for (Draw& draw : draws)
+        {
+            draw.indexCount    = 36;
+            draw.vertexCount   = 24;
+            draw.instanceCount = 1;
+        }
+        draws[0].indexType   = IndexType::UINT16;
+        draws[1].indexType   = IndexType::UINT32;
+        draws[2].indexType   = IndexType::UINT32;
+        draws[2].vertexCount = 70000;
+        draws[3].indexCount  = 0;
+        draws[3].vertexCount = 3;
+        draws[4].indexCount  = 0;
+        draws[4].vertexCount = 3;
+        draws[5].indexType   = IndexType::UINT16;
+
+        RequireRoundTrip(draws, DrawStreamEncoding::Full);
+        RequireRoundTrip(draws, DrawStreamEncoding::Compact);
+    }
+
+    SECTION("Handles that do not fit in 16 bits")
+    {
+        Pool<int, Buffer> buffers;
+        std::vector<BufferHandle> bufferHandles;
+        for (int i = 0; i < 70000; ++i)
+            bufferHandles.push_back(buffers.create(0, Buffer{}));
+
+        std::vector<Draw> draws(16);
+        for (size_t i = 0; i < draws.size(); ++i)
+        {
+            draws[i].vertexBuffer = bufferHandles[i % 2 == 0 ? i : bufferHandles.size() - i];
+            draws[i].indexCount   = 3;
+        }
+
+        RequireRoundTrip(draws, DrawStreamEncoding::Compact);
+    }
+
+    SECTION("Sub-streams")
+    {
+        auto draws  = MakeSortedDraws(1000);
+        auto ranges = SplitDrawData(static_cast<uint32_t>(draws.size()), 4, 64);
+
+        utils::LinearArena arena;
+        std::vector<DrawStream> subStreams;
+        JobSystem jobSystem(3);
+        CreateDrawStreamsFromDrawData(draws, ranges, arena, subStreams, &jobSystem, DrawStreamEncoding::Compact);
+
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            std::vector<Draw> rangeDraws;
+            DecodeDrawStream(subStreams[i], rangeDraws);
+
+            REQUIRE(rangeDraws.size() == ranges[i].GetDrawCount());
+            for (uint32_t j = 0; j < rangeDraws.size(); ++j)
+                REQUIRE(DrawEqual(rangeDraws[j], draws[ranges[i].begin + j]));
+        }
+    }
+}
+
+TEST_CASE("Re-encoding the same draws does not allocate", "[DrawStream]")
+{
+    auto draws = MakeSortedDraws(20000);
+    auto ranges = SplitDrawData(static_cast<uint32_t>(draws.size()), 4, 256);
+
+    utils::LinearArena arena(4096);
+    DrawStream fullStream;
+    std::vector<DrawStream> subStreams;
+
+    // the first frames grow the arena until a single block holds a whole frame
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        arena.Reset();
+        CreateDrawStreamFromDrawData(draws, arena, fullStream);
+        CreateDrawStreamsFromDrawData(draws, ranges, arena, subStreams);
+    }
+
+    uint32_t blockAllocationCount = arena.GetBlockAllocationCount();
+    for (int frame = 0; frame < 8; ++frame)
+    {
+        arena.Reset();
+        CreateDrawStreamFromDrawData(draws, arena, fullStream);
+        CreateDrawStreamsFromDrawData(draws, ranges, arena, subStreams);
+    }
+    REQUIRE(arena.GetBlockAllocationCount() == blockAllocationCount);
+
+    std::vector<Draw> decoded;
+    DecodeDrawStream(fullStream, decoded);
+    REQUIRE(decoded.size() == draws.size());
+    for (size_t i = 0; i < draws.size(); ++i)
+        REQUIRE(DrawEqual(decoded[i], draws[i]));
+}
+
+// The encoding as it was before the arena: a zeroed worst case buffer, ShrinkToFit into a second one and a copy into the stream
+struct CopyingDrawStream
+{
+    std::vector<uint8_t> data;
+};
+
+static void EncodeWithCopies(const std::vector<Draw>& draws, utils::LinearArena& scratch, CopyingDrawStream& stream)
+{
+    BitWriter writer(draws.size() * (sizeof(DrawStateMask) + sizeof(Draw)), false);
+
+    // the encoder only writes to an arena now, so the result is moved into the worst case buffer afterwards,
+    // which makes this path one copy slower than it used to be
+    DrawStream encoded;
+    scratch.Reset();
+    CreateDrawStreamFromDrawData(draws, scratch, encoded);
+    std::memcpy(writer.GetData(), encoded.data.data(), encoded.data.size());
+
+    std::vector<uint8_t> shrunk(writer.GetData(), writer.GetData() + encoded.data.size());
+    stream.data = std::vector<uint8_t>(shrunk.begin(), shrunk.end());
+}
+
+TEST_CASE("Draw stream encoding benchmark", "[DrawStream][.benchmark]")
+{
+    for (size_t drawCount : {1000, 10000, 100000})
+    {
+        auto draws = MakeSortedDraws(drawCount);
+
+        utils::LinearArena scratch;
+        CopyingDrawStream copyingStream;
+        EncodeWithCopies(draws, scratch, copyingStream);
+
+        // per stream: the worst case buffer, the shrunk buffer and the stream vector, the last two copy every byte
+        WARN(std::to_string(drawCount) + " draws, copying path: 3 heap allocations and "
+             + std::to_string(2 * copyingStream.data.size()) + " bytes copied per stream");
+
+        utils::LinearArena arena;
+        DrawStream stream;
+        CreateDrawStreamFromDrawData(draws, arena, stream);
+        arena.Reset();
+        uint32_t blockAllocationCount = arena.GetBlockAllocationCount();
+
+        BENCHMARK("Copying encode, " + std::to_string(drawCount) + " draws")
+        {
+            EncodeWithCopies(draws, scratch, copyingStream);
+            return copyingStream.data.size();
+        };
+
+        BENCHMARK("Arena encode, " + std::to_string(drawCount) + " draws")
+        {
+            arena.Reset();
+            CreateDrawStreamFromDrawData(draws, arena, stream);
+            return stream.data.size();
+        };
+
+        WARN(std::to_string(drawCount) + " draws, arena path: "
+             + std::to_string(arena.GetBlockAllocationCount() - blockAllocationCount) + " heap allocations and 0 bytes copied");
+    }
+}
+
+TEST_CASE("Draw stream compact encoding benchmark", "[DrawStream][.benchmark]")
+{
+    auto draws = MakeSortedDraws(100000);
+
+    for (DrawStreamEncoding encoding : {DrawStreamEncoding::Full, DrawStreamEncoding::Compact})
+    {
+        std::string name = encoding == DrawStreamEncoding::Full ? "Full" : "Compact";
+
+        utils::LinearArena arena;
+        DrawStream stream;
+        CreateDrawStreamFromDrawData(draws, arena, stream, encoding);
+
+        WARN(name + " encoding: " + std::to_string(static_cast<double>(stream.data.size()) / static_cast<double>(draws.size())) + " bytes per draw");
+
+        BENCHMARK(name + " encode, 100000 draws")
+        {
+            arena.Reset();
+            CreateDrawStreamFromDrawData(draws, arena, stream, encoding);
+            return stream.data.size();
+        };
+
+        std::vector<Draw> decoded;
+        decoded.reserve(draws.size());
+        BENCHMARK(name + " decode, 100000 draws")
+        {
+            decoded.clear();
+            DecodeDrawStream(stream, decoded);
+            return decoded.size();
+        };
+    }
+}
+
+} // namespace gore::test
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Prefix.h"
+
+#include "Rendering/GPUData/TransformData.h"
+
+#include "Graphics/Vulkan/VulkanIncludes.h"
+
+namespace gore
+{
+// Where the shaders of draws recorded from the DrawCache find the per object data of a draw.
+// The per object data index of a draw (Draw::dynamicBufferOffset) is the slot of its transform in the GPUTransformChangeSystem.
+enum class InstanceDataStoragePolicy
+{
+    None,
+    // The matrix is pushed before every draw, nothing is kept on the GPU
+    PerDrawPushConstant,
+    // One aligned PerDrawData per slot in a uniform buffer, bound with a dynamic offset before every draw
+    PersistentDynamicUniformBuffer,
+    // The transform buffer is indexed by instance ID through the instance indices of the draw list, copies of a mesh
+    // are drawn instanced and nothing is bound per draw
+    PersistentStructuredBuffer,
+};
+} // namespace gore
+
+namespace gore::renderer
+{
+// What ScheduleDrawStream needs to hand the per object data to the shaders, only the fields of policy are used.
+// The default binds the dynamic buffer of the draws at offset 0.
+struct InstanceDataBinding final
+{
+    InstanceDataStoragePolicy policy = InstanceDataStoragePolicy::PersistentDynamicUniformBuffer;
+
+    // PersistentDynamicUniformBuffer, bytes between the data of two slots
+    uint32_t dynamicOffsetStride = 0;
+
+    // PerDrawPushConstant, the transform of every slot
+    const TransformData* transforms = nullptr;
+
+    // PersistentStructuredBuffer, set 3 with the transform buffer and the instance indices, the ones of the draw list
+    // start at instanceIndexBase
+    vk::DescriptorSet instanceSet = {};
+    uint32_t instanceIndexBase    = 0;
+};
+} // namespace gore::renderer
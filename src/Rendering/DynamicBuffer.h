@@ -24,4 +24,9 @@ struct DynamicBuffer
 
 using DynamicBufferHandle = Handle<DynamicBuffer>;
 
+inline vk::DescriptorSet GetNativeHandle(const DynamicBuffer& dynamicBuffer)
+{
+    return dynamicBuffer.set;
+}
+
 } // namespace gore::gfx
\ No newline at end of file
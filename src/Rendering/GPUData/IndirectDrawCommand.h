@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+// Same layout as VkDrawIndexedIndirectCommand, so the CPU can build the argument buffer without the vulkan headers
+struct IndirectDrawCommand
+{
+    uint32_t indexCount;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t firstInstance;
+};
+
+static_assert(sizeof(IndirectDrawCommand) == 20, "IndirectDrawCommand has to match VkDrawIndexedIndirectCommand");
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// Element of the instance buffer of the unified geometry buffer, see UGB.md. The matrix is read from the transform
+// buffer of GPUTransformChangeSystem, so moving an object does not touch the instance buffer.
+struct InstanceData
+{
+    uint32_t transformSlot;
+    uint32_t meshIndex;
+    uint32_t padding[2];
+};
+
+static_assert(sizeof(InstanceData) == 16, "InstanceData has to match the StructuredBuffer layout in the shaders");
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// Element of the mesh buffer of the unified geometry buffer, see UGB.md.
+// Offsets are in vertices and indices, not bytes.
+struct MeshData
+{
+    uint32_t vertexOffset;
+    uint32_t indexOffset;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+};
@@ -1,8 +1,15 @@
 #pragma once
 
 #include "Math/Matrix4x4.h"
+#include "Math/Vector4.h"
 
+// Per object data of the draws recorded from the DrawCache, see InstanceDataStoragePolicy. The position scale and
+// offset are the ones of TransformData.
 struct PerDrawData
 {
-    gore::Matrix4x4 model[128];
+    gore::Matrix4x4 objectToWorld;
+    gore::Vector4 positionScale;
+    gore::Vector4 positionOffset;
 };
+
+static_assert(sizeof(PerDrawData) == 96, "PerDrawData has to match the ConstantBuffer and push constant layout in the shaders");
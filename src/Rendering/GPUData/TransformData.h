@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Math/Matrix4x4.h"
+#include "Math/Vector4.h"
+
+// Element of the transform buffer written by GPUTransformChangeSystem, the previous frame's matrix is for motion vectors.
+// Unorm16 positions of the mesh drawn with the transform are decoded to object space with positionScale and
+// positionOffset, which are one and zero for every other mesh. The w of both is unused.
+struct TransformData
+{
+    gore::Matrix4x4 localToWorld;
+    gore::Matrix4x4 prevLocalToWorld;
+    gore::Vector4 positionScale;
+    gore::Vector4 positionOffset;
+};
+
+static_assert(sizeof(TransformData) == 160, "TransformData has to match the StructuredBuffer layout in the shaders");
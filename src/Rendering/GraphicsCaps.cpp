@@ -14,5 +14,9 @@ void InitVulkanGraphicsCaps(GraphicsCaps& caps, Instance& instance, Device& devi
     // Note: This is a simplified check. In a real application, you would want to check for specific features
     // but if the device cannot support vulkan 1.2, it cannot support bindless.
     caps.supportsBindless = vulkanMinorVersion >= 2;
+
+    // Device enables every supported feature and extension, so supported means enabled here
+    caps.supportsMultiDrawIndirect = device.GetPhysicalDevice().Get().getFeatures().multiDrawIndirect == VK_TRUE;
+    caps.supportsDrawIndirectCount = device.HasExtension(VulkanDeviceExtension::kVK_KHR_draw_indirect_count);
 }
 } // namespace gore::gfx
\ No newline at end of file
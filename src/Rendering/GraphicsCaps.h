@@ -11,6 +11,9 @@ struct GraphicsCaps
     size_t minUniformBufferOffsetAlignment = 0;
 
     bool supportsBindless = false;
+
+    bool supportsMultiDrawIndirect = false;
+    bool supportsDrawIndirectCount = false;
 };
 
 void InitVulkanGraphicsCaps(GraphicsCaps& caps, Instance& instance, Device& device);
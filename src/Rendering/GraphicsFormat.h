@@ -22,6 +22,9 @@ enum class GraphicsFormat
     RGB8_UNORM,  // color
     RG16_FLOAT,  // uv
     RG32_FLOAT,  // uv for large texture sample
+    RGBA16_UNORM,  // position quantized to the mesh bounds
+    RG16_SNORM,    // octahedral normal, tangent
+    RGB10A2_UNORM, // packed normal, tangent
     R32_UINT,    // indices
     R16_UINT,    // indices
     R8_UINT,     // indices for small mesh
@@ -269,6 +269,8 @@ struct GraphicsPipelineDesc final
 
     std::vector<BindLayout> bindLayouts = {};
     DynamicBufferHandle dynamicBuffer   = {};
+    // one push constant range at offset 0 for the vertex stage
+    uint32_t pushConstantByteSize       = 0;
 
     InputAssemblyState assemblyState;
 
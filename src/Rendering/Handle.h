@@ -52,6 +52,10 @@ private:
 
     template <typename ObjectType_, typename ImplObjectType>
     friend class Pool;
+    template <typename ObjectType_, typename ImplObjectType>
+    friend class DensePool;
+    template <typename ObjectType_, typename ImplObjectType, uint32_t ChunkSizeLog2, uint32_t MaxChunkCount>
+    friend class ConcurrentPool;
 
     uint32_t _index = 0;
     uint32_t _gen   = 0;
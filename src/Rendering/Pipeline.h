@@ -28,4 +28,9 @@ struct ComputePipeline final : Pipeline
 
 using GraphicsPipelineHandle = Handle<GraphicsPipeline>;
 using ComputePipelineHandle  = Handle<ComputePipeline>;
+
+inline vk::Pipeline GetNativeHandle(const Pipeline& pipeline)
+{
+    return pipeline.pipeline;
+}
 } // namespace gore
\ No newline at end of file
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "Handle.h"
 
 #include <vector>
@@ -1,7 +1,14 @@
 #include "Test/TestPrefix.h"
 #include "Pool.h"
+#include "DensePool.h"
 
 #if ENABLE_TEST
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
 namespace gore {
 namespace test {
 
@@ -50,6 +57,197 @@ TEST_CASE("Pool class tests", "[Pool]") {
     }
 }
 
+struct NativeTestObject {
+    uint64_t native;
+    int value;
+};
+
+uint64_t GetNativeHandle(const NativeTestObject& obj) {
+    return obj.native;
+}
+
+TEST_CASE("DensePool class tests", "[Pool]") {
+    SECTION("Create and destroy") {
+        DensePool<TestObject, TestObject> pool;
+        auto handle = pool.create(TestObject{1}, TestObject{2});
+        REQUIRE(pool.num() == 1);
+        REQUIRE(pool.valid(handle));
+        pool.destroy(handle);
+        REQUIRE(pool.num() == 0);
+        REQUIRE(pool.valid(handle) == false);
+        REQUIRE(pool.getObjectPtr(handle) == nullptr);
+    }
+
+    SECTION("Destroy keeps live objects contiguous") {
+        DensePool<TestObject, TestObject> pool;
+        std::vector<Handle<TestObject>> handles;
+        for (int i = 0; i < 8; i++)
+            handles.push_back(pool.create(TestObject{i}, TestObject{i * 10}));
+
+        pool.destroy(handles[0]);
+        pool.destroy(handles[5]);
+        REQUIRE(pool.num() == 6);
+        REQUIRE(pool.objects().size() == 6);
+
+        for (int i = 0; i < 8; i++) {
+            if (i == 0 || i == 5)
+                continue;
+            REQUIRE(pool.getObject(handles[i]).value == i * 10);
+            REQUIRE(pool.getObjectDesc(handles[i]).value == i);
+        }
+
+        int sum = 0;
+        for (const TestObject& obj : pool)
+            sum += obj.value;
+        REQUIRE(sum == (1 + 2 + 3 + 4 + 6 + 7) * 10);
+
+        for (uint32_t i = 0; i < pool.num(); i++)
+            REQUIRE(pool.getObject(pool.getHandle(i)).value == pool.objects()[i].value);
+    }
+
+    SECTION("Slots are reused with a new generation") {
+        DensePool<TestObject, TestObject> pool;
+        auto first = pool.create(TestObject{1}, TestObject{2});
+        pool.destroy(first);
+        auto second = pool.create(TestObject{3}, TestObject{4});
+        REQUIRE(second.index() == first.index());
+        REQUIRE(second != first);
+        REQUIRE(pool.getObjectPtr(first) == nullptr);
+        REQUIRE(pool.getObjectPtr(second)->value == 4);
+    }
+
+    SECTION("Find object") {
+        DensePool<TestObject, TestObject> pool;
+        pool.create(TestObject{1}, TestObject{1});
+        auto handle = pool.create(TestObject{2}, TestObject{2});
+        REQUIRE(pool.getObjectHandle(pool.getObjectPtr(handle)) == handle);
+
+        // objects that do not live in the pool are not found
+        TestObject outside{2};
+        REQUIRE(pool.getObjectHandle(&outside).empty());
+    }
+
+    SECTION("Find object from its native handle") {
+        DensePool<int, NativeTestObject> pool;
+        auto first  = pool.create(0, NativeTestObject{0x1000, 1});
+        auto second = pool.create(0, NativeTestObject{0x2000, 2});
+        pool.create(0, NativeTestObject{0, 3});
+
+        REQUIRE(pool.getObjectHandleFromNative(uint64_t(0x1000)) == first);
+        REQUIRE(pool.getObjectHandleFromNative(uint64_t(0x2000)) == second);
+        REQUIRE(pool.getObjectHandleFromNative(uint64_t(0)).empty());
+
+        pool.destroy(first);
+        REQUIRE(pool.getObjectHandleFromNative(uint64_t(0x1000)).empty());
+        REQUIRE(pool.getObjectHandleFromNative(uint64_t(0x2000)) == second);
+    }
+
+    SECTION("Objects are found by an API object replaced in place") {
+        DensePool<int, NativeTestObject> pool;
+        auto handle = pool.create(0, NativeTestObject{0x1000, 1});
+
+        pool.getObject(handle).native = 0x2000;
+        pool.updateNativeHandle(handle, uint64_t(0x1000));
+        REQUIRE(pool.getObjectHandleFromNative(uint64_t(0x2000)) == handle);
+        REQUIRE(pool.getObjectHandleFromNative(uint64_t(0x1000)).empty());
+
+        // the previous API object may be pooled again right away, as a retired duplicate
+        auto retired = pool.create(0, NativeTestObject{0x1000, 2});
+        REQUIRE(pool.getObjectHandleFromNative(uint64_t(0x1000)) == retired);
+        REQUIRE(pool.getObjectHandleFromNative(uint64_t(0x2000)) == handle);
+    }
+
+    SECTION("Clear") {
+        DensePool<TestObject, TestObject> pool;
+        pool.create(TestObject{1}, TestObject{2});
+        pool.clear();
+        REQUIRE(pool.num() == 0);
+        REQUIRE(pool.objects().empty());
+    }
+}
+
+TEST_CASE("Pool benchmark", "[Pool][.benchmark]") {
+    constexpr int objectCount = 10000;
+
+    // half of the objects are destroyed in random order, which leaves holes all over Pool
+    auto fill = [](auto& pool, std::vector<Handle<TestObject>>& handles) {
+        std::mt19937 random(11);
+        handles.clear();
+        for (int i = 0; i < objectCount; i++)
+            handles.push_back(pool.create(TestObject{i}, TestObject{i}));
+        std::shuffle(handles.begin(), handles.end(), random);
+        for (int i = 0; i < objectCount / 2; i++)
+            pool.destroy(handles[i]);
+        handles.erase(handles.begin(), handles.begin() + objectCount / 2);
+    };
+
+    Pool<TestObject, TestObject> pool;
+    DensePool<TestObject, TestObject> densePool;
+    std::vector<Handle<TestObject>> poolHandles;
+    std::vector<Handle<TestObject>> densePoolHandles;
+    fill(pool, poolHandles);
+    fill(densePool, densePoolHandles);
+
+    BENCHMARK("Pool lookup") {
+        int sum = 0;
+        for (auto handle : poolHandles)
+            sum += pool.getObject(handle).value;
+        return sum;
+    };
+
+    BENCHMARK("DensePool lookup") {
+        int sum = 0;
+        for (auto handle : densePoolHandles)
+            sum += densePool.getObject(handle).value;
+        return sum;
+    };
+
+    // Pool has no way to skip destroyed entries, live objects are reached through their handles
+    BENCHMARK("Pool iteration") {
+        int sum = 0;
+        for (auto handle : poolHandles)
+            sum += pool.getObject(handle).value;
+        return sum;
+    };
+
+    BENCHMARK("DensePool iteration") {
+        int sum = 0;
+        for (const TestObject& obj : densePool)
+            sum += obj.value;
+        return sum;
+    };
+
+    BENCHMARK("Pool reverse lookup") {
+        uint32_t sum = 0;
+        for (size_t i = 0; i < poolHandles.size(); i += 100)
+            sum += pool.getObjectHandle(pool.getObjectPtr(poolHandles[i])).index();
+        return sum;
+    };
+
+    BENCHMARK("DensePool reverse lookup") {
+        uint32_t sum = 0;
+        for (size_t i = 0; i < densePoolHandles.size(); i += 100)
+            sum += densePool.getObjectHandle(densePool.getObjectPtr(densePoolHandles[i])).index();
+        return sum;
+    };
+
+    BENCHMARK("Pool churn") {
+        for (auto& handle : poolHandles) {
+            pool.destroy(handle);
+            handle = pool.create(TestObject{1}, TestObject{1});
+        }
+        return pool.num();
+    };
+
+    BENCHMARK("DensePool churn") {
+        for (auto& handle : densePoolHandles) {
+            densePool.destroy(handle);
+            handle = densePool.create(TestObject{1}, TestObject{1});
+        }
+        return densePool.num();
+    };
+}
+
 }  // namespace test
 }  // namespace gore
 #endif
\ No newline at end of file
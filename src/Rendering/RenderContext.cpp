@@ -6,10 +6,13 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-#include "Utilities/GLTFLoader.h"
+#include "Rendering/UnifiedGeometryBuffer/UnifiedGeometryBuffer.h"
+
+#include "Core/JobSystem.h"
+
+#include <algorithm>
 
 #define VULKAN_DEVICE      (*m_DevicePtr->Get())
-#define USE_STAGING_BUFFER 1
 
 namespace gore::gfx
 {
@@ -22,7 +25,8 @@ RenderContext::RenderContext(const RenderContextCreateInfo& createInfo) :
     m_BufferPool(),
     m_TexturePool(),
     m_CommandPool(VK_NULL_HANDLE),
-    m_PSOFlags(createInfo.flags)
+    m_PSOFlags(createInfo.flags),
+    m_GraphicsCaps(createInfo.caps)
 {
     uint32_t queueFamilyIndex = m_DevicePtr->GetQueueFamilyIndexByFlags(vk::QueueFlagBits::eGraphics);
 
@@ -39,18 +43,176 @@ RenderContext::~RenderContext()
     g_Instance = nullptr;
 }
 
-void RenderContext::LoadMeshToMeshRenderer(const std::string& name, MeshRenderer& meshRenderer, uint32_t meshIndex, ShaderChannel channel)
+static std::string GetGLTFPath(const std::string& name)
 {
     static const std::filesystem::path kGLTFFolder = FileSystem::GetResourceFolder() / "GLTF";
-    auto gltfPath                                  = kGLTFFolder / name;
-    GLTFLoader gltfLoader(*this);
+    return (kGLTFFolder / name).generic_string();
+}
+
+static std::string GetTexturePath(const std::string& name)
+{
+    static const std::filesystem::path kTextureFolder = FileSystem::GetResourceFolder() / "Textures";
+    return (kTextureFolder / name).generic_string();
+}
+
+void RenderContext::LoadMeshToMeshRenderer(const std::string& name, MeshRenderer& meshRenderer, uint32_t meshIndex, ShaderChannel channel)
+{
+    MeshLoadRequest request = {
+        .name         = name,
+        .meshRenderer = &meshRenderer,
+        .meshIndex    = meshIndex,
+        .channel      = channel,
+    };
+
+    LoadMeshesToMeshRenderers({&request, 1});
+}
+
+void RenderContext::LoadMeshesToMeshRenderers(std::span<const MeshLoadRequest> requests)
+{
+    AssetLoader& assetLoader = GetAssetLoader();
+
+    std::vector<MeshRequest> meshRequests;
+    meshRequests.reserve(requests.size());
+    for (const MeshLoadRequest& request : requests)
+        meshRequests.push_back({.path = GetGLTFPath(request.name), .meshIndex = static_cast<int>(request.meshIndex), .channels = request.channel});
+
+    std::vector<std::shared_ptr<MeshAsset>> assets = assetLoader.RequestMeshes(meshRequests);
+
+    // each packed mesh reports what it saves, the batch adds up the total
+    uint32_t packedMeshCount           = 0;
+    VertexCompressionStats packedStats = {};
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        if (assetLoader.Wait(*assets[i]) == false)
+        {
+            LOG_STREAM(ERROR) << "Failed to load mesh at " << assets[i]->path << std::endl;
+            continue;
+        }
+
+        // the pipelines read every channel of Vertex, the ones the request leaves out are packed with their defaults
+        VertexLayout layout = CreateVertexLayout(ShaderChannel::Default, requests[i].compression);
+        UploadMeshData(assets[i]->GetView(), *requests[i].meshRenderer, layout);
+
+        if (layout.IsVertex() == false)
+        {
+            VertexCompressionStats stats = GetVertexCompressionStats(requests[i].meshRenderer->GetVertexCount(), layout);
+            LOG_STREAM(INFO) << "Packed vertices of mesh " << requests[i].meshIndex << " in " << requests[i].name << " from "
+                             << stats.vertexByteSize << " to " << stats.packedByteSize << " bytes, "
+                             << stats.GetSavedRatio() * 100.0f << "% less to fetch" << std::endl;
+            packedStats.vertexByteSize += stats.vertexByteSize;
+            packedStats.packedByteSize += stats.packedByteSize;
+            ++packedMeshCount;
+        }
+    }
+
+    if (packedMeshCount > 1 && packedStats.packedByteSize < packedStats.vertexByteSize)
+    {
+        LOG_STREAM(INFO) << "Packed vertices of " << packedMeshCount << " meshes from " << packedStats.vertexByteSize << " to "
+                         << packedStats.packedByteSize << " bytes, " << packedStats.GetSavedRatio() * 100.0f << "% less to fetch"
+                         << std::endl;
+    }
+}
+
+MeshGeometry::~MeshGeometry()
+{
+    // frames in flight may still draw from them
+    if (RenderContext* renderContext = RenderContext::GetInstance())
+    {
+        renderContext->RetireBufferRange(vertexRange);
+        renderContext->RetireBufferRange(indexRange);
+    }
+}
 
-    bool ret = gltfLoader.LoadMesh(meshRenderer, gltfPath.generic_string(), meshIndex, channel);
+void RenderContext::UploadMeshData(const MeshDataView& meshData, MeshRenderer& meshRenderer, const VertexLayout& layout)
+{
+    uint32_t vertexCount = static_cast<uint32_t>(meshData.vertices.size());
+    IndexType indexType  = meshData.indexType;
+
+    MeshGeometryLocation location = UploadMeshGeometry(meshData, layout);
+
+    meshRenderer.SetGeometry(location.geometry);
+    meshRenderer.SetVertexBuffer(location.vertexBuffer);
+    meshRenderer.SetVertexCount(vertexCount);
+    meshRenderer.SetVertexOffset(location.vertexOffset);
+
+    meshRenderer.SetIndexBuffer(location.indexBuffer);
+    meshRenderer.SetIndexType(indexType);
+    meshRenderer.SetIndexCount(meshData.indexCount);
+    meshRenderer.SetIndexOffset(location.indexOffset);
+
+    meshRenderer.SetPositionScale(location.positionScale);
+    meshRenderer.SetPositionOffset(location.positionOffset);
+    meshRenderer.SetVertexLayout(layout);
+
+    // a mesh of one part is drawn as a whole
+    bool hasSubMeshes = meshData.subMeshes.size() > 1;
+    meshRenderer.SetSubMeshes(hasSubMeshes ? std::vector<SubMesh>(meshData.subMeshes.begin(), meshData.subMeshes.end()) : std::vector<SubMesh>());
+
+    // a copy goes to the unified geometry buffer, so the mesh can be drawn indirectly as well. Its indirect draws are
+    // one per mesh and read Vertex, so meshes of several parts or packed otherwise are only drawn directly.
+    UnifiedGeometryBuffer* geometryBuffer = UnifiedGeometryBuffer::GetInstance();
+    if (geometryBuffer == nullptr)
+        return;
+
+    // the mesh loaded into the renderer before gives its space back
+    geometryBuffer->RemoveMesh(meshRenderer.GetUnifiedMeshIndex());
+
+    uint32_t unifiedMeshIndex = UnifiedGeometryBuffer::k_InvalidMesh;
+    if (indexType != IndexType::None && hasSubMeshes == false && layout.IsVertex())
+        unifiedMeshIndex = geometryBuffer->AddMesh(meshData.vertices.data(), vertexCount, sizeof(Vertex), meshData.indices.data(), meshData.indexCount, indexType);
 
-    if (ret == false)
+    meshRenderer.SetUnifiedMeshIndex(unifiedMeshIndex);
+}
+
+MeshGeometryLocation RenderContext::UploadMeshGeometry(const MeshDataView& meshData, const VertexLayout& layout)
+{
+    assert(layout.byteStride > 0);
+
+    uint32_t vertexCount = static_cast<uint32_t>(meshData.vertices.size());
+    IndexType indexType  = meshData.indexType;
+
+    // vertices stored as Vertex are copied as they are
+    PackedVertices packedVertices;
+    const void* vertexData = meshData.vertices.data();
+    if (layout.IsVertex() == false)
     {
-        LOG_STREAM(ERROR) << "Failed to load mesh at " << gltfPath << std::endl;
+        packedVertices = PackVertices(meshData.vertices, layout);
+        vertexData     = packedVertices.data.data();
     }
+
+    // meshes share the blocks of the vertex and index arenas, offsets are in vertices and indices. Each layout has an
+    // arena of its own, aligned to its stride.
+    BufferRange vertexRange = AllocateBufferRange(BufferUsage::Vertex, vertexCount * layout.byteStride, layout.byteStride, vertexData);
+    // 16 and 32 bit indices share one arena, 4 byte alignment keeps the offset a whole number of either. Meshes without
+    // indices draw their vertices in order.
+    BufferRange indexRange = {};
+    if (indexType != IndexType::None)
+        indexRange = AllocateBufferRange(BufferUsage::Index, static_cast<uint32_t>(meshData.indices.size()), sizeof(uint32_t), meshData.indices.data());
+
+    auto geometry          = std::make_shared<MeshGeometry>();
+    geometry->vertexRange  = vertexRange;
+    geometry->indexRange   = indexRange;
+    geometry->vertexStride = layout.byteStride;
+    m_MeshGeometries.push_back(geometry);
+
+    return {
+        .geometry       = std::move(geometry),
+        .vertexBuffer   = vertexRange.buffer,
+        .vertexOffset   = vertexRange.byteOffset / layout.byteStride,
+        .indexBuffer    = indexRange.buffer,
+        .indexOffset    = indexType != IndexType::None ? indexRange.byteOffset / GetIndexTypeSize(indexType) : 0,
+        .positionScale  = packedVertices.positionScale,
+        .positionOffset = packedVertices.positionOffset,
+    };
+}
+
+AssetLoader& RenderContext::GetAssetLoader()
+{
+    // created on first use, the JobSystem is up before the render system
+    if (m_AssetLoader == nullptr)
+        m_AssetLoader = std::make_unique<AssetLoader>(JobSystem::GetInstance(), AssetLoaderDesc{.cookMeshes = true});
+
+    return *m_AssetLoader;
 }
 
 BindLayout RenderContext::GetOrCreateBindLayout(const BindLayoutCreateInfo& createInfo)
@@ -108,25 +270,45 @@ BindLayout RenderContext::GetOrCreateBindLayout(const BindLayoutCreateInfo& crea
 
 void RenderContext::Clear()
 {
+    // the staging buffers of both are in the buffer pool
+    m_AsyncUploader.reset();
+    m_StreamingBindGroups.clear();
+
+    ReleaseAllRetiredResources();
+    m_UploadRing.reset();
+    m_PendingTransfers.clear();
+    m_PendingBufferCopies.clear();
+    m_PendingImageCopies.clear();
+
+    // the blocks of the arenas are in the buffer pool, geometry still held by renderers lost its ranges with them
+    for (const std::weak_ptr<MeshGeometry>& weakGeometry : m_MeshGeometries)
+    {
+        if (std::shared_ptr<MeshGeometry> geometry = weakGeometry.lock())
+        {
+            geometry->vertexRange = {};
+            geometry->indexRange  = {};
+        }
+    }
+    m_MeshGeometries.clear();
+    m_BufferArenas.clear();
+
     m_ShaderModulePool.clear();
 
-    auto& buffers = m_BufferPool.objects;
-    for (auto& buffer : buffers)
+    for (auto& buffer : m_BufferPool)
     {
         ClearVulkanBuffer(m_DevicePtr->GetVmaAllocator(), buffer.vkBuffer, buffer.vmaAllocation);
     }
     m_BufferPool.clear();
 
-    auto& textures     = m_TexturePool.objects;
-    auto& textureDescs = m_TexturePool.objectDesc;
-    for (int i = 0; i < textures.size(); i++)
+    auto textures     = m_TexturePool.objects();
+    auto textureDescs = m_TexturePool.descs();
+    for (size_t i = 0; i < textures.size(); i++)
     {
-        DestroyTextureObject(textures[i], textureDescs[i].objDesc);
+        DestroyTextureObject(textures[i], textureDescs[i]);
     }
     m_TexturePool.clear();
 
-    auto& samplers = m_SamplerPool.objects;
-    for (auto& sampler : samplers)
+    for (auto& sampler : m_SamplerPool)
     {
         VULKAN_DEVICE.destroySampler(sampler.vkSampler);
     }
@@ -134,8 +316,7 @@ void RenderContext::Clear()
 
     ClearDescriptorPools();
 
-    auto& pipelines = m_GraphicsPipelinePool.objects;
-    for (auto& pipeline : pipelines)
+    for (auto& pipeline : m_GraphicsPipelinePool)
     {
         VULKAN_DEVICE.destroyPipeline(pipeline.pipeline);
     }
@@ -146,31 +327,6 @@ void RenderContext::Clear()
     ClearCache(m_ResourceCache, VULKAN_DEVICE);
 }
 
-Buffer RenderContext::CreateStagingBuffer(const Device& device, void const* data, size_t size)
-{
-    VkBufferCreateInfo bufferInfo = {
-        .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size        = size,
-        .usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-    };
-
-    VmaAllocationCreateInfo allocCreateInfo = {
-        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
-        .usage = VMA_MEMORY_USAGE_AUTO,
-    };
-
-    Buffer buffer = {};
-    buffer.vmaAllocator = device.GetVmaAllocator();
-
-    VK_CHECK_RESULT(vmaCreateBuffer(device.GetVmaAllocator(), &bufferInfo, &allocCreateInfo, &buffer.vkBuffer, &buffer.vmaAllocation, &buffer.vmaAllocationInfo));
-
-    void* mappedData = buffer.vmaAllocationInfo.pMappedData;
-    memcpy(mappedData, data, size);
-
-    return buffer;
-}
-
 vk::raii::CommandBuffer RenderContext::CreateCommandBuffer(vk::CommandBufferLevel level, bool begin)
 {
     vk::CommandBufferAllocateInfo allocateInfo(*m_CommandPool, level, 1);
@@ -340,7 +496,7 @@ GraphicsPipelineHandle RenderContext::CreateGraphicsPipeline(GraphicsPipelineDes
     if (desc.dynamicBuffer.empty() == false)
         dynamicBuffer = &GetDynamicBuffer(desc.dynamicBuffer);
 
-    vk::PipelineLayout pipelineLayout = GetOrCreatePipelineLayout(desc.bindLayouts, dynamicBuffer).layout;
+    vk::PipelineLayout pipelineLayout = GetOrCreatePipelineLayout(desc.bindLayouts, dynamicBuffer, desc.pushConstantByteSize).layout;
 
     vk::GraphicsPipelineCreateInfo createInfo;
     createInfo.stageCount          = 2;
@@ -399,29 +555,47 @@ const GraphicsPipeline& RenderContext::GetGraphicsPipeline(GraphicsPipelineHandl
 
 TextureHandle RenderContext::CreateTextureHandle(const std::string& name)
 {
-    static const std::filesystem::path kTextureFolder = FileSystem::GetResourceFolder() / "Textures";
-    auto texturePath                                  = kTextureFolder / name;
+    AssetLoader& assetLoader = GetAssetLoader();
+
+    std::shared_ptr<ImageAsset> image = assetLoader.RequestImage(GetTexturePath(name));
+    assetLoader.Wait(*image);
 
-    // TODO: change to use std::vector?
+    return CreateTextureHandle(name, *image);
+}
+
+std::vector<TextureHandle> RenderContext::CreateTextureHandles(std::span<const std::string> names)
+{
+    AssetLoader& assetLoader = GetAssetLoader();
 
-    int width, height, channel;
-    stbi_uc* pixels = stbi_load(texturePath.generic_string().c_str(), &width, &height, &channel, STBI_rgb_alpha);
+    std::vector<std::shared_ptr<ImageAsset>> images;
+    images.reserve(names.size());
+    for (const std::string& name : names)
+        images.push_back(assetLoader.RequestImage(GetTexturePath(name)));
 
-    if (pixels == nullptr)
+    std::vector<TextureHandle> handles;
+    handles.reserve(names.size());
+    for (size_t i = 0; i < names.size(); ++i)
     {
-        LOG_STREAM(ERROR) << "RenderSystem CreateTextureHandle: Failed to load texture: " << name << std::endl;
-        return TextureHandle();
+        assetLoader.Wait(*images[i]);
+        handles.push_back(CreateTextureHandle(names[i], *images[i]));
     }
 
-    TextureHandle handle = CreateTextureHandle({.debugName = name.c_str(),
-                                          .width     = static_cast<uint32_t>(width),
-                                          .height    = static_cast<uint32_t>(height),
-                                          .data      = pixels,
-                                          .dataSize  = static_cast<uint32_t>(width * height * 4)});
+    return handles;
+}
 
-    stbi_image_free(pixels);
+TextureHandle RenderContext::CreateTextureHandle(const std::string& name, const ImageAsset& image)
+{
+    if (image.loaded == false)
+    {
+        LOG_STREAM(ERROR) << "RenderSystem CreateTextureHandle: Failed to load texture: " << name << std::endl;
+        return TextureHandle();
+    }
 
-    return handle;
+    return CreateTextureHandleAsync({.debugName = name.c_str(),
+                                     .width     = image.data.width,
+                                     .height    = image.data.height,
+                                     .data      = image.data.pixels.data(),
+                                     .dataSize  = static_cast<uint32_t>(image.data.pixels.size())});
 }
 
 TextureHandle RenderContext::CreateTextureHandle(TextureDesc&& desc)
@@ -470,17 +644,35 @@ TextureHandle RenderContext::CreateTextureHandle(TextureDesc&& desc)
 
     assert(desc.data != nullptr && desc.dataSize > 0);
 
-    vk::raii::Queue queue = m_DevicePtr->Get().getQueue(m_DevicePtr->GetQueueFamilyIndexByFlags(vk::QueueFlagBits::eGraphics), 0);
+    CopyDataToTexture(handle, desc.data, desc.dataSize);
 
-    vk::raii::CommandBuffer cmd = CreateCommandBuffer(vk::CommandBufferLevel::ePrimary, true);
+    return handle;
+}
 
-    CopyDataToTexture(handle, desc.data, desc.dataSize);
+TextureHandle RenderContext::CreateTextureHandleAsync(TextureDesc&& desc)
+{
+    if (m_AsyncUploader == nullptr || desc.data == nullptr)
+        return CreateTextureHandle(std::move(desc));
 
-    FlushCommandBuffer(cmd, queue);
+    // the caller may free the data right after, the request keeps a copy until it is in the staging buffer
+    std::vector<uint8_t> data(desc.data, desc.data + desc.dataSize);
+    desc.data     = nullptr;
+    desc.dataSize = 0;
+
+    TextureHandle handle = CreateTextureHandle(std::move(desc));
+    m_AsyncUploader->UploadTexture(handle, std::move(data));
 
     return handle;
 }
 
+TextureHandle RenderContext::ResolveTexture(TextureHandle handle) const
+{
+    if (m_AsyncUploader == nullptr || m_StreamingFallbackTexture.empty() || m_AsyncUploader->IsResident(handle))
+        return handle;
+
+    return m_StreamingFallbackTexture;
+}
+
 void RenderContext::DestroyTextureObject(const Texture& texture, const TextureDesc& desc)
 {
     DestroyVulkanTexture(m_DevicePtr->GetVmaAllocator(), texture.image, texture.vmaAllocation);
@@ -518,49 +710,199 @@ const TextureDesc& RenderContext::GetTextureDesc(TextureHandle handle)
     return m_TexturePool.getObjectDesc(handle);
 }
 
-void RenderContext::CopyDataToBuffer(BufferHandle handle, const void* data, size_t size)
+UploadRing& RenderContext::GetUploadRing()
 {
-    auto buffer = m_BufferPool.getObject(handle);
+    if (m_UploadRing == nullptr)
+        m_UploadRing = std::make_unique<UploadRing>(this, UploadRingDesc{.debugName = "RenderContext UploadRing"});
+
+    return *m_UploadRing;
+}
 
-#if USE_STAGING_BUFFER
-    Buffer stagingBuffer = CreateStagingBuffer(*m_DevicePtr, data, size);
+UploadAllocation RenderContext::AllocateUpload(uint32_t byteSize, uint32_t alignment)
+{
+    return GetUploadRing().Allocate(byteSize, alignment);
+}
+
+void RenderContext::QueueBufferCopy(vk::Buffer srcBuffer, vk::Buffer dstBuffer, const vk::BufferCopy* regions, uint32_t regionCount)
+{
+    if (regionCount == 0)
+        return;
+
+    m_PendingTransfers.push_back({
+        .srcBuffer   = srcBuffer,
+        .dstBuffer   = dstBuffer,
+        .firstRegion = static_cast<uint32_t>(m_PendingBufferCopies.size()),
+        .regionCount = regionCount,
+    });
+    m_PendingBufferCopies.insert(m_PendingBufferCopies.end(), regions, regions + regionCount);
+}
+
+void RenderContext::CopyUploadToBuffer(const UploadAllocation& allocation, BufferHandle dstHandle, const std::vector<vk::BufferCopy>& regions)
+{
+    const vk::Buffer srcBuffer = GetBuffer(allocation.buffer).vkBuffer;
+    const vk::Buffer dstBuffer = GetBuffer(dstHandle).vkBuffer;
+
+    const uint32_t firstRegion = static_cast<uint32_t>(m_PendingBufferCopies.size());
+    QueueBufferCopy(srcBuffer, dstBuffer, regions.data(), static_cast<uint32_t>(regions.size()));
+    for (uint32_t i = firstRegion; i < m_PendingBufferCopies.size(); ++i)
+    {
+        assert(m_PendingBufferCopies[i].srcOffset + m_PendingBufferCopies[i].size <= allocation.byteSize);
+        m_PendingBufferCopies[i].srcOffset += allocation.byteOffset;
+    }
+}
+
+void RenderContext::CopyDataToBuffer(BufferHandle handle, const void* data, size_t size, size_t dstOffset)
+{
+    UploadAllocation allocation = AllocateUpload(static_cast<uint32_t>(size));
+    if (allocation.empty())
+        return;
+
+    memcpy(allocation.data, data, size);
+
+    vk::BufferCopy region(allocation.byteOffset, dstOffset, size);
+    QueueBufferCopy(GetBuffer(allocation.buffer).vkBuffer, GetBuffer(handle).vkBuffer, &region, 1);
+}
+
+void RenderContext::CopyDataToBufferImmediate(BufferHandle handle, const void* data, size_t size, size_t dstOffset)
+{
+    CopyDataToBuffer(handle, data, size, dstOffset);
 
     vk::raii::Queue queue = m_DevicePtr->Get().getQueue(m_DevicePtr->GetQueueFamilyIndexByFlags(vk::QueueFlagBits::eGraphics), 0);
 
     vk::raii::CommandBuffer cmd = CreateCommandBuffer(vk::CommandBufferLevel::ePrimary, true);
 
-    cmd.copyBuffer(stagingBuffer.vkBuffer, buffer.vkBuffer, vk::BufferCopy(0, 0, size));
+    // what was queued before goes along, the copies stay in the order they were made
+    RecordTransfers(*cmd, m_TransferFrameIndex);
 
     FlushCommandBuffer(cmd, queue);
+}
 
-    ClearVulkanBuffer(m_DevicePtr->GetVmaAllocator(), stagingBuffer.vkBuffer, stagingBuffer.vmaAllocation);
-#endif
+void RenderContext::CopyBuffer(BufferHandle srcHandle, BufferHandle dstHandle, const std::vector<vk::BufferCopy>& regions)
+{
+    QueueBufferCopy(GetBuffer(srcHandle).vkBuffer, GetBuffer(dstHandle).vkBuffer, regions.data(), static_cast<uint32_t>(regions.size()));
 }
 
 void RenderContext::CopyDataToTexture(TextureHandle handle, const void* data, size_t size)
 {
-    auto texture     = m_TexturePool.getObject(handle);
-    auto textureDesc = m_TexturePool.getObjectDesc(handle);
+    const Texture& texture         = m_TexturePool.getObject(handle);
+    const TextureDesc& textureDesc = m_TexturePool.getObjectDesc(handle);
 
-    Buffer stagingBuffer = CreateStagingBuffer(*m_DevicePtr, data, size);
+    UploadAllocation allocation = AllocateUpload(static_cast<uint32_t>(size));
+    if (allocation.empty())
+        return;
 
-    vk::raii::Queue queue = m_DevicePtr->Get().getQueue(m_DevicePtr->GetQueueFamilyIndexByFlags(vk::QueueFlagBits::eGraphics), 0);
+    memcpy(allocation.data, data, size);
 
-    vk::raii::CommandBuffer cmd = CreateCommandBuffer(vk::CommandBufferLevel::ePrimary, true);
+    m_PendingTransfers.push_back({
+        .srcBuffer   = GetBuffer(allocation.buffer).vkBuffer,
+        .dstImage    = texture.image,
+        .firstRegion = static_cast<uint32_t>(m_PendingImageCopies.size()),
+        .regionCount = 1,
+    });
+    m_PendingImageCopies.emplace_back(allocation.byteOffset, 0, 0,
+                                      vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+                                      vk::Offset3D(0, 0, 0),
+                                      vk::Extent3D(textureDesc.width, textureDesc.height, 1));
+}
 
-    vk::ImageSubresourceRange subresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+static vk::ImageMemoryBarrier GetUploadImageBarrier(vk::Image image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, vk::AccessFlags srcAccessMask, vk::AccessFlags dstAccessMask)
+{
+    vk::ImageMemoryBarrier imageBarrier;
+    imageBarrier.srcAccessMask       = srcAccessMask;
+    imageBarrier.dstAccessMask       = dstAccessMask;
+    imageBarrier.oldLayout           = oldLayout;
+    imageBarrier.newLayout           = newLayout;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image               = image;
+    imageBarrier.subresourceRange    = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+    return imageBarrier;
+}
 
-    vk::Image image = texture.image;
+bool RenderContext::RecordTransfers(vk::CommandBuffer commandBuffer, uint64_t frameIndex)
+{
+    m_TransferFrameIndex = frameIndex;
 
-    VulkanHelper::ImageLayoutTransition(cmd, image, vk::ImageLayout::ePreinitialized, vk::ImageLayout::eTransferDstOptimal, subresourceRange);
+    if (m_PendingTransfers.empty())
+        return false;
 
-    cmd.copyBufferToImage(stagingBuffer.vkBuffer, image, vk::ImageLayout::eTransferDstOptimal, vk::BufferImageCopy(0, 0, 0, vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1), vk::Offset3D(0, 0, 0), vk::Extent3D(textureDesc.width, textureDesc.height, 1)));
+    if (m_UploadRing != nullptr)
+        m_UploadRing->Flush();
 
-    VulkanHelper::ImageLayoutTransition(cmd, image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, subresourceRange);
+    std::vector<vk::ImageMemoryBarrier> imageBarriers;
+    for (const PendingTransfer& transfer : m_PendingTransfers)
+    {
+        if (transfer.dstImage)
+            imageBarriers.push_back(GetUploadImageBarrier(transfer.dstImage, vk::ImageLayout::ePreinitialized, vk::ImageLayout::eTransferDstOptimal, {}, vk::AccessFlagBits::eTransferWrite));
+    }
 
-    FlushCommandBuffer(cmd, queue);
+    // the copies overwrite what earlier submits of the queue may still read or write
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands,
+                                  vk::PipelineStageFlagBits::eTransfer,
+                                  {},
+                                  vk::MemoryBarrier(vk::AccessFlagBits::eMemoryWrite, vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite),
+                                  {},
+                                  imageBarriers);
+
+    // copies reading or writing a buffer an earlier copy wrote, or writing one it read, wait for it. The moves of
+    // the UnifiedGeometryBuffer are followed by uploads into the places they left.
+    std::vector<vk::Buffer> readBuffers;
+    std::vector<vk::Buffer> writtenBuffers;
+    auto contains = [](const std::vector<vk::Buffer>& buffers, vk::Buffer buffer)
+    {
+        return std::find(buffers.begin(), buffers.end(), buffer) != buffers.end();
+    };
 
-    ClearVulkanBuffer(m_DevicePtr->GetVmaAllocator(), stagingBuffer.vkBuffer, stagingBuffer.vmaAllocation);
+    for (const PendingTransfer& transfer : m_PendingTransfers)
+    {
+        if (transfer.dstImage)
+        {
+            commandBuffer.copyBufferToImage(transfer.srcBuffer, transfer.dstImage, vk::ImageLayout::eTransferDstOptimal,
+                                            transfer.regionCount, &m_PendingImageCopies[transfer.firstRegion]);
+            continue;
+        }
+
+        if (contains(writtenBuffers, transfer.srcBuffer) || contains(writtenBuffers, transfer.dstBuffer) || contains(readBuffers, transfer.dstBuffer))
+        {
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                          vk::PipelineStageFlagBits::eTransfer,
+                                          {},
+                                          vk::MemoryBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite),
+                                          {},
+                                          {});
+            readBuffers.clear();
+            writtenBuffers.clear();
+        }
+
+        commandBuffer.copyBuffer(transfer.srcBuffer, transfer.dstBuffer, transfer.regionCount, &m_PendingBufferCopies[transfer.firstRegion]);
+        readBuffers.push_back(transfer.srcBuffer);
+        writtenBuffers.push_back(transfer.dstBuffer);
+    }
+
+    for (vk::ImageMemoryBarrier& imageBarrier : imageBarriers)
+    {
+        imageBarrier.oldLayout     = vk::ImageLayout::eTransferDstOptimal;
+        imageBarrier.newLayout     = vk::ImageLayout::eShaderReadOnlyOptimal;
+        imageBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        imageBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+    }
+
+    // everything recorded after in the queue sees the data
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                  vk::PipelineStageFlagBits::eAllCommands,
+                                  {},
+                                  vk::MemoryBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite),
+                                  {},
+                                  imageBarriers);
+
+    if (m_UploadRing != nullptr)
+        m_UploadRing->EndFrame(frameIndex);
+
+    m_PendingTransfers.clear();
+    m_PendingBufferCopies.clear();
+    m_PendingImageCopies.clear();
+
+    return true;
 }
 
 BufferHandle RenderContext::CreateBuffer(BufferDesc&& desc)
@@ -620,6 +962,113 @@ void RenderContext::DestroyBuffer(BufferHandle handle)
     m_BufferPool.destroy(handle);
 }
 
+static const char* GetBufferArenaName(BufferUsage usage)
+{
+    switch (usage)
+    {
+        case BufferUsage::Vertex:
+            return "Vertex BufferArena";
+        case BufferUsage::Index:
+            return "Index BufferArena";
+        case BufferUsage::Uniform:
+            return "Uniform BufferArena";
+        case BufferUsage::Storage:
+            return "Storage BufferArena";
+        default:
+            return "BufferArena";
+    }
+}
+
+BufferRange RenderContext::AllocateBufferRange(BufferUsage usage, uint32_t byteSize, uint32_t alignment, const void* data)
+{
+    uint32_t arenaIndex = 0;
+    for (; arenaIndex < m_BufferArenas.size(); ++arenaIndex)
+    {
+        const BufferArenaDesc& desc = m_BufferArenas[arenaIndex]->GetDesc();
+        if (desc.usage == usage && desc.alignment == alignment)
+            break;
+    }
+
+    if (arenaIndex == m_BufferArenas.size())
+    {
+        m_BufferArenas.push_back(std::make_unique<BufferArena>(this, BufferArenaDesc{
+            .debugName = GetBufferArenaName(usage),
+            .usage     = usage,
+            .alignment = alignment,
+        }));
+    }
+
+    BufferRange range = m_BufferArenas[arenaIndex]->Allocate(byteSize);
+    range.arena       = arenaIndex;
+
+    if (data != nullptr && range.empty() == false)
+        CopyDataToBuffer(range.buffer, data, byteSize, range.byteOffset);
+
+    return range;
+}
+
+void RenderContext::FreeBufferRange(const BufferRange& range)
+{
+    if (range.empty())
+        return;
+
+    assert(range.arena < m_BufferArenas.size());
+    m_BufferArenas[range.arena]->Free(range);
+}
+
+void RenderContext::DefragmentMeshGeometry(uint32_t byteBudget)
+{
+    std::vector<std::shared_ptr<MeshGeometry>> geometries;
+    std::vector<BufferRange> ranges;
+    std::vector<MeshGeometry*> owners;
+    for (uint32_t arenaIndex = 0; arenaIndex < m_BufferArenas.size() && byteBudget > 0; ++arenaIndex)
+    {
+        BufferArena& arena = *m_BufferArenas[arenaIndex];
+        bool vertices      = arena.GetDesc().usage == BufferUsage::Vertex;
+        if ((vertices == false && arena.GetDesc().usage != BufferUsage::Index) || arena.IsDefragmentationPending() == false)
+            continue;
+
+        // only looked at once any arena has gaps
+        if (geometries.empty())
+        {
+            std::erase_if(m_MeshGeometries, [&geometries](const std::weak_ptr<MeshGeometry>& weakGeometry)
+            {
+                std::shared_ptr<MeshGeometry> geometry = weakGeometry.lock();
+                if (geometry == nullptr)
+                    return true;
+
+                geometries.push_back(std::move(geometry));
+                return false;
+            });
+        }
+
+        ranges.clear();
+        owners.clear();
+        for (const std::shared_ptr<MeshGeometry>& geometry : geometries)
+        {
+            const BufferRange& range = vertices ? geometry->vertexRange : geometry->indexRange;
+            if (range.arena == arenaIndex && range.empty() == false)
+            {
+                ranges.push_back(range);
+                owners.push_back(geometry.get());
+            }
+        }
+
+        for (const BufferRangeMove& move : arena.Defragment(ranges, byteBudget))
+        {
+            MeshGeometry& geometry = *owners[move.index];
+            BufferRange& range     = vertices ? geometry.vertexRange : geometry.indexRange;
+            range                  = move.to;
+            for (MeshRenderer* renderer : geometry.renderers)
+                renderer->OnGeometryMoved(move.from, move.to, vertices);
+
+            // the copy out of it is recorded with this frame
+            RetireBufferRange(move.from);
+            byteBudget -= std::min(byteBudget, move.from.byteSize);
+        }
+    }
+}
+
 SamplerHandle RenderContext::CreateSampler(SamplerDesc&& desc)
 {
     vk::SamplerCreateInfo samplerCreateInfo{};
@@ -678,7 +1127,7 @@ void RenderContext::ResetDescriptorPool(UpdateFrequency poolType)
     VULKAN_DEVICE.resetDescriptorPool(m_DescriptorPool[(uint32_t)poolType], {});
 }
 
-BindGroupHandle RenderContext::CreateBindGroup(BindGroupDesc&& desc)
+vk::DescriptorSet RenderContext::WriteBindGroupSet(const BindGroupDesc& desc)
 {
     vk::DescriptorSetLayout setLayout = desc.bindLayout->layout;
     vk::DescriptorPool pool           = GetDescriptorPool(desc.updateFrequency);
@@ -718,7 +1167,8 @@ BindGroupHandle RenderContext::CreateBindGroup(BindGroupDesc&& desc)
     imageInfos.reserve(desc.textures.size());
     for (const auto& textureBinding : desc.textures)
     {
-        TextureHandle handle = textureBinding.handle;
+        // textures still being uploaded are bound as the fallback, UpdateAsyncUploads writes them once they arrived
+        TextureHandle handle = ResolveTexture(textureBinding.handle);
 
         const TextureDesc& textureDesc = GetTextureDesc(handle);
         const Texture& textureInfo     = GetTexture(handle);
@@ -784,13 +1234,44 @@ BindGroupHandle RenderContext::CreateBindGroup(BindGroupDesc&& desc)
 
     VULKAN_DEVICE.updateDescriptorSets(writeDescriptorSets, {});
 
-    return m_BindGroupPool.create(
+    return descriptorSet;
+}
+
+uint32_t RenderContext::CountStreamingTextures(const BindGroupDesc& desc) const
+{
+    if (m_AsyncUploader == nullptr)
+        return 0;
+
+    uint32_t count = 0;
+    for (const TextureBinding& textureBinding : desc.textures)
+    {
+        if (m_AsyncUploader->IsResident(textureBinding.handle) == false)
+            count++;
+    }
+    return count;
+}
+
+BindGroupHandle RenderContext::CreateBindGroup(BindGroupDesc&& desc)
+{
+    vk::DescriptorSet descriptorSet = WriteBindGroupSet(desc);
+    uint32_t streamingTextureCount  = CountStreamingTextures(desc);
+
+    BindGroupHandle handle = m_BindGroupPool.create(
         std::move(desc),
         BindGroup{descriptorSet});
+
+    if (streamingTextureCount > 0)
+        m_StreamingBindGroups.push_back({handle, streamingTextureCount});
+
+    return handle;
 }
 
+
 void RenderContext::DestroyBindGroup(BindGroupHandle handle)
 {
+    std::erase_if(m_StreamingBindGroups, [handle](const StreamingBindGroup& streamingBindGroup)
+                  { return streamingBindGroup.handle == handle; });
+
     auto bindGroupDesc = m_BindGroupPool.getObjectDesc(handle);
     auto bindGroup     = m_BindGroupPool.getObject(handle);
 
@@ -827,10 +1308,13 @@ void RenderContext::PrepareRendering()
     CreateDescriptorPools();
 }
 
-PipelineLayout RenderContext::GetOrCreatePipelineLayout(const std::vector<BindLayout>& createInfo, const DynamicBuffer* dynamicBuffer)
+PipelineLayout RenderContext::GetOrCreatePipelineLayout(const std::vector<BindLayout>& createInfo, const DynamicBuffer* dynamicBuffer, uint32_t pushConstantByteSize)
 {
     std::size_t hash{0u};
     utils::hash_combine(hash, createInfo);
+    // the same sets make a different layout with the dynamic buffer at set 3 or with push constants
+    utils::hash_combine(hash, dynamicBuffer != nullptr);
+    utils::hash_combine(hash, pushConstantByteSize);
 
     auto it = m_ResourceCache.pipelineLayouts.find(hash);
     if (it != m_ResourceCache.pipelineLayouts.end())
@@ -859,12 +1343,14 @@ PipelineLayout RenderContext::GetOrCreatePipelineLayout(const std::vector<BindLa
         layouts.push_back(dynamicBuffer->layout);
     }
 
+    vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, pushConstantByteSize);
+
     vk::PipelineLayoutCreateInfo pipelineLayoutInfo(
         {},
         layoutCount,
         layouts.data(),
-        0,
-        nullptr);
+        pushConstantByteSize > 0 ? 1 : 0,
+        &pushConstantRange);
 
     PipelineLayout pipelineLayout;
     pipelineLayout.layout = VULKAN_DEVICE.createPipelineLayout(pipelineLayoutInfo);
@@ -1251,6 +1737,64 @@ void RenderContext::InsertDebugLabel(CommandBuffer& cmd, const char* label, floa
 #endif
 }
 
+void RenderContext::DrawMeshIndirect(vk::CommandBuffer commandBuffer, BufferHandle argumentBuffer, uint32_t argumentOffset, uint32_t maxDrawCount,
+                                     BufferHandle countBuffer, uint32_t countOffset)
+{
+    const Buffer& arguments = m_BufferPool.getObject(argumentBuffer);
+    constexpr uint32_t stride = sizeof(vk::DrawIndexedIndirectCommand);
+
+    if (countBuffer.empty() == false)
+    {
+        if (m_GraphicsCaps.supportsDrawIndirectCount)
+        {
+            const Buffer& count = m_BufferPool.getObject(countBuffer);
+            commandBuffer.drawIndexedIndirectCountKHR(arguments.vkBuffer, argumentOffset, count.vkBuffer, countOffset, maxDrawCount, stride);
+            return;
+        }
+
+        // without VK_KHR_draw_indirect_count every command is drawn, the unused ones need an instance count of zero
+    }
+
+    if (m_GraphicsCaps.supportsMultiDrawIndirect)
+    {
+        commandBuffer.drawIndexedIndirect(arguments.vkBuffer, argumentOffset, maxDrawCount, stride);
+        return;
+    }
+
+    for (uint32_t i = 0; i < maxDrawCount; ++i)
+    {
+        commandBuffer.drawIndexedIndirect(arguments.vkBuffer, argumentOffset + i * stride, 1, stride);
+    }
+}
+
+void RenderContext::DrawProceduralIndirect(vk::CommandBuffer commandBuffer, BufferHandle argumentBuffer, uint32_t argumentOffset, uint32_t maxDrawCount,
+                                           BufferHandle countBuffer, uint32_t countOffset)
+{
+    const Buffer& arguments = m_BufferPool.getObject(argumentBuffer);
+    constexpr uint32_t stride = sizeof(vk::DrawIndirectCommand);
+
+    if (countBuffer.empty() == false)
+    {
+        if (m_GraphicsCaps.supportsDrawIndirectCount)
+        {
+            const Buffer& count = m_BufferPool.getObject(countBuffer);
+            commandBuffer.drawIndirectCountKHR(arguments.vkBuffer, argumentOffset, count.vkBuffer, countOffset, maxDrawCount, stride);
+            return;
+        }
+    }
+
+    if (m_GraphicsCaps.supportsMultiDrawIndirect)
+    {
+        commandBuffer.drawIndirect(arguments.vkBuffer, argumentOffset, maxDrawCount, stride);
+        return;
+    }
+
+    for (uint32_t i = 0; i < maxDrawCount; ++i)
+    {
+        commandBuffer.drawIndirect(arguments.vkBuffer, argumentOffset + i * stride, 1, stride);
+    }
+}
+
 void RenderContext::DestroySemaphore(Semaphore& semaphore)
 {
     VULKAN_DEVICE.destroySemaphore(semaphore.semaphore);
@@ -1263,6 +1807,101 @@ void RenderContext::DestroyFence(Fence& fence)
     fence.fence = nullptr;
 }
 
+void RenderContext::RetireBuffer(BufferHandle handle)
+{
+    m_RetiredResources.Retire(handle);
+}
+
+void RenderContext::RetireTexture(TextureHandle handle)
+{
+    m_RetiredResources.Retire(handle);
+}
+
+void RenderContext::RetireBindGroup(BindGroupHandle handle)
+{
+    m_RetiredResources.Retire(handle);
+}
+
+void RenderContext::RetireDynamicBuffer(DynamicBufferHandle handle)
+{
+    m_RetiredResources.Retire(handle);
+}
+
+void RenderContext::RetireBufferRange(const BufferRange& range)
+{
+    m_RetiredResources.Retire(range);
+}
+
+static auto GetRetiredResourceDestroyer(RenderContext& renderContext)
+{
+    return [&renderContext](auto handle)
+    {
+        using HandleType = decltype(handle);
+        if constexpr (std::is_same_v<HandleType, BufferHandle>)
+            renderContext.DestroyBuffer(handle);
+        else if constexpr (std::is_same_v<HandleType, TextureHandle>)
+            renderContext.DestroyTexture(handle);
+        else if constexpr (std::is_same_v<HandleType, BindGroupHandle>)
+            renderContext.DestroyBindGroup(handle);
+        else if constexpr (std::is_same_v<HandleType, DynamicBufferHandle>)
+            renderContext.DestroyDynamicBuffer(handle);
+        else
+            renderContext.FreeBufferRange(handle);
+    };
+}
+
+void RenderContext::ReleaseRetiredResources(uint64_t frameIndex, uint64_t completedFrameIndex)
+{
+    m_RetiredResources.Collect(completedFrameIndex, GetRetiredResourceDestroyer(*this));
+    m_RetiredResources.BeginFrame(frameIndex);
+
+    if (m_UploadRing != nullptr)
+        m_UploadRing->Release(completedFrameIndex);
+}
+
+void RenderContext::ReleaseAllRetiredResources()
+{
+    m_RetiredResources.Flush(GetRetiredResourceDestroyer(*this));
+
+    if (m_UploadRing != nullptr)
+        m_UploadRing->ReleaseAll();
+}
+
+void RenderContext::EnableAsyncUploads(uint32_t transferQueueFamilyIndex, uint32_t graphicsQueueFamilyIndex)
+{
+    m_AsyncUploader = std::make_unique<AsyncUploader>(*this, *m_DevicePtr, AsyncUploaderDesc{
+        .transferQueueFamilyIndex = transferQueueFamilyIndex,
+        .graphicsQueueFamilyIndex = graphicsQueueFamilyIndex,
+    });
+}
+
+void RenderContext::UpdateAsyncUploads()
+{
+    if (m_AsyncUploader == nullptr || m_AsyncUploader->Update() == false)
+        return;
+
+    // bind groups of textures that arrived get a set with them, the handle stays the same so nothing holding it
+    // has to be made again
+    std::erase_if(m_StreamingBindGroups, [this](StreamingBindGroup& streamingBindGroup)
+    {
+        const BindGroupDesc& desc      = m_BindGroupPool.getObjectDesc(streamingBindGroup.handle);
+        uint32_t streamingTextureCount = CountStreamingTextures(desc);
+        if (streamingTextureCount == streamingBindGroup.streamingTextureCount)
+            return false;
+
+        vk::DescriptorSet descriptorSet = WriteBindGroupSet(desc);
+        vk::DescriptorSet previousSet   = m_BindGroupPool.getObject(streamingBindGroup.handle).set;
+        m_BindGroupPool.getObject(streamingBindGroup.handle).set = descriptorSet;
+        m_BindGroupPool.updateNativeHandle(streamingBindGroup.handle, previousSet);
+
+        // frames in flight may still bind the previous set, it is retired as a bind group of its own
+        RetireBindGroup(m_BindGroupPool.create(BindGroupDesc(desc), BindGroup{previousSet}));
+
+        streamingBindGroup.streamingTextureCount = streamingTextureCount;
+        return streamingTextureCount == 0;
+    });
+}
+
 RenderPass RenderContext::CreateRenderPass(RenderPassDesc&& desc)
 {
     bool hasDepthStencil = desc.depthFormat != GraphicsFormat::Undefined || desc.stencilFormat != GraphicsFormat::Undefined;
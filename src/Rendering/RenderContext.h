@@ -5,11 +5,13 @@
 #include "Graphics/Device.h"
 
 #include "Graphics/Vulkan/VulkanIncludes.h"
+#include "GraphicsCaps.h"
 #include "GraphicsCaching/ResourceCache.h"
 
 #include "GraphicsResource.h"
 
 #include "Rendering/Utils/GeometryUtils.h"
+#include "Rendering/Utils/VertexLayout.h"
 #include "Rendering/Components/MeshRenderer.h"
 
 #include "CommandRing.h"
@@ -26,9 +28,18 @@
 #include "RenderPassDesc.h"
 #include "DescriptorPoolHolder.h"
 #include "Pool.h"
+#include "DensePool.h"
+#include "ResourceRetirementRing.h"
+#include "BufferArena.h"
+#include "UploadRing.h"
+#include "AsyncUploader.h"
+
+#include "Utilities/AssetLoader.h"
 
 #include "TransientBindGroupUpdateDesc.h"
 
+#include <memory>
+#include <span>
 #include <vector>
 
 namespace gore::gfx
@@ -57,10 +68,51 @@ enum PSOCreateRuntimeFlagBits
     PSO_CREATE_FLAG_PREFER_RPS = PSO_CREATE_FLAG_PREFER_RENDER_PASS | PSO_CREATE_FLAG_PREFER_SINGLE_SUBPASS | PSO_CREATE_FLAG_PREFER_NO_DEPENDENCIES
 };
  
+struct MeshLoadRequest final
+{
+    std::string name;
+    MeshRenderer* meshRenderer = nullptr;
+    uint32_t meshIndex         = 0;
+    ShaderChannel channel      = ShaderChannel::Default;
+    // channel is what is read from the file, the vertices are packed with every channel of Vertex and compression.
+    // The pipelines drawing them take the matching binding.
+    VertexCompressionDesc compression;
+};
+
+// The arena ranges uploaded geometry lives in, shared by every MeshRenderer drawing a part of it. They are retired
+// once the last one lets go, RenderContext::DefragmentMeshGeometry moves them and patches the renderers.
+struct MeshGeometry final
+{
+    ~MeshGeometry();
+
+    BufferRange vertexRange = {};
+    BufferRange indexRange  = {};
+    uint32_t vertexStride   = 0;
+
+    std::vector<MeshRenderer*> renderers;
+};
+
+// Where UploadMeshGeometry copied a mesh to, offsets are in vertices of the layout it was packed with and in indices
+struct MeshGeometryLocation final
+{
+    // every renderer drawing from it takes a reference, see MeshRenderer::SetGeometry
+    std::shared_ptr<MeshGeometry> geometry;
+
+    BufferHandle vertexBuffer = {};
+    uint32_t vertexOffset     = 0;
+    BufferHandle indexBuffer  = {};
+    uint32_t indexOffset      = 0;
+
+    // how quantized positions are scaled back, see PackedVertices
+    Vector3 positionScale  = Vector3::One;
+    Vector3 positionOffset = Vector3::Zero;
+};
+
 struct RenderContextCreateInfo final
 {
     const Device* device = nullptr;
     uint32_t flags       = PSO_CREATE_FLAG_NONE;
+    GraphicsCaps caps    = {};
 };
 
 ENGINE_CLASS(RenderContext) final
@@ -72,7 +124,16 @@ ENGINE_CLASS(RenderContext) final
     ~RenderContext();
     
     void LoadMeshToMeshRenderer(const std::string& name, MeshRenderer& meshRenderer, uint32_t meshIndex = 0, ShaderChannel channel = ShaderChannel::Default);
+    // The files are parsed on the JobSystem all at once, each mesh is copied to the GPU as soon as it is ready
+    void LoadMeshesToMeshRenderers(std::span<const MeshLoadRequest> requests);
+    // Copies mesh data built on the CPU to the GPU and points meshRenderer at it
+    void UploadMeshData(const MeshDataView& meshData, MeshRenderer& meshRenderer, const VertexLayout& layout = CreateVertexLayout());
+    // Copies the vertices and the indices of meshData to the GPU with one allocation each, however many sub-meshes
+    // and renderers share them. Vertices are packed into layout on the way.
+    MeshGeometryLocation UploadMeshGeometry(const MeshDataView& meshData, const VertexLayout& layout = CreateVertexLayout());
     void LoadMesh();
+    // Files loaded by name go through it, it loads on the JobSystem when there is one
+    [[nodiscard]] AssetLoader& GetAssetLoader();
     
     // Debug Utils
     void BeginDebugLabel(CommandBuffer& cmd, const char* label, float r = 1.0f, float g = 0.0f, float b = 0.0f);
@@ -95,12 +156,24 @@ ENGINE_CLASS(RenderContext) final
     
     // Draw Call
     void DrawMesh(int instanceCount = 1, int firstInstance = 0);
-    void DrawMeshIndirect();
+    // Records maxDrawCount IndirectDrawCommands from argumentBuffer. With a countBuffer the draw count is read on the GPU
+    // at countOffset instead and maxDrawCount only caps it, so commands written by a compute pass need no readback.
+    void DrawMeshIndirect(vk::CommandBuffer commandBuffer, BufferHandle argumentBuffer, uint32_t argumentOffset, uint32_t maxDrawCount,
+                          BufferHandle countBuffer = {}, uint32_t countOffset = 0);
     void DrawProcedural();
-    void DrawProceduralIndirect();
+    // Same as DrawMeshIndirect for non indexed draws, argumentBuffer holds VkDrawIndirectCommands
+    void DrawProceduralIndirect(vk::CommandBuffer commandBuffer, BufferHandle argumentBuffer, uint32_t argumentOffset, uint32_t maxDrawCount,
+                                BufferHandle countBuffer = {}, uint32_t countOffset = 0);
     
+    // Textures loaded by name are uploaded with CreateTextureHandleAsync
     TextureHandle CreateTextureHandle(const std::string& name);
+    // Decodes the images on the JobSystem all at once, the handles are in the order of names
+    std::vector<TextureHandle> CreateTextureHandles(std::span<const std::string> names);
     TextureHandle CreateTextureHandle(TextureDesc&& desc);
+    // Same as CreateTextureHandle, but the data is copied on the transfer queue once async uploads are enabled
+    TextureHandle CreateTextureHandleAsync(TextureDesc&& desc);
+    // The streaming fallback texture while handle is still being uploaded, handle otherwise
+    [[nodiscard]] TextureHandle ResolveTexture(TextureHandle handle) const;
     
     void DestroyTexture(TextureHandle handle);
     const Texture& GetTexture(TextureHandle handle);
@@ -119,16 +192,53 @@ ENGINE_CLASS(RenderContext) final
     }
     
     template <typename T>
-    void CopyDataToBuffer(BufferHandle handle, const std::vector<T>& data)
+    void CopyDataToBuffer(BufferHandle handle, const std::vector<T>& data, size_t dstOffset = 0)
     {
-        CopyDataToBuffer(handle, data.data(), data.size() * sizeof(T));
+        CopyDataToBuffer(handle, data.data(), data.size() * sizeof(T), dstOffset);
     }
 
+    // Copies regions between or within GPU buffers, regions of the same buffer must not overlap. Like every copy
+    // below it is only queued, RecordTransfers records them in the order they were made.
+    void CopyBuffer(BufferHandle srcHandle, BufferHandle dstHandle, const std::vector<vk::BufferCopy>& regions);
+
+    // Staging memory in the UploadRing that stays valid until the frame the copies reading it are recorded in is
+    // done on the GPU, so a system can write its data in place instead of keeping a staging buffer of its own
+    [[nodiscard]] UploadAllocation AllocateUpload(uint32_t byteSize, uint32_t alignment = UploadRing::k_DefaultAlignment);
+    // srcOffset of the regions is relative to the allocation
+    void CopyUploadToBuffer(const UploadAllocation& allocation, BufferHandle dstHandle, const std::vector<vk::BufferCopy>& regions);
+    // Copies right away and waits for the GPU, for data needed before the next frame is submitted
+    void CopyDataToBufferImmediate(BufferHandle handle, const void* data, size_t size, size_t dstOffset = 0);
+    // Records the copies queued since the last call with the barriers around them, commands recorded after in the
+    // same queue see the data. frameIndex is the frame the command buffer is submitted with. Returns false when
+    // nothing was queued.
+    bool RecordTransfers(vk::CommandBuffer commandBuffer, uint64_t frameIndex);
+    // Bytes of staging memory the copies queued since the last RecordTransfers use
+    [[nodiscard]] uint32_t GetQueuedUploadByteSize() const { return m_UploadRing != nullptr ? m_UploadRing->GetFrameByteSize() : 0; }
+
+    // From then on CreateTextureHandleAsync uploads on the transfer queue without waiting, bind groups read the
+    // streaming fallback texture in place of textures that did not arrive yet
+    void EnableAsyncUploads(uint32_t transferQueueFamilyIndex, uint32_t graphicsQueueFamilyIndex);
+    void SetStreamingFallbackTexture(TextureHandle handle) { m_StreamingFallbackTexture = handle; }
+    // Once per frame before recording, bind groups of textures that arrived read them from then on
+    void UpdateAsyncUploads();
+    // nullptr until EnableAsyncUploads
+    [[nodiscard]] AsyncUploader* GetAsyncUploader() const { return m_AsyncUploader.get(); }
+
     BufferHandle CreateBuffer(BufferDesc&& desc);
     const BufferDesc& GetBufferDesc(BufferHandle handle);
     const Buffer& GetBuffer(BufferHandle handle);
     void DestroyBuffer(BufferHandle handle);
 
+    // Small GPU buffers are sub-allocated from a BufferArena shared by all ranges of the same usage and alignment
+    // instead of getting a buffer each. Vertex data passes its stride as alignment, so the range starts at vertex
+    // byteOffset / stride. data is copied in when given.
+    BufferRange AllocateBufferRange(BufferUsage usage, uint32_t byteSize, uint32_t alignment, const void* data = nullptr);
+    void FreeBufferRange(const BufferRange& range);
+    // Moves the ranges of mesh geometry down their arena blocks, copying at most about byteBudget bytes, so the space
+    // of freed meshes grows back together. The renderers drawing from moved geometry get their offsets patched. Only
+    // plans anything once ranges were freed.
+    void DefragmentMeshGeometry(uint32_t byteBudget);
+
     SamplerHandle CreateSampler(SamplerDesc&& desc);
     const SamplerDesc& GetSamplerDesc(SamplerHandle handle);
     const Sampler& GetSampler(SamplerHandle handle);
@@ -161,7 +271,7 @@ ENGINE_CLASS(RenderContext) final
     const GraphicsPipeline& GetGraphicsPipeline(GraphicsPipelineHandle handle);
 
     BindLayout GetOrCreateBindLayout(const BindLayoutCreateInfo& createInfo);
-    PipelineLayout GetOrCreatePipelineLayout(const std::vector<BindLayout>& createInfo, const DynamicBuffer* dynamicBuffer = nullptr);
+    PipelineLayout GetOrCreatePipelineLayout(const std::vector<BindLayout>& createInfo, const DynamicBuffer* dynamicBuffer = nullptr, uint32_t pushConstantByteSize = 0);
 
     Semaphore* CreateSemaphore();
     void DestroySemaphore(Semaphore& semaphore);
@@ -169,6 +279,18 @@ ENGINE_CLASS(RenderContext) final
     Fence* CreateFence(bool signaled = true);
     void DestroyFence(Fence& fence);
 
+    // Destroy the resource once the GPU is done with the current frame instead of right away, so command buffers
+    // in flight can keep using it without waiting for the GPU to be idle
+    void RetireBuffer(BufferHandle handle);
+    void RetireTexture(TextureHandle handle);
+    void RetireBindGroup(BindGroupHandle handle);
+    void RetireDynamicBuffer(DynamicBufferHandle handle);
+    void RetireBufferRange(const BufferRange& range);
+    // Once per frame after waiting for the frame fence, completedFrameIndex is the last frame the GPU is done with
+    void ReleaseRetiredResources(uint64_t frameIndex, uint64_t completedFrameIndex);
+    // Only when the GPU is idle
+    void ReleaseAllRetiredResources();
+
     void Clear();
 
 private:
@@ -183,17 +305,16 @@ private:
 
     void DestroyTextureObject(const Texture& texture, const TextureDesc& desc);
 
-    template <typename T>
-    static Buffer CreateStagingBuffer(const Device& device, std::vector<T> const& data)
-    {
-        return CreateStagingBuffer(device, data.data(), data.size() * sizeof(T));
-    }
-
-    static Buffer CreateStagingBuffer(const Device& device, void const* data, size_t size);
-    
-    void CopyDataToBuffer(BufferHandle handle, const void* data, size_t size);
+    void CopyDataToBuffer(BufferHandle handle, const void* data, size_t size, size_t dstOffset = 0);
     void CopyDataToTexture(TextureHandle handle, const void* data, size_t size);
 
+    UploadRing& GetUploadRing();
+    TextureHandle CreateTextureHandle(const std::string& name, const ImageAsset& image);
+    void QueueBufferCopy(vk::Buffer srcBuffer, vk::Buffer dstBuffer, const vk::BufferCopy* regions, uint32_t regionCount);
+
+    vk::DescriptorSet WriteBindGroupSet(const BindGroupDesc& desc);
+    uint32_t CountStreamingTextures(const BindGroupDesc& desc) const;
+
     vk::raii::CommandBuffer CreateCommandBuffer(vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary, bool begin = true);
     void FlushCommandBuffer(vk::raii::CommandBuffer& commandBuffer, vk::raii::Queue& queue);
 
@@ -203,13 +324,13 @@ private:
 private:
     uint32_t m_PSOFlags;
 
-    using ShaderModulePool     = Pool<ShaderModuleDesc, ShaderModule>;
-    using BufferPool           = Pool<BufferDesc, Buffer>;
-    using TexturePool          = Pool<TextureDesc, Texture>;
-    using GraphicsPipelinePool = Pool<GraphicsPipelineDesc, GraphicsPipeline>;
-    using SamplerPool          = Pool<SamplerDesc, Sampler>;
-    using BindGroupPool        = Pool<BindGroupDesc, BindGroup>;
-    using DynamicBufferPool    = Pool<DynamicBufferDesc, DynamicBuffer>;
+    using ShaderModulePool     = DensePool<ShaderModuleDesc, ShaderModule>;
+    using BufferPool           = DensePool<BufferDesc, Buffer>;
+    using TexturePool          = DensePool<TextureDesc, Texture>;
+    using GraphicsPipelinePool = DensePool<GraphicsPipelineDesc, GraphicsPipeline>;
+    using SamplerPool          = DensePool<SamplerDesc, Sampler>;
+    using BindGroupPool        = DensePool<BindGroupDesc, BindGroup>;
+    using DynamicBufferPool    = DensePool<DynamicBufferDesc, DynamicBuffer>;
 
     ShaderModulePool m_ShaderModulePool;
     BufferPool m_BufferPool;
@@ -219,6 +340,43 @@ private:
     BindGroupPool m_BindGroupPool;
     DynamicBufferPool m_DynamicBufferPool;
 
+    // more slots than frames the swapchain can queue, a frame waits for at most image count + 1 frames
+    static constexpr uint32_t k_RetirementSlotCount = 8;
+    ResourceRetirementRing<k_RetirementSlotCount, BufferHandle, TextureHandle, BindGroupHandle, DynamicBufferHandle, BufferRange> m_RetiredResources;
+
+    std::vector<std::unique_ptr<BufferArena>> m_BufferArenas;
+    // every upload of UploadMeshGeometry, the ones no renderer holds anymore are dropped while defragmenting
+    std::vector<std::weak_ptr<MeshGeometry>> m_MeshGeometries;
+
+    // a copy into a buffer or an image, the regions are in the vector of its kind
+    struct PendingTransfer
+    {
+        vk::Buffer srcBuffer;
+        vk::Buffer dstBuffer;
+        vk::Image dstImage;
+        uint32_t firstRegion = 0;
+        uint32_t regionCount = 0;
+    };
+
+    std::unique_ptr<UploadRing> m_UploadRing;
+    std::vector<PendingTransfer> m_PendingTransfers;
+    std::vector<vk::BufferCopy> m_PendingBufferCopies;
+    std::vector<vk::BufferImageCopy> m_PendingImageCopies;
+    uint64_t m_TransferFrameIndex = 0;
+
+    struct StreamingBindGroup
+    {
+        BindGroupHandle handle;
+        // textures of the bind group that were still being uploaded when its set was written
+        uint32_t streamingTextureCount = 0;
+    };
+
+    std::unique_ptr<AsyncUploader> m_AsyncUploader;
+    TextureHandle m_StreamingFallbackTexture;
+    std::vector<StreamingBindGroup> m_StreamingBindGroups;
+
+    std::unique_ptr<AssetLoader> m_AssetLoader;
+
     vk::DescriptorSetLayout m_EmptySetLayout;
 
     struct FramedDescriptorPool
@@ -242,6 +400,8 @@ private:
     vk::raii::CommandPool m_CommandPool;
 
     const Device* m_DevicePtr;
+
+    GraphicsCaps m_GraphicsCaps;
 };
 
 } // namespace gore::gfx
\ No newline at end of file
@@ -42,6 +42,12 @@ vk::Format GetVkFormat(GraphicsFormat format)
             return vk::Format::eR32G32Sfloat;
         case GraphicsFormat::RG16_FLOAT:
             return vk::Format::eR16G16Sfloat;
+        case GraphicsFormat::RGBA16_UNORM:
+            return vk::Format::eR16G16B16A16Unorm;
+        case GraphicsFormat::RG16_SNORM:
+            return vk::Format::eR16G16Snorm;
+        case GraphicsFormat::RGB10A2_UNORM:
+            return vk::Format::eA2B10G10R10UnormPack32;
         case GraphicsFormat::D32_FLOAT:
             return vk::Format::eD32Sfloat;
         case GraphicsFormat::D32_FLOAT_S8_UINT:
@@ -84,14 +90,19 @@ VkBufferCreateInfo GetVkBufferCreateInfo(BufferDesc& desc)
         case BufferUsage::Storage:
             flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
             break;
+        case BufferUsage::Indirect:
+            // indirect arguments are usually written by compute as well
+            flags |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            break;
         default:
             break;
     }
 
+    // transfer source too, so data can be moved within a buffer, like when the unified geometry buffer is compacted
     VkBufferCreateInfo bufferInfo = {
         .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         .size        = desc.byteSize,
-        .usage       = flags | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        .usage       = flags | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
     };
 
@@ -6,6 +6,7 @@
 
 #include "Graphics/Utils.h"
 #include "Core/App.h"
+#include "Core/JobSystem.h"
 #include "Core/Time.h"
 #include "FileSystem/FileSystem.h"
 #include "Math/Matrix4x4.h"
@@ -26,6 +27,9 @@
 #include "Rendering/Components/Light.h"
 #include "Rendering/GPUData/PerDrawData.h"
 #include "Rendering/GPUData/PerFrameData.h"
+#include "Rendering/GPUData/InstanceData.h"
+#include "Rendering/GPUData/IndirectDrawCommand.h"
+#include "Rendering/Utils/VertexLayout.h"
 
 #include "Profiler/microprofile.h"
 
@@ -39,14 +43,22 @@ MICROPROFILE_DEFINE(g_RenderSystemInit, "System", "RenderSystemInit", MP_AUTO);
 MICROPROFILE_DEFINE(g_PrepareDrawData, "RenderSystemLoop", "PrepareDrawData", MP_BLUE);
 MICROPROFILE_DEFINE(g_RenderGraphUpdate, "RenderSystemLoop", "RenderGraphUpdate", MP_BLUE);
 MICROPROFILE_DEFINE(g_ExecuteRenderGraph, "RenderSystemLoop", "ExecuteRenderGraph", MP_BLUE);
+MICROPROFILE_DEFINE(g_RecordDrawStream, "RenderSystemLoop", "RecordDrawStream", MP_BLUE);
+MICROPROFILE_DEFINE(g_PrepareIndirectDraws, "RenderSystemLoop", "PrepareIndirectDraws", MP_BLUE);
 
 namespace gore
 {
 
 static RenderSystem* g_RenderSystem = nullptr;
 
-RenderSystem::RenderSystem(gore::App* app) :
+static const char* k_ForwardIndirectPassName = "ForwardPassIndirect";
+static constexpr uint32_t k_InitialIndirectDrawCapacity = 1024;
+// bytes of geometry the arenas and the unified geometry buffer each may move per frame to close the gaps of freed meshes
+static constexpr uint32_t k_GeometryDefragmentationBudget = 256 * 1024;
+
+RenderSystem::RenderSystem(gore::App* app, const RenderSystemCreateInfo& createInfo) :
     System(app),
+    m_CreateInfo(createInfo),
     m_GraphicsCaps(),
     // Instance
     m_Instance(app),
@@ -73,7 +85,7 @@ RenderSystem::RenderSystem(gore::App* app) :
     m_swapChainImageSemaphoreIndex(0),
     m_pendingAcqImgSemaphoreIndex(UINT32_MAX),
     // Draw Data
-    m_DrawData()
+    m_DrawCache()
 {
     g_RenderSystem = this;
 }
@@ -113,10 +125,15 @@ void RenderSystem::Initialize()
     RenderContextCreateInfo renderContextCreateInfo = {};
     renderContextCreateInfo.device = &m_Device;
     renderContextCreateInfo.flags = PSO_CREATE_FLAG_PREFER_RPS;
+    renderContextCreateInfo.caps = m_GraphicsCaps;
 
     m_RenderContext = std::make_unique<RenderContext>(renderContextCreateInfo);
     m_RenderContext->PrepareRendering();
 
+    // textures loaded from here on are uploaded on the copy queue
+    GetQueues();
+    m_RenderContext->EnableAsyncUploads(m_GpuQueueFamilyIndices[RPS_QUEUE_COPY], m_GpuQueueFamilyIndices[RPS_QUEUE_GRAPHICS]);
+
     m_frameFences.resize(swapchainCount);
     for (uint32_t i = 0; i < swapchainCount; i++)
     {
@@ -151,46 +168,227 @@ void RenderSystem::Initialize()
     CreateMaterialDescriptorSets();
     CreateShadowPassObject();
     CreateUVQuadDescriptorSets();
-    CreateDynamicUniformBuffer();
+    CreateInstanceDataStorage();
+    CreateGPUTransformChangeSystem();
+    CreateUnifiedGeometryBuffer();
     CreateRpsPipelines();
     CreatePipeline();
-    GetQueues();
+
+    CreateDrawCache();
 
     InitImgui();
 }
 
-static void PrepareDrawStreamByDrawInfo(std::unordered_map<DrawKey, DrawStream>& map, DrawCreateInfo info, std::vector<GameObject*>& gameObjects, Material* overrideMaterial)
+void RenderSystem::CreateGPUTransformChangeSystem()
 {
-    DrawKey key = {};
-    key.passName = info.passName;
-    key.alphaMode = info.alphaMode;
-
-    std::vector<Draw> sortedDrawData;
-    PrepareDrawDataAndSort(info, gameObjects, sortedDrawData, overrideMaterial);
-
-    DrawStream drawStream;
-    CreateDrawStreamFromDrawData(sortedDrawData, drawStream);
-
-    map[key] = drawStream;
+    m_GPUTransformChangeSystem = std::make_unique<GPUTransformChangeSystem>();
+    m_GPUTransformChangeSystem->CreateGPUBuffers(*m_RenderContext);
 }
 
-void RenderSystem::PrepareDrawData()
+void RenderSystem::CreateDrawCache()
 {
-    MICROPROFILE_SCOPE(g_PrepareDrawData);
+    m_DrawCache = std::make_unique<DrawCache>();
 
     DrawCreateInfo info = {};
     info.passName = "ForwardPass";
     info.alphaMode = AlphaMode::Opaque;
+    info.skipUnifiedGeometry = true;
 
     DrawCreateInfo shadowInfo = {};
     shadowInfo.passName = "ShadowCaster";
     shadowInfo.alphaMode = AlphaMode::Opaque;
 
-    std::vector<GameObject*> gameObjects = Scene::GetActiveScene()->GetGameObjects();
-    m_DrawData.clear();
+    m_DrawCache->AddDrawList(info, &m_RpsMaterial.forward);
+    m_DrawCache->AddDrawList(shadowInfo, &m_RpsMaterial.forward);
+
+    // one sub-stream per thread that can record a secondary command buffer
+    JobSystem* jobSystem = JobSystem::GetInstance();
+    m_DrawCache->SetSubStreamSplit(jobSystem != nullptr ? jobSystem->GetThreadCount() : 1);
+    // less to read back while recording, streams fall back to full handles on their own once a pool grows too big
+    m_DrawCache->SetDrawStreamEncoding(DrawStreamEncoding::Compact);
+    // a uniform buffer or push constant only holds the data of one object per draw
+    m_DrawCache->SetInstancing(m_InstanceDataStorage->CanInstance());
+}
+
+void RenderSystem::CreateUnifiedGeometryBuffer()
+{
+    m_UnifiedGeometryBuffer = std::make_unique<UnifiedGeometryBuffer>(UnifiedGeometryBufferDesc{.vertexStride = sizeof(Vertex)});
+    m_UnifiedGeometryBuffer->CreateGPUBuffers(*m_RenderContext);
+
+    std::vector<Binding> bindings{
+        {0, BindType::StorageBuffer, 1, ShaderStage::Vertex},
+        {1, BindType::StorageBuffer, 1, ShaderStage::Vertex},
+        {2, BindType::StorageBuffer, 1, ShaderStage::Vertex}
+    };
+
+    BindLayoutCreateInfo bindLayoutCreateInfo =
+    {
+        .name = "Instance Descriptor Set Layout",
+        .bindings = bindings
+    };
+
+    m_IndirectDraws.bindLayout = m_RenderContext->GetOrCreateBindLayout(bindLayoutCreateInfo);
+
+    ReserveIndirectDrawBuffers(k_InitialIndirectDrawCapacity);
+}
+
+void RenderSystem::ReserveIndirectDrawBuffers(uint32_t instanceCount)
+{
+    if (instanceCount <= m_IndirectDraws.capacity)
+        return;
+
+    uint32_t capacity = std::max(instanceCount, m_IndirectDraws.capacity * 2);
+
+    if (m_IndirectDraws.capacity > 0)
+    {
+        // frames in flight may still read the old buffers
+        m_RenderContext->RetireBuffer(m_IndirectDraws.instanceBuffer);
+        m_RenderContext->RetireBuffer(m_IndirectDraws.argumentBuffer);
+        m_RenderContext->RetireBuffer(m_IndirectDraws.countBuffer);
+    }
+
+    m_IndirectDraws.instanceBuffer = m_RenderContext->CreateBuffer({
+        .debugName = "Instance Buffer",
+        .byteSize  = capacity * static_cast<uint32_t>(sizeof(InstanceData)),
+        .usage     = BufferUsage::Storage,
+        .memUsage  = MemoryUsage::GPU
+    });
+
+    m_IndirectDraws.argumentBuffer = m_RenderContext->CreateBuffer({
+        .debugName = "Indirect Argument Buffer",
+        .byteSize  = capacity * static_cast<uint32_t>(sizeof(IndirectDrawCommand)),
+        .usage     = BufferUsage::Indirect,
+        .memUsage  = MemoryUsage::GPU
+    });
+
+    m_IndirectDraws.countBuffer = m_RenderContext->CreateBuffer({
+        .debugName = "Indirect Count Buffer",
+        .byteSize  = capacity * static_cast<uint32_t>(sizeof(uint32_t)),
+        .usage     = BufferUsage::Indirect,
+        .memUsage  = MemoryUsage::GPU
+    });
+
+    m_IndirectDraws.capacity = capacity;
+    CreateIndirectDrawBindGroup();
+}
+
+void RenderSystem::CreateIndirectDrawBindGroup()
+{
+    // frames in flight may still use the old set
+    if (!m_IndirectDraws.bindGroup.empty())
+        m_RenderContext->RetireBindGroup(m_IndirectDraws.bindGroup);
+
+    BufferHandle meshBuffer      = m_UnifiedGeometryBuffer->GetMeshBuffer();
+    BufferHandle transformBuffer = m_GPUTransformChangeSystem->GetTransformBuffer();
+    m_IndirectDraws.bindGroup = m_RenderContext->CreateBindGroup({
+        .debugName = "Instance BindGroup",
+        .updateFrequency = UpdateFrequency::Persistent,
+        .textures = {},
+        .buffers = {
+            {0, m_IndirectDraws.instanceBuffer, 0, m_IndirectDraws.capacity * static_cast<uint32_t>(sizeof(InstanceData)), BindType::StorageBuffer},
+            {1, meshBuffer, 0, m_RenderContext->GetBufferDesc(meshBuffer).byteSize, BindType::StorageBuffer},
+            {2, transformBuffer, 0, m_RenderContext->GetBufferDesc(transformBuffer).byteSize, BindType::StorageBuffer}
+        },
+        .samplers = {},
+        .bindLayout = &m_IndirectDraws.bindLayout,
+    });
+
+    m_IndirectDraws.transformBuffer = transformBuffer;
+}
+
+void RenderSystem::PrepareIndirectDraws()
+{
+    MICROPROFILE_SCOPE(g_PrepareIndirectDraws);
+
+    // geometry of the meshes loaded since the last frame, plus what was moved to compact the buffers. The commands
+    // hold the offsets of the meshes, moved ones have to be built again.
+    bool geometryMoved = m_UnifiedGeometryBuffer->Defragment(k_GeometryDefragmentationBudget).empty() == false;
+    m_UnifiedGeometryBuffer->FlushUploads(*m_RenderContext);
+
+    IndirectDrawBuilder& builder = m_IndirectDraws.builder;
+
+    Scene* scene = Scene::GetActiveScene();
+    Pass pass;
+    bool hasPass            = scene != nullptr && m_RpsMaterial.forward.TryGetPassByName(k_ForwardIndirectPassName, pass);
+    IndirectDrawState state = hasPass ? IndirectDrawState{pass.shader, {pass.bindGroup[0], pass.bindGroup[1], pass.bindGroup[2]}} : IndirectDrawState{};
+
+    // the instances point at the transform buffer, which is replaced when it grows
+    if (m_IndirectDraws.transformBuffer != m_GPUTransformChangeSystem->GetTransformBuffer())
+        CreateIndirectDrawBindGroup();
+
+    // the draw cache hears of every renderer that was added, removed or changed its mesh or material. Without any the
+    // commands and instances stay as they are, moved transforms only reach the transform buffer.
+    if (geometryMoved == false && m_IndirectDraws.drawChangeCount == m_DrawCache->GetChangeCount() && m_IndirectDraws.state == state)
+        return;
+
+    m_IndirectDraws.drawChangeCount = m_DrawCache->GetChangeCount();
+    m_IndirectDraws.state           = state;
+    builder.Clear();
 
-    PrepareDrawStreamByDrawInfo(m_DrawData, info, gameObjects, &m_RpsMaterial.forward);
-    PrepareDrawStreamByDrawInfo(m_DrawData, shadowInfo, gameObjects, &m_RpsMaterial.forward);
+    if (hasPass)
+    {
+        for (GameObject* gameObject : scene->GetGameObjects())
+        {
+            MeshRenderer* renderer = gameObject->GetComponent<MeshRenderer>();
+            if (renderer == nullptr || renderer->GetUnifiedMeshIndex() == UnifiedGeometryBuffer::k_InvalidMesh)
+                continue;
+
+            // the renderer registered its transform already, this only looks the slot up
+            uint32_t transformSlot = m_GPUTransformChangeSystem->AddTransform(gameObject->GetTransform());
+            builder.AddInstance(state, renderer->GetUnifiedMeshIndex(), transformSlot);
+        }
+    }
+
+    builder.Build(*m_UnifiedGeometryBuffer);
+    MICROPROFILE_COUNTER_SET("IndirectDraws/Instances", builder.GetInstances().size());
+    MICROPROFILE_COUNTER_SET("IndirectDraws/Commands", builder.GetCommandCount());
+
+    if (builder.GetCommandCount() == 0)
+        return;
+
+    ReserveIndirectDrawBuffers(static_cast<uint32_t>(builder.GetInstances().size()));
+
+    m_RenderContext->CopyDataToBuffer(m_IndirectDraws.instanceBuffer, builder.GetInstances());
+    m_RenderContext->CopyDataToBuffer(m_IndirectDraws.argumentBuffer, builder.GetCommands());
+
+    // one count per batch, a culling pass can lower them on the GPU without the CPU knowing
+    if (m_GraphicsCaps.supportsDrawIndirectCount)
+    {
+        m_IndirectDraws.drawCounts.clear();
+        for (const IndirectDrawBatch& batch : builder.GetBatches())
+            m_IndirectDraws.drawCounts.push_back(batch.commandCount);
+
+        m_RenderContext->CopyDataToBuffer(m_IndirectDraws.countBuffer, m_IndirectDraws.drawCounts);
+    }
+}
+
+void RenderSystem::PrepareDrawData()
+{
+    MICROPROFILE_SCOPE(g_PrepareDrawData);
+
+    // only the transforms that moved in this frame or the one before
+    m_GPUTransformChangeSystem->Update();
+    m_GPUTransformChangeSystem->Upload(*m_RenderContext);
+    MICROPROFILE_COUNTER_SET("GPUTransforms/UploadedBytes", m_GPUTransformChangeSystem->GetUploadedByteSize());
+
+    if (m_InstanceDataStorage->UploadObjectData(*m_RenderContext, *m_GPUTransformChangeSystem))
+    {
+        // the draws still bind the dynamic buffer that ran out of slots
+        m_DynamicBufferHandle = m_InstanceDataStorage->GetDynamicBuffer();
+        m_RpsMaterial.forward.SetDynamicBuffer(m_DynamicBufferHandle);
+        m_DrawCache->Invalidate();
+    }
+
+    // renderers of geometry that moved get new offsets, the draw cache patches their draws below
+    m_RenderContext->DefragmentMeshGeometry(k_GeometryDefragmentationBudget);
+
+    // only renderers that were added, removed or changed since the last frame are looked at
+    m_DrawCache->Update(Scene::GetActiveScene());
+
+    m_InstanceDataStorage->UploadInstanceIndices(*m_RenderContext, *m_GPUTransformChangeSystem, *m_DrawCache);
+    MICROPROFILE_COUNTER_SET("InstanceData/UploadedBytes", m_InstanceDataStorage->GetUploadedByteSize());
+
+    PrepareIndirectDraws();
 }
 
 void RenderSystem::Update()
@@ -254,10 +452,134 @@ void RenderSystem::OnResize(Window* window, int width, int height)
 
 void RenderSystem::DrawRenderer(DrawKey key, vk::CommandBuffer cmd, GraphicsPipelineHandle overridePipeline)
 {
-    if (m_DrawData.find(key) == m_DrawData.end())
+    DrawStream* drawStream = m_DrawCache->GetDrawStream(key);
+    if (drawStream == nullptr)
+        return;
+
+    ScheduleDrawStream(*m_RenderContext, *drawStream, cmd, {}, m_InstanceDataStorage->GetBinding(key, *m_GPUTransformChangeSystem));
+}
+
+void RenderSystem::DrawRendererInParallel(const RpsCmdCallbackContext* pContext, DrawKey key, const std::function<void(vk::CommandBuffer)>& bindPassResources,
+                                          const std::function<void(vk::CommandBuffer)>& drawAfterStream)
+{
+    MICROPROFILE_SCOPE(g_RecordDrawStream);
+
+    vk::CommandBuffer cmd                = rpsVKCommandBufferFromHandle(pContext->hCommandBuffer);
+    std::vector<DrawStream>* subStreams = m_DrawCache->GetDrawSubStreams(key);
+    JobSystem* jobSystem                 = JobSystem::GetInstance();
+
+    // not worth the secondary command buffers, record inline
+    if (subStreams == nullptr || subStreams->size() <= 1 || jobSystem == nullptr)
+    {
+        RpsCmdRenderPassBeginInfo beginInfo = {};
+        AssertIfRpsFailed(rpsCmdBeginRenderPass(pContext, &beginInfo));
+
+        bindPassResources(cmd);
+        DrawRenderer(key, cmd);
+        if (drawAfterStream)
+            drawAfterStream(cmd);
+
+        AssertIfRpsFailed(rpsCmdEndRenderPass(pContext));
+        return;
+    }
+
+    RpsCmdRenderPassBeginInfo beginInfo = {};
+    beginInfo.flags                     = RPS_RUNTIME_RENDER_PASS_EXECUTE_SECONDARY_COMMAND_BUFFERS;
+    AssertIfRpsFailed(rpsCmdBeginRenderPass(pContext, &beginInfo));
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    AssertIfRpsFailed(rpsVKGetCmdRenderPass(pContext, &renderPass));
+
+    vk::CommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.renderPass                       = renderPass;
+    inheritanceInfo.subpass                          = 0;
+
+    // Command buffers and cloned contexts are created here, rps needs that to be synchronized.
+    // BeginCmdList hands out a different command pool to every list that is still open, so the workers never share one.
+    const auto subStreamCount = static_cast<uint32_t>(subStreams->size());
+    std::vector<ActiveCommandList> cmdLists(subStreamCount);
+    std::vector<const RpsCmdCallbackContext*> contexts(subStreamCount);
+    for (uint32_t i = 0; i < subStreamCount; ++i)
+    {
+        cmdLists[i] = BeginCmdList(RPS_QUEUE_GRAPHICS, &inheritanceInfo);
+        AssertIfRpsFailed(rpsCmdCloneContext(pContext, rpsVKCommandBufferToHandle(cmdLists[i].cmdBuf), &contexts[i]));
+    }
+
+    InstanceDataBinding instanceDataBinding = m_InstanceDataStorage->GetBinding(key, *m_GPUTransformChangeSystem);
+
+    JobCounter counter;
+    for (uint32_t i = 0; i < subStreamCount; ++i)
+    {
+        jobSystem->Schedule([&, i]()
+                            {
+                                RpsCmdRenderPassBeginInfo secondaryBeginInfo = {};
+                                secondaryBeginInfo.flags                     = RPS_RUNTIME_RENDER_PASS_SECONDARY_COMMAND_BUFFER;
+                                AssertIfRpsFailed(rpsCmdBeginRenderPass(contexts[i], &secondaryBeginInfo));
+
+                                bindPassResources(cmdLists[i].cmdBuf);
+                                ScheduleDrawStream(*m_RenderContext, (*subStreams)[i], cmdLists[i].cmdBuf, {}, instanceDataBinding);
+                                if (i == 0 && drawAfterStream)
+                                    drawAfterStream(cmdLists[i].cmdBuf);
+
+                                AssertIfRpsFailed(rpsCmdEndRenderPass(contexts[i]));
+                                EndCmdList(cmdLists[i]); },
+                            &counter);
+    }
+    jobSystem->Wait(counter);
+
+    std::vector<vk::CommandBuffer> secondaryCmdBufs;
+    secondaryCmdBufs.reserve(subStreamCount);
+    for (auto& cmdList : cmdLists)
+    {
+        secondaryCmdBufs.push_back(cmdList.cmdBuf);
+        RecycleCmdList(cmdList);
+    }
+
+    cmd.executeCommands(secondaryCmdBufs);
+
+    AssertIfRpsFailed(rpsCmdEndRenderPass(pContext));
+}
+
+void RenderSystem::DrawUnifiedGeometry(vk::CommandBuffer cmd, vk::DescriptorSet passSet)
+{
+    const IndirectDrawBuilder& builder = m_IndirectDraws.builder;
+    if (builder.GetCommandCount() == 0)
         return;
 
-    ScheduleDrawStream(*m_RenderContext, m_DrawData[key], cmd);        
+    const Buffer& vertexBuffer = m_RenderContext->GetBuffer(m_UnifiedGeometryBuffer->GetVertexBuffer());
+    const Buffer& indexBuffer  = m_RenderContext->GetBuffer(m_UnifiedGeometryBuffer->GetIndexBuffer());
+    cmd.bindVertexBuffers(0, {vertexBuffer.vkBuffer}, {0});
+    cmd.bindIndexBuffer(indexBuffer.vkBuffer, 0, vk::IndexType::eUint32);
+
+    vk::DescriptorSet instanceSet = m_RenderContext->GetBindGroup(m_IndirectDraws.bindGroup).set;
+
+    const std::vector<IndirectDrawBatch>& batches = builder.GetBatches();
+    for (uint32_t batchIndex = 0; batchIndex < batches.size(); ++batchIndex)
+    {
+        const IndirectDrawBatch& batch = batches[batchIndex];
+        const GraphicsPipeline& pipeline = m_RenderContext->GetGraphicsPipeline(batch.state.shader);
+        cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.pipeline);
+
+        for (uint32_t set = 0; set < 3; ++set)
+        {
+            if (batch.state.bindGroup[set].empty() == false)
+                cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.layout, set, {m_RenderContext->GetBindGroup(batch.state.bindGroup[set]).set}, {});
+        }
+        if (passSet)
+            cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.layout, 1, {passSet}, {});
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.layout, 3, {instanceSet}, {});
+
+        uint32_t argumentOffset = batch.firstCommand * static_cast<uint32_t>(sizeof(IndirectDrawCommand));
+        if (m_GraphicsCaps.supportsDrawIndirectCount)
+        {
+            m_RenderContext->DrawMeshIndirect(cmd, m_IndirectDraws.argumentBuffer, argumentOffset, batch.commandCount,
+                                              m_IndirectDraws.countBuffer, batchIndex * static_cast<uint32_t>(sizeof(uint32_t)));
+        }
+        else
+        {
+            m_RenderContext->DrawMeshIndirect(cmd, m_IndirectDraws.argumentBuffer, argumentOffset, batch.commandCount);
+        }
+    }
 }
 
 void RenderSystem::CreateImGuiFramebuffer()
@@ -425,8 +747,9 @@ void RenderSystem::CreateRpsRuntimeDeivce()
     
     RpsRenderGraph& renderGraph = *m_RpsSystem->rpsRDG;
 
-    AssertIfRpsFailed(rpsProgramBindNode(rpsRenderGraphGetMainEntry(renderGraph), "Shadowmap", &ShadowmapPassWithRPSWrapper, this));
-    AssertIfRpsFailed(rpsProgramBindNode(rpsRenderGraphGetMainEntry(renderGraph), "ForwardOpaque", &ForwardOpaquePassWithRPSWrapper, this));
+    // the draw passes begin their render pass themselves, so they can record into secondary command buffers
+    AssertIfRpsFailed(rpsProgramBindNode(rpsRenderGraphGetMainEntry(renderGraph), "Shadowmap", &ShadowmapPassWithRPSWrapper, this, RPS_CMD_CALLBACK_CUSTOM_ALL));
+    AssertIfRpsFailed(rpsProgramBindNode(rpsRenderGraphGetMainEntry(renderGraph), "ForwardOpaque", &ForwardOpaquePassWithRPSWrapper, this, RPS_CMD_CALLBACK_CUSTOM_ALL));
 }
 
 void RenderSystem::DestroyRpsRuntimeDevice()
@@ -444,12 +767,19 @@ void RenderSystem::RunRpsSystem()
         
     WaitForSwapChainBuffer();
 
+    uint64_t completedFrameIndex = CalcGuaranteedCompletedFrameindexForRps();
+    m_RenderContext->ReleaseRetiredResources(m_FrameCounter, completedFrameIndex);
+    m_UnifiedGeometryBuffer->ReleaseMovedGeometry(m_FrameCounter, completedFrameIndex);
+
     UpdateGlobalConstantBuffer();
 
     ResetPerFrameDescriptorPool();
 
     ResetCommandPools();
 
+    m_RenderContext->UpdateAsyncUploads();
+    SubmitPendingTransfers();
+
     ExecuteRenderGraph(m_FrameCounter, *m_RpsSystem->rpsRDG, true, false);
 
     StartImguiDraw();
@@ -892,6 +1222,23 @@ void RenderSystem::RecycleCmdList(ActiveCommandList& cmdList)
     cmdList.cmdBuf = VK_NULL_HANDLE;
 }
 
+void RenderSystem::SubmitPendingTransfers()
+{
+    MICROPROFILE_COUNTER_SET("Upload/StagingBytes", m_RenderContext->GetQueuedUploadByteSize());
+
+    // every copy made since the last frame, ahead of the render graph on the same queue
+    ActiveCommandList cmdList = BeginCmdList(RPS_QUEUE_GRAPHICS);
+
+    bool hasTransfers = m_RenderContext->RecordTransfers(cmdList.cmdBuf, m_FrameCounter);
+
+    EndCmdList(cmdList);
+
+    if (hasTransfers)
+        SubmitCmdLists(&cmdList, 1, false);
+
+    RecycleCmdList(cmdList);
+}
+
 void RenderSystem::ResetCommandPools()
 {
     for (uint32_t iQ = 0; iQ < RPS_QUEUE_COUNT; iQ++)
@@ -1191,42 +1538,25 @@ void RenderSystem:: CreateUVQuadDescriptorSets()
     });
 }
 
-struct PerDrawData
-{
-    Matrix4x4 modelMatrix[128];
-};
-
-void RenderSystem::CreateDynamicUniformBuffer()
+void RenderSystem::CreateInstanceDataStorage()
 {
-    size_t alignmentSize = utils::AlignUp(sizeof(PerDrawData), m_GraphicsCaps.minUniformBufferOffsetAlignment);
+    m_InstanceDataStorage = std::make_unique<InstanceDataStorage>(m_CreateInfo.instanceDataStoragePolicy,
+                                                                  static_cast<uint32_t>(m_GraphicsCaps.minUniformBufferOffsetAlignment));
+    m_InstanceDataStorage->CreateGPUResources(*m_RenderContext);
 
-    size_t renderCount = 4;
-    std::vector<uint8_t> dynamicUniformBufferData(alignmentSize * renderCount);
-    
-    for (size_t i = 0; i < renderCount; ++i)
-    {
-        PerDrawData* perDrawData = reinterpret_cast<PerDrawData*>(dynamicUniformBufferData.data() + (i * alignmentSize));
-        perDrawData->modelMatrix[0] = Matrix4x4(1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, i, 0.f, 0.f, 1.f);
-    }
+    // empty unless the per object data is in a dynamic uniform buffer
+    m_DynamicBufferHandle = m_InstanceDataStorage->GetDynamicBuffer();
+}
 
-    m_DynamicUniformBuffer = m_RenderContext->CreateBuffer(
-        {
-            .debugName = "Dynamic Uniform Buffer",
-            .byteSize = static_cast<uint32_t>(dynamicUniformBufferData.size()),
-            .usage = BufferUsage::Uniform,
-            .memUsage = MemoryUsage::GPU,
-            .data = dynamicUniformBufferData.data()
-        }
-    );
+std::vector<BindLayout> RenderSystem::GetDrawCacheBindLayouts(std::vector<BindLayout> bindLayouts)
+{
+    if (m_InstanceDataStorage->GetPolicy() != InstanceDataStoragePolicy::PersistentStructuredBuffer)
+        return bindLayouts;
 
-    m_DynamicBufferHandle = m_RenderContext->CreateDynamicBuffer(
-        {
-            .debugName = "Dynamic Uniform Buffer",
-            .buffer = m_DynamicUniformBuffer,
-            .offset = 0,
-            .range = sizeof(PerDrawData)    
-        }
-    );
+    BindLayout emptyBindLayout = m_RenderContext->GetOrCreateBindLayout({.name = "Empty Descriptor Set Layout", .bindings = {}});
+    bindLayouts.resize(3, emptyBindLayout);
+    bindLayouts.push_back(m_InstanceDataStorage->GetBindLayout());
+    return bindLayouts;
 }
 
 static std::vector<char> LoadShaderBytecode(const std::string& name, const ShaderStage& stage, const std::string& entryPoint)
@@ -1258,31 +1588,35 @@ void RenderSystem::CreatePipeline()
     std::vector<char> cubeVertBytecode = LoadShaderBytecode("sample/cube", ShaderStage::Vertex, "vs");
     std::vector<char> cubeFragBytecode = LoadShaderBytecode("sample/cube", ShaderStage::Fragment, "ps");
 
-    m_CubePipelineHandle = m_RenderContext->CreateGraphicsPipeline(
-        GraphicsPipelineDesc
-        {
-            .debugName = "Cube Pipeline",
-            .VS
-            {
-                .byteCode = reinterpret_cast<uint8_t*>(cubeVertBytecode.data()),
-                .byteSize = static_cast<uint32_t>(cubeVertBytecode.size()), 
-                .entryFunc = "vs"
-            },
-            .PS
+    // the cube shader only reads its matrix from the dynamic uniform buffer
+    if (m_DynamicBufferHandle.empty() == false)
+    {
+        m_CubePipelineHandle = m_RenderContext->CreateGraphicsPipeline(
+            GraphicsPipelineDesc
             {
-                .byteCode = reinterpret_cast<uint8_t*>(cubeFragBytecode.data()), 
-                .byteSize = static_cast<uint32_t>(cubeFragBytecode.size()), 
-                .entryFunc = "ps"
-            },
-            .colorFormats = { GraphicsFormat::BGRA8_SRGB },
-            .depthFormat = GraphicsFormat::D32_FLOAT,
-            .stencilFormat = GraphicsFormat::Undefined,
-            .bindLayouts = { m_GlobalBindLayout },
-            .dynamicBuffer = m_DynamicBufferHandle,
-            .renderPass = renderPass.renderPass,
-            .subpassIndex = 0
-        }
-    );
+                .debugName = "Cube Pipeline",
+                .VS
+                {
+                    .byteCode = reinterpret_cast<uint8_t*>(cubeVertBytecode.data()),
+                    .byteSize = static_cast<uint32_t>(cubeVertBytecode.size()), 
+                    .entryFunc = "vs"
+                },
+                .PS
+                {
+                    .byteCode = reinterpret_cast<uint8_t*>(cubeFragBytecode.data()), 
+                    .byteSize = static_cast<uint32_t>(cubeFragBytecode.size()), 
+                    .entryFunc = "ps"
+                },
+                .colorFormats = { GraphicsFormat::BGRA8_SRGB },
+                .depthFormat = GraphicsFormat::D32_FLOAT,
+                .stencilFormat = GraphicsFormat::Undefined,
+                .bindLayouts = { m_GlobalBindLayout },
+                .dynamicBuffer = m_DynamicBufferHandle,
+                .renderPass = renderPass.renderPass,
+                .subpassIndex = 0
+            }
+        );
+    }
 
     // std::vector<char> unlitVertBytecode = LoadShaderBytecode("sample/UnLit", ShaderStage::Vertex, "vs");
     // std::vector<char> unlitFragBytecode = LoadShaderBytecode("sample/UnLit", ShaderStage::Fragment, "ps");
@@ -1504,17 +1838,79 @@ const PhysicalDevice& RenderSystem::GetBestDevice(const std::vector<PhysicalDevi
     return devices[physicalDeviceIndex];
 }
 
+// Every compression of the Default channels, but the one that is Vertex
+static std::vector<VertexCompressionDesc> GetPackedVertexCompressions()
+{
+    std::vector<VertexCompressionDesc> compressions;
+    for (PositionEncoding position : {PositionEncoding::Float32, PositionEncoding::Unorm16})
+    {
+        for (DirectionEncoding normal : {DirectionEncoding::Float32, DirectionEncoding::Octahedral16, DirectionEncoding::Packed1010102})
+        {
+            for (UVEncoding uv : {UVEncoding::Float32, UVEncoding::Float16})
+            {
+                VertexCompressionDesc compression = {.position = position, .normal = normal, .uv = uv};
+                if (CreateVertexLayout(ShaderChannel::Default, compression).IsVertex() == false)
+                    compressions.push_back(compression);
+            }
+        }
+    }
+    return compressions;
+}
+
+// The vertex shaders are compiled once per position and normal encoding, see CMakeLists.txt. Half uvs only change the
+// vertex binding.
+static std::string GetVertexShaderVariantSuffix(const VertexCompressionDesc& compression)
+{
+    if (compression.position == PositionEncoding::Float32 && compression.normal == DirectionEncoding::Float32)
+        return "";
+
+    std::string suffix = compression.position == PositionEncoding::Unorm16 ? "_PositionUnorm16" : "_PositionFloat32";
+    switch (compression.normal)
+    {
+        case DirectionEncoding::Octahedral16:
+            return suffix + "NormalOctahedral16";
+        case DirectionEncoding::Packed1010102:
+            return suffix + "NormalPacked1010102";
+        default:
+            return suffix + "NormalFloat32";
+    }
+}
+
+std::vector<PassVariant> RenderSystem::CreatePassVariants(const GraphicsPipelineDesc& desc, const std::string& vertexShaderName)
+{
+    std::vector<PassVariant> variants;
+    for (const VertexCompressionDesc& compression : GetPackedVertexCompressions())
+    {
+        VertexLayout layout = CreateVertexLayout(ShaderChannel::Default, compression);
+        std::vector<char> vertexShaderByteCode = LoadShaderBytecode(vertexShaderName + GetVertexShaderVariantSuffix(compression), ShaderStage::Vertex, "main");
+
+        GraphicsPipelineDesc variantDesc  = desc;
+        variantDesc.VS.byteCode           = reinterpret_cast<uint8_t*>(vertexShaderByteCode.data());
+        variantDesc.VS.byteSize           = static_cast<uint32_t>(vertexShaderByteCode.size());
+        variantDesc.vertexBufferBindings  = {layout.GetVertexBufferBinding()};
+
+        variants.push_back({compression, m_RenderContext->CreateGraphicsPipeline(std::move(variantDesc))});
+    }
+    return variants;
+}
+
 void RenderSystem::CreateRpsPipelines()
 {
     // Forward Pipeline
     RenderPassDesc forwardPassDesc = {{GraphicsFormat::BGRA8_SRGB}};
     AutoRenderPass forwardPass(m_RenderContext.get(), forwardPassDesc);
 
-    std::vector<char> vertexShaderByteCode = LoadShaderBytecode("sample/SimpleLit", ShaderStage::Vertex, "main");
-    std::vector<char> fragmentShaderByteCode = LoadShaderBytecode("sample/SimpleLit", ShaderStage::Fragment, "main");
+    // the shaders drawn from the DrawCache have a variant for every InstanceDataStoragePolicy
+    std::string instanceDataSuffix = m_InstanceDataStorage->GetShaderSuffix();
+    uint32_t pushConstantByteSize  = m_InstanceDataStorage->GetPushConstantByteSize();
 
-    m_RpsPipelines.forwardPipeline = m_RenderContext->CreateGraphicsPipeline(
-        GraphicsPipelineDesc{
+    // meshes are uploaded as Vertex unless they ask for compression, the attributes follow the shader inputs
+    VertexLayout vertexLayout = CreateVertexLayout();
+
+    std::vector<char> vertexShaderByteCode = LoadShaderBytecode("sample/SimpleLit" + instanceDataSuffix, ShaderStage::Vertex, "main");
+    std::vector<char> fragmentShaderByteCode = LoadShaderBytecode("sample/SimpleLit" + instanceDataSuffix, ShaderStage::Fragment, "main");
+
+    GraphicsPipelineDesc forwardPipelineDesc{
             .debugName = "SimpleLit",
             .VS{
                 .byteCode  = reinterpret_cast<uint8_t*>(vertexShaderByteCode.data()),
@@ -1527,15 +1923,36 @@ void RenderSystem::CreateRpsPipelines()
             .colorFormats  = {GraphicsFormat::BGRA8_SRGB},
             .depthFormat   = GraphicsFormat::D32_FLOAT,
             .stencilFormat = GraphicsFormat::Undefined,
-            .vertexBufferBindings{
-                {.byteStride = sizeof(Vector3) + sizeof(Vector2) + sizeof(Vector3),
-                 .attributes =
-                     {
-                         {.byteOffset = 0, .format = GraphicsFormat::RGB32_FLOAT},
-                         {.byteOffset = 12, .format = GraphicsFormat::RG32_FLOAT},
-                         {.byteOffset = 20, .format = GraphicsFormat::RGB32_FLOAT}}}},
-            .bindLayouts   = { m_GlobalBindLayout, m_ShadowPassBindLayout, m_BindlessMaterialBinding.bindLayout },
+            .vertexBufferBindings{vertexLayout.GetVertexBufferBinding()},
+            .bindLayouts   = GetDrawCacheBindLayouts({ m_GlobalBindLayout, m_ShadowPassBindLayout, m_BindlessMaterialBinding.bindLayout }),
             .dynamicBuffer = m_DynamicBufferHandle,
+            .pushConstantByteSize = pushConstantByteSize,
+            .renderPass    = forwardPass.GetRenderPass().renderPass,
+            .subpassIndex  = 0
+    };
+    std::vector<PassVariant> forwardVariants = CreatePassVariants(forwardPipelineDesc, "sample/SimpleLit" + instanceDataSuffix);
+    m_RpsPipelines.forwardPipeline = m_RenderContext->CreateGraphicsPipeline(std::move(forwardPipelineDesc));
+
+    // Forward Indirect Pipeline, the model matrix comes from the instance buffer instead of the dynamic buffer
+    std::vector<char> indirectVertexShaderByteCode = LoadShaderBytecode("sample/SimpleLitIndirect", ShaderStage::Vertex, "main");
+    std::vector<char> indirectFragmentShaderByteCode = LoadShaderBytecode("sample/SimpleLitIndirect", ShaderStage::Fragment, "main");
+
+    m_RpsPipelines.forwardIndirectPipeline = m_RenderContext->CreateGraphicsPipeline(
+        GraphicsPipelineDesc{
+            .debugName = "SimpleLitIndirect",
+            .VS{
+                .byteCode  = reinterpret_cast<uint8_t*>(indirectVertexShaderByteCode.data()),
+                .byteSize  = static_cast<uint32_t>(indirectVertexShaderByteCode.size()),
+                .entryFunc = "vs"},
+            .PS{
+                .byteCode  = reinterpret_cast<uint8_t*>(indirectFragmentShaderByteCode.data()),
+                .byteSize  = static_cast<uint32_t>(indirectFragmentShaderByteCode.size()),
+                .entryFunc = "ps"},
+            .colorFormats  = {GraphicsFormat::BGRA8_SRGB},
+            .depthFormat   = GraphicsFormat::D32_FLOAT,
+            .stencilFormat = GraphicsFormat::Undefined,
+            .vertexBufferBindings{vertexLayout.GetVertexBufferBinding()},
+            .bindLayouts   = { m_GlobalBindLayout, m_ShadowPassBindLayout, m_BindlessMaterialBinding.bindLayout, m_IndirectDraws.bindLayout },
             .renderPass    = forwardPass.GetRenderPass().renderPass,
             .subpassIndex  = 0
     });
@@ -1544,11 +1961,10 @@ void RenderSystem::CreateRpsPipelines()
     RenderPassDesc shadowPassDesc = {{}, GraphicsFormat::D32_FLOAT};
     AutoRenderPass shadowPass(m_RenderContext.get(), shadowPassDesc);
 
-    std::vector<char> vertexShaderBytecode   = LoadShaderBytecode("sample/Shadowmap", ShaderStage::Vertex, "main");
-    std::vector<char> fragmentShaderBytecode = LoadShaderBytecode("sample/Shadowmap", ShaderStage::Fragment, "main");
+    std::vector<char> vertexShaderBytecode   = LoadShaderBytecode("sample/Shadowmap" + instanceDataSuffix, ShaderStage::Vertex, "main");
+    std::vector<char> fragmentShaderBytecode = LoadShaderBytecode("sample/Shadowmap" + instanceDataSuffix, ShaderStage::Fragment, "main");
 
-    m_RpsPipelines.shadowPipeline = m_RenderContext->CreateGraphicsPipeline({
-        GraphicsPipelineDesc{
+    GraphicsPipelineDesc shadowPipelineDesc{
             .debugName = "Shadowmap Pipeline",
             .VS{
                 .byteCode  = reinterpret_cast<uint8_t*>(vertexShaderBytecode.data()),
@@ -1561,19 +1977,15 @@ void RenderSystem::CreateRpsPipelines()
             .colorFormats  = {},
             .depthFormat   = GraphicsFormat::D32_FLOAT,
             .stencilFormat = GraphicsFormat::Undefined,
-            .vertexBufferBindings{
-                {.byteStride = sizeof(Vector3) + sizeof(Vector2) + sizeof(Vector3),
-                 .attributes =
-                     {
-                         {.byteOffset = 0, .format = GraphicsFormat::RGB32_FLOAT},
-                         {.byteOffset = 12, .format = GraphicsFormat::RG32_FLOAT},
-                         {.byteOffset = 20, .format = GraphicsFormat::RGB32_FLOAT}}}},
-            .bindLayouts   = { m_GlobalBindLayout },
+            .vertexBufferBindings{vertexLayout.GetVertexBufferBinding()},
+            .bindLayouts   = GetDrawCacheBindLayouts({ m_GlobalBindLayout }),
             .dynamicBuffer = m_DynamicBufferHandle,
+            .pushConstantByteSize = pushConstantByteSize,
             .renderPass    = shadowPass.GetRenderPass().renderPass,
             .subpassIndex  = 0
-        }
-    });
+    };
+    std::vector<PassVariant> shadowVariants = CreatePassVariants(shadowPipelineDesc, "sample/Shadowmap" + instanceDataSuffix);
+    m_RpsPipelines.shadowPipeline = m_RenderContext->CreateGraphicsPipeline(std::move(shadowPipelineDesc));
 
     Material& forwardMat = m_RpsMaterial.forward;
     forwardMat.SetAlphaMode(AlphaMode::Opaque);
@@ -1582,6 +1994,7 @@ void RenderSystem::CreateRpsPipelines()
         .name = "ShadowCaster",
         .shader = m_RpsPipelines.shadowPipeline,
         .bindGroup = {m_GlobalBindGroup},
+        .variants = std::move(shadowVariants),
     });
 
     Pass forwardOpaquePass;
@@ -1589,8 +2002,17 @@ void RenderSystem::CreateRpsPipelines()
     forwardOpaquePass.shader = m_RpsPipelines.forwardPipeline;
     forwardOpaquePass.bindGroup[0] = m_GlobalBindGroup;
     forwardOpaquePass.bindGroup[2] = m_BindlessMaterialBinding.bindGroup;
+    forwardOpaquePass.variants = std::move(forwardVariants);
 
     forwardMat.AddPass(forwardOpaquePass);
+
+    Pass forwardIndirectPass;
+    forwardIndirectPass.name = k_ForwardIndirectPassName;
+    forwardIndirectPass.shader = m_RpsPipelines.forwardIndirectPipeline;
+    forwardIndirectPass.bindGroup[0] = m_GlobalBindGroup;
+    forwardIndirectPass.bindGroup[2] = m_BindlessMaterialBinding.bindGroup;
+
+    forwardMat.AddPass(forwardIndirectPass);
 }
 
 void RenderSystem::CreateDefaultResources()
@@ -1618,6 +2040,9 @@ void RenderSystem::CreateDefaultResources()
             .dataSize  = 4,
         });
 
+    // bound in place of textures that are still being uploaded
+    m_RenderContext->SetStreamingFallbackTexture(m_DefaultResources.whiteTexture);
+
     m_DefaultResources.gridTexture = m_RenderContext->CreateTextureHandle("grid.jpg");
 }
 
@@ -1656,19 +2081,18 @@ void RenderSystem::UpdateGlobalConstantBuffer()
 void RenderSystem::ShadowmapPassWithRPSWrapper(const RpsCmdCallbackContext* pContext)
 {
     RenderSystem& renderSystem = *reinterpret_cast<RenderSystem*>(pContext->pUserRecordContext);
-    vk::CommandBuffer cmd      = rpsVKCommandBufferFromHandle(pContext->hCommandBuffer);
     
     DrawKey key = {"ShadowCaster", AlphaMode::Opaque};
     
-    renderSystem.DrawRenderer(key, cmd, renderSystem.m_RpsPipelines.shadowPipeline);
+    renderSystem.DrawRendererInParallel(pContext, key, [](vk::CommandBuffer) {});
 }
 
 void RenderSystem::ForwardOpaquePassWithRPSWrapper(const RpsCmdCallbackContext* pContext)
 {
     RenderSystem& renderSystem = *reinterpret_cast<RenderSystem*>(pContext->pUserRecordContext);
-    vk::CommandBuffer cmd      = rpsVKCommandBufferFromHandle(pContext->hCommandBuffer);
     
     // Update ShadowMap Descriptor Set
+    vk::DescriptorSet shadowmapSet = VK_NULL_HANDLE;
     VkImageView shadowmapView;
     RpsResult result = rpsVKGetCmdArgImageView(pContext, 0, &shadowmapView);
     if (RPS_SUCCEEDED(result) == true)
@@ -1690,14 +2114,22 @@ void RenderSystem::ForwardOpaquePassWithRPSWrapper(const RpsCmdCallbackContext*
             }
         );
 
-        auto& pipeline = renderContext->GetGraphicsPipeline(renderSystem.m_RpsPipelines.forwardPipeline);
-
-        cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.layout, 1, {shadowmapBindGroup.descriptorSet}, {});
+        shadowmapSet = shadowmapBindGroup.descriptorSet;
     }
 
+    auto& pipeline = renderSystem.m_RenderContext->GetGraphicsPipeline(renderSystem.m_RpsPipelines.forwardPipeline);
+
     DrawKey key = {"ForwardPass", AlphaMode::Opaque};
 
-    renderSystem.DrawRenderer(key, cmd, renderSystem.m_RpsPipelines.forwardPipeline);
+    renderSystem.DrawRendererInParallel(pContext, key, [shadowmapSet, layout = pipeline.layout](vk::CommandBuffer cmd)
+    {
+        if (shadowmapSet)
+            cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, 1, {shadowmapSet}, {});
+    },
+    [&renderSystem, shadowmapSet](vk::CommandBuffer cmd)
+    {
+        renderSystem.DrawUnifiedGeometry(cmd, shadowmapSet);
+    });
 }
 
 void RenderSystem::ResetPerFrameDescriptorPool()
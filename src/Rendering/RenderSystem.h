@@ -21,6 +21,11 @@
 #include <vector>
 
 #include "Rendering/DrawStream/DrawStream.h"
+#include "Rendering/DrawStream/DrawCache.h"
+#include "Rendering/UnifiedGeometryBuffer/UnifiedGeometryBuffer.h"
+#include "Rendering/UnifiedGeometryBuffer/IndirectDrawBuilder.h"
+#include "Rendering/System/GPUTransformChangeSystem.h"
+#include "Rendering/System/InstanceDataStorage.h"
 
 #define RPS_VK_RUNTIME 1
 #include "rps/rps.h"
@@ -63,14 +68,6 @@ struct DeletionQueue
     }
 };
 
-enum class InstanceDataStoragePolicy
-{
-    None,
-    PerDrawPushConstant,
-    PersistentDynamicUniformBuffer,
-    PersistentStructuredBuffer,
-};
-
 struct RenderSystemCreateInfo final
 {
     InstanceDataStoragePolicy instanceDataStoragePolicy : 8 = InstanceDataStoragePolicy::PersistentDynamicUniformBuffer;
@@ -79,7 +76,7 @@ struct RenderSystemCreateInfo final
 ENGINE_CLASS(RenderSystem) final : System
 {
 public:
-    explicit RenderSystem(App* app);
+    explicit RenderSystem(App* app, const RenderSystemCreateInfo& createInfo = {});
     ~RenderSystem() override;
 
     NON_COPYABLE(RenderSystem);
@@ -98,6 +95,12 @@ public:
 public:
     GraphicsCaps GetGraphicsCaps() const { return m_GraphicsCaps; }
     void DrawRenderer(DrawKey key, vk::CommandBuffer cmd, GraphicsPipelineHandle overridePipeline = {});
+    // Records the sub-streams of key into secondary command buffers on the JobSystem and executes them from the node's command buffer.
+    // bindPassResources runs on every command buffer before its draws, secondaries do not inherit any bound state.
+    void DrawRendererInParallel(const RpsCmdCallbackContext* pContext, DrawKey key, const std::function<void(vk::CommandBuffer)>& bindPassResources,
+                                const std::function<void(vk::CommandBuffer)>& drawAfterStream = nullptr);
+    // Records the indirect draws of the renderers in the UnifiedGeometryBuffer, passSet is bound to set 1 if there is one
+    void DrawUnifiedGeometry(vk::CommandBuffer cmd, vk::DescriptorSet passSet = VK_NULL_HANDLE);
 
 private:
     // Imgui
@@ -173,6 +176,7 @@ private:
     void ResetPerFrameDescriptorPool();
     
     void ResetCommandPools();
+    void SubmitPendingTransfers();
 
     void ReserveSemaphores(uint32_t numSyncs);
 
@@ -199,6 +203,7 @@ private:
     struct RPSPipelines
     {
         GraphicsPipelineHandle forwardPipeline;
+        GraphicsPipelineHandle forwardIndirectPipeline;
         GraphicsPipelineHandle shadowPipeline;
     } m_RpsPipelines;
     
@@ -208,6 +213,8 @@ private:
     } m_RpsMaterial;
 
     void CreateRpsPipelines();
+    // One pipeline made like desc for every packed vertex layout, with the variant of the vertex shader decoding it
+    std::vector<renderer::PassVariant> CreatePassVariants(const GraphicsPipelineDesc& desc, const std::string& vertexShaderName);
 
     struct DefaultResources
     {
@@ -272,8 +279,6 @@ private:
     BindLayout m_UVQuadBindLayout;
     BindGroupHandle m_UVQuadBindGroup;
 
-    BufferHandle m_DynamicUniformBuffer;
-    
     DynamicBufferHandle m_DynamicBufferHandle;
 
     TextureHandle m_UVCheckTextureHandle;
@@ -286,10 +291,41 @@ private:
 
     DeletionQueue m_RenderDeletionQueue;
 
+    RenderSystemCreateInfo m_CreateInfo;
     GraphicsCaps m_GraphicsCaps;
 
-    // TODO: Change this to drawStream
-    std::unordered_map<DrawKey, DrawStream> m_DrawData;
+    // Sorted draws and their DrawStreams, patched incrementally when renderers change
+    std::unique_ptr<renderer::DrawCache> m_DrawCache;
+
+    // Geometry of every loaded mesh, opaque renderers drawing from it skip the DrawCache and are drawn indirectly
+    std::unique_ptr<renderer::UnifiedGeometryBuffer> m_UnifiedGeometryBuffer;
+
+    // World matrices of the transforms of every MeshRenderer with last frame's for motion vectors, only changes are uploaded
+    std::unique_ptr<renderer::GPUTransformChangeSystem> m_GPUTransformChangeSystem;
+
+    // Per object data of the draws recorded from the DrawCache, where it lives is picked with the InstanceDataStoragePolicy
+    std::unique_ptr<renderer::InstanceDataStorage> m_InstanceDataStorage;
+
+    struct IndirectDraws
+    {
+        renderer::IndirectDrawBuilder builder;
+        std::vector<uint32_t> drawCounts;
+
+        // what the commands were built from
+        uint32_t drawChangeCount = ~0u;
+        renderer::IndirectDrawState state;
+
+        // sized for capacity instances, there are never more commands or batches than instances
+        uint32_t capacity = 0;
+        BufferHandle instanceBuffer;
+        BufferHandle argumentBuffer;
+        BufferHandle countBuffer;
+
+        BindLayout bindLayout;
+        BindGroupHandle bindGroup;
+        // the transform buffer bindGroup was made with
+        BufferHandle transformBuffer;
+    } m_IndirectDraws;
 private:
     void UploadPerframeGlobalConstantBuffer(uint32_t imageIndex);
 
@@ -302,9 +338,17 @@ private:
     void CreateMaterialDescriptorSets();
     void CreateShadowPassObject();
     void CreateUVQuadDescriptorSets();
-    void CreateDynamicUniformBuffer();
+    void CreateInstanceDataStorage();
+    // Set 3 of the pipelines drawn from the DrawCache holds the per object data for the PersistentStructuredBuffer
+    [[nodiscard]] std::vector<BindLayout> GetDrawCacheBindLayouts(std::vector<BindLayout> bindLayouts);
     void CreatePipeline();
     void CreateTextureObjects();
+    void CreateDrawCache();
+    void CreateUnifiedGeometryBuffer();
+    void CreateGPUTransformChangeSystem();
+    void ReserveIndirectDrawBuffers(uint32_t instanceCount);
+    void CreateIndirectDrawBindGroup();
+    void PrepareIndirectDraws();
     void GetQueues();
     
     [[nodiscard]] const PhysicalDevice& GetBestDevice(const std::vector<PhysicalDevice>& devices) const;
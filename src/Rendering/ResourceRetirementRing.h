@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace gore
+{
+// Holds on to handles of resources that in flight command buffers may still use until the GPU finished the frame
+// they were retired in. Every handle type has its own vector per frame slot which keeps its capacity, so retiring
+// does not allocate once the ring is warm. Handles stay alive in their pool until they are handed to the destroyer,
+// which is when the pool slot is recycled.
+template <uint32_t SlotCount, typename... Handles>
+class ResourceRetirementRing final
+{
+public:
+    static constexpr uint64_t k_NoFrame = UINT64_MAX;
+
+    // frameIndex has to grow, going back only delays the release of what was retired since
+    void BeginFrame(uint64_t frameIndex)
+    {
+        m_CurrentFrame = frameIndex;
+    }
+
+    template <typename Handle>
+    void Retire(Handle handle)
+    {
+        if (handle.empty())
+            return;
+
+        // a slot that still holds an older frame that is not done yet takes the newer frame, which only delays the
+        // older handles instead of releasing anything early
+        Slot& slot = m_Slots[m_CurrentFrame % SlotCount];
+        slot.frameIndex = slot.count == 0 ? m_CurrentFrame : std::max(slot.frameIndex, m_CurrentFrame);
+        slot.count++;
+        std::get<std::vector<Handle>>(slot.handles).push_back(handle);
+    }
+
+    // completedFrameIndex is the last frame the GPU is guaranteed to be done with, k_NoFrame if there is none yet
+    template <typename Destroyer>
+    void Collect(uint64_t completedFrameIndex, Destroyer&& destroyer)
+    {
+        if (completedFrameIndex == k_NoFrame)
+            return;
+
+        for (Slot& slot : m_Slots)
+        {
+            if (slot.count > 0 && slot.frameIndex <= completedFrameIndex)
+                Release(slot, destroyer);
+        }
+    }
+
+    // Releases everything regardless of the frame, only after waiting for the GPU to be idle
+    template <typename Destroyer>
+    void Flush(Destroyer&& destroyer)
+    {
+        for (Slot& slot : m_Slots)
+        {
+            if (slot.count > 0)
+                Release(slot, destroyer);
+        }
+    }
+
+    [[nodiscard]] uint32_t GetPendingCount() const
+    {
+        uint32_t count = 0;
+        for (const Slot& slot : m_Slots)
+            count += slot.count;
+        return count;
+    }
+
+private:
+    struct Slot
+    {
+        uint64_t frameIndex = k_NoFrame;
+        uint32_t count      = 0;
+        std::tuple<std::vector<Handles>...> handles;
+    };
+
+    template <typename Destroyer>
+    static void Release(Slot& slot, Destroyer& destroyer)
+    {
+        // in retirement order per type, clear keeps the capacity for the next frame using the slot
+        std::apply([&destroyer](auto&... handles)
+                   { ((std::for_each(handles.begin(), handles.end(), [&destroyer](auto handle) { destroyer(handle); }), handles.clear()), ...); },
+                   slot.handles);
+
+        slot.frameIndex = k_NoFrame;
+        slot.count      = 0;
+    }
+
+    std::array<Slot, SlotCount> m_Slots = {};
+    uint64_t m_CurrentFrame             = 0;
+};
+} // namespace gore
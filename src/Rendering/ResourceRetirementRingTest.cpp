@@ -0,0 +1,103 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/ResourceRetirementRing.h"
+#include "Rendering/Pool.h"
+
+#include <vector>
+
+namespace gore::test
+{
+struct RetiredBuffer
+{
+    int value;
+};
+
+struct RetiredTexture
+{
+    int value;
+};
+
+TEST_CASE("Retired resources are released once their frame completed", "[ResourceRetirementRing]")
+{
+    Pool<int, RetiredBuffer> buffers;
+    Pool<int, RetiredTexture> textures;
+    ResourceRetirementRing<4, Handle<RetiredBuffer>, Handle<RetiredTexture>> ring;
+
+    std::vector<Handle<RetiredBuffer>> releasedBuffers;
+    std::vector<Handle<RetiredTexture>> releasedTextures;
+    auto destroyer = [&](auto handle)
+    {
+        if constexpr (std::is_same_v<decltype(handle), Handle<RetiredBuffer>>)
+        {
+            buffers.destroy(handle);
+            releasedBuffers.push_back(handle);
+        }
+        else
+        {
+            textures.destroy(handle);
+            releasedTextures.push_back(handle);
+        }
+    };
+
+    ring.BeginFrame(10);
+    auto buffer10  = buffers.create(0, {10});
+    auto texture10 = textures.create(0, {10});
+    ring.Retire(buffer10);
+    ring.Retire(texture10);
+    ring.Retire(Handle<RetiredBuffer>());
+    REQUIRE(ring.GetPendingCount() == 2);
+
+    ring.BeginFrame(11);
+    auto buffer11 = buffers.create(0, {11});
+    ring.Retire(buffer11);
+
+    // nothing is released before the GPU is known to be done with a frame
+    ring.Collect(decltype(ring)::k_NoFrame, destroyer);
+    ring.Collect(9, destroyer);
+    REQUIRE(releasedBuffers.empty());
+    REQUIRE(releasedTextures.empty());
+    REQUIRE(buffers.num() == 2);
+
+    // the handle stays valid and the pool slot taken until then
+    REQUIRE(buffers.getObjectPtr(buffer10)->value == 10);
+
+    ring.Collect(10, destroyer);
+    REQUIRE(releasedBuffers == std::vector<Handle<RetiredBuffer>>{buffer10});
+    REQUIRE(releasedTextures == std::vector<Handle<RetiredTexture>>{texture10});
+    REQUIRE(buffers.num() == 1);
+    REQUIRE(ring.GetPendingCount() == 1);
+
+    SECTION("Later frames follow")
+    {
+        ring.Collect(11, destroyer);
+        REQUIRE(releasedBuffers.back() == buffer11);
+        REQUIRE(ring.GetPendingCount() == 0);
+    }
+
+    SECTION("A slot still in use is never released early")
+    {
+        // frame 15 maps onto the slot of frame 11 which is not done yet
+        ring.BeginFrame(15);
+        auto buffer15 = buffers.create(0, {15});
+        ring.Retire(buffer15);
+
+        ring.Collect(14, destroyer);
+        REQUIRE(releasedBuffers.size() == 1);
+
+        ring.Collect(15, destroyer);
+        REQUIRE(releasedBuffers.size() == 3);
+    }
+
+    SECTION("Flush releases everything")
+    {
+        ring.BeginFrame(12);
+        ring.Retire(buffers.create(0, {12}));
+        ring.Flush(destroyer);
+        REQUIRE(ring.GetPendingCount() == 0);
+        REQUIRE(buffers.num() == 0);
+    }
+}
+
+} // namespace gore::test
+#endif
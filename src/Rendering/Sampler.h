@@ -66,4 +66,9 @@ inline void DestroyVulkanSampler(vk::Device device, vk::Sampler sampler)
 }
 
 using SamplerHandle = Handle<Sampler>;
+
+inline vk::Sampler GetNativeHandle(const Sampler& sampler)
+{
+    return sampler.vkSampler;
+}
 } // namespace gore::gfx
\ No newline at end of file
@@ -2,59 +2,228 @@
 
 #include "Object/Transform.h"
 
+#include "Rendering/RenderContext.h"
+
 #include "Math/Matrix4x4.h"
 
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+
 namespace gore::renderer
 {
+SINGLETON_IMPL(GPUTransformChangeSystem)
+
+static constexpr uint32_t k_SlotsPerWord = 64;
+
 GPUTransformChangeSystem::GPUTransformChangeSystem() noexcept :
-    m_Transforms(1024, nullptr),
-    m_CurMatrix(1024, Matrix4x4::Identity),
-    m_PrevMatrix(1024, Matrix4x4::Identity),
-    m_TransformAllocator()
+    m_TransformAllocator(),
+    m_Transforms(m_TransformAllocator.GetSize(), nullptr),
+    m_TransformData(m_TransformAllocator.GetSize(), TransformData{Matrix4x4::Identity, Matrix4x4::Identity, Vector4::One, Vector4::Zero}),
+    m_ChangedSlots(m_TransformAllocator.GetSize() / k_SlotsPerWord + 1, 0),
+    m_PreviouslyChangedSlots(m_ChangedSlots.size(), 0),
+    m_UploadRanges(),
+    m_TransformBuffer(),
+    m_TransformBufferCapacity(0),
+    m_UploadedByteSize(0)
 {
+    TransformHierarchy::Get().SetChangeListener(this);
+
+    g_Instance = this;
 }
 
-void GPUTransformChangeSystem::AddTransform(Transform* transform)
+GPUTransformChangeSystem::~GPUTransformChangeSystem() noexcept
 {
-    uint32_t index = TransformAllocator::k_InvalidIndex;
-    if (m_TransformAllocator.IsFull())
+    for (Transform* transform : m_Transforms)
     {
-        IncreaseSize();
-        index = m_TransformAllocator.Allocate();
+        if (transform != nullptr)
+            transform->SetChangeSlot(TransformHierarchy::k_NoChangeSlot);
     }
+    TransformHierarchy::Get().SetChangeListener(nullptr);
 
-#if ENGINE_DEBUG
-    auto iter = std::find(m_Transforms.begin(), m_Transforms.end(), transform);
-    if (iter != m_Transforms.end())
+    g_Instance = nullptr;
+}
+
+void GPUTransformChangeSystem::SetDirty(std::vector<uint64_t>& bits, uint32_t slot)
+{
+    bits[slot / k_SlotsPerWord] |= 1ull << (slot % k_SlotsPerWord);
+}
+
+void GPUTransformChangeSystem::ClearDirty(std::vector<uint64_t>& bits, uint32_t slot)
+{
+    bits[slot / k_SlotsPerWord] &= ~(1ull << (slot % k_SlotsPerWord));
+}
+
+uint32_t GPUTransformChangeSystem::AddTransform(Transform* transform)
+{
+    uint32_t slot = transform->GetChangeSlot();
+    if (slot != TransformHierarchy::k_NoChangeSlot)
+        return slot;
+
+    if (m_TransformAllocator.IsFull())
     {
-        LOG(ERROR, "Transform already exists in the system");
-        return;
+        IncreaseSize();
     }
-#endif
+    slot = m_TransformAllocator.Allocate();
+
+    // no motion in the first frame, positions are not quantized until the renderer says so
+    Matrix4x4 localToWorld = transform->GetLocalToWorldMatrix();
+    m_Transforms[slot]     = transform;
+    m_TransformData[slot]  = TransformData{localToWorld, localToWorld, Vector4::One, Vector4::Zero};
+
+    transform->SetChangeSlot(slot);
+    SetDirty(m_ChangedSlots, slot);
 
-    m_Transforms[index] = transform;
-    m_CurMatrix[index]  = transform->GetLocalToWorldMatrix();
-    m_PrevMatrix[index] = Matrix4x4::Zero;
+    return slot;
 }
 
 void GPUTransformChangeSystem::RemoveTransform(Transform* transform)
 {
-    auto iter = std::find(m_Transforms.begin(), m_Transforms.end(), transform);
-    if (iter == m_Transforms.end())
-    {
-        LOG(ERROR, "Transform does not exist in the system");
+    uint32_t slot = transform->GetChangeSlot();
+    if (slot == TransformHierarchy::k_NoChangeSlot)
         return;
-    }
 
-    uint32_t index = static_cast<uint32_t>(std::distance(m_Transforms.begin(), m_Transforms.end()));
+    transform->SetChangeSlot(TransformHierarchy::k_NoChangeSlot);
+    OnTransformRemoved(slot);
+}
+
+void GPUTransformChangeSystem::SetPositionDequantization(uint32_t slot, const Vector3& scale, const Vector3& offset)
+{
+    assert(m_Transforms[slot] != nullptr);
 
-    m_TransformAllocator.Free(index);
-    m_Transforms[index] = nullptr;
+    TransformData& data = m_TransformData[slot];
+    data.positionScale  = Vector4(scale.x, scale.y, scale.z, 1.0f);
+    data.positionOffset = Vector4(offset.x, offset.y, offset.z, 0.0f);
+
+    SetDirty(m_ChangedSlots, slot);
+}
+
+void GPUTransformChangeSystem::OnTransformChanged(uint32_t slot)
+{
+    SetDirty(m_ChangedSlots, slot);
+}
+
+void GPUTransformChangeSystem::OnTransformRemoved(uint32_t slot)
+{
+    assert(m_Transforms[slot] != nullptr);
+
+    // what the slot holds on the GPU is not read anymore, it is written again once the slot is handed out
+    ClearDirty(m_ChangedSlots, slot);
+    ClearDirty(m_PreviouslyChangedSlots, slot);
+
+    m_Transforms[slot] = nullptr;
+    m_TransformAllocator.Free(slot);
 }
 
 void GPUTransformChangeSystem::IncreaseSize()
 {
-    m_CurMatrix.resize(m_CurMatrix.size() + TransformAllocator::k_IncreaseSize, Matrix4x4::Identity);
-    m_PrevMatrix.resize(m_PrevMatrix.size() + TransformAllocator::k_IncreaseSize, Matrix4x4::Identity);
+    m_Transforms.resize(m_Transforms.size() + TransformAllocator::k_IncreaseSize, nullptr);
+    m_TransformData.resize(m_TransformData.size() + TransformAllocator::k_IncreaseSize, TransformData{Matrix4x4::Identity, Matrix4x4::Identity, Vector4::One, Vector4::Zero});
+    m_ChangedSlots.resize(m_Transforms.size() / k_SlotsPerWord + 1, 0);
+    m_PreviouslyChangedSlots.resize(m_ChangedSlots.size(), 0);
+}
+
+void GPUTransformChangeSystem::Update()
+{
+    m_UploadRanges.clear();
+
+    for (uint32_t word = 0; word < m_ChangedSlots.size(); ++word)
+    {
+        uint64_t changed = m_ChangedSlots[word];
+        uint64_t dirty   = changed | m_PreviouslyChangedSlots[word];
+        while (dirty != 0)
+        {
+            uint32_t bit  = static_cast<uint32_t>(std::countr_zero(dirty));
+            uint32_t slot = word * k_SlotsPerWord + bit;
+            dirty &= dirty - 1;
+
+            // a slot that changed last frame but not in this one has its previous matrix catch up, so it stops moving
+            TransformData& data   = m_TransformData[slot];
+            data.prevLocalToWorld = data.localToWorld;
+            if (changed & (1ull << bit))
+                data.localToWorld = m_Transforms[slot]->GetLocalToWorldMatrix();
+
+            if (!m_UploadRanges.empty() && slot <= m_UploadRanges.back().firstSlot + m_UploadRanges.back().slotCount + k_MaxRangeGap)
+                m_UploadRanges.back().slotCount = slot + 1 - m_UploadRanges.back().firstSlot;
+            else
+                m_UploadRanges.push_back({slot, 1});
+        }
+    }
+
+    m_PreviouslyChangedSlots.swap(m_ChangedSlots);
+    std::fill(m_ChangedSlots.begin(), m_ChangedSlots.end(), 0);
+}
+
+uint32_t GPUTransformChangeSystem::GetUploadByteSize() const
+{
+    uint32_t slotCount = 0;
+    for (const UploadRange& range : m_UploadRanges)
+        slotCount += range.slotCount;
+    return slotCount * static_cast<uint32_t>(sizeof(TransformData));
+}
+
+void GPUTransformChangeSystem::CreateTransformBuffer(RenderContext& renderContext, uint32_t capacity)
+{
+    m_TransformBuffer = renderContext.CreateBuffer({
+        .debugName = "Transform Buffer",
+        .byteSize  = capacity * static_cast<uint32_t>(sizeof(TransformData)),
+        .usage     = BufferUsage::Storage,
+        .memUsage  = MemoryUsage::GPU,
+    });
+
+    m_TransformBufferCapacity = capacity;
+}
+
+void GPUTransformChangeSystem::CreateGPUBuffers(RenderContext& renderContext)
+{
+    CreateTransformBuffer(renderContext, static_cast<uint32_t>(m_TransformData.size()));
+}
+
+void GPUTransformChangeSystem::DestroyGPUBuffers(RenderContext& renderContext)
+{
+    if (!m_TransformBuffer.empty())
+        renderContext.DestroyBuffer(m_TransformBuffer);
+
+    m_TransformBuffer         = {};
+    m_TransformBufferCapacity = 0;
+}
+
+void GPUTransformChangeSystem::Upload(RenderContext& renderContext)
+{
+    m_UploadedByteSize = 0;
+    if (m_TransformBuffer.empty())
+        return;
+
+    if (m_TransformBufferCapacity < m_TransformData.size())
+    {
+        // frames in flight still read the old buffer, the new one gets every slot
+        renderContext.RetireBuffer(m_TransformBuffer);
+        CreateTransformBuffer(renderContext, static_cast<uint32_t>(m_TransformData.size()));
+        m_UploadRanges.assign(1, {0, m_TransformBufferCapacity});
+    }
+
+    if (m_UploadRanges.empty())
+        return;
+
+    // every range back to back in the upload, then one copy with a region per range
+    UploadAllocation upload = renderContext.AllocateUpload(GetUploadByteSize());
+    uint8_t* mappedData     = upload.data;
+
+    std::vector<vk::BufferCopy> regions;
+    regions.reserve(m_UploadRanges.size());
+
+    uint32_t stagingOffset = 0;
+    for (const UploadRange& range : m_UploadRanges)
+    {
+        uint32_t rangeByteSize = range.slotCount * static_cast<uint32_t>(sizeof(TransformData));
+        memcpy(mappedData + stagingOffset, &m_TransformData[range.firstSlot], rangeByteSize);
+        regions.emplace_back(stagingOffset, range.firstSlot * sizeof(TransformData), rangeByteSize);
+        stagingOffset += rangeByteSize;
+    }
+
+    renderContext.CopyUploadToBuffer(upload, m_TransformBuffer, regions);
+
+    m_UploadedByteSize = stagingOffset;
 }
-} // namespace gore::renderer
\ No newline at end of file
+} // namespace gore::renderer
@@ -1,10 +1,17 @@
 #pragma once
 
 #include "Prefix.h"
+#include "Export.h"
 
 #include "Math/Matrix4x4.h"
+#include "Math/Vector3.h"
 
-#include "Utilities/Allocator/ArrayAllocator.h"
+#include "Object/TransformHierarchy.h"
+
+#include "Rendering/Buffer.h"
+#include "Rendering/GPUData/TransformData.h"
+
+#include "Utilities/Allocator/BitsetArrayAllocator.h"
 
 #include <vector>
 
@@ -13,28 +20,89 @@ namespace gore
 class Transform;
 }
 
+namespace gore::gfx
+{
+class RenderContext;
+}
+
 namespace gore::renderer
 {
-class GPUTransformChangeSystem
+using namespace gore::gfx;
+
+// Keeps the world matrices of registered transforms in a persistent structured buffer on the GPU, together with
+// the matrices of the previous frame for motion vectors. Every transform gets a stable slot in the buffer.
+// The TransformHierarchy reports which slots changed, so a frame only uploads those plus the ones that changed in
+// the frame before, whose previous matrix has to catch up. The dirty slots are merged into a few ranges that are
+// written to the upload ring of the frame at once and copied with a single command.
+ENGINE_CLASS(GPUTransformChangeSystem) final : public TransformChangeListener
 {
-    using TransformAllocator = utils::ArrayAllocator;
+    SINGLETON(GPUTransformChangeSystem)
+
+    // lowest free slot first, so the matrices uploaded to the GPU stay in a compact range
+    using TransformAllocator = utils::BitsetArrayAllocator;
 
 public:
+    static constexpr uint32_t k_InvalidSlot = TransformAllocator::k_InvalidIndex;
+    // dirty slots closer than this are uploaded as one range, a few clean matrices are cheaper than another region
+    static constexpr uint32_t k_MaxRangeGap = 4;
+
+    struct UploadRange
+    {
+        uint32_t firstSlot = 0;
+        uint32_t slotCount = 0;
+    };
+
     GPUTransformChangeSystem() noexcept;
-    ~GPUTransformChangeSystem() noexcept;
+    ~GPUTransformChangeSystem() noexcept override;
 
-    void AddTransform(Transform* transform);
+    // Returns the slot of the transform, the one it already has if it was added before.
+    // The slot is given back when the transform is destroyed.
+    uint32_t AddTransform(Transform* transform);
     void RemoveTransform(Transform* transform);
+    // How the Unorm16 positions of the mesh drawn with the transform in slot are decoded, uploaded with its matrices
+    void SetPositionDequantization(uint32_t slot, const Vector3& scale, const Vector3& offset);
+
+    void OnTransformChanged(uint32_t slot) override;
+    void OnTransformRemoved(uint32_t slot) override;
+
+    // Once per frame after the world transforms are up to date, finds the ranges the next Upload writes
+    void Update();
+    // Writes the ranges found by Update to the transform buffer, growing it if slots were added past its end
+    void Upload(RenderContext& renderContext);
+
+    void CreateGPUBuffers(RenderContext& renderContext);
+    void DestroyGPUBuffers(RenderContext& renderContext);
+
+    [[nodiscard]] const TransformData& GetTransformData(uint32_t slot) const { return m_TransformData[slot]; }
+    [[nodiscard]] uint32_t GetTransformCount() const { return m_TransformAllocator.GetAllocatedCount(); }
+    // Every slot is below this, the transform buffer is at least this big after Upload
+    [[nodiscard]] uint32_t GetSlotCapacity() const { return static_cast<uint32_t>(m_TransformData.size()); }
+    [[nodiscard]] const std::vector<UploadRange>& GetUploadRanges() const { return m_UploadRanges; }
+    // Bytes of TransformData the ranges of the current frame cover
+    [[nodiscard]] uint32_t GetUploadByteSize() const;
+
+    GETTER(BufferHandle, TransformBuffer)
+    GETTER(uint32_t, UploadedByteSize)
 
 private:
     void IncreaseSize();
+    void SetDirty(std::vector<uint64_t>& bits, uint32_t slot);
+    void ClearDirty(std::vector<uint64_t>& bits, uint32_t slot);
+    void CreateTransformBuffer(RenderContext& renderContext, uint32_t capacity);
 
 private:
     TransformAllocator m_TransformAllocator;
 
     std::vector<Transform*> m_Transforms;
+    std::vector<TransformData> m_TransformData;
+
+    // a bit per slot, what changed since the last Update and what changed in the Update before
+    std::vector<uint64_t> m_ChangedSlots;
+    std::vector<uint64_t> m_PreviouslyChangedSlots;
+    std::vector<UploadRange> m_UploadRanges;
 
-    std::vector<Matrix4x4> m_CurMatrix;
-    std::vector<Matrix4x4> m_PrevMatrix;
+    BufferHandle m_TransformBuffer;
+    uint32_t m_TransformBufferCapacity;
+    uint32_t m_UploadedByteSize;
 };
-} // namespace gore::renderer
\ No newline at end of file
+} // namespace gore::renderer
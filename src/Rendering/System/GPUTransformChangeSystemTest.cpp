@@ -0,0 +1,126 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/System/GPUTransformChangeSystem.h"
+
+#include "Object/GameObject.h"
+#include "Object/Transform.h"
+#include "Object/TransformHierarchy.h"
+#include "Scene/Scene.h"
+
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::renderer;
+
+static Transform* NewTransform(Scene& scene, float x)
+{
+    Transform* transform = scene.NewObject()->GetTransform();
+    transform->SetLocalPosition(Vector3(x, 0.0f, 0.0f));
+    return transform;
+}
+
+TEST_CASE("Only transforms that moved are uploaded", "[GPUTransformChangeSystem]")
+{
+    Scene scene("GPUTransformChangeSystemTest");
+    GPUTransformChangeSystem changeSystem;
+    REQUIRE(GPUTransformChangeSystem::GetInstance() == &changeSystem);
+
+    std::vector<Transform*> transforms;
+    for (uint32_t i = 0; i < 32; ++i)
+    {
+        transforms.push_back(NewTransform(scene, static_cast<float>(i)));
+        REQUIRE(changeSystem.AddTransform(transforms.back()) == i);
+    }
+    REQUIRE(changeSystem.AddTransform(transforms[5]) == 5);
+
+    // everything is new, the previous matrix starts out the same as the current one
+    changeSystem.Update();
+    REQUIRE(changeSystem.GetUploadRanges().size() == 1);
+    REQUIRE(changeSystem.GetUploadByteSize() == 32 * sizeof(TransformData));
+    REQUIRE(changeSystem.GetTransformData(7).localToWorld.GetTranslation().x == 7.0f);
+    REQUIRE(changeSystem.GetTransformData(7).prevLocalToWorld.GetTranslation().x == 7.0f);
+
+    // the frame after uploads them again for the previous matrices, then nothing is left
+    changeSystem.Update();
+    REQUIRE(changeSystem.GetUploadByteSize() == 32 * sizeof(TransformData));
+    changeSystem.Update();
+    REQUIRE(changeSystem.GetUploadRanges().empty());
+
+    SECTION("Moved transforms keep where they were for motion vectors")
+    {
+        transforms[2]->SetLocalPosition(Vector3(100.0f, 0.0f, 0.0f));
+        transforms[4]->SetLocalPosition(Vector3(200.0f, 0.0f, 0.0f));
+        transforms[20]->SetLocalPosition(Vector3(300.0f, 0.0f, 0.0f));
+        TransformHierarchy::Get().UpdateWorldTransforms();
+
+        // slots close to each other share a range
+        changeSystem.Update();
+        const std::vector<GPUTransformChangeSystem::UploadRange>& ranges = changeSystem.GetUploadRanges();
+        REQUIRE(ranges.size() == 2);
+        REQUIRE(ranges[0].firstSlot == 2);
+        REQUIRE(ranges[0].slotCount == 3);
+        REQUIRE(ranges[1].firstSlot == 20);
+        REQUIRE(ranges[1].slotCount == 1);
+
+        REQUIRE(changeSystem.GetTransformData(2).localToWorld.GetTranslation().x == 100.0f);
+        REQUIRE(changeSystem.GetTransformData(2).prevLocalToWorld.GetTranslation().x == 2.0f);
+
+        // standing still again
+        changeSystem.Update();
+        REQUIRE(changeSystem.GetUploadRanges().size() == 2);
+        REQUIRE(changeSystem.GetTransformData(2).prevLocalToWorld.GetTranslation().x == 100.0f);
+
+        changeSystem.Update();
+        REQUIRE(changeSystem.GetUploadRanges().empty());
+    }
+
+    SECTION("Children moved with their parent are uploaded")
+    {
+        transforms[9]->SetParent(transforms[8], false);
+        transforms[8]->SetLocalPosition(Vector3(50.0f, 0.0f, 0.0f));
+        TransformHierarchy::Get().UpdateWorldTransforms();
+
+        changeSystem.Update();
+        REQUIRE(changeSystem.GetUploadRanges().size() == 1);
+        REQUIRE(changeSystem.GetUploadRanges()[0].firstSlot == 8);
+        REQUIRE(changeSystem.GetUploadRanges()[0].slotCount == 2);
+        REQUIRE(changeSystem.GetTransformData(9).localToWorld.GetTranslation().x == 59.0f);
+    }
+
+    SECTION("Destroyed transforms give their slot back")
+    {
+        transforms[3]->SetLocalPosition(Vector3(1.0f, 1.0f, 1.0f));
+        scene.DestroyObject(transforms[3]->GetGameObject());
+        REQUIRE(changeSystem.GetTransformCount() == 31);
+
+        changeSystem.Update();
+        REQUIRE(changeSystem.GetUploadRanges().empty());
+
+        // the lowest free slot is handed out first
+        REQUIRE(changeSystem.AddTransform(NewTransform(scene, 0.0f)) == 3);
+    }
+
+    SECTION("Position dequantization is uploaded with the slot")
+    {
+        changeSystem.SetPositionDequantization(6, Vector3(2.0f, 4.0f, 8.0f), Vector3(-1.0f, 0.0f, 1.0f));
+
+        changeSystem.Update();
+        REQUIRE(changeSystem.GetUploadRanges().size() == 1);
+        REQUIRE(changeSystem.GetUploadRanges()[0].firstSlot == 6);
+        REQUIRE(changeSystem.GetUploadRanges()[0].slotCount == 1);
+        REQUIRE(changeSystem.GetTransformData(6).positionScale.y == 4.0f);
+        REQUIRE(changeSystem.GetTransformData(6).positionOffset.x == -1.0f);
+        REQUIRE(changeSystem.GetTransformData(6).localToWorld.GetTranslation().x == 6.0f);
+
+        // a slot handed out again does not keep the dequantization of the mesh before
+        scene.DestroyObject(transforms[6]->GetGameObject());
+        REQUIRE(changeSystem.AddTransform(NewTransform(scene, 0.0f)) == 6);
+        REQUIRE(changeSystem.GetTransformData(6).positionScale.y == 1.0f);
+        REQUIRE(changeSystem.GetTransformData(6).positionOffset.x == 0.0f);
+    }
+}
+
+} // namespace gore::test
+#endif
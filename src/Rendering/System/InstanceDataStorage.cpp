@@ -0,0 +1,279 @@
+#include "InstanceDataStorage.h"
+
+#include "Rendering/RenderContext.h"
+#include "Rendering/DrawStream/DrawCache.h"
+#include "Rendering/GPUData/PerDrawData.h"
+#include "Rendering/System/GPUTransformChangeSystem.h"
+
+#include "Utilities/Math/MathHelpers.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gore::renderer
+{
+// both grow on their own, this only saves growing them in the first frames
+static constexpr uint32_t k_InitialUniformBufferSlotCapacity = 1024;
+static constexpr uint32_t k_InitialInstanceIndexCapacity     = 1024;
+
+InstanceDataStorage::InstanceDataStorage(InstanceDataStoragePolicy policy, uint32_t minUniformBufferOffsetAlignment) noexcept :
+    m_Policy(policy == InstanceDataStoragePolicy::None ? InstanceDataStoragePolicy::PersistentDynamicUniformBuffer : policy),
+    m_DynamicOffsetStride(static_cast<uint32_t>(utils::AlignUp(sizeof(PerDrawData), std::max(minUniformBufferOffsetAlignment, 1u)))),
+    m_UniformBuffer(),
+    m_DynamicBuffer(),
+    m_UniformBufferSlotCapacity(0),
+    m_BindLayout(),
+    m_InstanceBindGroup(),
+    m_InstanceSet(),
+    m_BoundTransformBuffer(),
+    m_InstanceIndexBuffer(),
+    m_InstanceIndexCapacity(0),
+    m_InstanceIndices(),
+    m_InstanceIndexBase(),
+    m_UploadedEncodeCount(0),
+    m_UploadedByteSize(0)
+{
+}
+
+InstanceDataStorage::~InstanceDataStorage() noexcept
+{
+}
+
+uint32_t InstanceDataStorage::GetPushConstantByteSize() const
+{
+    switch (m_Policy)
+    {
+        case InstanceDataStoragePolicy::PerDrawPushConstant:
+            return sizeof(PerDrawData);
+        case InstanceDataStoragePolicy::PersistentStructuredBuffer:
+            // where the instance indices of the draw list start
+            return sizeof(uint32_t);
+        default:
+            return 0;
+    }
+}
+
+const char* InstanceDataStorage::GetShaderSuffix() const
+{
+    switch (m_Policy)
+    {
+        case InstanceDataStoragePolicy::PerDrawPushConstant:
+            return "PushConstant";
+        case InstanceDataStoragePolicy::PersistentStructuredBuffer:
+            return "StructuredBuffer";
+        default:
+            return "";
+    }
+}
+
+void InstanceDataStorage::CreateGPUResources(RenderContext& renderContext)
+{
+    if (m_Policy == InstanceDataStoragePolicy::PersistentDynamicUniformBuffer)
+    {
+        CreateUniformBuffer(renderContext, k_InitialUniformBufferSlotCapacity);
+    }
+    else if (m_Policy == InstanceDataStoragePolicy::PersistentStructuredBuffer)
+    {
+        std::vector<Binding> bindings{
+            {0, BindType::StorageBuffer, 1, ShaderStage::Vertex},
+            {1, BindType::StorageBuffer, 1, ShaderStage::Vertex}
+        };
+
+        m_BindLayout = renderContext.GetOrCreateBindLayout({
+            .name     = "Instance Data Descriptor Set Layout",
+            .bindings = bindings,
+        });
+
+        m_InstanceIndexCapacity = k_InitialInstanceIndexCapacity;
+        m_InstanceIndexBuffer   = renderContext.CreateBuffer({
+            .debugName = "Instance Index Buffer",
+            .byteSize  = m_InstanceIndexCapacity * static_cast<uint32_t>(sizeof(uint32_t)),
+            .usage     = BufferUsage::Storage,
+            .memUsage  = MemoryUsage::GPU,
+        });
+    }
+}
+
+void InstanceDataStorage::DestroyGPUResources(RenderContext& renderContext)
+{
+    if (!m_DynamicBuffer.empty())
+        renderContext.DestroyDynamicBuffer(m_DynamicBuffer);
+    if (!m_UniformBuffer.empty())
+        renderContext.DestroyBuffer(m_UniformBuffer);
+    if (!m_InstanceBindGroup.empty())
+        renderContext.DestroyBindGroup(m_InstanceBindGroup);
+    if (!m_InstanceIndexBuffer.empty())
+        renderContext.DestroyBuffer(m_InstanceIndexBuffer);
+
+    m_DynamicBuffer             = {};
+    m_UniformBuffer             = {};
+    m_UniformBufferSlotCapacity = 0;
+    m_InstanceBindGroup         = {};
+    m_InstanceSet               = vk::DescriptorSet{};
+    m_BoundTransformBuffer      = {};
+    m_InstanceIndexBuffer       = {};
+    m_InstanceIndexCapacity     = 0;
+}
+
+void InstanceDataStorage::CreateUniformBuffer(RenderContext& renderContext, uint32_t slotCapacity)
+{
+    m_UniformBuffer = renderContext.CreateBuffer({
+        .debugName = "Per Draw Uniform Buffer",
+        .byteSize  = slotCapacity * m_DynamicOffsetStride,
+        .usage     = BufferUsage::Uniform,
+        .memUsage  = MemoryUsage::GPU,
+    });
+
+    m_DynamicBuffer = renderContext.CreateDynamicBuffer({
+        .debugName = "Per Draw Dynamic Buffer",
+        .buffer    = m_UniformBuffer,
+        .offset    = 0,
+        .range     = sizeof(PerDrawData),
+    });
+
+    m_UniformBufferSlotCapacity = slotCapacity;
+}
+
+bool InstanceDataStorage::UploadObjectData(RenderContext& renderContext, const GPUTransformChangeSystem& transformChangeSystem)
+{
+    m_UploadedByteSize = 0;
+    if (m_Policy != InstanceDataStoragePolicy::PersistentDynamicUniformBuffer || m_UniformBuffer.empty())
+        return false;
+
+    std::vector<GPUTransformChangeSystem::UploadRange> ranges = transformChangeSystem.GetUploadRanges();
+
+    bool replaced = false;
+    if (m_UniformBufferSlotCapacity < transformChangeSystem.GetSlotCapacity())
+    {
+        // frames in flight still read the old buffer, the new one gets every slot
+        renderContext.RetireDynamicBuffer(m_DynamicBuffer);
+        renderContext.RetireBuffer(m_UniformBuffer);
+        CreateUniformBuffer(renderContext, std::max(transformChangeSystem.GetSlotCapacity(), m_UniformBufferSlotCapacity * 2));
+
+        ranges.assign(1, {0, transformChangeSystem.GetSlotCapacity()});
+        replaced = true;
+    }
+
+    if (ranges.empty())
+        return replaced;
+
+    uint32_t byteSize = 0;
+    for (const GPUTransformChangeSystem::UploadRange& range : ranges)
+        byteSize += range.slotCount * m_DynamicOffsetStride;
+
+    // the ranges keep the stride of the uniform buffer in the upload, so each of them is a single region
+    UploadAllocation upload = renderContext.AllocateUpload(byteSize);
+    uint8_t* mappedData     = upload.data;
+
+    std::vector<vk::BufferCopy> regions;
+    regions.reserve(ranges.size());
+
+    uint32_t stagingOffset = 0;
+    for (const GPUTransformChangeSystem::UploadRange& range : ranges)
+    {
+        for (uint32_t i = 0; i < range.slotCount; ++i)
+        {
+            const TransformData& transform = transformChangeSystem.GetTransformData(range.firstSlot + i);
+            PerDrawData perDrawData        = {transform.localToWorld, transform.positionScale, transform.positionOffset};
+            memcpy(mappedData + stagingOffset + i * m_DynamicOffsetStride, &perDrawData, sizeof(PerDrawData));
+        }
+
+        uint32_t rangeByteSize = range.slotCount * m_DynamicOffsetStride;
+        regions.emplace_back(stagingOffset, range.firstSlot * m_DynamicOffsetStride, rangeByteSize);
+        stagingOffset += rangeByteSize;
+    }
+
+    renderContext.CopyUploadToBuffer(upload, m_UniformBuffer, regions);
+
+    m_UploadedByteSize = stagingOffset;
+    return replaced;
+}
+
+void InstanceDataStorage::CreateInstanceSet(RenderContext& renderContext, BufferHandle transformBuffer)
+{
+    // frames in flight may still use the old set
+    if (!m_InstanceBindGroup.empty())
+        renderContext.RetireBindGroup(m_InstanceBindGroup);
+
+    m_InstanceBindGroup = renderContext.CreateBindGroup({
+        .debugName       = "Instance Data BindGroup",
+        .updateFrequency = UpdateFrequency::Persistent,
+        .textures        = {},
+        .buffers         = {
+            {0, transformBuffer, 0, renderContext.GetBufferDesc(transformBuffer).byteSize, BindType::StorageBuffer},
+            {1, m_InstanceIndexBuffer, 0, m_InstanceIndexCapacity * static_cast<uint32_t>(sizeof(uint32_t)), BindType::StorageBuffer}
+        },
+        .samplers        = {},
+        .bindLayout      = &m_BindLayout,
+    });
+
+    m_InstanceSet          = renderContext.GetBindGroup(m_InstanceBindGroup).set;
+    m_BoundTransformBuffer = transformBuffer;
+}
+
+void InstanceDataStorage::UploadInstanceIndices(RenderContext& renderContext, const GPUTransformChangeSystem& transformChangeSystem, const DrawCache& drawCache)
+{
+    if (m_Policy != InstanceDataStoragePolicy::PersistentStructuredBuffer || m_InstanceIndexBuffer.empty())
+        return;
+
+    bool instanceIndexBufferReplaced = false;
+    if (drawCache.GetEncodeCount() != m_UploadedEncodeCount)
+    {
+        m_UploadedEncodeCount = drawCache.GetEncodeCount();
+
+        // the draw lists are encoded separately, their instance offsets start at 0 and are moved by the base of the list
+        m_InstanceIndices.clear();
+        m_InstanceIndexBase.clear();
+        for (const DrawKey& key : drawCache.GetDrawKeys())
+        {
+            const std::vector<uint32_t>* instanceIndices = drawCache.GetInstanceIndices(key);
+            m_InstanceIndexBase[key] = static_cast<uint32_t>(m_InstanceIndices.size());
+            m_InstanceIndices.insert(m_InstanceIndices.end(), instanceIndices->begin(), instanceIndices->end());
+        }
+
+        if (m_InstanceIndices.size() > m_InstanceIndexCapacity)
+        {
+            renderContext.RetireBuffer(m_InstanceIndexBuffer);
+
+            m_InstanceIndexCapacity = std::max(static_cast<uint32_t>(m_InstanceIndices.size()), m_InstanceIndexCapacity * 2);
+            m_InstanceIndexBuffer   = renderContext.CreateBuffer({
+                .debugName = "Instance Index Buffer",
+                .byteSize  = m_InstanceIndexCapacity * static_cast<uint32_t>(sizeof(uint32_t)),
+                .usage     = BufferUsage::Storage,
+                .memUsage  = MemoryUsage::GPU,
+            });
+            instanceIndexBufferReplaced = true;
+        }
+
+        if (!m_InstanceIndices.empty())
+        {
+            renderContext.CopyDataToBuffer(m_InstanceIndexBuffer, m_InstanceIndices);
+            m_UploadedByteSize += static_cast<uint32_t>(m_InstanceIndices.size() * sizeof(uint32_t));
+        }
+    }
+
+    // the transform buffer is made again when it grows
+    BufferHandle transformBuffer = transformChangeSystem.GetTransformBuffer();
+    if (instanceIndexBufferReplaced || transformBuffer != m_BoundTransformBuffer)
+        CreateInstanceSet(renderContext, transformBuffer);
+}
+
+InstanceDataBinding InstanceDataStorage::GetBinding(const DrawKey& key, const GPUTransformChangeSystem& transformChangeSystem) const
+{
+    InstanceDataBinding binding = {};
+    binding.policy              = m_Policy;
+    binding.dynamicOffsetStride = m_DynamicOffsetStride;
+
+    if (m_Policy == InstanceDataStoragePolicy::PerDrawPushConstant && transformChangeSystem.GetSlotCapacity() > 0)
+        binding.transforms = &transformChangeSystem.GetTransformData(0);
+
+    if (m_Policy == InstanceDataStoragePolicy::PersistentStructuredBuffer)
+    {
+        auto it                   = m_InstanceIndexBase.find(key);
+        binding.instanceSet       = m_InstanceSet;
+        binding.instanceIndexBase = it != m_InstanceIndexBase.end() ? it->second : 0;
+    }
+
+    return binding;
+}
+} // namespace gore::renderer
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Prefix.h"
+#include "Export.h"
+
+#include "Rendering/Buffer.h"
+#include "Rendering/BindGroup.h"
+#include "Rendering/BindLayout.h"
+#include "Rendering/DynamicBuffer.h"
+#include "Rendering/DrawStream/Draw.h"
+#include "Rendering/DrawStream/InstanceDataBinding.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace gore::gfx
+{
+class RenderContext;
+}
+
+namespace gore::renderer
+{
+using namespace gore::gfx;
+
+class DrawCache;
+class GPUTransformChangeSystem;
+
+// Puts the per object data of the draws recorded from the DrawCache where the InstanceDataStoragePolicy wants it.
+// Everything comes from the GPUTransformChangeSystem, the per object data index of a draw is the slot of its transform:
+// the dynamic uniform buffer mirrors the slots of the transform buffer and only the changed ones are written,
+// the structured buffer policy reads the transform buffer itself and only adds the instance indices of the draw lists,
+// push constants are read from the CPU copy of the transforms while recording.
+ENGINE_CLASS(InstanceDataStorage) final
+{
+public:
+    // None picks the PersistentDynamicUniformBuffer
+    InstanceDataStorage(InstanceDataStoragePolicy policy, uint32_t minUniformBufferOffsetAlignment) noexcept;
+    ~InstanceDataStorage() noexcept;
+
+    NON_COPYABLE(InstanceDataStorage)
+
+    void CreateGPUResources(RenderContext& renderContext);
+    void DestroyGPUResources(RenderContext& renderContext);
+
+    // Once per frame after GPUTransformChangeSystem::Upload and before DrawCache::Update. Returns true when the dynamic
+    // buffer had to be replaced to fit every slot, the draws holding the old one have to be made again.
+    bool UploadObjectData(RenderContext& renderContext, const GPUTransformChangeSystem& transformChangeSystem);
+    // Once per frame after DrawCache::Update, only does something for the PersistentStructuredBuffer
+    void UploadInstanceIndices(RenderContext& renderContext, const GPUTransformChangeSystem& transformChangeSystem, const DrawCache& drawCache);
+
+    [[nodiscard]] InstanceDataBinding GetBinding(const DrawKey& key, const GPUTransformChangeSystem& transformChangeSystem) const;
+
+    // Only a structured buffer can tell the instances of a batched draw apart
+    [[nodiscard]] bool CanInstance() const { return m_Policy == InstanceDataStoragePolicy::PersistentStructuredBuffer; }
+    [[nodiscard]] uint32_t GetPushConstantByteSize() const;
+    // Every policy has its own variant of the shaders drawn from the DrawCache, this goes after their name
+    [[nodiscard]] const char* GetShaderSuffix() const;
+
+    GETTER(InstanceDataStoragePolicy, Policy)
+    // Bytes between the data of two slots in the dynamic uniform buffer
+    GETTER(uint32_t, DynamicOffsetStride)
+    GETTER(DynamicBufferHandle, DynamicBuffer)
+    // Set 3 of the PersistentStructuredBuffer
+    GETTER(BindLayout, BindLayout)
+    GETTER(uint32_t, UploadedByteSize)
+
+private:
+    void CreateUniformBuffer(RenderContext& renderContext, uint32_t slotCapacity);
+    void CreateInstanceSet(RenderContext& renderContext, BufferHandle transformBuffer);
+
+private:
+    InstanceDataStoragePolicy m_Policy;
+    uint32_t m_DynamicOffsetStride;
+
+    // PersistentDynamicUniformBuffer
+    BufferHandle m_UniformBuffer;
+    DynamicBufferHandle m_DynamicBuffer;
+    uint32_t m_UniformBufferSlotCapacity;
+
+    // PersistentStructuredBuffer, the instance indices of every draw list back to back
+    BindLayout m_BindLayout;
+    BindGroupHandle m_InstanceBindGroup;
+    vk::DescriptorSet m_InstanceSet;
+    BufferHandle m_BoundTransformBuffer;
+    BufferHandle m_InstanceIndexBuffer;
+    uint32_t m_InstanceIndexCapacity;
+    std::vector<uint32_t> m_InstanceIndices;
+    std::unordered_map<DrawKey, uint32_t> m_InstanceIndexBase;
+    uint32_t m_UploadedEncodeCount;
+
+    uint32_t m_UploadedByteSize;
+};
+} // namespace gore::renderer
@@ -3,7 +3,7 @@
 namespace gore::renderer
 {
 MeshRendererSystem::MeshRendererSystem() :
-    m_MeshRendererAllocator(std::make_unique<utils::ArrayAllocator>())
+    m_MeshRendererAllocator(std::make_unique<utils::BitsetArrayAllocator>())
 {
 }
 
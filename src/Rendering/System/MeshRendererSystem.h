@@ -6,7 +6,7 @@
 #include <memory>
 
 #include "Rendering/Handle.h"
-#include "Utilities/Allocator/ArrayAllocator.h"
+#include "Utilities/Allocator/BitsetArrayAllocator.h"
 
 namespace gore::renderer
 {
@@ -56,6 +56,6 @@ public:
     void FreeRendererHandle(RendererHandle handle);
 
 private:
-    std::unique_ptr<utils::ArrayAllocator> m_MeshRendererAllocator;
+    std::unique_ptr<utils::BitsetArrayAllocator> m_MeshRendererAllocator;
 };
 } // namespace gore::renderer
\ No newline at end of file
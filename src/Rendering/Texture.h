@@ -44,7 +44,7 @@ struct TextureDesc final
     int numMips           = 1;
     int numLayers         = 1;
     int numSamples        = 1;
-    uint8_t* data         = nullptr;
+    const uint8_t* data   = nullptr;
     uint32_t dataSize     = 0;
 };
 
@@ -63,6 +63,11 @@ struct Texture
 
 using TextureHandle = Handle<Texture>;
 
+inline VkImage GetNativeHandle(const Texture& texture)
+{
+    return texture.image;
+}
+
 inline void DestroyVulkanTexture(VmaAllocator vmaAllocator, VkImage image, VmaAllocation vmaAllocation)
 {
     vmaDestroyImage(vmaAllocator, image, vmaAllocation);
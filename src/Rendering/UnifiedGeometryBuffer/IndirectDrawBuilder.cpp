@@ -0,0 +1,84 @@
+#include "IndirectDrawBuilder.h"
+
+#include "UnifiedGeometryBuffer.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace gore::renderer
+{
+template <typename T>
+static uint64_t GetHandleSortKey(Handle<T> handle)
+{
+    return (static_cast<uint64_t>(handle.index()) << 32) | handle.gen();
+}
+
+static auto GetStateSortKey(const IndirectDrawState& state)
+{
+    return std::make_tuple(GetHandleSortKey(state.shader),
+                           GetHandleSortKey(state.bindGroup[0]),
+                           GetHandleSortKey(state.bindGroup[1]),
+                           GetHandleSortKey(state.bindGroup[2]));
+}
+
+void IndirectDrawBuilder::Clear()
+{
+    m_PendingInstances.clear();
+
+    m_Instances.clear();
+    m_Commands.clear();
+    m_Batches.clear();
+}
+
+void IndirectDrawBuilder::AddInstance(const IndirectDrawState& state, uint32_t meshIndex, uint32_t transformSlot)
+{
+    m_PendingInstances.push_back({state, meshIndex, transformSlot, static_cast<uint32_t>(m_PendingInstances.size())});
+}
+
+void IndirectDrawBuilder::Build(const UnifiedGeometryBuffer& geometryBuffer)
+{
+    m_Instances.clear();
+    m_Commands.clear();
+    m_Batches.clear();
+
+    std::erase_if(m_PendingInstances, [&geometryBuffer](const PendingInstance& instance)
+                  { return geometryBuffer.IsValidMesh(instance.meshIndex) == false; });
+
+    // the add index keeps the order the instances were added in within a mesh
+    std::sort(m_PendingInstances.begin(), m_PendingInstances.end(), [](const PendingInstance& a, const PendingInstance& b)
+              { return std::tuple_cat(GetStateSortKey(a.state), std::make_tuple(a.meshIndex, a.addIndex))
+                     < std::tuple_cat(GetStateSortKey(b.state), std::make_tuple(b.meshIndex, b.addIndex)); });
+
+    m_Instances.reserve(m_PendingInstances.size());
+    for (const PendingInstance& instance : m_PendingInstances)
+    {
+        bool newBatch = m_Batches.empty() || !(m_Batches.back().state == instance.state);
+        if (newBatch)
+        {
+            m_Batches.push_back({instance.state, static_cast<uint32_t>(m_Commands.size()), 0});
+        }
+
+        if (newBatch || m_Instances.back().meshIndex != instance.meshIndex)
+        {
+            const MeshData& mesh = geometryBuffer.GetMeshData(instance.meshIndex);
+
+            IndirectDrawCommand& command = m_Commands.emplace_back();
+            command.indexCount           = mesh.indexCount;
+            command.instanceCount        = 0;
+            command.firstIndex           = mesh.indexOffset;
+            command.vertexOffset         = static_cast<int32_t>(mesh.vertexOffset);
+            command.firstInstance        = static_cast<uint32_t>(m_Instances.size());
+
+            m_Batches.back().commandCount++;
+        }
+
+        m_Commands.back().instanceCount++;
+
+        InstanceData& data = m_Instances.emplace_back();
+        data.transformSlot = instance.transformSlot;
+        data.meshIndex     = instance.meshIndex;
+        data.padding[0]    = 0;
+        data.padding[1]    = 0;
+    }
+}
+} // namespace gore::renderer
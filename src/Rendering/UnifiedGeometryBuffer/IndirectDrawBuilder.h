@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Prefix.h"
+#include "Export.h"
+
+#include "Rendering/Pipeline.h"
+#include "Rendering/BindGroup.h"
+#include "Rendering/GPUData/InstanceData.h"
+#include "Rendering/GPUData/IndirectDrawCommand.h"
+
+#include <vector>
+
+namespace gore::renderer
+{
+using namespace gore::gfx;
+
+class UnifiedGeometryBuffer;
+
+// Everything that has to be bound before a multi draw, instances with the same state share one
+struct IndirectDrawState
+{
+    GraphicsPipelineHandle shader = {};
+    BindGroupHandle bindGroup[3]  = {};
+
+    bool operator==(const IndirectDrawState& other) const
+    {
+        return shader == other.shader && bindGroup[0] == other.bindGroup[0] && bindGroup[1] == other.bindGroup[1] && bindGroup[2] == other.bindGroup[2];
+    }
+};
+
+// Commands [firstCommand, firstCommand + commandCount) of the argument buffer, recorded with one DrawMeshIndirect
+struct IndirectDrawBatch
+{
+    IndirectDrawState state = {};
+    uint32_t firstCommand   = 0;
+    uint32_t commandCount   = 0;
+};
+
+// Builds the instance buffer and the indirect argument buffer for meshes in the UnifiedGeometryBuffer on the CPU.
+// Instances are sorted by state and mesh, every mesh of a state becomes one IndirectDrawCommand whose instances are
+// next to each other in the instance buffer, starting at firstInstance. Shaders find their InstanceData with
+// SV_InstanceID, which includes firstInstance on vulkan.
+ENGINE_CLASS(IndirectDrawBuilder) final
+{
+public:
+    IndirectDrawBuilder() = default;
+    ~IndirectDrawBuilder() = default;
+
+    NON_COPYABLE(IndirectDrawBuilder);
+
+    void Clear();
+    // transformSlot is the slot of the transform in GPUTransformChangeSystem, the shader reads the matrix from there
+    void AddInstance(const IndirectDrawState& state, uint32_t meshIndex, uint32_t transformSlot);
+
+    // Instances of meshes that are not in geometryBuffer anymore are dropped
+    void Build(const UnifiedGeometryBuffer& geometryBuffer);
+
+    [[nodiscard]] const std::vector<InstanceData>& GetInstances() const { return m_Instances; }
+    [[nodiscard]] const std::vector<IndirectDrawCommand>& GetCommands() const { return m_Commands; }
+    [[nodiscard]] const std::vector<IndirectDrawBatch>& GetBatches() const { return m_Batches; }
+    [[nodiscard]] uint32_t GetCommandCount() const { return static_cast<uint32_t>(m_Commands.size()); }
+
+private:
+    struct PendingInstance
+    {
+        IndirectDrawState state;
+        uint32_t meshIndex;
+        uint32_t transformSlot;
+        uint32_t addIndex;
+    };
+
+    std::vector<PendingInstance> m_PendingInstances;
+
+    std::vector<InstanceData> m_Instances;
+    std::vector<IndirectDrawCommand> m_Commands;
+    std::vector<IndirectDrawBatch> m_Batches;
+};
+} // namespace gore::renderer
@@ -0,0 +1,116 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/UnifiedGeometryBuffer/IndirectDrawBuilder.h"
+#include "Rendering/UnifiedGeometryBuffer/UnifiedGeometryBuffer.h"
+#include "Rendering/Pool.h"
+
+#include <random>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::renderer;
+
+TEST_CASE("Instances are grouped into one indirect command per mesh", "[IndirectDrawBuilder]")
+{
+    UnifiedGeometryBuffer geometryBuffer({.vertexStride = sizeof(float) * 8, .vertexCapacity = 4096, .indexCapacity = 4096, .maxMeshCount = 16});
+
+    std::vector<float> vertices(8 * 64);
+    std::vector<uint32_t> indices(96);
+    std::vector<uint32_t> meshes;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        meshes.push_back(geometryBuffer.AddMesh(vertices.data(), 64, sizeof(float) * 8, indices.data(), 36 + 30 * i, IndexType::UINT32));
+    }
+
+    Pool<int, GraphicsPipeline> pipelines;
+    Pool<int, BindGroup> bindGroups;
+
+    IndirectDrawState opaque = {pipelines.create(0, GraphicsPipeline{}), {bindGroups.create(0, BindGroup{})}};
+    IndirectDrawState other  = opaque;
+    other.bindGroup[2]       = bindGroups.create(0, BindGroup{});
+
+    std::mt19937 random(7);
+    std::vector<uint32_t> instanceMeshes(1000);
+
+    // the transform slot of an instance is its add index here
+    IndirectDrawBuilder builder;
+    for (uint32_t i = 0; i < instanceMeshes.size(); ++i)
+    {
+        instanceMeshes[i] = meshes[random() % meshes.size()];
+        builder.AddInstance(i % 2 == 0 ? opaque : other, instanceMeshes[i], i);
+    }
+    builder.Build(geometryBuffer);
+
+    const std::vector<InstanceData>& instances       = builder.GetInstances();
+    const std::vector<IndirectDrawCommand>& commands = builder.GetCommands();
+    const std::vector<IndirectDrawBatch>& batches    = builder.GetBatches();
+
+    REQUIRE(instances.size() == instanceMeshes.size());
+    REQUIRE(commands.size() == 6);
+    REQUIRE(batches.size() == 2);
+    REQUIRE(batches[0].firstCommand == 0);
+    REQUIRE(batches[0].commandCount == 3);
+    REQUIRE(batches[1].firstCommand == 3);
+    REQUIRE(batches[1].commandCount == 3);
+
+    // every command covers the instances of its mesh in the order they were added and draws the geometry the mesh
+    // buffer points at
+    uint32_t nextInstance = 0;
+    for (const IndirectDrawCommand& command : commands)
+    {
+        REQUIRE(command.firstInstance == nextInstance);
+        REQUIRE(command.instanceCount > 0);
+
+        const MeshData& mesh = geometryBuffer.GetMeshData(instances[command.firstInstance].meshIndex);
+        REQUIRE(command.indexCount == mesh.indexCount);
+        REQUIRE(command.firstIndex == mesh.indexOffset);
+        REQUIRE(command.vertexOffset == static_cast<int32_t>(mesh.vertexOffset));
+
+        for (uint32_t i = command.firstInstance; i < command.firstInstance + command.instanceCount; ++i)
+        {
+            REQUIRE(instances[i].meshIndex == instances[command.firstInstance].meshIndex);
+            if (i > command.firstInstance)
+            {
+                REQUIRE(instances[i - 1].transformSlot < instances[i].transformSlot);
+            }
+        }
+        nextInstance += command.instanceCount;
+    }
+    REQUIRE(nextInstance == instances.size());
+
+    // the transform slots travel with their instance
+    std::vector<bool> seen(instanceMeshes.size(), false);
+    for (uint32_t i = 0; i < instances.size(); ++i)
+    {
+        const InstanceData& instance = instances[i];
+        REQUIRE(instance.transformSlot < instanceMeshes.size());
+        REQUIRE(seen[instance.transformSlot] == false);
+        REQUIRE(instance.meshIndex == instanceMeshes[instance.transformSlot]);
+        seen[instance.transformSlot] = true;
+    }
+
+    SECTION("Instances of removed meshes are dropped")
+    {
+        geometryBuffer.RemoveMesh(meshes[1]);
+        builder.Build(geometryBuffer);
+
+        REQUIRE(builder.GetCommandCount() == 4);
+        for (const InstanceData& instance : builder.GetInstances())
+        {
+            REQUIRE(instance.meshIndex != meshes[1]);
+        }
+    }
+
+    SECTION("Clear starts over")
+    {
+        builder.Clear();
+        builder.Build(geometryBuffer);
+        REQUIRE(builder.GetInstances().empty());
+        REQUIRE(builder.GetCommandCount() == 0);
+    }
+}
+
+} // namespace gore::test
+#endif
@@ -0,0 +1,333 @@
+#include "UnifiedGeometryBuffer.h"
+
+#include "Rendering/RenderContext.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace gore::renderer
+{
+SINGLETON_IMPL(UnifiedGeometryBuffer)
+
+static constexpr uint32_t k_IndexSize = sizeof(uint32_t);
+
+UnifiedGeometryBuffer::UnifiedGeometryBuffer(const UnifiedGeometryBufferDesc& desc) :
+    m_Desc(desc),
+    m_VertexAllocator(desc.vertexCapacity),
+    m_IndexAllocator(desc.indexCapacity),
+    m_Meshes(),
+    m_MeshAllocations(),
+    m_FreeMeshSlots(),
+    m_MeshCount(0),
+    m_PendingVertexUploads(),
+    m_PendingIndexUploads(),
+    m_PendingVertexCopies(),
+    m_PendingIndexCopies(),
+    m_MeshTableDirty(false),
+    m_DefragmentationPending(false),
+    m_MovedGeometry(),
+    m_VertexBuffer(),
+    m_IndexBuffer(),
+    m_MeshBuffer()
+{
+    // byte offsets into the buffers are 32 bit
+    assert(static_cast<uint64_t>(desc.vertexCapacity) * desc.vertexStride <= UINT32_MAX);
+    assert(static_cast<uint64_t>(desc.indexCapacity) * k_IndexSize <= UINT32_MAX);
+
+    m_Meshes.reserve(desc.maxMeshCount);
+    m_MeshAllocations.reserve(desc.maxMeshCount);
+
+    g_Instance = this;
+}
+
+UnifiedGeometryBuffer::~UnifiedGeometryBuffer()
+{
+    g_Instance = nullptr;
+}
+
+static void WidenIndices(const void* indexData, uint32_t indexCount, IndexType indexType, uint8_t* output)
+{
+    switch (indexType)
+    {
+        case IndexType::UINT8:
+            for (uint32_t i = 0; i < indexCount; ++i)
+            {
+                uint32_t index = static_cast<const uint8_t*>(indexData)[i];
+                memcpy(output + i * k_IndexSize, &index, k_IndexSize);
+            }
+            break;
+        case IndexType::UINT16:
+            for (uint32_t i = 0; i < indexCount; ++i)
+            {
+                uint16_t narrowIndex;
+                memcpy(&narrowIndex, static_cast<const uint8_t*>(indexData) + i * sizeof(uint16_t), sizeof(uint16_t));
+                uint32_t index = narrowIndex;
+                memcpy(output + i * k_IndexSize, &index, k_IndexSize);
+            }
+            break;
+        case IndexType::UINT32:
+            memcpy(output, indexData, static_cast<size_t>(indexCount) * k_IndexSize);
+            break;
+        default:
+            break;
+    }
+}
+
+uint32_t UnifiedGeometryBuffer::AddMesh(const void* vertexData, uint32_t vertexCount, uint32_t vertexStride, const void* indexData, uint32_t indexCount, IndexType indexType)
+{
+    if (vertexStride != m_Desc.vertexStride || vertexCount == 0 || indexCount == 0 || GetIndexTypeSize(indexType) == 0)
+        return k_InvalidMesh;
+
+    if (m_FreeMeshSlots.empty() && m_Meshes.size() >= m_Desc.maxMeshCount)
+        return k_InvalidMesh;
+
+    OffsetAllocator::Allocation vertices = m_VertexAllocator.allocate(vertexCount);
+    if (vertices.offset == OffsetAllocator::Allocation::NO_SPACE)
+        return k_InvalidMesh;
+
+    OffsetAllocator::Allocation indices = m_IndexAllocator.allocate(indexCount);
+    if (indices.offset == OffsetAllocator::Allocation::NO_SPACE)
+    {
+        m_VertexAllocator.free(vertices);
+        return k_InvalidMesh;
+    }
+
+    uint32_t meshIndex;
+    if (!m_FreeMeshSlots.empty())
+    {
+        meshIndex = m_FreeMeshSlots.back();
+        m_FreeMeshSlots.pop_back();
+    }
+    else
+    {
+        meshIndex = static_cast<uint32_t>(m_Meshes.size());
+        m_Meshes.emplace_back();
+        m_MeshAllocations.emplace_back();
+    }
+
+    m_Meshes[meshIndex]          = MeshData{vertices.offset, indices.offset, vertexCount, indexCount};
+    m_MeshAllocations[meshIndex] = MeshAllocation{vertices, indices, true};
+    m_MeshCount++;
+
+    PendingUpload& vertexUpload = m_PendingVertexUploads.emplace_back();
+    vertexUpload.meshIndex      = meshIndex;
+    vertexUpload.byteOffset     = vertices.offset * vertexStride;
+    vertexUpload.data.resize(static_cast<size_t>(vertexCount) * vertexStride);
+    memcpy(vertexUpload.data.data(), vertexData, vertexUpload.data.size());
+
+    PendingUpload& indexUpload = m_PendingIndexUploads.emplace_back();
+    indexUpload.meshIndex      = meshIndex;
+    indexUpload.byteOffset     = indices.offset * k_IndexSize;
+    indexUpload.data.resize(static_cast<size_t>(indexCount) * k_IndexSize);
+    WidenIndices(indexData, indexCount, indexType, indexUpload.data.data());
+
+    m_MeshTableDirty = true;
+
+    return meshIndex;
+}
+
+void UnifiedGeometryBuffer::RemoveMesh(uint32_t meshIndex)
+{
+    if (IsValidMesh(meshIndex) == false)
+        return;
+
+    MeshAllocation& allocation = m_MeshAllocations[meshIndex];
+    m_VertexAllocator.free(allocation.vertices);
+    m_IndexAllocator.free(allocation.indices);
+    allocation = {};
+
+    // the slot is handed out again, an upload left behind would be moved along with the next mesh in it. Copies of a
+    // pending move can stay, FlushUploads copies before it uploads
+    auto isRemovedMesh = [meshIndex](const PendingUpload& upload) { return upload.meshIndex == meshIndex; };
+    std::erase_if(m_PendingVertexUploads, isRemovedMesh);
+    std::erase_if(m_PendingIndexUploads, isRemovedMesh);
+
+    // a zero sized mesh draws nothing if an instance still points at it
+    m_Meshes[meshIndex] = {};
+    m_FreeMeshSlots.push_back(meshIndex);
+    m_MeshCount--;
+
+    m_MeshTableDirty         = true;
+    m_DefragmentationPending = true;
+}
+
+bool UnifiedGeometryBuffer::IsValidMesh(uint32_t meshIndex) const
+{
+    return meshIndex < m_MeshAllocations.size() && m_MeshAllocations[meshIndex].used;
+}
+
+size_t UnifiedGeometryBuffer::GetPendingUploadSize() const
+{
+    size_t size = m_MeshTableDirty ? m_Meshes.size() * sizeof(MeshData) : 0;
+    for (const PendingUpload& upload : m_PendingVertexUploads)
+        size += upload.data.size();
+    for (const PendingUpload& upload : m_PendingIndexUploads)
+        size += upload.data.size();
+    return size;
+}
+
+void UnifiedGeometryBuffer::CreateGPUBuffers(RenderContext& renderContext)
+{
+    m_VertexBuffer = renderContext.CreateBuffer({
+        .debugName = "UGB Vertex Buffer",
+        .byteSize  = m_Desc.vertexCapacity * m_Desc.vertexStride,
+        .usage     = BufferUsage::Vertex,
+        .memUsage  = MemoryUsage::GPU,
+    });
+
+    m_IndexBuffer = renderContext.CreateBuffer({
+        .debugName = "UGB Index Buffer",
+        .byteSize  = m_Desc.indexCapacity * k_IndexSize,
+        .usage     = BufferUsage::Index,
+        .memUsage  = MemoryUsage::GPU,
+    });
+
+    m_MeshBuffer = renderContext.CreateBuffer({
+        .debugName = "UGB Mesh Buffer",
+        .byteSize  = m_Desc.maxMeshCount * static_cast<uint32_t>(sizeof(MeshData)),
+        .usage     = BufferUsage::Storage,
+        .memUsage  = MemoryUsage::GPU,
+    });
+
+    m_MeshTableDirty = !m_Meshes.empty();
+}
+
+void UnifiedGeometryBuffer::DestroyGPUBuffers(RenderContext& renderContext)
+{
+    if (m_VertexBuffer.empty())
+        return;
+
+    renderContext.DestroyBuffer(m_VertexBuffer);
+    renderContext.DestroyBuffer(m_IndexBuffer);
+    renderContext.DestroyBuffer(m_MeshBuffer);
+
+    m_VertexBuffer = {};
+    m_IndexBuffer  = {};
+    m_MeshBuffer   = {};
+
+    m_PendingVertexCopies.clear();
+    m_PendingIndexCopies.clear();
+}
+
+void UnifiedGeometryBuffer::FlushUploads(RenderContext& renderContext)
+{
+    // meshes added before the buffers exist stay pending
+    if (m_VertexBuffer.empty())
+        return;
+
+    // moves first, they read the old places which may have been freed and handed out again since
+    if (!m_PendingVertexCopies.empty())
+        renderContext.CopyBuffer(m_VertexBuffer, m_VertexBuffer, m_PendingVertexCopies);
+    if (!m_PendingIndexCopies.empty())
+        renderContext.CopyBuffer(m_IndexBuffer, m_IndexBuffer, m_PendingIndexCopies);
+
+    // in order, a range that was freed and handed out again ends up with the newest data
+    for (const PendingUpload& upload : m_PendingVertexUploads)
+        renderContext.CopyDataToBuffer(m_VertexBuffer, upload.data, upload.byteOffset);
+    for (const PendingUpload& upload : m_PendingIndexUploads)
+        renderContext.CopyDataToBuffer(m_IndexBuffer, upload.data, upload.byteOffset);
+
+    if (m_MeshTableDirty && !m_Meshes.empty())
+        renderContext.CopyDataToBuffer(m_MeshBuffer, m_Meshes);
+
+    m_PendingVertexUploads.clear();
+    m_PendingIndexUploads.clear();
+    m_PendingVertexCopies.clear();
+    m_PendingIndexCopies.clear();
+    m_MeshTableDirty = false;
+}
+
+UnifiedMeshMove& UnifiedGeometryBuffer::GetMove(std::vector<UnifiedMeshMove>& moves, uint32_t meshIndex)
+{
+    auto it = std::find_if(moves.begin(), moves.end(), [meshIndex](const UnifiedMeshMove& move) { return move.meshIndex == meshIndex; });
+    if (it != moves.end())
+        return *it;
+
+    return moves.emplace_back(UnifiedMeshMove{meshIndex, m_Meshes[meshIndex], m_Meshes[meshIndex]});
+}
+
+void UnifiedGeometryBuffer::MoveGeometry(const DefragmentationMove& move, bool vertices)
+{
+    uint32_t elementSize                  = vertices ? m_Desc.vertexStride : k_IndexSize;
+    std::vector<PendingUpload>& uploads   = vertices ? m_PendingVertexUploads : m_PendingIndexUploads;
+    std::vector<vk::BufferCopy>& copies   = vertices ? m_PendingVertexCopies : m_PendingIndexCopies;
+    MeshAllocation& allocation            = m_MeshAllocations[move.userData];
+    OffsetAllocator::Allocation& location = vertices ? allocation.vertices : allocation.indices;
+
+    // geometry that is not on the GPU yet is simply uploaded to the new place
+    bool uploadPending = false;
+    for (PendingUpload& upload : uploads)
+    {
+        if (upload.meshIndex == move.userData)
+        {
+            upload.byteOffset = move.to.offset * elementSize;
+            uploadPending     = true;
+        }
+    }
+
+    if (!uploadPending && !m_VertexBuffer.empty())
+        copies.emplace_back(move.from.offset * elementSize, move.to.offset * elementSize, move.size * elementSize);
+
+    location = move.to;
+    if (vertices)
+        m_Meshes[move.userData].vertexOffset = move.to.offset;
+    else
+        m_Meshes[move.userData].indexOffset = move.to.offset;
+
+    m_MovedGeometry.Retire(MovedAllocation{move.from, vertices});
+}
+
+std::vector<UnifiedMeshMove> UnifiedGeometryBuffer::Defragment(uint32_t byteBudget)
+{
+    std::vector<UnifiedMeshMove> moves;
+
+    // a second move before the copies ran would read from a place that was not written yet
+    if (m_DefragmentationPending == false || !m_PendingVertexCopies.empty() || !m_PendingIndexCopies.empty())
+        return moves;
+
+    std::vector<DefragmentationCandidate> candidates;
+    candidates.reserve(m_MeshCount);
+    for (uint32_t meshIndex = 0; meshIndex < m_MeshAllocations.size(); ++meshIndex)
+    {
+        if (m_MeshAllocations[meshIndex].used)
+            candidates.push_back({m_MeshAllocations[meshIndex].vertices, meshIndex});
+    }
+
+    uint32_t movedByteSize = 0;
+    for (const DefragmentationMove& move : PlanDefragmentation(m_VertexAllocator, candidates, byteBudget / m_Desc.vertexStride))
+    {
+        UnifiedMeshMove& meshMove = GetMove(moves, move.userData);
+        MoveGeometry(move, true);
+        meshMove.to = m_Meshes[move.userData];
+        movedByteSize += move.size * m_Desc.vertexStride;
+    }
+
+    for (DefragmentationCandidate& candidate : candidates)
+        candidate.allocation = m_MeshAllocations[candidate.userData].indices;
+
+    for (const DefragmentationMove& move : PlanDefragmentation(m_IndexAllocator, candidates, (byteBudget - movedByteSize) / k_IndexSize))
+    {
+        UnifiedMeshMove& meshMove = GetMove(moves, move.userData);
+        MoveGeometry(move, false);
+        meshMove.to = m_Meshes[move.userData];
+    }
+
+    m_MeshTableDirty |= !moves.empty();
+
+    // nothing fits further down until more is freed
+    m_DefragmentationPending = !moves.empty();
+
+    return moves;
+}
+
+void UnifiedGeometryBuffer::ReleaseMovedGeometry(uint64_t frameIndex, uint64_t completedFrameIndex)
+{
+    m_MovedGeometry.Collect(completedFrameIndex, [this](const MovedAllocation& moved)
+                            {
+                                (moved.vertices ? m_VertexAllocator : m_IndexAllocator).free(moved.allocation);
+                                m_DefragmentationPending = true;
+                            });
+    m_MovedGeometry.BeginFrame(frameIndex);
+}
+} // namespace gore::renderer
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Prefix.h"
+#include "Export.h"
+
+#include "Rendering/Buffer.h"
+#include "Rendering/GPUData/MeshData.h"
+#include "Rendering/Utils/GeometryUtils.h"
+
+#include "Rendering/ResourceRetirementRing.h"
+
+#include "Memory/OffsetAllocator.h"
+#include "Memory/OffsetAllocatorDefragmentation.h"
+
+#include <vector>
+
+namespace gore::gfx
+{
+class RenderContext;
+} // namespace gore::gfx
+
+namespace gore::renderer
+{
+using namespace gore::gfx;
+
+struct UnifiedGeometryBufferDesc
+{
+    // every mesh in the buffer shares the vertex layout of the pipelines that draw from it
+    uint32_t vertexStride   = 32;
+    uint32_t vertexCapacity = 1024 * 1024;
+    uint32_t indexCapacity  = 4 * 1024 * 1024;
+    uint32_t maxMeshCount   = 4096;
+};
+
+// Where the geometry of a mesh was and is after Defragment, the mesh index itself never changes
+struct UnifiedMeshMove
+{
+    uint32_t meshIndex = 0;
+    MeshData from      = {};
+    MeshData to        = {};
+};
+
+// One vertex buffer and one 32 bit index buffer holding the geometry of every mesh, plus the mesh buffer describing
+// where each mesh lives in them, see UGB.md. Meshes are sub-allocated with OffsetAllocator and referred to by their
+// index into the mesh buffer, which is what InstanceData::meshIndex points at.
+// Adding and removing meshes only touches CPU side bookkeeping, the new geometry is written to the GPU buffers by
+// FlushUploads, so everything but the upload works without a device.
+ENGINE_CLASS(UnifiedGeometryBuffer) final
+{
+    SINGLETON(UnifiedGeometryBuffer)
+
+public:
+    static constexpr uint32_t k_InvalidMesh = UINT32_MAX;
+
+    explicit UnifiedGeometryBuffer(const UnifiedGeometryBufferDesc& desc = {});
+    ~UnifiedGeometryBuffer();
+
+    // Returns k_InvalidMesh when the stride does not match, the index type is not supported or the buffers are full.
+    // 8 and 16 bit indices are widened, so all meshes can be drawn with one index buffer binding.
+    [[nodiscard]] uint32_t AddMesh(const void* vertexData, uint32_t vertexCount, uint32_t vertexStride, const void* indexData, uint32_t indexCount, IndexType indexType);
+    void RemoveMesh(uint32_t meshIndex);
+
+    [[nodiscard]] bool IsValidMesh(uint32_t meshIndex) const;
+    [[nodiscard]] const MeshData& GetMeshData(uint32_t meshIndex) const { return m_Meshes[meshIndex]; }
+    [[nodiscard]] uint32_t GetMeshCount() const { return m_MeshCount; }
+
+    [[nodiscard]] uint32_t GetVertexStride() const { return m_Desc.vertexStride; }
+    [[nodiscard]] uint32_t GetFreeVertexCount() const { return m_VertexAllocator.storageReport().totalFreeSpace; }
+    [[nodiscard]] uint32_t GetFreeIndexCount() const { return m_IndexAllocator.storageReport().totalFreeSpace; }
+
+    [[nodiscard]] bool HasPendingUploads() const { return !m_PendingVertexUploads.empty() || !m_PendingIndexUploads.empty() || !m_PendingVertexCopies.empty() || !m_PendingIndexCopies.empty() || m_MeshTableDirty; }
+    [[nodiscard]] size_t GetPendingUploadSize() const;
+
+    void CreateGPUBuffers(RenderContext& renderContext);
+    void DestroyGPUBuffers(RenderContext& renderContext);
+    // Writes the geometry added since the last flush and the mesh buffer if it changed
+    void FlushUploads(RenderContext& renderContext);
+
+    // Moves meshes from the top of the buffers into free space further down, copying at most byteBudget bytes, so
+    // the space of removed meshes grows back together. The mesh buffer is patched, meshes keep their index, so
+    // MeshRenderer::UnifiedMeshIndex and InstanceData::meshIndex stay valid. The returned moves are for anything else
+    // caching offsets. The copies happen in the next FlushUploads, a mesh moves at most once per flush.
+    // Returns nothing without planning anything until geometry was freed since the last call that moved nothing.
+    std::vector<UnifiedMeshMove> Defragment(uint32_t byteBudget);
+    // Once per frame like RenderContext::ReleaseRetiredResources, frees where moved meshes were once no frame in
+    // flight reads from there anymore
+    void ReleaseMovedGeometry(uint64_t frameIndex, uint64_t completedFrameIndex);
+    [[nodiscard]] uint32_t GetMovedGeometryCount() const { return m_MovedGeometry.GetPendingCount(); }
+
+    GETTER(BufferHandle, VertexBuffer)
+    GETTER(BufferHandle, IndexBuffer)
+    GETTER(BufferHandle, MeshBuffer)
+
+private:
+    struct MeshAllocation
+    {
+        OffsetAllocator::Allocation vertices;
+        OffsetAllocator::Allocation indices;
+        bool used = false;
+    };
+
+    struct PendingUpload
+    {
+        uint32_t meshIndex  = k_InvalidMesh;
+        uint32_t byteOffset = 0;
+        std::vector<uint8_t> data;
+    };
+
+    struct MovedAllocation
+    {
+        OffsetAllocator::Allocation allocation;
+        bool vertices = false;
+
+        [[nodiscard]] bool empty() const { return allocation.offset == OffsetAllocator::Allocation::NO_SPACE; }
+    };
+
+    static constexpr uint32_t k_MovedGeometrySlotCount = 8;
+
+    UnifiedMeshMove& GetMove(std::vector<UnifiedMeshMove>& moves, uint32_t meshIndex);
+    void MoveGeometry(const DefragmentationMove& move, bool vertices);
+
+    UnifiedGeometryBufferDesc m_Desc;
+
+    OffsetAllocator::Allocator m_VertexAllocator;
+    OffsetAllocator::Allocator m_IndexAllocator;
+
+    std::vector<MeshData> m_Meshes;
+    std::vector<MeshAllocation> m_MeshAllocations;
+    std::vector<uint32_t> m_FreeMeshSlots;
+    uint32_t m_MeshCount;
+
+    std::vector<PendingUpload> m_PendingVertexUploads;
+    std::vector<PendingUpload> m_PendingIndexUploads;
+    std::vector<vk::BufferCopy> m_PendingVertexCopies;
+    std::vector<vk::BufferCopy> m_PendingIndexCopies;
+    bool m_MeshTableDirty;
+    bool m_DefragmentationPending;
+
+    ResourceRetirementRing<k_MovedGeometrySlotCount, MovedAllocation> m_MovedGeometry;
+
+    BufferHandle m_VertexBuffer;
+    BufferHandle m_IndexBuffer;
+    BufferHandle m_MeshBuffer;
+};
+} // namespace gore::renderer
@@ -0,0 +1,148 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/UnifiedGeometryBuffer/UnifiedGeometryBuffer.h"
+
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::renderer;
+
+struct TestVertex
+{
+    float position[3];
+    float uv[2];
+    float normal[3];
+};
+
+TEST_CASE("Meshes are packed into the unified geometry buffer", "[UnifiedGeometryBuffer]")
+{
+    UnifiedGeometryBuffer geometryBuffer({.vertexStride = sizeof(TestVertex), .vertexCapacity = 1024, .indexCapacity = 4096, .maxMeshCount = 4});
+    REQUIRE(UnifiedGeometryBuffer::GetInstance() == &geometryBuffer);
+
+    std::vector<TestVertex> vertices(24);
+    std::vector<uint16_t> indices16(36);
+    std::vector<uint32_t> indices32(36);
+    for (uint32_t i = 0; i < 36; ++i)
+    {
+        indices16[i] = static_cast<uint16_t>(i % 24);
+        indices32[i] = i % 24;
+    }
+
+    uint32_t cube    = geometryBuffer.AddMesh(vertices.data(), 24, sizeof(TestVertex), indices16.data(), 36, IndexType::UINT16);
+    uint32_t another = geometryBuffer.AddMesh(vertices.data(), 24, sizeof(TestVertex), indices32.data(), 36, IndexType::UINT32);
+    REQUIRE(cube != UnifiedGeometryBuffer::k_InvalidMesh);
+    REQUIRE(another != UnifiedGeometryBuffer::k_InvalidMesh);
+    REQUIRE(geometryBuffer.GetMeshCount() == 2);
+
+    const MeshData& cubeData    = geometryBuffer.GetMeshData(cube);
+    const MeshData& anotherData = geometryBuffer.GetMeshData(another);
+    REQUIRE(cubeData.vertexCount == 24);
+    REQUIRE(cubeData.indexCount == 36);
+    REQUIRE((cubeData.vertexOffset + 24 <= anotherData.vertexOffset || anotherData.vertexOffset + 24 <= cubeData.vertexOffset));
+    REQUIRE((cubeData.indexOffset + 36 <= anotherData.indexOffset || anotherData.indexOffset + 36 <= cubeData.indexOffset));
+    REQUIRE(geometryBuffer.GetFreeVertexCount() == 1024 - 48);
+
+    // indices are widened to 32 bit, nothing is uploaded before the GPU buffers exist
+    REQUIRE(geometryBuffer.HasPendingUploads());
+    REQUIRE(geometryBuffer.GetPendingUploadSize() == 2 * (24 * sizeof(TestVertex) + 36 * sizeof(uint32_t)) + 2 * sizeof(MeshData));
+
+    SECTION("Meshes that do not fit are refused")
+    {
+        REQUIRE(geometryBuffer.AddMesh(vertices.data(), 24, sizeof(float), indices32.data(), 36, IndexType::UINT32) == UnifiedGeometryBuffer::k_InvalidMesh);
+        REQUIRE(geometryBuffer.AddMesh(vertices.data(), 24, sizeof(TestVertex), indices32.data(), 36, IndexType::None) == UnifiedGeometryBuffer::k_InvalidMesh);
+        REQUIRE(geometryBuffer.AddMesh(vertices.data(), 2048, sizeof(TestVertex), indices32.data(), 36, IndexType::UINT32) == UnifiedGeometryBuffer::k_InvalidMesh);
+
+        // a failed index allocation gives the vertices back
+        REQUIRE(geometryBuffer.AddMesh(vertices.data(), 24, sizeof(TestVertex), indices32.data(), 8192, IndexType::UINT32) == UnifiedGeometryBuffer::k_InvalidMesh);
+        REQUIRE(geometryBuffer.GetFreeVertexCount() == 1024 - 48);
+
+        REQUIRE(geometryBuffer.AddMesh(vertices.data(), 24, sizeof(TestVertex), indices32.data(), 36, IndexType::UINT32) != UnifiedGeometryBuffer::k_InvalidMesh);
+        REQUIRE(geometryBuffer.AddMesh(vertices.data(), 24, sizeof(TestVertex), indices32.data(), 36, IndexType::UINT32) != UnifiedGeometryBuffer::k_InvalidMesh);
+        REQUIRE(geometryBuffer.AddMesh(vertices.data(), 24, sizeof(TestVertex), indices32.data(), 36, IndexType::UINT32) == UnifiedGeometryBuffer::k_InvalidMesh);
+    }
+
+    SECTION("Removed meshes give their space and slot back")
+    {
+        geometryBuffer.RemoveMesh(cube);
+        REQUIRE(geometryBuffer.IsValidMesh(cube) == false);
+        REQUIRE(geometryBuffer.GetMeshData(cube).indexCount == 0);
+        REQUIRE(geometryBuffer.GetMeshCount() == 1);
+        REQUIRE(geometryBuffer.GetFreeVertexCount() == 1024 - 24);
+
+        // removing twice does nothing
+        geometryBuffer.RemoveMesh(cube);
+        REQUIRE(geometryBuffer.GetMeshCount() == 1);
+
+        uint32_t reused = geometryBuffer.AddMesh(vertices.data(), 24, sizeof(TestVertex), indices16.data(), 36, IndexType::UINT16);
+        REQUIRE(reused == cube);
+        REQUIRE(geometryBuffer.IsValidMesh(reused));
+    }
+}
+
+TEST_CASE("Defragmentation moves meshes down without changing their index", "[UnifiedGeometryBuffer]")
+{
+    UnifiedGeometryBuffer geometryBuffer({.vertexStride = sizeof(TestVertex), .vertexCapacity = 1024, .indexCapacity = 1024, .maxMeshCount = 4});
+
+    std::vector<TestVertex> vertices(128);
+    std::vector<uint32_t> indices(128);
+
+    uint32_t meshes[4];
+    for (uint32_t& mesh : meshes)
+        mesh = geometryBuffer.AddMesh(vertices.data(), 128, sizeof(TestVertex), indices.data(), 128, IndexType::UINT32);
+
+    // a gap at the bottom of both buffers
+    geometryBuffer.RemoveMesh(meshes[0]);
+    geometryBuffer.RemoveMesh(meshes[1]);
+    uint32_t pendingUploadSize = static_cast<uint32_t>(geometryBuffer.GetPendingUploadSize());
+
+    SECTION("Everything within the budget moves")
+    {
+        std::vector<UnifiedMeshMove> moves = geometryBuffer.Defragment(UINT32_MAX);
+        REQUIRE(moves.size() == 2);
+        for (const UnifiedMeshMove& move : moves)
+        {
+            REQUIRE((move.meshIndex == meshes[2] || move.meshIndex == meshes[3]));
+            REQUIRE(move.to.vertexOffset < move.from.vertexOffset);
+            REQUIRE(move.to.indexOffset < move.from.indexOffset);
+            REQUIRE(move.to.vertexOffset < 256);
+            REQUIRE(move.to.indexOffset < 256);
+
+            // the mesh buffer is patched in place, the geometry itself was not uploaded yet and goes to the new place
+            REQUIRE(geometryBuffer.GetMeshData(move.meshIndex).vertexOffset == move.to.vertexOffset);
+            REQUIRE(geometryBuffer.GetMeshData(move.meshIndex).vertexCount == 128);
+        }
+        REQUIRE(geometryBuffer.GetPendingUploadSize() == pendingUploadSize);
+
+        // the old places are only freed once no frame in flight can read them
+        REQUIRE(geometryBuffer.GetMovedGeometryCount() == 4);
+        REQUIRE(geometryBuffer.GetFreeVertexCount() == 1024 - 512);
+
+        // no frame is known to be done yet
+        geometryBuffer.ReleaseMovedGeometry(1, UINT64_MAX);
+        REQUIRE(geometryBuffer.GetFreeVertexCount() == 1024 - 512);
+
+        geometryBuffer.ReleaseMovedGeometry(2, 0);
+        REQUIRE(geometryBuffer.GetMovedGeometryCount() == 0);
+        REQUIRE(geometryBuffer.GetFreeVertexCount() == 1024 - 256);
+        REQUIRE(geometryBuffer.GetFreeIndexCount() == 1024 - 256);
+
+        // nothing is left to move
+        REQUIRE(geometryBuffer.Defragment(UINT32_MAX).empty());
+    }
+
+    SECTION("The budget limits the bytes moved")
+    {
+        std::vector<UnifiedMeshMove> moves = geometryBuffer.Defragment(128 * sizeof(TestVertex));
+        REQUIRE(moves.size() == 1);
+        REQUIRE(moves[0].meshIndex == meshes[3]);
+        REQUIRE(moves[0].to.vertexOffset < moves[0].from.vertexOffset);
+        REQUIRE(moves[0].to.indexOffset == moves[0].from.indexOffset);
+
+        REQUIRE(geometryBuffer.Defragment(0).empty());
+    }
+}
+
+} // namespace gore::test
+#endif
@@ -0,0 +1,185 @@
+#include "UploadRing.h"
+
+#include "Rendering/RenderContext.h"
+
+#include <cassert>
+
+namespace gore::gfx
+{
+static uint64_t AlignUp(uint64_t value, uint32_t alignment)
+{
+    return (value + alignment - 1) & ~static_cast<uint64_t>(alignment - 1);
+}
+
+UploadRing::UploadRing(RenderContext* renderContext, const UploadRingDesc& desc) :
+    m_RenderContext(renderContext),
+    m_Desc(desc),
+    m_Buffer(),
+    m_MappedData(nullptr),
+    m_CpuData(),
+    m_Head(0),
+    m_Tail(0),
+    m_FrameMarkers(),
+    m_Overflows(),
+    m_FrameByteSize(0)
+{
+    assert(desc.byteSize > 0);
+
+    if (m_RenderContext == nullptr)
+    {
+        m_CpuData    = std::make_unique<uint8_t[]>(desc.byteSize);
+        m_MappedData = m_CpuData.get();
+        return;
+    }
+
+    // mapped for as long as the ring lives, writing an allocation is a memcpy
+    m_Buffer = m_RenderContext->CreateBuffer({
+        .debugName = desc.debugName,
+        .byteSize  = desc.byteSize,
+        .usage     = BufferUsage::TransferSrc,
+        .memUsage  = MemoryUsage::CPU_TO_GPU,
+    });
+    m_MappedData = static_cast<uint8_t*>(MapVulkanBuffer(m_RenderContext->GetBuffer(m_Buffer)));
+}
+
+UploadRing::~UploadRing()
+{
+    ReleaseAll();
+
+    if (m_RenderContext != nullptr && m_Buffer.empty() == false)
+    {
+        UnmapVulkanBuffer(m_RenderContext->GetBuffer(m_Buffer));
+        m_RenderContext->DestroyBuffer(m_Buffer);
+    }
+}
+
+UploadAllocation UploadRing::Allocate(uint32_t byteSize, uint32_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    if (byteSize == 0)
+        return {};
+
+    const uint32_t capacity = m_Desc.byteSize;
+    if (byteSize > capacity)
+        return AllocateOverflow(byteSize);
+
+    // an allocation does not wrap around, what is left at the end of the ring is skipped
+    uint64_t head = AlignUp(m_Head, alignment);
+    if (head % capacity + byteSize > capacity)
+        head = (head / capacity + 1) * capacity;
+
+    if (head + byteSize - m_Tail > capacity)
+        return AllocateOverflow(byteSize);
+
+    m_Head = head + byteSize;
+    m_FrameByteSize += byteSize;
+
+    const uint32_t byteOffset = static_cast<uint32_t>(head % capacity);
+    return {
+        .data       = m_MappedData + byteOffset,
+        .buffer     = m_Buffer,
+        .byteOffset = byteOffset,
+        .byteSize   = byteSize,
+    };
+}
+
+UploadAllocation UploadRing::AllocateOverflow(uint32_t byteSize)
+{
+    Overflow& overflow = m_Overflows.emplace_back();
+    overflow.byteSize  = byteSize;
+    m_FrameByteSize += byteSize;
+
+    uint8_t* data = nullptr;
+    if (m_RenderContext == nullptr)
+    {
+        overflow.cpuData = std::make_unique<uint8_t[]>(byteSize);
+        data             = overflow.cpuData.get();
+    }
+    else
+    {
+        overflow.buffer = m_RenderContext->CreateBuffer({
+            .debugName = "UploadRing Overflow",
+            .byteSize  = byteSize,
+            .usage     = BufferUsage::TransferSrc,
+            .memUsage  = MemoryUsage::CPU_TO_GPU,
+        });
+        data = static_cast<uint8_t*>(MapVulkanBuffer(m_RenderContext->GetBuffer(overflow.buffer)));
+    }
+
+    return {
+        .data       = data,
+        .buffer     = overflow.buffer,
+        .byteOffset = 0,
+        .byteSize   = byteSize,
+    };
+}
+
+void UploadRing::DestroyOverflow(Overflow& overflow)
+{
+    if (m_RenderContext == nullptr || overflow.buffer.empty())
+        return;
+
+    UnmapVulkanBuffer(m_RenderContext->GetBuffer(overflow.buffer));
+    m_RenderContext->DestroyBuffer(overflow.buffer);
+}
+
+void UploadRing::Flush()
+{
+    if (m_RenderContext == nullptr)
+        return;
+
+    // a no-op on host coherent memory
+    FlushVulkanBuffer(m_RenderContext->GetBuffer(m_Buffer), m_Desc.byteSize);
+    for (const Overflow& overflow : m_Overflows)
+    {
+        if (overflow.frameIndex == k_NoFrame)
+            FlushVulkanBuffer(m_RenderContext->GetBuffer(overflow.buffer), overflow.byteSize);
+    }
+}
+
+void UploadRing::EndFrame(uint64_t frameIndex)
+{
+    if (m_FrameMarkers.empty() || m_FrameMarkers.back().head != m_Head)
+        m_FrameMarkers.push_back({frameIndex, m_Head});
+
+    for (Overflow& overflow : m_Overflows)
+    {
+        if (overflow.frameIndex == k_NoFrame)
+            overflow.frameIndex = frameIndex;
+    }
+
+    m_FrameByteSize = 0;
+}
+
+void UploadRing::Release(uint64_t completedFrameIndex)
+{
+    if (completedFrameIndex == k_NoFrame)
+        return;
+
+    while (!m_FrameMarkers.empty() && m_FrameMarkers.front().frameIndex <= completedFrameIndex)
+    {
+        m_Tail = m_FrameMarkers.front().head;
+        m_FrameMarkers.pop_front();
+    }
+
+    std::erase_if(m_Overflows, [this, completedFrameIndex](Overflow& overflow)
+    {
+        if (overflow.frameIndex > completedFrameIndex)
+            return false;
+
+        DestroyOverflow(overflow);
+        return true;
+    });
+}
+
+void UploadRing::ReleaseAll()
+{
+    m_Tail = m_Head;
+    m_FrameMarkers.clear();
+
+    for (Overflow& overflow : m_Overflows)
+        DestroyOverflow(overflow);
+    m_Overflows.clear();
+}
+} // namespace gore::gfx
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Prefix.h"
+#include "Export.h"
+
+#include "Rendering/Buffer.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace gore::gfx
+{
+class RenderContext;
+
+struct UploadRingDesc final
+{
+    const char* debugName = "Noname UploadRing";
+    uint32_t byteSize     = 16 * 1024 * 1024;
+};
+
+// Where the data of a copy is written before it is recorded, byteOffset is the place of data in buffer
+struct UploadAllocation final
+{
+    uint8_t* data       = nullptr;
+    BufferHandle buffer = {};
+    uint32_t byteOffset = 0;
+    uint32_t byteSize   = 0;
+
+    [[nodiscard]] bool empty() const { return data == nullptr; }
+};
+
+// Hands out staging memory for the copies of a frame from one persistently mapped buffer that is used as a ring.
+// Allocations are only given back once the GPU finished the frame they were copied in, so the ring never waits
+// for the GPU. When the frames in flight hold on to the whole ring, an allocation gets a staging buffer of its own
+// that is released with its frame the same way. Without a render context the ring is CPU memory, the bookkeeping
+// works the same.
+ENGINE_CLASS(UploadRing) final
+{
+public:
+    static constexpr uint64_t k_NoFrame          = UINT64_MAX;
+    static constexpr uint32_t k_DefaultAlignment = 16;
+
+    UploadRing(RenderContext* renderContext, const UploadRingDesc& desc);
+    ~UploadRing();
+
+    NON_COPYABLE(UploadRing);
+
+    // alignment has to be a power of two, the allocation is empty when byteSize is 0
+    [[nodiscard]] UploadAllocation Allocate(uint32_t byteSize, uint32_t alignment = k_DefaultAlignment);
+    // Makes what was written since the last EndFrame visible to the GPU, before the copies reading it are submitted
+    void Flush();
+    // Everything allocated since the last EndFrame is read by the copies submitted with frameIndex
+    void EndFrame(uint64_t frameIndex);
+    // completedFrameIndex is the last frame the GPU is done with, k_NoFrame if there is none yet
+    void Release(uint64_t completedFrameIndex);
+    // Only when the GPU is idle
+    void ReleaseAll();
+
+    [[nodiscard]] const UploadRingDesc& GetDesc() const { return m_Desc; }
+    [[nodiscard]] uint32_t GetUsedByteSize() const { return static_cast<uint32_t>(m_Head - m_Tail); }
+    [[nodiscard]] uint32_t GetOverflowCount() const { return static_cast<uint32_t>(m_Overflows.size()); }
+    // Bytes allocated since the last EndFrame, overflows included
+    [[nodiscard]] uint32_t GetFrameByteSize() const { return m_FrameByteSize; }
+
+private:
+    struct FrameMarker
+    {
+        uint64_t frameIndex = k_NoFrame;
+        uint64_t head       = 0;
+    };
+
+    struct Overflow
+    {
+        uint64_t frameIndex = k_NoFrame;
+        BufferHandle buffer = {};
+        uint32_t byteSize   = 0;
+        std::unique_ptr<uint8_t[]> cpuData;
+    };
+
+    UploadAllocation AllocateOverflow(uint32_t byteSize);
+    void DestroyOverflow(Overflow& overflow);
+
+    RenderContext* m_RenderContext;
+    UploadRingDesc m_Desc;
+
+    BufferHandle m_Buffer;
+    uint8_t* m_MappedData;
+    std::unique_ptr<uint8_t[]> m_CpuData;
+
+    // only grow, the offset in the ring is the remainder of the capacity
+    uint64_t m_Head;
+    uint64_t m_Tail;
+    std::deque<FrameMarker> m_FrameMarkers;
+    std::vector<Overflow> m_Overflows;
+
+    uint32_t m_FrameByteSize;
+};
+} // namespace gore::gfx
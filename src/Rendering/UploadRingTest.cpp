@@ -0,0 +1,136 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/UploadRing.h"
+
+#include <cstring>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::gfx;
+
+TEST_CASE("Upload allocations come from the ring until frames hold on to all of it", "[UploadRing]")
+{
+    UploadRing ring(nullptr, {.byteSize = 1024});
+
+    UploadAllocation constants = ring.Allocate(100);
+    UploadAllocation vertices  = ring.Allocate(200, 64);
+    UploadAllocation empty     = ring.Allocate(0);
+    REQUIRE(constants.empty() == false);
+    REQUIRE(vertices.empty() == false);
+    REQUIRE(empty.empty());
+
+    REQUIRE(constants.byteOffset == 0);
+    REQUIRE(vertices.byteOffset == 128);
+    REQUIRE(vertices.data == constants.data + 128);
+    REQUIRE(ring.GetUsedByteSize() == 328);
+    REQUIRE(ring.GetFrameByteSize() == 300);
+
+    // the memory can be written right away
+    std::memset(vertices.data, 0xff, vertices.byteSize);
+
+    ring.EndFrame(0);
+    REQUIRE(ring.GetFrameByteSize() == 0);
+
+    SECTION("Allocations do not wrap around the end of the ring")
+    {
+        UploadAllocation middle = ring.Allocate(600);
+        REQUIRE(middle.byteOffset == 336);
+        ring.EndFrame(1);
+
+        // frame 0 is done, its space at the start is reused while frame 1 still reads the middle
+        ring.Release(0);
+        UploadAllocation wrapped = ring.Allocate(200);
+        REQUIRE(wrapped.byteOffset == 0);
+        REQUIRE(ring.GetOverflowCount() == 0);
+    }
+
+    SECTION("Space is only given back once its frame is done")
+    {
+        UploadAllocation rest = ring.Allocate(1024 - 336);
+        REQUIRE(rest.byteOffset == 336);
+        ring.EndFrame(1);
+
+        ring.Release(UploadRing::k_NoFrame);
+        REQUIRE(ring.GetUsedByteSize() == 1024);
+
+        ring.Release(0);
+        REQUIRE(ring.GetUsedByteSize() == 1024 - 328);
+
+        ring.Release(1);
+        REQUIRE(ring.GetUsedByteSize() == 0);
+        REQUIRE(ring.Allocate(1024).byteOffset == 0);
+    }
+
+    SECTION("A full ring hands out staging memory of its own")
+    {
+        UploadAllocation overflow = ring.Allocate(800);
+        REQUIRE(overflow.empty() == false);
+        REQUIRE(ring.GetOverflowCount() == 1);
+        REQUIRE(ring.GetUsedByteSize() == 328);
+
+        UploadAllocation huge = ring.Allocate(4096);
+        REQUIRE(huge.byteSize == 4096);
+        REQUIRE(ring.GetOverflowCount() == 2);
+        std::memset(huge.data, 0, huge.byteSize);
+
+        ring.EndFrame(1);
+        ring.Release(0);
+        REQUIRE(ring.GetOverflowCount() == 2);
+
+        ring.Release(1);
+        REQUIRE(ring.GetOverflowCount() == 0);
+    }
+}
+
+TEST_CASE("Upload allocations of frames in flight never overlap", "[UploadRing]")
+{
+    UploadRing ring(nullptr, {.byteSize = 64 * 1024});
+
+    struct Written
+    {
+        uint64_t frameIndex;
+        UploadAllocation allocation;
+        uint8_t value;
+    };
+
+    // three frames in flight, every allocation keeps its bytes until its frame is released
+    std::vector<Written> inFlight;
+    for (uint64_t frameIndex = 0; frameIndex < 200; ++frameIndex)
+    {
+        for (uint32_t i = 0; i < 1 + frameIndex % 7; ++i)
+        {
+            uint32_t byteSize = 1 + static_cast<uint32_t>((frameIndex * 7919 + i * 104729) % 9000);
+            uint8_t value     = static_cast<uint8_t>(frameIndex * 31 + i);
+
+            UploadAllocation allocation = ring.Allocate(byteSize, 4u << (i % 4));
+            REQUIRE(allocation.empty() == false);
+            REQUIRE(allocation.byteOffset % (4u << (i % 4)) == 0);
+            std::memset(allocation.data, value, byteSize);
+            inFlight.push_back({frameIndex, allocation, value});
+        }
+        ring.EndFrame(frameIndex);
+
+        uint64_t completedFrameIndex = frameIndex >= 3 ? frameIndex - 3 : UploadRing::k_NoFrame;
+        for (const Written& written : inFlight)
+        {
+            if (completedFrameIndex != UploadRing::k_NoFrame && written.frameIndex <= completedFrameIndex)
+                continue;
+
+            for (uint32_t byte = 0; byte < written.allocation.byteSize; ++byte)
+                REQUIRE(written.allocation.data[byte] == written.value);
+        }
+
+        ring.Release(completedFrameIndex);
+        std::erase_if(inFlight, [completedFrameIndex](const Written& written)
+                      { return completedFrameIndex != UploadRing::k_NoFrame && written.frameIndex <= completedFrameIndex; });
+    }
+
+    ring.ReleaseAll();
+    REQUIRE(ring.GetUsedByteSize() == 0);
+    REQUIRE(ring.GetOverflowCount() == 0);
+}
+
+} // namespace gore::test
+#endif
@@ -2,6 +2,10 @@
 
 #include "Math/Types.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 int gore::gfx::CalculateShaderChannelsByteStrideSize(uint8_t channels)
 {
     const int k_PositionSize = sizeof(Vector3);
@@ -63,3 +67,36 @@ int gore::gfx::CalculateIndexBufferSize(IndexType indexType, uint32_t indexCount
 {
     return GetIndexTypeSize(indexType) * indexCount;
 }
+
+bool gore::gfx::NarrowIndices(MeshData& meshData)
+{
+    if (meshData.indexType != IndexType::UINT32)
+        return false;
+
+    // the indices of a sub-mesh count from its own first vertex
+    size_t largestVertexCount = meshData.vertices.size();
+    if (meshData.subMeshes.empty() == false)
+    {
+        largestVertexCount = 0;
+        for (const renderer::SubMesh& subMesh : meshData.subMeshes)
+            largestVertexCount = std::max<size_t>(largestVertexCount, subMesh.vertexCount);
+    }
+
+    if (largestVertexCount > std::numeric_limits<uint16_t>::max())
+        return false;
+
+    // in place, every 16 bit index is written at or before the 32 bit one it is read from
+    uint8_t* indexData = meshData.indices.data();
+    for (uint32_t i = 0; i < meshData.indexCount; ++i)
+    {
+        uint32_t index;
+        std::memcpy(&index, indexData + i * sizeof(uint32_t), sizeof(uint32_t));
+
+        uint16_t narrowIndex = static_cast<uint16_t>(index);
+        std::memcpy(indexData + i * sizeof(uint16_t), &narrowIndex, sizeof(uint16_t));
+    }
+
+    meshData.indices.resize(meshData.indexCount * sizeof(uint16_t));
+    meshData.indexType = IndexType::UINT16;
+    return true;
+}
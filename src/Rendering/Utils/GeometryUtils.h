@@ -6,8 +6,11 @@
 #include "Math/Vector4.h"
 #include <stdint.h>
 #include <assert.h>
+#include <span>
+#include <vector>
 
 #include "Rendering/GraphicsFormat.h"
+#include "Rendering/Components/SubMesh.h"
 
 namespace gore::gfx
 {
@@ -87,6 +90,33 @@ int CalculateShaderChannelsByteStrideSize(uint8_t channels);
 int CalculateVertexBufferSize(uint8_t channels, uint32_t vertexCount);
 int CalculateIndexBufferSize(IndexType indexType, uint32_t indexCount);
 
+// What the upload path reads a mesh from, wherever it lives on the CPU
+struct MeshDataView final
+{
+    std::span<const Vertex> vertices;
+    std::span<const uint8_t> indices;
+    IndexType indexType = IndexType::None;
+    uint32_t indexCount = 0;
+    std::span<const renderer::SubMesh> subMeshes;
+};
+
+// A mesh as it is on the CPU before it is copied to the GPU, indices are 16 or 32 bit. The indices of a sub-mesh
+// count from its own first vertex.
+struct MeshData final
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint8_t> indices;
+    IndexType indexType = IndexType::None;
+    uint32_t indexCount = 0;
+    std::vector<renderer::SubMesh> subMeshes;
+
+    [[nodiscard]] MeshDataView GetView() const { return {vertices, indices, indexType, indexCount, subMeshes}; }
+};
+
+// Turns 32 bit indices into 16 bit ones, which halves the index bandwidth of every draw, when the vertices they count
+// from fit: those of each sub-mesh, or all of them for a mesh without sub-meshes. Returns whether it did.
+bool NarrowIndices(MeshData& meshData);
+
 enum class PrimitiveType : uint8_t
 {
     Triangle,
@@ -0,0 +1,70 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/Utils/GeometryUtils.h"
+
+#include <cstring>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::gfx;
+
+static MeshData MakeMeshData(uint32_t vertexCount, const std::vector<uint32_t>& indices)
+{
+    MeshData meshData;
+    meshData.vertices.resize(vertexCount, Vertex{k_DefaultPosition, k_DefaultNormal, k_DefaultUV});
+    meshData.indexType  = IndexType::UINT32;
+    meshData.indexCount = static_cast<uint32_t>(indices.size());
+    meshData.indices.resize(indices.size() * sizeof(uint32_t));
+    std::memcpy(meshData.indices.data(), indices.data(), meshData.indices.size());
+    return meshData;
+}
+
+static uint16_t GetIndex16(const MeshData& meshData, size_t i)
+{
+    uint16_t index;
+    std::memcpy(&index, meshData.indices.data() + i * sizeof(uint16_t), sizeof(index));
+    return index;
+}
+
+TEST_CASE("32 bit indices are narrowed when their vertices fit in 16 bit", "[GeometryUtils]")
+{
+    SECTION("Small meshes")
+    {
+        MeshData meshData = MakeMeshData(65535, {0, 1, 2, 65534, 3, 1});
+        REQUIRE(NarrowIndices(meshData));
+        REQUIRE(meshData.indexType == IndexType::UINT16);
+        REQUIRE(meshData.indexCount == 6);
+        REQUIRE(meshData.indices.size() == 6 * sizeof(uint16_t));
+        REQUIRE(GetIndex16(meshData, 2) == 2);
+        REQUIRE(GetIndex16(meshData, 3) == 65534);
+        REQUIRE(GetIndex16(meshData, 5) == 1);
+
+        // already 16 bit
+        REQUIRE(NarrowIndices(meshData) == false);
+    }
+
+    SECTION("Large meshes keep their 32 bit indices")
+    {
+        MeshData meshData = MakeMeshData(70000, {0, 69999, 1});
+        REQUIRE(NarrowIndices(meshData) == false);
+        REQUIRE(meshData.indexType == IndexType::UINT32);
+        REQUIRE(meshData.indices.size() == 3 * sizeof(uint32_t));
+    }
+
+    SECTION("Sub-meshes count from their own first vertex")
+    {
+        MeshData meshData  = MakeMeshData(70000, {0, 1, 2, 0, 2, 1});
+        meshData.subMeshes = {{0, 35000, 0, 3}, {35000, 35000, 3, 3}};
+        REQUIRE(NarrowIndices(meshData));
+        REQUIRE(meshData.indexType == IndexType::UINT16);
+        REQUIRE(GetIndex16(meshData, 4) == 2);
+
+        MeshData largeSubMesh  = MakeMeshData(70000, {0, 1, 2});
+        largeSubMesh.subMeshes = {{0, 70000, 0, 3}};
+        REQUIRE(NarrowIndices(largeSubMesh) == false);
+    }
+}
+} // namespace gore::test
+#endif
@@ -0,0 +1,458 @@
+#include "VertexLayout.h"
+
+#include "Rendering/GraphicsPipelineDesc.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace gore::gfx
+{
+static uint32_t GetPositionByteSize(PositionEncoding encoding)
+{
+    return encoding == PositionEncoding::Unorm16 ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+}
+
+static uint32_t GetDirectionByteSize(DirectionEncoding encoding)
+{
+    switch (encoding)
+    {
+        case DirectionEncoding::Octahedral16:
+            return 2 * sizeof(int16_t);
+        case DirectionEncoding::Packed1010102:
+            return sizeof(uint32_t);
+        default:
+            return 3 * sizeof(float);
+    }
+}
+
+static uint32_t GetUVByteSize(UVEncoding encoding)
+{
+    return encoding == UVEncoding::Float16 ? 2 * sizeof(uint16_t) : 2 * sizeof(float);
+}
+
+static GraphicsFormat GetPositionFormat(PositionEncoding encoding)
+{
+    return encoding == PositionEncoding::Unorm16 ? GraphicsFormat::RGBA16_UNORM : GraphicsFormat::RGB32_FLOAT;
+}
+
+static GraphicsFormat GetDirectionFormat(DirectionEncoding encoding)
+{
+    switch (encoding)
+    {
+        case DirectionEncoding::Octahedral16:
+            return GraphicsFormat::RG16_SNORM;
+        case DirectionEncoding::Packed1010102:
+            return GraphicsFormat::RGB10A2_UNORM;
+        default:
+            return GraphicsFormat::RGB32_FLOAT;
+    }
+}
+
+static GraphicsFormat GetUVFormat(UVEncoding encoding)
+{
+    return encoding == UVEncoding::Float16 ? GraphicsFormat::RG16_FLOAT : GraphicsFormat::RG32_FLOAT;
+}
+
+VertexLayout CreateVertexLayout(ShaderChannel channels, const VertexCompressionDesc& compression)
+{
+    VertexLayout layout;
+    layout.channels    = channels;
+    layout.compression = compression;
+
+    // every attribute is a multiple of 4 bytes, so they stay 4 byte aligned
+    uint32_t byteOffset = 0;
+    if (HasFlag(channels, ShaderChannel::Position))
+    {
+        layout.positionOffset = byteOffset;
+        byteOffset += GetPositionByteSize(compression.position);
+    }
+
+    if (HasFlag(channels, ShaderChannel::Normal))
+    {
+        layout.normalOffset = byteOffset;
+        byteOffset += GetDirectionByteSize(compression.normal);
+    }
+
+    if (HasFlag(channels, ShaderChannel::UV0))
+    {
+        layout.uvOffset = byteOffset;
+        byteOffset += GetUVByteSize(compression.uv);
+    }
+
+    layout.byteStride = byteOffset;
+    return layout;
+}
+
+bool VertexLayout::IsVertex() const
+{
+    return channels == ShaderChannel::Default
+        && compression.position == PositionEncoding::Float32
+        && compression.normal == DirectionEncoding::Float32
+        && compression.uv == UVEncoding::Float32;
+}
+
+VertexBufferBinding VertexLayout::GetVertexBufferBinding() const
+{
+    VertexBufferBinding binding;
+    binding.byteStride = byteStride;
+
+    if (HasFlag(channels, ShaderChannel::Position))
+        binding.attributes.push_back({.byteOffset = positionOffset, .format = GetPositionFormat(compression.position)});
+
+    if (HasFlag(channels, ShaderChannel::UV0))
+        binding.attributes.push_back({.byteOffset = uvOffset, .format = GetUVFormat(compression.uv)});
+
+    if (HasFlag(channels, ShaderChannel::Normal))
+        binding.attributes.push_back({.byteOffset = normalOffset, .format = GetDirectionFormat(compression.normal)});
+
+    return binding;
+}
+
+// Rounds to nearest even, values too large for a half become infinity
+static uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign        = (bits >> 16) & 0x8000;
+    uint32_t exponent    = (bits >> 23) & 0xFF;
+    uint32_t mantissa    = bits & 0x7FFFFF;
+    int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+
+    if (exponent == 0xFF)
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+
+    if (halfExponent >= 31)
+        return static_cast<uint16_t>(sign | 0x7C00);
+
+    if (halfExponent <= 0)
+    {
+        // subnormal half, or zero below its smallest value
+        if (halfExponent < -10)
+            return static_cast<uint16_t>(sign);
+
+        mantissa |= 0x800000;
+        uint32_t shift   = static_cast<uint32_t>(14 - halfExponent);
+        uint32_t half    = mantissa >> shift;
+        uint32_t rest    = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1) != 0))
+            ++half;
+
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // a mantissa that rounds up past its largest value carries into the exponent, which is the right result
+    uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1) != 0))
+        ++half;
+
+    return static_cast<uint16_t>(sign | half);
+}
+
+static float HalfToFloat(uint16_t half)
+{
+    uint32_t sign     = static_cast<uint32_t>(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+
+    if (exponent == 0)
+    {
+        float value = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign != 0 ? -value : value;
+    }
+
+    uint32_t bits = exponent == 31 ? sign | 0x7F800000 | (mantissa << 13)
+                                   : sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int16_t FloatToSnorm16(float value)
+{
+    return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static float Snorm16ToFloat(int16_t value)
+{
+    return std::max(value / 32767.0f, -1.0f);
+}
+
+static float SignNotZero(float value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+// The direction is projected on the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper one
+static void EncodeOctahedral(const Vector3& direction, int16_t encoded[2])
+{
+    float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (length == 0.0f)
+    {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+
+    float x = direction.x / length;
+    float y = direction.y / length;
+    if (direction.z < 0.0f)
+    {
+        float foldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+        float foldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+        x             = foldedX;
+        y             = foldedY;
+    }
+
+    encoded[0] = FloatToSnorm16(x);
+    encoded[1] = FloatToSnorm16(y);
+}
+
+static Vector3 DecodeOctahedral(const int16_t encoded[2])
+{
+    float x = Snorm16ToFloat(encoded[0]);
+    float y = Snorm16ToFloat(encoded[1]);
+    float z = 1.0f - std::abs(x) - std::abs(y);
+
+    float fold = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -fold : fold;
+    y += y >= 0.0f ? -fold : fold;
+
+    float length = std::sqrt(x * x + y * y + z * z);
+    return length > 0.0f ? Vector3(x / length, y / length, z / length) : k_DefaultNormal;
+}
+
+// x in bits 0-9, y in 10-19, z in 20-29, the 2 bits of w stay 0 for normals
+static uint32_t EncodePacked1010102(const Vector3& direction)
+{
+    auto encode = [](float value)
+    {
+        return static_cast<uint32_t>(std::round(std::clamp(value * 0.5f + 0.5f, 0.0f, 1.0f) * 1023.0f));
+    };
+
+    return encode(direction.x) | (encode(direction.y) << 10) | (encode(direction.z) << 20);
+}
+
+static Vector3 DecodePacked1010102(uint32_t encoded)
+{
+    auto decode = [](uint32_t value)
+    {
+        return (value & 0x3FF) / 1023.0f * 2.0f - 1.0f;
+    };
+
+    return Vector3(decode(encoded), decode(encoded >> 10), decode(encoded >> 20));
+}
+
+PackedVertices PackVertices(std::span<const Vertex> vertices, const VertexLayout& layout)
+{
+    PackedVertices packedVertices;
+    packedVertices.vertexCount = static_cast<uint32_t>(vertices.size());
+    packedVertices.data.resize(vertices.size() * layout.byteStride);
+
+    if (layout.IsVertex())
+    {
+        if (vertices.empty() == false)
+            std::memcpy(packedVertices.data.data(), vertices.data(), vertices.size_bytes());
+
+        return packedVertices;
+    }
+
+    bool hasPosition = HasFlag(layout.channels, ShaderChannel::Position);
+    bool hasNormal   = HasFlag(layout.channels, ShaderChannel::Normal);
+    bool hasUV       = HasFlag(layout.channels, ShaderChannel::UV0);
+
+    // quantized positions span the bounds of the mesh, an axis without extent is all 0
+    float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+    float extent[3]    = {0.0f, 0.0f, 0.0f};
+    bool quantize      = hasPosition && layout.compression.position == PositionEncoding::Unorm16 && vertices.empty() == false;
+    if (quantize)
+    {
+        float boundsMax[3] = {vertices[0].position.x, vertices[0].position.y, vertices[0].position.z};
+        boundsMin[0]       = boundsMax[0];
+        boundsMin[1]       = boundsMax[1];
+        boundsMin[2]       = boundsMax[2];
+
+        for (const Vertex& vertex : vertices)
+        {
+            const float position[3] = {vertex.position.x, vertex.position.y, vertex.position.z};
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                boundsMin[axis] = std::min(boundsMin[axis], position[axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], position[axis]);
+            }
+        }
+
+        for (int axis = 0; axis < 3; ++axis)
+            extent[axis] = boundsMax[axis] - boundsMin[axis];
+
+        // the shader reads unorm attributes as 0 to 1
+        packedVertices.positionScale  = Vector3(extent[0], extent[1], extent[2]);
+        packedVertices.positionOffset = Vector3(boundsMin[0], boundsMin[1], boundsMin[2]);
+    }
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        const Vertex& vertex = vertices[i];
+        uint8_t* packed      = packedVertices.data.data() + i * layout.byteStride;
+
+        if (hasPosition && quantize)
+        {
+            const float position[3] = {vertex.position.x, vertex.position.y, vertex.position.z};
+
+            uint16_t encoded[4] = {0, 0, 0, 0};
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                float normalized = extent[axis] > 0.0f ? (position[axis] - boundsMin[axis]) / extent[axis] : 0.0f;
+                encoded[axis]    = static_cast<uint16_t>(std::round(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f));
+            }
+
+            std::memcpy(packed + layout.positionOffset, encoded, sizeof(encoded));
+        }
+        else if (hasPosition)
+        {
+            const float position[3] = {vertex.position.x, vertex.position.y, vertex.position.z};
+            std::memcpy(packed + layout.positionOffset, position, sizeof(position));
+        }
+
+        if (hasNormal)
+        {
+            switch (layout.compression.normal)
+            {
+                case DirectionEncoding::Octahedral16:
+                {
+                    int16_t encoded[2];
+                    EncodeOctahedral(vertex.normal, encoded);
+                    std::memcpy(packed + layout.normalOffset, encoded, sizeof(encoded));
+                    break;
+                }
+                case DirectionEncoding::Packed1010102:
+                {
+                    uint32_t encoded = EncodePacked1010102(vertex.normal);
+                    std::memcpy(packed + layout.normalOffset, &encoded, sizeof(encoded));
+                    break;
+                }
+                default:
+                {
+                    const float normal[3] = {vertex.normal.x, vertex.normal.y, vertex.normal.z};
+                    std::memcpy(packed + layout.normalOffset, normal, sizeof(normal));
+                    break;
+                }
+            }
+        }
+
+        if (hasUV)
+        {
+            if (layout.compression.uv == UVEncoding::Float16)
+            {
+                const uint16_t uv[2] = {FloatToHalf(vertex.uv.x), FloatToHalf(vertex.uv.y)};
+                std::memcpy(packed + layout.uvOffset, uv, sizeof(uv));
+            }
+            else
+            {
+                const float uv[2] = {vertex.uv.x, vertex.uv.y};
+                std::memcpy(packed + layout.uvOffset, uv, sizeof(uv));
+            }
+        }
+    }
+
+    return packedVertices;
+}
+
+std::vector<Vertex> UnpackVertices(const PackedVertices& packedVertices, const VertexLayout& layout)
+{
+    std::vector<Vertex> vertices(packedVertices.vertexCount, Vertex{k_DefaultPosition, k_DefaultNormal, k_DefaultUV});
+
+    if (layout.IsVertex())
+    {
+        if (vertices.empty() == false)
+            std::memcpy(vertices.data(), packedVertices.data.data(), vertices.size() * sizeof(Vertex));
+
+        return vertices;
+    }
+
+    const float scale[3]  = {packedVertices.positionScale.x, packedVertices.positionScale.y, packedVertices.positionScale.z};
+    const float offset[3] = {packedVertices.positionOffset.x, packedVertices.positionOffset.y, packedVertices.positionOffset.z};
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        Vertex& vertex        = vertices[i];
+        const uint8_t* packed = packedVertices.data.data() + i * layout.byteStride;
+
+        if (HasFlag(layout.channels, ShaderChannel::Position))
+        {
+            float position[3];
+            if (layout.compression.position == PositionEncoding::Unorm16)
+            {
+                uint16_t encoded[4];
+                std::memcpy(encoded, packed + layout.positionOffset, sizeof(encoded));
+                for (int axis = 0; axis < 3; ++axis)
+                    position[axis] = encoded[axis] / 65535.0f * scale[axis] + offset[axis];
+            }
+            else
+            {
+                std::memcpy(position, packed + layout.positionOffset, sizeof(position));
+            }
+
+            vertex.position = Vector3(position[0], position[1], position[2]);
+        }
+
+        if (HasFlag(layout.channels, ShaderChannel::Normal))
+        {
+            switch (layout.compression.normal)
+            {
+                case DirectionEncoding::Octahedral16:
+                {
+                    int16_t encoded[2];
+                    std::memcpy(encoded, packed + layout.normalOffset, sizeof(encoded));
+                    vertex.normal = DecodeOctahedral(encoded);
+                    break;
+                }
+                case DirectionEncoding::Packed1010102:
+                {
+                    uint32_t encoded;
+                    std::memcpy(&encoded, packed + layout.normalOffset, sizeof(encoded));
+                    vertex.normal = DecodePacked1010102(encoded);
+                    break;
+                }
+                default:
+                {
+                    float normal[3];
+                    std::memcpy(normal, packed + layout.normalOffset, sizeof(normal));
+                    vertex.normal = Vector3(normal[0], normal[1], normal[2]);
+                    break;
+                }
+            }
+        }
+
+        if (HasFlag(layout.channels, ShaderChannel::UV0))
+        {
+            if (layout.compression.uv == UVEncoding::Float16)
+            {
+                uint16_t uv[2];
+                std::memcpy(uv, packed + layout.uvOffset, sizeof(uv));
+                vertex.uv = Vector2(HalfToFloat(uv[0]), HalfToFloat(uv[1]));
+            }
+            else
+            {
+                float uv[2];
+                std::memcpy(uv, packed + layout.uvOffset, sizeof(uv));
+                vertex.uv = Vector2(uv[0], uv[1]);
+            }
+        }
+    }
+
+    return vertices;
+}
+
+VertexCompressionStats GetVertexCompressionStats(uint32_t vertexCount, const VertexLayout& layout)
+{
+    return {
+        .vertexByteSize = static_cast<uint64_t>(vertexCount) * sizeof(Vertex),
+        .packedByteSize = static_cast<uint64_t>(vertexCount) * layout.byteStride,
+    };
+}
+} // namespace gore::gfx
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Prefix.h"
+
+#include "Math/Vector3.h"
+#include "Rendering/Utils/GeometryUtils.h"
+
+#include <span>
+#include <vector>
+
+namespace gore::gfx
+{
+struct VertexBufferBinding;
+
+enum class PositionEncoding : uint8_t
+{
+    Float32,
+    // 16 bit per axis between the bounds of the mesh, PackedVertices has the scale and offset back
+    Unorm16,
+};
+
+// Normals and tangents
+enum class DirectionEncoding : uint8_t
+{
+    Float32,
+    // two snorm16 on the octahedron, the shader decodes them with DecodeOctahedral
+    Octahedral16,
+    // 10:10:10:2 unorm of direction * 0.5 + 0.5
+    Packed1010102,
+};
+
+enum class UVEncoding : uint8_t
+{
+    Float32,
+    Float16,
+};
+
+// Nothing is compressed by default, vertices are then stored exactly as Vertex
+struct VertexCompressionDesc final
+{
+    PositionEncoding position = PositionEncoding::Float32;
+    DirectionEncoding normal  = DirectionEncoding::Float32;
+    UVEncoding uv             = UVEncoding::Float32;
+
+    bool operator==(const VertexCompressionDesc& other) const = default;
+};
+
+// How the channels of a vertex are packed. They are stored in the order of Vertex, the attributes of the binding are
+// in the order the shaders declare them: position, uv, normal.
+struct VertexLayout final
+{
+    ShaderChannel channels = ShaderChannel::None;
+    VertexCompressionDesc compression;
+
+    uint32_t byteStride     = 0;
+    uint32_t positionOffset = 0;
+    uint32_t normalOffset   = 0;
+    uint32_t uvOffset       = 0;
+
+    // Packing vertices into it is copying them
+    [[nodiscard]] bool IsVertex() const;
+    [[nodiscard]] VertexBufferBinding GetVertexBufferBinding() const;
+};
+
+[[nodiscard]] VertexLayout CreateVertexLayout(ShaderChannel channels = ShaderChannel::Default, const VertexCompressionDesc& compression = {});
+
+// Positions in the shader are attribute * positionScale + positionOffset, which is only needed for Unorm16
+struct PackedVertices final
+{
+    std::vector<uint8_t> data;
+    uint32_t vertexCount   = 0;
+    Vector3 positionScale  = Vector3::One;
+    Vector3 positionOffset = Vector3::Zero;
+};
+
+[[nodiscard]] PackedVertices PackVertices(std::span<const Vertex> vertices, const VertexLayout& layout);
+// Channels that are not in the layout get their defaults
+[[nodiscard]] std::vector<Vertex> UnpackVertices(const PackedVertices& packedVertices, const VertexLayout& layout);
+
+// What packing saved on the size of a mesh, and on the vertex fetch bandwidth of every draw of it
+struct VertexCompressionStats final
+{
+    uint64_t vertexByteSize = 0;
+    uint64_t packedByteSize = 0;
+
+    [[nodiscard]] uint64_t GetSavedByteSize() const { return vertexByteSize - packedByteSize; }
+    [[nodiscard]] float GetSavedRatio() const { return vertexByteSize != 0 ? static_cast<float>(GetSavedByteSize()) / vertexByteSize : 0.0f; }
+};
+
+[[nodiscard]] VertexCompressionStats GetVertexCompressionStats(uint32_t vertexCount, const VertexLayout& layout);
+} // namespace gore::gfx
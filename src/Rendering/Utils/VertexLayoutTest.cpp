@@ -0,0 +1,187 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Rendering/Utils/VertexLayout.h"
+#include "Rendering/GraphicsPipelineDesc.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::gfx;
+
+static std::vector<Vertex> MakeTestVertices()
+{
+    std::vector<Vertex> vertices;
+    for (int i = 0; i < 64; ++i)
+    {
+        float angle = i * 0.1f;
+        Vector3 normal(std::cos(angle) * std::sin(angle * 3.0f), std::sin(angle) * std::sin(angle * 3.0f), std::cos(angle * 3.0f));
+        vertices.push_back(Vertex{Vector3(i * 0.5f - 4.0f, std::sin(angle) * 3.0f, 2.0f), normal, Vector2(i / 63.0f, 1.0f - i / 127.0f)});
+    }
+    return vertices;
+}
+
+static float GetDistance(const Vector3& v1, const Vector3& v2)
+{
+    float x = v1.x - v2.x;
+    float y = v1.y - v2.y;
+    float z = v1.z - v2.z;
+    return std::sqrt(x * x + y * y + z * z);
+}
+
+TEST_CASE("The default vertex layout is Vertex", "[VertexLayout]")
+{
+    VertexLayout layout = CreateVertexLayout();
+    REQUIRE(layout.IsVertex());
+    REQUIRE(layout.byteStride == sizeof(Vertex));
+    REQUIRE(layout.positionOffset == offsetof(Vertex, position));
+    REQUIRE(layout.normalOffset == offsetof(Vertex, normal));
+    REQUIRE(layout.uvOffset == offsetof(Vertex, uv));
+
+    // the attributes are in the order of the shader inputs: position, uv, normal
+    VertexBufferBinding binding = layout.GetVertexBufferBinding();
+    REQUIRE(binding.byteStride == sizeof(Vertex));
+    REQUIRE(binding.attributes.size() == 3);
+    REQUIRE(binding.attributes[0].byteOffset == offsetof(Vertex, position));
+    REQUIRE(binding.attributes[0].format == GraphicsFormat::RGB32_FLOAT);
+    REQUIRE(binding.attributes[1].byteOffset == offsetof(Vertex, uv));
+    REQUIRE(binding.attributes[1].format == GraphicsFormat::RG32_FLOAT);
+    REQUIRE(binding.attributes[2].byteOffset == offsetof(Vertex, normal));
+    REQUIRE(binding.attributes[2].format == GraphicsFormat::RGB32_FLOAT);
+
+    std::vector<Vertex> vertices = MakeTestVertices();
+    PackedVertices packedVertices = PackVertices(vertices, layout);
+    REQUIRE(packedVertices.data.size() == vertices.size() * sizeof(Vertex));
+    REQUIRE(std::memcmp(packedVertices.data.data(), vertices.data(), packedVertices.data.size()) == 0);
+}
+
+TEST_CASE("Compressed vertex layouts round trip within their precision", "[VertexLayout]")
+{
+    std::vector<Vertex> vertices = MakeTestVertices();
+
+    SECTION("Quantized positions, octahedral normals and half uvs")
+    {
+        VertexLayout layout = CreateVertexLayout(ShaderChannel::Default,
+                                                 {.position = PositionEncoding::Unorm16,
+                                                  .normal   = DirectionEncoding::Octahedral16,
+                                                  .uv       = UVEncoding::Float16});
+        REQUIRE(layout.IsVertex() == false);
+        REQUIRE(layout.byteStride == 16);
+
+        VertexBufferBinding binding = layout.GetVertexBufferBinding();
+        REQUIRE(binding.byteStride == 16);
+        REQUIRE(binding.attributes[0].format == GraphicsFormat::RGBA16_UNORM);
+        REQUIRE(binding.attributes[1].byteOffset == 12);
+        REQUIRE(binding.attributes[1].format == GraphicsFormat::RG16_FLOAT);
+        REQUIRE(binding.attributes[2].byteOffset == 8);
+        REQUIRE(binding.attributes[2].format == GraphicsFormat::RG16_SNORM);
+
+        PackedVertices packedVertices = PackVertices(vertices, layout);
+        REQUIRE(packedVertices.data.size() == vertices.size() * 16);
+        REQUIRE(packedVertices.positionOffset.x == -4.0f);
+        REQUIRE(packedVertices.positionScale.x == 31.5f);
+        REQUIRE(packedVertices.positionScale.z == 0.0f);
+
+        std::vector<Vertex> unpacked = UnpackVertices(packedVertices, layout);
+        REQUIRE(unpacked.size() == vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            // half a step of 16 bits over the extent
+            REQUIRE(std::abs(unpacked[i].position.x - vertices[i].position.x) <= 31.5f / 65535.0f);
+            REQUIRE(std::abs(unpacked[i].position.y - vertices[i].position.y) <= 6.0f / 65535.0f);
+            REQUIRE(unpacked[i].position.z == 2.0f);
+
+            REQUIRE(GetDistance(unpacked[i].normal, vertices[i].normal) < 1e-4f);
+
+            REQUIRE(std::abs(unpacked[i].uv.x - vertices[i].uv.x) <= 1.0f / 2048.0f);
+            REQUIRE(std::abs(unpacked[i].uv.y - vertices[i].uv.y) <= 1.0f / 2048.0f);
+        }
+    }
+
+    SECTION("Packed 10:10:10:2 normals")
+    {
+        VertexLayout layout = CreateVertexLayout(ShaderChannel::Default, {.normal = DirectionEncoding::Packed1010102});
+        REQUIRE(layout.byteStride == 24);
+
+        std::vector<Vertex> unpacked = UnpackVertices(PackVertices(vertices, layout), layout);
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            REQUIRE(unpacked[i].position == vertices[i].position);
+            REQUIRE(GetDistance(unpacked[i].normal, vertices[i].normal) < 2e-3f);
+        }
+    }
+
+    SECTION("Channels left out of the layout get their defaults")
+    {
+        VertexLayout layout = CreateVertexLayout(ShaderChannel::Position | ShaderChannel::UV0, {.uv = UVEncoding::Float16});
+        REQUIRE(layout.byteStride == 16);
+        REQUIRE(layout.GetVertexBufferBinding().attributes.size() == 2);
+
+        std::vector<Vertex> unpacked = UnpackVertices(PackVertices(vertices, layout), layout);
+        REQUIRE(unpacked[5].position == vertices[5].position);
+        REQUIRE(unpacked[5].normal.x == k_DefaultNormal.x);
+        REQUIRE(unpacked[5].normal.y == k_DefaultNormal.y);
+        REQUIRE(unpacked[5].normal.z == k_DefaultNormal.z);
+    }
+}
+
+TEST_CASE("Axis aligned and opposite normals survive octahedral encoding", "[VertexLayout]")
+{
+    VertexLayout layout = CreateVertexLayout(ShaderChannel::Normal, {.normal = DirectionEncoding::Octahedral16});
+    REQUIRE(layout.byteStride == 4);
+
+    const Vector3 normals[] = {
+        Vector3(1.0f, 0.0f, 0.0f), Vector3(-1.0f, 0.0f, 0.0f),
+        Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, -1.0f, 0.0f),
+        Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 0.0f, -1.0f),
+        Vector3(0.577350f, -0.577350f, -0.577350f),
+    };
+
+    std::vector<Vertex> vertices;
+    for (const Vector3& normal : normals)
+        vertices.push_back(Vertex{Vector3::Zero, normal, Vector2(0.0f, 0.0f)});
+
+    std::vector<Vertex> unpacked = UnpackVertices(PackVertices(vertices, layout), layout);
+    for (size_t i = 0; i < vertices.size(); ++i)
+        REQUIRE(GetDistance(unpacked[i].normal, vertices[i].normal) < 1e-4f);
+}
+
+TEST_CASE("Half uvs keep exact values and saturate large ones", "[VertexLayout]")
+{
+    VertexLayout layout = CreateVertexLayout(ShaderChannel::UV0, {.uv = UVEncoding::Float16});
+
+    std::vector<Vertex> vertices = {
+        Vertex{Vector3::Zero, k_DefaultNormal, Vector2(0.5f, -2.0f)},
+        Vertex{Vector3::Zero, k_DefaultNormal, Vector2(1e-8f, 65504.0f)},
+        Vertex{Vector3::Zero, k_DefaultNormal, Vector2(1e6f, -0.0f)},
+    };
+
+    std::vector<Vertex> unpacked = UnpackVertices(PackVertices(vertices, layout), layout);
+    REQUIRE(unpacked[0].uv.x == 0.5f);
+    REQUIRE(unpacked[0].uv.y == -2.0f);
+    // below half of the smallest subnormal
+    REQUIRE(unpacked[1].uv.x == 0.0f);
+    REQUIRE(unpacked[1].uv.y == 65504.0f);
+    REQUIRE(std::isinf(unpacked[2].uv.x));
+    REQUIRE(std::signbit(unpacked[2].uv.y));
+}
+
+TEST_CASE("Compression stats compare against Vertex", "[VertexLayout]")
+{
+    VertexCompressionStats stats = GetVertexCompressionStats(1000, CreateVertexLayout());
+    REQUIRE(stats.vertexByteSize == 32000);
+    REQUIRE(stats.GetSavedByteSize() == 0);
+
+    stats = GetVertexCompressionStats(1000, CreateVertexLayout(ShaderChannel::Default,
+                                                               {.position = PositionEncoding::Unorm16,
+                                                                .normal   = DirectionEncoding::Octahedral16,
+                                                                .uv       = UVEncoding::Float16}));
+    REQUIRE(stats.packedByteSize == 16000);
+    REQUIRE(stats.GetSavedRatio() == 0.5f);
+}
+} // namespace gore::test
+#endif
@@ -0,0 +1,65 @@
+#ifndef GORE_VERTEX_COMPRESSION_HLSL_INCLUDE
+#define GORE_VERTEX_COMPRESSION_HLSL_INCLUDE
+
+// Decoding of the vertex attributes packed by PackVertices, see VertexLayout.h. Vertex shaders are compiled once per
+// position and normal encoding, POSITION_UNORM16, NORMAL_OCTAHEDRAL16 and NORMAL_PACKED1010102 pick the one of a
+// variant. Half uvs (RG16_FLOAT) are widened to float2 by the vertex fetch and need no variant.
+
+#if defined(POSITION_UNORM16)
+#define VERTEX_POSITION_TYPE float4
+#else
+#define VERTEX_POSITION_TYPE float3
+#endif
+
+#if defined(NORMAL_OCTAHEDRAL16)
+#define VERTEX_NORMAL_TYPE float2
+#elif defined(NORMAL_PACKED1010102)
+#define VERTEX_NORMAL_TYPE float4
+#else
+#define VERTEX_NORMAL_TYPE float3
+#endif
+
+// RGBA16_UNORM position, scale and offset are the ones PackVertices returned for the mesh
+float3 DequantizePosition(float4 encoded, float3 scale, float3 offset)
+{
+    return encoded.xyz * scale + offset;
+}
+
+// RG16_SNORM direction on the octahedron, the lower half is folded over the upper one
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 direction = float3(encoded.xy, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float fold = saturate(-direction.z);
+    float2 signNotZero = step(0.0f, direction.xy) * 2.0f - 1.0f;
+    direction.xy -= signNotZero * fold;
+    return normalize(direction);
+}
+
+// RGB10A2_UNORM direction stored as direction * 0.5 + 0.5
+float3 DecodePacked1010102(float4 encoded)
+{
+    return normalize(encoded.xyz * 2.0f - 1.0f);
+}
+
+// Object space position of the POSITION attribute, scale and offset are only read for Unorm16
+float3 DecodeVertexPosition(VERTEX_POSITION_TYPE position, float3 scale, float3 offset)
+{
+#if defined(POSITION_UNORM16)
+    return DequantizePosition(position, scale, offset);
+#else
+    return position;
+#endif
+}
+
+float3 DecodeVertexNormal(VERTEX_NORMAL_TYPE normal)
+{
+#if defined(NORMAL_OCTAHEDRAL16)
+    return DecodeOctahedral(normal);
+#elif defined(NORMAL_PACKED1010102)
+    return DecodePacked1010102(normal);
+#else
+    return normal;
+#endif
+}
+
+#endif
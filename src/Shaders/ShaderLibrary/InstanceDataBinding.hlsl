@@ -0,0 +1,94 @@
+#ifndef GORE_INSTANCE_DATA_BINDING
+#define GORE_INSTANCE_DATA_BINDING
+
+#include "Core/Common.hlsl"
+
+// Where draws recorded from the DrawCache find their object to world matrix, one variant per InstanceDataStoragePolicy.
+// Shaders including this need an instance ID (SV_InstanceID) to pass to GetObjectToWorld and GetPositionDequantization.
+// The dequantization decodes Unorm16 positions, see VertexCompression.hlsl.
+
+#if defined(INSTANCE_DATA_PUSH_CONSTANT)
+
+struct PerDrawData
+{
+    float4x4 objectToWorld;
+    float4 positionScale;
+    float4 positionOffset;
+};
+
+[[vk::push_constant]] PerDrawData _PerDrawData;
+
+float4x4 GetObjectToWorld(uint instanceID)
+{
+    return _PerDrawData.objectToWorld;
+}
+
+void GetPositionDequantization(uint instanceID, out float3 scale, out float3 offset)
+{
+    scale  = _PerDrawData.positionScale.xyz;
+    offset = _PerDrawData.positionOffset.xyz;
+}
+
+#elif defined(INSTANCE_DATA_STRUCTURED_BUFFER)
+
+struct TransformData
+{
+    float4x4 localToWorld;
+    float4x4 prevLocalToWorld;
+    float4 positionScale;
+    float4 positionOffset;
+};
+
+struct InstanceIndexConstants
+{
+    uint instanceIndexBase; // where the instance indices of the draw list start
+};
+
+[[vk::push_constant]] InstanceIndexConstants _InstanceIndexConstants;
+
+DESCRIPTOR_SET_BINDING(0, 3) StructuredBuffer<TransformData> _TransformBuffer;
+DESCRIPTOR_SET_BINDING(1, 3) StructuredBuffer<uint> _InstanceIndexBuffer;
+
+// instanceID includes the firstInstance of the draw on vulkan
+uint GetTransformSlot(uint instanceID)
+{
+    return _InstanceIndexBuffer[_InstanceIndexConstants.instanceIndexBase + instanceID];
+}
+
+float4x4 GetObjectToWorld(uint instanceID)
+{
+    return _TransformBuffer[GetTransformSlot(instanceID)].localToWorld;
+}
+
+void GetPositionDequantization(uint instanceID, out float3 scale, out float3 offset)
+{
+    TransformData transform = _TransformBuffer[GetTransformSlot(instanceID)];
+    scale  = transform.positionScale.xyz;
+    offset = transform.positionOffset.xyz;
+}
+
+#else // PersistentDynamicUniformBuffer
+
+struct PerDrawData
+{
+    float4x4 objectToWorld;
+    float4 positionScale;
+    float4 positionOffset;
+};
+
+DESCRIPTOR_SET_BINDING(0, 3) ConstantBuffer<PerDrawData> _PerDrawData;
+
+float4x4 GetObjectToWorld(uint instanceID)
+{
+    return _PerDrawData.objectToWorld;
+}
+
+void GetPositionDequantization(uint instanceID, out float3 scale, out float3 offset)
+{
+    scale  = _PerDrawData.positionScale.xyz;
+    offset = _PerDrawData.positionOffset.xyz;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef GORE_UNIFIED_GEOMETRY_BUFFER_INSTANCE_BINDING
+#define GORE_UNIFIED_GEOMETRY_BUFFER_INSTANCE_BINDING
+
+#include "../Core/Common.hlsl"
+
+// Set 3 is for the instance data of indirect draws
+#define INSTANCE_BINDING_DESCRIPTOR_SET 3
+
+// See UGB.md
+struct InstanceData
+{
+    uint transformSlot; // index to _TransformBuffer
+    uint meshIndex;     // index to _MeshDataBuffer
+    uint2 padding;
+};
+
+struct MeshData
+{
+    uint vertexOffset;
+    uint indexOffset;
+    uint vertexCount;
+    uint indexCount;
+};
+
+// written by GPUTransformChangeSystem, only the transforms that moved are uploaded
+struct TransformData
+{
+    float4x4 localToWorld;
+    float4x4 prevLocalToWorld;
+    float4 positionScale;
+    float4 positionOffset;
+};
+
+DESCRIPTOR_SET_BINDING(0, INSTANCE_BINDING_DESCRIPTOR_SET) StructuredBuffer<InstanceData> _InstanceDataBuffer;
+DESCRIPTOR_SET_BINDING(1, INSTANCE_BINDING_DESCRIPTOR_SET) StructuredBuffer<MeshData> _MeshDataBuffer;
+DESCRIPTOR_SET_BINDING(2, INSTANCE_BINDING_DESCRIPTOR_SET) StructuredBuffer<TransformData> _TransformBuffer;
+
+#endif
@@ -0,0 +1,3 @@
+// Shadowmap for InstanceDataStoragePolicy::PerDrawPushConstant
+#define INSTANCE_DATA_PUSH_CONSTANT
+#include "shadowmap.hlsl"
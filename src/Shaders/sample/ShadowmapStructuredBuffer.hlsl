@@ -0,0 +1,3 @@
+// Shadowmap for InstanceDataStoragePolicy::PersistentStructuredBuffer
+#define INSTANCE_DATA_STRUCTURED_BUFFER
+#include "shadowmap.hlsl"
@@ -1,12 +1,15 @@
 #include "../ShaderLibrary/GlobalBinding.hlsl"
 #include "../ShaderLibrary/ShadowPassBinding.hlsl"
 #include "../ShaderLibrary/BindlessMaterial.hlsl"
+#include "../ShaderLibrary/InstanceDataBinding.hlsl"
+#include "../ShaderLibrary/Core/VertexCompression.hlsl"
 
 struct Attributes
 {
-    float3 positionOS : POSITION;
+    VERTEX_POSITION_TYPE positionOS : POSITION;
     float2 uv : TEXCOORD;
-    float3 normal : NORMAL;
+    VERTEX_NORMAL_TYPE normal : NORMAL;
+    uint instanceID : SV_InstanceID;
 };
 
 struct Varyings
@@ -17,22 +20,18 @@ struct Varyings
     float3 normal : NORMAL;
 };
 
-struct PerDrawData
-{
-    float4x4 objToWorld;
-};
-
-DESCRIPTOR_SET_BINDING(0, 3) ConstantBuffer<PerDrawData> perDrawData;
-
 Varyings vs(Attributes IN)
 {
+    float3 positionScale, positionOffset;
+    GetPositionDequantization(IN.instanceID, positionScale, positionOffset);
+
     Varyings v;
-    float4 objVertPos = float4(IN.positionOS, 1);
-    float4 positionWS = mul(perDrawData.objToWorld, objVertPos);
+    float4 objVertPos = float4(DecodeVertexPosition(IN.positionOS, positionScale, positionOffset), 1);
+    float4 positionWS = mul(GetObjectToWorld(IN.instanceID), objVertPos);
     v.positionWS = positionWS;
     v.positionCS = mul(_VPMatrix, positionWS);
     v.uv = IN.uv;
-    v.normal = IN.normal;
+    v.normal = DecodeVertexNormal(IN.normal);
     return v;
 }
 
@@ -0,0 +1,45 @@
+#include "../ShaderLibrary/GlobalBinding.hlsl"
+#include "../ShaderLibrary/ShadowPassBinding.hlsl"
+#include "../ShaderLibrary/BindlessMaterial.hlsl"
+#include "../ShaderLibrary/UGB/UGBInstanceBinding.hlsl"
+
+struct Attributes
+{
+    float3 positionOS : POSITION;
+    float2 uv : TEXCOORD;
+    float3 normal : NORMAL;
+    // includes the firstInstance of the indirect command on vulkan
+    uint instanceID : SV_InstanceID;
+};
+
+struct Varyings
+{
+    float4 positionCS : SV_Position;
+    float2 uv : TEXCOORD;
+    float4 positionWS : TEXCOORD1;
+    float3 normal : NORMAL;
+};
+
+Varyings vs(Attributes IN)
+{
+    InstanceData instance = _InstanceDataBuffer[IN.instanceID];
+    float4x4 modelMatrix  = _TransformBuffer[instance.transformSlot].localToWorld;
+
+    Varyings v;
+    float4 objVertPos = float4(IN.positionOS, 1);
+    float4 positionWS = mul(modelMatrix, objVertPos);
+    v.positionWS = positionWS;
+    v.positionCS = mul(_VPMatrix, positionWS);
+    v.uv = IN.uv;
+    v.normal = IN.normal;
+    return v;
+}
+
+float4 ps(Varyings v) : SV_Target0
+{
+    float2 uv = v.uv / 0.57735f * .5f + .5f;
+
+    Texture2D albedo = LOAD_ARRAY_TEXTURES(_Albedo, 3);
+
+    return albedo.Sample(_AlbedoSampler, uv);
+}
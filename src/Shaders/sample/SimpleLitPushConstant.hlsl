@@ -0,0 +1,3 @@
+// SimpleLit for InstanceDataStoragePolicy::PerDrawPushConstant
+#define INSTANCE_DATA_PUSH_CONSTANT
+#include "SimpleLit.hlsl"
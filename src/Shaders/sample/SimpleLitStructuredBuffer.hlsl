@@ -0,0 +1,3 @@
+// SimpleLit for InstanceDataStoragePolicy::PersistentStructuredBuffer
+#define INSTANCE_DATA_STRUCTURED_BUFFER
+#include "SimpleLit.hlsl"
@@ -1,20 +1,16 @@
 #include "../ShaderLibrary/Core/Common.hlsl"
 #include "../ShaderLibrary/Core/GlobalConstantBuffer.hlsl"
+#include "../ShaderLibrary/InstanceDataBinding.hlsl"
+#include "../ShaderLibrary/Core/VertexCompression.hlsl"
 
 struct Attributes
 {
-    float3 positionOS : POSITION;
+    VERTEX_POSITION_TYPE positionOS : POSITION;
     float2 uv : TEXCOORD;
-    float3 normal : NORMAL;
+    VERTEX_NORMAL_TYPE normal : NORMAL;
+    uint instanceID : SV_InstanceID;
 };
 
-struct PerDrawData
-{
-    float4x4 m[128];
-};
-
-DESCRIPTOR_SET_BINDING(0, 3) ConstantBuffer<PerDrawData> perDrawData;
-
 struct Varyings
 {
     float4 positionCS : SV_Position;
@@ -22,9 +18,12 @@ struct Varyings
 
 Varyings vs(Attributes IN)
 {
+    float3 positionScale, positionOffset;
+    GetPositionDequantization(IN.instanceID, positionScale, positionOffset);
+
     Varyings v;
-    float4 objVertPos = float4(IN.positionOS, 1);
-    v.positionCS = mul(_DirectionalLightVPMatrix, mul(perDrawData.m[0], objVertPos));
+    float4 objVertPos = float4(DecodeVertexPosition(IN.positionOS, positionScale, positionOffset), 1);
+    v.positionCS = mul(_DirectionalLightVPMatrix, mul(GetObjectToWorld(IN.instanceID), objVertPos));
     return v;
 }
 
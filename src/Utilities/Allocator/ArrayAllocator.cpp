@@ -30,9 +30,9 @@ void ArrayAllocator::IncreaseSize()
         m_FreeList.push_back(i + 1);
     }
 
-    m_FreeList[m_Size - 1]                  = k_InvalidIndex;
-    m_NextIndex                             = m_Size - k_IncreaseSize;
-    m_FreeList[m_Size - k_IncreaseSize - 1] = m_NextIndex;
+    // only called when the free list is empty, the last old index is allocated and keeps its k_InvalidIndex
+    m_FreeList[m_Size - 1] = k_InvalidIndex;
+    m_NextIndex            = m_Size - k_IncreaseSize;
 }
 
 uint32_t ArrayAllocator::Allocate()
@@ -0,0 +1,222 @@
+#include "BitsetArrayAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace gore::utils
+{
+static constexpr uint32_t k_WordBitCount = 64;
+
+static uint32_t GetWordCount(size_t bitCount)
+{
+    return static_cast<uint32_t>((bitCount + k_WordBitCount - 1) / k_WordBitCount);
+}
+
+// Calls func(word, mask) for every word the bits [first, first + count) touch
+template <typename Func>
+static void ForEachWord(uint32_t first, uint32_t count, Func&& func)
+{
+    uint32_t end = first + count;
+    while (first < end)
+    {
+        uint32_t bit      = first % k_WordBitCount;
+        uint32_t bitCount = std::min(k_WordBitCount - bit, end - first);
+        uint64_t mask     = bitCount == k_WordBitCount ? ~0ull : ((1ull << bitCount) - 1) << bit;
+
+        func(first / k_WordBitCount, mask);
+        first += bitCount;
+    }
+}
+
+BitsetArrayAllocator::BitsetArrayAllocator(uint32_t size) noexcept :
+    m_Levels(),
+    m_Size(0),
+    m_FreeCount(0)
+{
+    assert(size > 0);
+
+    IncreaseSize(size);
+}
+
+void BitsetArrayAllocator::IncreaseSize(uint32_t minIncrease)
+{
+    uint32_t oldSize = m_Size;
+    m_Size += minIncrease;
+
+    // growing is rare, the summary levels are simply built again
+    m_Levels.resize(1);
+    m_Levels[0].resize(GetWordCount(m_Size), 0);
+    ForEachWord(oldSize, m_Size - oldSize, [this](uint32_t word, uint64_t mask) { m_Levels[0][word] |= mask; });
+    m_FreeCount += m_Size - oldSize;
+
+    while (m_Levels.back().size() > 1)
+    {
+        std::vector<uint64_t> level(GetWordCount(m_Levels.back().size()), 0);
+        const std::vector<uint64_t>& below = m_Levels.back();
+        for (uint32_t word = 0; word < below.size(); ++word)
+        {
+            if (below[word] != 0)
+                level[word / k_WordBitCount] |= 1ull << (word % k_WordBitCount);
+        }
+        m_Levels.push_back(std::move(level));
+    }
+}
+
+uint32_t BitsetArrayAllocator::FindNextSet(uint32_t level, uint32_t position) const
+{
+    const std::vector<uint64_t>& words = m_Levels[level];
+
+    uint32_t word = position / k_WordBitCount;
+    if (word >= words.size())
+        return k_InvalidIndex;
+
+    uint64_t bits = words[word] & (~0ull << (position % k_WordBitCount));
+    if (bits != 0)
+        return word * k_WordBitCount + std::countr_zero(bits);
+
+    // the level above knows which of the following words has a set bit, the top level is a single word
+    uint32_t nextWord = level + 1 < m_Levels.size() ? FindNextSet(level + 1, word + 1) : k_InvalidIndex;
+    if (nextWord == k_InvalidIndex)
+        return k_InvalidIndex;
+
+    return nextWord * k_WordBitCount + std::countr_zero(words[nextWord]);
+}
+
+uint32_t BitsetArrayAllocator::FindNextAllocated(uint32_t position) const
+{
+    const std::vector<uint64_t>& words = m_Levels[0];
+    if (position >= m_Size)
+        return m_Size;
+
+    uint32_t word = position / k_WordBitCount;
+    uint64_t bits = ~words[word] & (~0ull << (position % k_WordBitCount));
+    while (bits == 0)
+    {
+        if (++word == words.size())
+            return m_Size;
+
+        bits = ~words[word];
+    }
+
+    // bits past the end are never set, they look allocated
+    return std::min(word * k_WordBitCount + static_cast<uint32_t>(std::countr_zero(bits)), m_Size);
+}
+
+void BitsetArrayAllocator::SetSummaryBit(uint32_t level, uint32_t word)
+{
+    if (level == m_Levels.size())
+        return;
+
+    uint64_t& bits = m_Levels[level][word / k_WordBitCount];
+    bool wasEmpty  = bits == 0;
+    bits |= 1ull << (word % k_WordBitCount);
+
+    if (wasEmpty)
+        SetSummaryBit(level + 1, word / k_WordBitCount);
+}
+
+void BitsetArrayAllocator::ClearSummaryBit(uint32_t level, uint32_t word)
+{
+    if (level == m_Levels.size())
+        return;
+
+    uint64_t& bits = m_Levels[level][word / k_WordBitCount];
+    bits &= ~(1ull << (word % k_WordBitCount));
+
+    if (bits == 0)
+        ClearSummaryBit(level + 1, word / k_WordBitCount);
+}
+
+void BitsetArrayAllocator::SetRange(uint32_t first, uint32_t count)
+{
+    ForEachWord(first, count,
+                [this](uint32_t word, uint64_t mask)
+                {
+                    uint64_t& bits = m_Levels[0][word];
+                    assert((bits & mask) == 0);
+
+                    bool wasEmpty = bits == 0;
+                    bits |= mask;
+                    if (wasEmpty)
+                        SetSummaryBit(1, word);
+                });
+
+    m_FreeCount += count;
+}
+
+void BitsetArrayAllocator::ClearRange(uint32_t first, uint32_t count)
+{
+    ForEachWord(first, count,
+                [this](uint32_t word, uint64_t mask)
+                {
+                    uint64_t& bits = m_Levels[0][word];
+                    assert((bits & mask) == mask);
+
+                    bits &= ~mask;
+                    if (bits == 0)
+                        ClearSummaryBit(1, word);
+                });
+
+    m_FreeCount -= count;
+}
+
+uint32_t BitsetArrayAllocator::Allocate()
+{
+    if (m_FreeCount == 0)
+    {
+        IncreaseSize(k_IncreaseSize);
+    }
+
+    uint32_t index = FindNextSet(0, 0);
+    ClearRange(index, 1);
+
+    return index;
+}
+
+void BitsetArrayAllocator::Free(uint32_t index)
+{
+    assert(index < m_Size);
+    assert(IsAllocated(index));
+
+    SetRange(index, 1);
+}
+
+uint32_t BitsetArrayAllocator::AllocateRange(uint32_t count)
+{
+    if (count == 0)
+        return k_InvalidIndex;
+
+    while (true)
+    {
+        // from one run of free indices to the next until one is long enough
+        uint32_t first = FindNextSet(0, 0);
+        while (first != k_InvalidIndex)
+        {
+            uint32_t end = FindNextAllocated(first);
+            if (end - first >= count)
+            {
+                ClearRange(first, count);
+                return first;
+            }
+
+            first = end < m_Size ? FindNextSet(0, end) : k_InvalidIndex;
+        }
+
+        // a free run at the end continues into the new indices
+        IncreaseSize(std::max(k_IncreaseSize, count));
+    }
+}
+
+void BitsetArrayAllocator::FreeRange(uint32_t first, uint32_t count)
+{
+    assert(first + count <= m_Size);
+
+    SetRange(first, count);
+}
+
+bool BitsetArrayAllocator::IsAllocated(uint32_t index) const
+{
+    return index < m_Size && (m_Levels[0][index / k_WordBitCount] & (1ull << (index % k_WordBitCount))) == 0;
+}
+} // namespace gore::utils
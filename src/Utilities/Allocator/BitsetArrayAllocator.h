@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Prefix.h"
+
+#include "Export.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace gore::utils
+{
+// BitsetArrayAllocator hands out indices in an array like ArrayAllocator, but always the lowest free one, so the
+// live indices stay packed at the start of the array and GPU uploads of them cover a compact range.
+// Free indices are set bits of a bitset. Each level above it has one bit per 64 bit word of the level below, set when
+// that word has any free index, so finding the lowest free index only looks at one word per level.
+// Runs of consecutive indices can be allocated and freed at once. The array grows when nothing fits.
+ENGINE_CLASS(BitsetArrayAllocator)
+{
+public:
+    static constexpr uint32_t k_InvalidIndex = 0xffffffff;
+    static constexpr uint32_t k_IncreaseSize = 1024;
+
+    BitsetArrayAllocator(uint32_t size = 1024) noexcept;
+    ~BitsetArrayAllocator() = default;
+
+    [[nodiscard]] uint32_t Allocate();
+    void Free(uint32_t index);
+
+    // First index of the lowest run of count free indices
+    [[nodiscard]] uint32_t AllocateRange(uint32_t count);
+    void FreeRange(uint32_t first, uint32_t count);
+
+    [[nodiscard]] bool IsAllocated(uint32_t index) const;
+    [[nodiscard]] uint32_t GetSize() const { return m_Size; }
+    [[nodiscard]] uint32_t GetAllocatedCount() const { return m_Size - m_FreeCount; }
+    [[nodiscard]] bool IsFull() const { return m_FreeCount == 0; }
+
+private:
+    // The lowest set bit of the level at or after position, k_InvalidIndex if there is none
+    [[nodiscard]] uint32_t FindNextSet(uint32_t level, uint32_t position) const;
+    // The lowest allocated index at or after position, m_Size if there is none
+    [[nodiscard]] uint32_t FindNextAllocated(uint32_t position) const;
+
+    void SetRange(uint32_t first, uint32_t count);
+    void ClearRange(uint32_t first, uint32_t count);
+    void SetSummaryBit(uint32_t level, uint32_t word);
+    void ClearSummaryBit(uint32_t level, uint32_t word);
+
+    void IncreaseSize(uint32_t minIncrease);
+
+private:
+    // m_Levels[0] has a bit per index, every level above a bit per word of the one below, the top one is a word or less
+    std::vector<std::vector<uint64_t>> m_Levels;
+    uint32_t m_Size;
+    uint32_t m_FreeCount;
+};
+} // namespace gore::utils
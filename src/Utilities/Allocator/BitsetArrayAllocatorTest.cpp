@@ -0,0 +1,169 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Utilities/Allocator/ArrayAllocator.h"
+#include "Utilities/Allocator/BitsetArrayAllocator.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::utils;
+
+TEST_CASE("The lowest free index is handed out first", "[BitsetArrayAllocator]")
+{
+    BitsetArrayAllocator allocator(100);
+
+    for (uint32_t i = 0; i < 100; ++i)
+        REQUIRE(allocator.Allocate() == i);
+    REQUIRE(allocator.IsFull());
+
+    allocator.Free(70);
+    allocator.Free(3);
+    allocator.Free(64);
+    REQUIRE(allocator.GetAllocatedCount() == 97);
+
+    // not in the order they were freed
+    REQUIRE(allocator.Allocate() == 3);
+    REQUIRE(allocator.Allocate() == 64);
+    REQUIRE(allocator.Allocate() == 70);
+
+    SECTION("A full allocator grows")
+    {
+        REQUIRE(allocator.Allocate() == 100);
+        REQUIRE(allocator.GetSize() == 100 + BitsetArrayAllocator::k_IncreaseSize);
+        REQUIRE(allocator.IsAllocated(100));
+        REQUIRE(allocator.IsAllocated(101) == false);
+    }
+}
+
+TEST_CASE("Ranges take the lowest run that fits", "[BitsetArrayAllocator]")
+{
+    BitsetArrayAllocator allocator(256);
+
+    uint32_t a = allocator.AllocateRange(10);
+    uint32_t b = allocator.AllocateRange(100);
+    uint32_t c = allocator.AllocateRange(20);
+    REQUIRE(a == 0);
+    REQUIRE(b == 10);
+    REQUIRE(c == 110);
+
+    // a hole of 100 across word boundaries
+    allocator.FreeRange(b, 100);
+    REQUIRE(allocator.AllocateRange(101) == 130);
+    REQUIRE(allocator.AllocateRange(60) == 10);
+    REQUIRE(allocator.AllocateRange(40) == 70);
+    REQUIRE(allocator.Allocate() == 231);
+
+    SECTION("A run at the end continues into the grown part")
+    {
+        REQUIRE(allocator.AllocateRange(30) == 232);
+        REQUIRE(allocator.GetSize() == 256 + BitsetArrayAllocator::k_IncreaseSize);
+    }
+
+    SECTION("Freeing everything leaves one run")
+    {
+        allocator.FreeRange(0, 232);
+        REQUIRE(allocator.GetAllocatedCount() == 0);
+        REQUIRE(allocator.AllocateRange(256) == 0);
+        REQUIRE(allocator.GetSize() == 256);
+    }
+}
+
+TEST_CASE("Bitset and free list agree under churn", "[BitsetArrayAllocator]")
+{
+    // bigger than one summary word, so every level is used
+    BitsetArrayAllocator allocator(64 * 64 * 2);
+    std::set<uint32_t> allocated;
+
+    std::mt19937 random(11);
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        if (!allocated.empty() && random() % 2 == 0)
+        {
+            auto it = allocated.begin();
+            std::advance(it, random() % std::min<size_t>(allocated.size(), 64));
+            allocator.Free(*it);
+            allocated.erase(it);
+        }
+        else
+        {
+            uint32_t lowestFree = 0;
+            while (allocated.contains(lowestFree))
+                lowestFree++;
+
+            REQUIRE(allocator.Allocate() == lowestFree);
+            allocated.insert(lowestFree);
+        }
+    }
+
+    REQUIRE(allocator.GetAllocatedCount() == allocated.size());
+}
+
+TEST_CASE("Array allocator benchmark", "[BitsetArrayAllocator][.benchmark]")
+{
+    constexpr uint32_t count = 100000;
+
+    // the same indices are freed from both, in an order that leaves holes all over the array
+    std::vector<uint32_t> freeOrder(count);
+    for (uint32_t i = 0; i < count; ++i)
+        freeOrder[i] = i;
+    std::shuffle(freeOrder.begin(), freeOrder.end(), std::mt19937(7));
+    freeOrder.resize(count / 2);
+
+    BENCHMARK("Free list, allocate and free")
+    {
+        ArrayAllocator allocator;
+        for (uint32_t i = 0; i < count; ++i)
+            (void)allocator.Allocate();
+        for (uint32_t index : freeOrder)
+            allocator.Free(index);
+
+        uint32_t maxIndex = 0;
+        for (uint32_t i = 0; i < count / 2; ++i)
+            maxIndex = std::max(maxIndex, allocator.Allocate());
+        return maxIndex;
+    };
+
+    BENCHMARK("Bitset, allocate and free")
+    {
+        BitsetArrayAllocator allocator;
+        for (uint32_t i = 0; i < count; ++i)
+            (void)allocator.Allocate();
+        for (uint32_t index : freeOrder)
+            allocator.Free(index);
+
+        uint32_t maxIndex = 0;
+        for (uint32_t i = 0; i < count / 2; ++i)
+            maxIndex = std::max(maxIndex, allocator.Allocate());
+        return maxIndex;
+    };
+
+    BENCHMARK("Free list, 64 at once")
+    {
+        ArrayAllocator allocator;
+        for (uint32_t i = 0; i < count; ++i)
+            (void)allocator.Allocate();
+        for (uint32_t i = 0; i < count; ++i)
+            allocator.Free(i);
+        return allocator.GetSize();
+    };
+
+    BENCHMARK("Bitset, 64 at once")
+    {
+        BitsetArrayAllocator allocator;
+        for (uint32_t i = 0; i < count; i += 64)
+            (void)allocator.AllocateRange(64);
+        for (uint32_t i = 0; i < count; i += 64)
+            allocator.FreeRange(i, 64);
+        return allocator.GetSize();
+    };
+}
+
+} // namespace gore::test
+#endif
@@ -0,0 +1,93 @@
+#include "LinearArena.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace gore::utils
+{
+LinearArena::LinearArena(size_t blockSize) :
+    m_Blocks(),
+    m_BlockIndex(0),
+    m_Offset(0),
+    m_BlockSize(blockSize),
+    m_BytesUsed(0),
+    m_BlockAllocationCount(0)
+{
+    assert(blockSize > 0);
+}
+
+uint8_t* LinearArena::Allocate(size_t size, size_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+    while (m_BlockIndex < m_Blocks.size())
+    {
+        Block& block   = m_Blocks[m_BlockIndex];
+        auto address   = reinterpret_cast<uintptr_t>(block.data.get()) + m_Offset;
+        size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+
+        if (m_Offset + padding + size <= block.size)
+        {
+            uint8_t* allocation = block.data.get() + m_Offset + padding;
+            m_Offset += padding + size;
+            m_BytesUsed += padding + size;
+            return allocation;
+        }
+
+        // the rest of this block is wasted until the next Reset
+        m_BlockIndex++;
+        m_Offset = 0;
+    }
+
+    AddBlock(size + alignment);
+    return Allocate(size, alignment);
+}
+
+void LinearArena::Trim(const uint8_t* allocation, size_t size, size_t usedSize)
+{
+    assert(usedSize <= size);
+
+    if (m_BlockIndex >= m_Blocks.size())
+        return;
+
+    const uint8_t* top = m_Blocks[m_BlockIndex].data.get() + m_Offset;
+    if (allocation + size != top)
+        return;
+
+    m_Offset -= size - usedSize;
+    m_BytesUsed -= size - usedSize;
+}
+
+void LinearArena::Reset()
+{
+    if (m_Blocks.size() > 1)
+    {
+        size_t totalSize = GetCapacity();
+        m_Blocks.clear();
+        AddBlock(totalSize);
+    }
+
+    m_BlockIndex = 0;
+    m_Offset     = 0;
+    m_BytesUsed  = 0;
+}
+
+size_t LinearArena::GetCapacity() const
+{
+    size_t capacity = 0;
+    for (const Block& block : m_Blocks)
+    {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void LinearArena::AddBlock(size_t minSize)
+{
+    size_t size = std::max(minSize, m_BlockSize);
+    m_Blocks.push_back({std::make_unique_for_overwrite<uint8_t[]>(size), size});
+    m_BlockIndex = m_Blocks.size() - 1;
+    m_Offset     = 0;
+    m_BlockAllocationCount++;
+}
+} // namespace gore::utils
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Prefix.h"
+
+#include "Export.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace gore::utils
+{
+// LinearArena hands out memory by bumping an offset and frees everything at once in Reset.
+// Blocks are kept across Reset, so once the arena has grown to what a frame needs it stops allocating.
+// Allocate is not thread safe, hand out the memory on one thread and fill it on as many as needed.
+ENGINE_CLASS(LinearArena)
+{
+public:
+    static constexpr size_t k_DefaultBlockSize = 256 * 1024;
+
+    explicit LinearArena(size_t blockSize = k_DefaultBlockSize);
+    ~LinearArena() = default;
+
+    NON_COPYABLE(LinearArena);
+
+    [[nodiscard]] uint8_t* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    // Gives the unused end of the most recent allocation back, does nothing for older allocations
+    void Trim(const uint8_t* allocation, size_t size, size_t usedSize);
+
+    // Everything allocated so far becomes invalid. If the last round needed more than one block,
+    // they are replaced by a single block that fits all of it.
+    void Reset();
+
+    [[nodiscard]] size_t GetBytesUsed() const { return m_BytesUsed; }
+    [[nodiscard]] size_t GetCapacity() const;
+    // number of blocks allocated from the heap since the arena was created
+    [[nodiscard]] uint32_t GetBlockAllocationCount() const { return m_BlockAllocationCount; }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+    };
+
+    void AddBlock(size_t minSize);
+
+private:
+    std::vector<Block> m_Blocks;
+    size_t m_BlockIndex;
+    size_t m_Offset;
+    size_t m_BlockSize;
+    size_t m_BytesUsed;
+    uint32_t m_BlockAllocationCount;
+};
+} // namespace gore::utils
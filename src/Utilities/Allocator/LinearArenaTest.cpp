@@ -0,0 +1,69 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Utilities/Allocator/LinearArena.h"
+
+namespace gore::test
+{
+using namespace gore::utils;
+
+TEST_CASE("Linear arena allocations are aligned and do not overlap", "[LinearArena]")
+{
+    LinearArena arena(1024);
+
+    uint8_t* a = arena.Allocate(3, 1);
+    uint8_t* b = arena.Allocate(16, 16);
+    uint8_t* c = arena.Allocate(8, 8);
+
+    REQUIRE(reinterpret_cast<uintptr_t>(b) % 16 == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(c) % 8 == 0);
+    REQUIRE(b >= a + 3);
+    REQUIRE(c >= b + 16);
+    REQUIRE(arena.GetBlockAllocationCount() == 1);
+
+    SECTION("Allocations bigger than a block get a block of their own")
+    {
+        uint8_t* big = arena.Allocate(4000, 4);
+        REQUIRE(big != nullptr);
+        REQUIRE(arena.GetBlockAllocationCount() == 2);
+        REQUIRE(arena.GetCapacity() >= 1024 + 4000);
+    }
+}
+
+TEST_CASE("Linear arena trims the most recent allocation only", "[LinearArena]")
+{
+    LinearArena arena(1024);
+
+    uint8_t* a = arena.Allocate(100, 1);
+    arena.Trim(a, 100, 10);
+    REQUIRE(arena.GetBytesUsed() == 10);
+
+    uint8_t* b = arena.Allocate(100, 1);
+    REQUIRE(b == a + 10);
+
+    // a is not on top anymore
+    arena.Trim(a, 10, 0);
+    REQUIRE(arena.GetBytesUsed() == 110);
+}
+
+TEST_CASE("Linear arena merges its blocks on reset", "[LinearArena]")
+{
+    LinearArena arena(256);
+
+    for (int i = 0; i < 10; ++i)
+        (void)arena.Allocate(200, 1);
+    REQUIRE(arena.GetBlockAllocationCount() == 10);
+
+    arena.Reset();
+    REQUIRE(arena.GetBytesUsed() == 0);
+    REQUIRE(arena.GetBlockAllocationCount() == 11);
+
+    // the merged block holds a whole round now
+    for (int i = 0; i < 10; ++i)
+        (void)arena.Allocate(200, 1);
+    arena.Reset();
+    REQUIRE(arena.GetBlockAllocationCount() == 11);
+}
+
+} // namespace gore::test
+#endif
@@ -0,0 +1,173 @@
+#include "AssetLoader.h"
+
+#include "Utilities/GLTFLoader.h"
+
+#include "Profiler/microprofile.h"
+
+#include "stb_image.h"
+
+#include <cstring>
+#include <filesystem>
+
+MICROPROFILE_DEFINE(g_AssetLoaderLoadMesh, "AssetLoader", "LoadMesh", MP_AUTO);
+MICROPROFILE_DEFINE(g_AssetLoaderLoadImage, "AssetLoader", "LoadImage", MP_AUTO);
+
+namespace gore::gfx
+{
+AssetLoader::AssetLoader(JobSystem* jobSystem, const AssetLoaderDesc& desc) :
+    m_JobSystem(jobSystem),
+    m_Desc(desc),
+    m_Mutex(),
+    m_Meshes(),
+    m_Images(),
+    m_LoadCount(0)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+}
+
+std::shared_ptr<MeshAsset> AssetLoader::RequestMesh(const std::string& path, int meshIndex, ShaderChannel channels)
+{
+    return RequestMesh(MeshRequest{.path = path, .meshIndex = meshIndex, .channels = channels});
+}
+
+std::shared_ptr<MeshAsset> AssetLoader::RequestMesh(const MeshRequest& request)
+{
+    const std::string& path = request.path;
+    int meshIndex           = request.meshIndex;
+    ShaderChannel channels  = request.channels;
+
+    std::string key = path + "#" + std::to_string(meshIndex) + "#" + std::to_string(static_cast<uint32_t>(channels));
+
+    std::lock_guard lock(m_Mutex);
+
+    std::weak_ptr<MeshAsset>& entry = m_Meshes[key];
+    if (std::shared_ptr<MeshAsset> asset = entry.lock())
+        return asset;
+
+    auto asset       = std::make_shared<MeshAsset>();
+    asset->path      = path;
+    asset->meshIndex = meshIndex;
+    asset->channels  = channels;
+    entry            = asset;
+
+    m_LoadCount.fetch_add(1, std::memory_order_relaxed);
+
+    // under the lock, so a request for the same file from another thread can not see the asset half loaded
+    bool cookMesh = m_Desc.cookMeshes;
+    if (m_JobSystem == nullptr)
+        LoadMesh(*asset, cookMesh);
+    else
+        m_JobSystem->Schedule([asset, cookMesh]() { LoadMesh(*asset, cookMesh); }, &asset->counter);
+
+    return asset;
+}
+
+std::shared_ptr<ImageAsset> AssetLoader::RequestImage(const std::string& path)
+{
+    std::lock_guard lock(m_Mutex);
+
+    std::weak_ptr<ImageAsset>& entry = m_Images[path];
+    if (std::shared_ptr<ImageAsset> asset = entry.lock())
+        return asset;
+
+    auto asset  = std::make_shared<ImageAsset>();
+    asset->path = path;
+    entry       = asset;
+
+    m_LoadCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_JobSystem == nullptr)
+        LoadImage(*asset);
+    else
+        m_JobSystem->Schedule([asset]() { LoadImage(*asset); }, &asset->counter);
+
+    return asset;
+}
+
+std::vector<std::shared_ptr<MeshAsset>> AssetLoader::RequestMeshes(std::span<const MeshRequest> requests)
+{
+    std::vector<std::shared_ptr<MeshAsset>> assets;
+    assets.reserve(requests.size());
+
+    for (const MeshRequest& request : requests)
+        assets.push_back(RequestMesh(request));
+
+    return assets;
+}
+
+std::vector<std::shared_ptr<ImageAsset>> AssetLoader::RequestImages(std::span<const std::string> paths)
+{
+    std::vector<std::shared_ptr<ImageAsset>> assets;
+    assets.reserve(paths.size());
+
+    for (const std::string& path : paths)
+        assets.push_back(RequestImage(path));
+
+    return assets;
+}
+
+bool AssetLoader::Wait(const MeshAsset& asset)
+{
+    return WaitForAsset(asset);
+}
+
+bool AssetLoader::Wait(const ImageAsset& asset)
+{
+    return WaitForAsset(asset);
+}
+
+template <typename Asset>
+bool AssetLoader::WaitForAsset(const Asset& asset)
+{
+    if (m_JobSystem != nullptr)
+        m_JobSystem->Wait(asset.counter);
+
+    return asset.loaded;
+}
+
+void AssetLoader::LoadMesh(MeshAsset& asset, bool cookMesh)
+{
+    MICROPROFILE_SCOPE(g_AssetLoaderLoadMesh);
+
+    // a cooked mesh without its glTF is used as it is, otherwise it has to be cooked from the glTF as it is now
+    std::string cookedPath = CookedMesh::GetCookedPath(asset.path, asset.meshIndex, asset.channels);
+    bool hasSource         = std::filesystem::exists(asset.path);
+    if (asset.cookedMesh.Open(cookedPath, hasSource ? asset.path : std::string(), asset.channels))
+    {
+        asset.loaded = true;
+        return;
+    }
+
+    GLTFLoader gltfLoader;
+    asset.loaded = gltfLoader.LoadMesh(asset.data, asset.path, asset.meshIndex, asset.channels);
+
+    if (asset.loaded && cookMesh && CookedMesh::Write(cookedPath, asset.data, asset.path, asset.channels) == false)
+        LOG_STREAM(WARNING) << "Failed to cook mesh: " << cookedPath << std::endl;
+}
+
+void AssetLoader::LoadImage(ImageAsset& asset)
+{
+    MICROPROFILE_SCOPE(g_AssetLoaderLoadImage);
+
+    int width, height, channel;
+    stbi_uc* pixels = stbi_load(asset.path.c_str(), &width, &height, &channel, STBI_rgb_alpha);
+
+    if (pixels == nullptr)
+    {
+        LOG_STREAM(ERROR) << "Failed to load image: " << asset.path << std::endl;
+        return;
+    }
+
+    asset.data.width  = static_cast<uint32_t>(width);
+    asset.data.height = static_cast<uint32_t>(height);
+    asset.data.pixels.resize(static_cast<size_t>(width) * height * 4);
+    std::memcpy(asset.data.pixels.data(), pixels, asset.data.pixels.size());
+
+    stbi_image_free(pixels);
+
+    asset.loaded = true;
+}
+} // namespace gore::gfx
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Prefix.h"
+#include "Export.h"
+
+#include "Core/JobSystem.h"
+#include "Rendering/Utils/GeometryUtils.h"
+#include "Utilities/CookedMesh.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gore::gfx
+{
+// RGBA8 pixels of a decoded image
+struct ImageData final
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+// data can only be read once IsDone returns true, loaded tells whether it is valid
+struct MeshAsset final
+{
+    std::string path;
+    int meshIndex          = 0;
+    ShaderChannel channels = ShaderChannel::Default;
+
+    bool loaded = false;
+    // a glTF mesh is built in data, a cooked one is read from the mapped file
+    MeshData data;
+    CookedMesh cookedMesh;
+    JobCounter counter;
+
+    [[nodiscard]] bool IsDone() const { return counter.IsDone(); }
+    [[nodiscard]] MeshDataView GetView() const { return cookedMesh.IsOpen() ? cookedMesh.GetView() : data.GetView(); }
+};
+
+// What RequestMesh and RequestMeshes load, requests that only differ in the path share a cooked file per channels
+struct MeshRequest final
+{
+    std::string path;
+    int meshIndex          = 0;
+    ShaderChannel channels = ShaderChannel::Default;
+};
+
+struct ImageAsset final
+{
+    std::string path;
+
+    bool loaded = false;
+    ImageData data;
+    JobCounter counter;
+
+    [[nodiscard]] bool IsDone() const { return counter.IsDone(); }
+};
+
+struct AssetLoaderDesc final
+{
+    // a mesh loaded from glTF is written as a cooked mesh next to it, which is mapped instead from then on
+    bool cookMeshes = false;
+};
+
+// Reads, decodes and parses asset files on the JobSystem and keeps the results on the CPU until the render thread
+// copies them to the GPU. A file that is requested again while an earlier request for it is still held on to is only
+// loaded once, both requests share the asset. Once the last holder lets go, a new request loads the file again.
+ENGINE_CLASS(AssetLoader) final
+{
+public:
+    // Without a JobSystem the assets are loaded on the thread that requests them
+    explicit AssetLoader(JobSystem* jobSystem, const AssetLoaderDesc& desc = {});
+    ~AssetLoader();
+
+    NON_COPYABLE(AssetLoader);
+
+    [[nodiscard]] std::shared_ptr<MeshAsset> RequestMesh(const MeshRequest& request);
+    [[nodiscard]] std::shared_ptr<MeshAsset> RequestMesh(const std::string& path, int meshIndex = 0, ShaderChannel channels = ShaderChannel::Default);
+    [[nodiscard]] std::shared_ptr<ImageAsset> RequestImage(const std::string& path);
+
+    // Every asset is scheduled before the first one is waited for, the result is in the order of requests and paths
+    [[nodiscard]] std::vector<std::shared_ptr<MeshAsset>> RequestMeshes(std::span<const MeshRequest> requests);
+    [[nodiscard]] std::vector<std::shared_ptr<ImageAsset>> RequestImages(std::span<const std::string> paths);
+
+    // Runs other jobs on the calling thread until the asset is done, returns whether it was loaded
+    bool Wait(const MeshAsset& asset);
+    bool Wait(const ImageAsset& asset);
+
+    // Files actually read since the loader was created, requests that were shared are not counted
+    [[nodiscard]] uint32_t GetLoadCount() const { return m_LoadCount.load(std::memory_order_relaxed); }
+
+private:
+    static void LoadMesh(MeshAsset& asset, bool cookMesh);
+    static void LoadImage(ImageAsset& asset);
+
+    template <typename Asset>
+    bool WaitForAsset(const Asset& asset);
+
+    JobSystem* m_JobSystem;
+    AssetLoaderDesc m_Desc;
+
+    std::mutex m_Mutex;
+    std::unordered_map<std::string, std::weak_ptr<MeshAsset>> m_Meshes;
+    std::unordered_map<std::string, std::weak_ptr<ImageAsset>> m_Images;
+
+    std::atomic<uint32_t> m_LoadCount;
+};
+} // namespace gore::gfx
@@ -0,0 +1,211 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Core/JobSystem.h"
+#include "Utilities/AssetLoader.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::gfx;
+
+static const std::filesystem::path k_ResourceFolder = TEST_RESOURCE_FOLDER;
+
+static std::string GetGLTFPath(const char* name)
+{
+    return (k_ResourceFolder / "gltf" / name).generic_string();
+}
+
+TEST_CASE("Requests for the same mesh share one load", "[AssetLoader]")
+{
+    JobSystem jobSystem(3);
+    AssetLoader assetLoader(&jobSystem);
+
+    std::shared_ptr<MeshAsset> cube = assetLoader.RequestMesh(GetGLTFPath("cube.gltf"));
+
+    std::vector<MeshRequest> requests = {{.path = GetGLTFPath("rock.gltf")}, {.path = GetGLTFPath("cube.gltf")}, {.path = GetGLTFPath("teapot.gltf")}, {.path = GetGLTFPath("rock.gltf")}};
+    std::vector<std::shared_ptr<MeshAsset>> assets = assetLoader.RequestMeshes(requests);
+
+    REQUIRE(assets.size() == 4);
+    REQUIRE(assets[1] == cube);
+    REQUIRE(assets[0] == assets[3]);
+    REQUIRE(assetLoader.GetLoadCount() == 3);
+
+    for (const auto& asset : assets)
+        REQUIRE(assetLoader.Wait(*asset));
+
+    REQUIRE(cube->GetView().vertices.size() == 36);
+    REQUIRE(cube->GetView().indexCount == 36);
+    // 8 bit indices are widened
+    REQUIRE(cube->GetView().indexType == IndexType::UINT16);
+    REQUIRE(cube->GetView().indices.size() == 36 * sizeof(uint16_t));
+
+    REQUIRE(assets[0]->GetView().vertices.size() == 205);
+    REQUIRE(assets[0]->GetView().indexCount == 540);
+
+    REQUIRE(assets[2]->GetView().vertices.size() == 4690);
+    REQUIRE(assets[2]->GetView().indexCount == 27384);
+    REQUIRE(assets[2]->GetView().indexType == IndexType::UINT16);
+
+    SECTION("A mesh nobody holds on to any more is loaded again")
+    {
+        assets.clear();
+        cube.reset();
+
+        std::shared_ptr<MeshAsset> reloaded = assetLoader.RequestMesh(GetGLTFPath("cube.gltf"));
+        REQUIRE(assetLoader.GetLoadCount() == 4);
+        REQUIRE(assetLoader.Wait(*reloaded));
+        REQUIRE(reloaded->GetView().vertices.size() == 36);
+    }
+
+    SECTION("Requests from other threads share the asset as well")
+    {
+        std::atomic<uint32_t> sharedCount = 0;
+        jobSystem.ParallelFor(64, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (assetLoader.RequestMesh(GetGLTFPath("rock.gltf")) == assets[0])
+                    sharedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        REQUIRE(sharedCount == 64);
+        REQUIRE(assetLoader.GetLoadCount() == 3);
+    }
+
+    SECTION("Batches carry the mesh index and channels of every request")
+    {
+        std::vector<MeshRequest> batch = {
+            {.path = GetGLTFPath("cube.gltf")},
+            {.path = GetGLTFPath("cube.gltf"), .channels = ShaderChannel::Position},
+            {.path = GetGLTFPath("cube.gltf"), .meshIndex = 1},
+        };
+        std::vector<std::shared_ptr<MeshAsset>> batchAssets = assetLoader.RequestMeshes(batch);
+
+        REQUIRE(batchAssets[0] == cube);
+        REQUIRE(batchAssets[1] != cube);
+        REQUIRE(batchAssets[1]->channels == ShaderChannel::Position);
+        REQUIRE(batchAssets[2]->meshIndex == 1);
+        REQUIRE(assetLoader.GetLoadCount() == 5);
+
+        REQUIRE(assetLoader.Wait(*batchAssets[1]));
+        REQUIRE(batchAssets[1]->GetView().vertices.size() == 36);
+        // the cube has a single mesh
+        REQUIRE(assetLoader.Wait(*batchAssets[2]) == false);
+    }
+}
+
+TEST_CASE("Assets that fail to load do not hold up their waiters", "[AssetLoader]")
+{
+    JobSystem jobSystem(1);
+
+    // without a JobSystem the request itself loads
+    AssetLoader inlineLoader(nullptr);
+    AssetLoader assetLoader(&jobSystem);
+
+    for (AssetLoader* loader : {&inlineLoader, &assetLoader})
+    {
+        std::shared_ptr<MeshAsset> mesh   = loader->RequestMesh(GetGLTFPath("missing.gltf"));
+        std::shared_ptr<ImageAsset> image = loader->RequestImage((k_ResourceFolder / "texture" / "missing.jpg").generic_string());
+
+        REQUIRE(loader->Wait(*mesh) == false);
+        REQUIRE(loader->Wait(*image) == false);
+        REQUIRE(mesh->IsDone());
+        REQUIRE(image->data.pixels.empty());
+    }
+}
+
+TEST_CASE("Asset cold load benchmark", "[AssetLoader][.benchmark]")
+{
+    constexpr int repeatCount = 32;
+
+    // every repetition loads copies of its own, the loader would only read a file once otherwise
+    const std::filesystem::path folder = std::filesystem::temp_directory_path() / "gore_asset_loader_benchmark";
+    std::filesystem::remove_all(folder);
+
+    std::vector<MeshRequest> meshRequests;
+    std::vector<std::string> imagePaths;
+    for (int i = 0; i < repeatCount; ++i)
+    {
+        std::filesystem::path copyFolder = folder / std::to_string(i);
+        std::filesystem::create_directories(copyFolder);
+
+        for (const char* subFolder : {"gltf", "texture"})
+        {
+            for (const auto& entry : std::filesystem::directory_iterator(k_ResourceFolder / subFolder))
+            {
+                std::filesystem::path copyPath = copyFolder / entry.path().filename();
+                std::filesystem::copy_file(entry.path(), copyPath);
+
+                if (entry.path().extension() == ".gltf")
+                    meshRequests.push_back({.path = copyPath.generic_string()});
+                else
+                    imagePaths.push_back(copyPath.generic_string());
+            }
+        }
+    }
+
+    auto loadAll = [&](AssetLoader& assetLoader, const std::vector<MeshRequest>& meshes, const std::vector<std::string>& images)
+    {
+        auto meshAssets  = assetLoader.RequestMeshes(meshes);
+        auto imageAssets = assetLoader.RequestImages(images);
+
+        uint32_t loadedCount = 0;
+        for (const auto& asset : meshAssets)
+            loadedCount += assetLoader.Wait(*asset) ? 1 : 0;
+        for (const auto& asset : imageAssets)
+            loadedCount += assetLoader.Wait(*asset) ? 1 : 0;
+        return loadedCount;
+    };
+
+    BENCHMARK("Serial, " + std::to_string(repeatCount) + " copies")
+    {
+        AssetLoader assetLoader(nullptr);
+        return loadAll(assetLoader, meshRequests, imagePaths);
+    };
+
+    uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t threads = 2; threads <= maxThreads; threads *= 2)
+    {
+        JobSystem jobSystem(threads - 1);
+
+        BENCHMARK("JobSystem, " + std::to_string(threads) + " threads, " + std::to_string(repeatCount) + " copies")
+        {
+            AssetLoader assetLoader(&jobSystem);
+            return loadAll(assetLoader, meshRequests, imagePaths);
+        };
+    }
+
+    // the same files requested repeatCount times in one batch, which is read once
+    std::vector<MeshRequest> sameMeshRequests;
+    std::vector<std::string> sameImagePaths;
+    for (int i = 0; i < repeatCount; ++i)
+    {
+        sameMeshRequests.insert(sameMeshRequests.end(), meshRequests.begin(), meshRequests.begin() + meshRequests.size() / repeatCount);
+        sameImagePaths.insert(sameImagePaths.end(), imagePaths.begin(), imagePaths.begin() + imagePaths.size() / repeatCount);
+    }
+
+    {
+        JobSystem jobSystem(maxThreads - 1);
+
+        BENCHMARK("JobSystem, same files " + std::to_string(repeatCount) + " times")
+        {
+            AssetLoader assetLoader(&jobSystem);
+            return loadAll(assetLoader, sameMeshRequests, sameImagePaths);
+        };
+    }
+
+    std::filesystem::remove_all(folder);
+}
+
+} // namespace gore::test
+#endif
@@ -6,21 +6,41 @@ namespace gore
 {
 BitWriter::BitWriter(void* data, size_t size) :
     m_AllowResize(false),
+    m_Storage(),
+    m_Data(static_cast<uint8_t*>(data)),
+    m_ByteCount(size),
     m_Index(0)
 {
-    m_Data.assign(static_cast<uint8_t*>(data), static_cast<uint8_t*>(data) + size);
 }
 
 BitWriter::BitWriter(size_t maxByteCount, bool allowResize) :
     m_AllowResize(allowResize),
+    m_Storage(maxByteCount),
+    m_Data(m_Storage.data()),
+    m_ByteCount(maxByteCount),
     m_Index(0)
 {
-    m_Data.resize(maxByteCount);
+}
+
+void BitWriter::Resize(size_t byteCount)
+{
+    m_Storage.resize(byteCount);
+    m_Data      = m_Storage.data();
+    m_ByteCount = byteCount;
+}
+
+void BitWriter::ShrinkToFit()
+{
+    // memory that is not ours can not be shrunk
+    if (m_Data != m_Storage.data())
+        return;
+
+    Resize(m_Index);
 }
 
 void BitWriter::WriteUInt8(uint8_t value)
 {
-    if (m_Index >= m_Data.size())
+    if (m_Index >= m_ByteCount)
     {
         if (!m_AllowResize)
         {
@@ -28,7 +48,7 @@ void BitWriter::WriteUInt8(uint8_t value)
             return;
         }
 
-        m_Data.resize(m_Data.size() * 2);
+        Resize(m_ByteCount == 0 ? 1 : m_ByteCount * 2);
     }
 
     m_Data[m_Index++] = value;
@@ -46,4 +66,4 @@ void BitWriter::WriteUInt32(uint32_t value)
     WriteUInt16((value >> 16) & 0xFFFF);
 }
 
-} // namespace gore
\ No newline at end of file
+} // namespace gore
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <cassert>
 #include <cstring>
 #include <stdexcept>
 
@@ -9,12 +10,19 @@ struct BitWriter
 {
 public:
     BitWriter(size_t maxByteCount, bool allowResize = false);
+    // Writes straight into data, which has to outlive the writer. The writer never resizes it.
     BitWriter(void* data, size_t size);
 
+    // m_Data may point into m_Storage, a copy would point into the original
+    BitWriter(const BitWriter&)            = delete;
+    BitWriter& operator=(const BitWriter&) = delete;
+    BitWriter(BitWriter&&)                 = default;
+    BitWriter& operator=(BitWriter&&)      = default;
+
     void Flush() { m_Index = 0; }
-    void ShrinkToFit() { m_Data.resize(m_Index); }
+    void ShrinkToFit();
 
-    uint8_t* GetData() { return m_Data.data(); }
+    uint8_t* GetData() { return m_Data; }
 
     void WriteUInt8(uint8_t value);
     void WriteUInt16(uint16_t value);
@@ -24,11 +32,11 @@ public:
     void Write(const T& value)
     {
         size_t size = sizeof(T);
-        if (m_Index + size > m_Data.size())
+        if (m_Index + size > m_ByteCount)
         {
             if (m_AllowResize)
             {
-                m_Data.resize(m_Index + size);
+                Resize(m_Index + size);
             }
             else
             {
@@ -38,17 +46,31 @@ public:
         std::memcpy(&m_Data[m_Index], &value, size);
         m_Index += size;
     }
+
+    // For callers that sized the buffer for the worst case up front
+    template <typename T>
+    void WriteUnchecked(const T& value)
+    {
+        assert(m_Index + sizeof(T) <= m_ByteCount && "BitWriter overflow");
+        std::memcpy(&m_Data[m_Index], &value, sizeof(T));
+        m_Index += sizeof(T);
+    }
     
     bool IsAllowResize() const { return m_AllowResize; }
     
-    size_t GetByteCount() const { return m_Data.size(); }
+    size_t GetByteCount() const { return m_ByteCount; }
     size_t GetByteWritten() const { return m_Index; }
     size_t GetByteRemaining() const { return GetByteCount() - GetByteWritten(); }
 
 private:
+    void Resize(size_t byteCount);
+
     bool m_AllowResize;
 
-    std::vector<uint8_t> m_Data;
+    // only used when the writer owns its memory
+    std::vector<uint8_t> m_Storage;
+    uint8_t* m_Data;
+    size_t m_ByteCount;
     size_t m_Index;
 };
-} // namespace gore
\ No newline at end of file
+} // namespace gore
@@ -0,0 +1,183 @@
+#include "CookedMesh.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace gore::gfx
+{
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static bool GetSourceStamp(const std::string& sourcePath, int64_t& writeTime, uint64_t& byteSize)
+{
+    std::error_code error;
+    auto lastWriteTime = std::filesystem::last_write_time(sourcePath, error);
+    if (error)
+        return false;
+
+    uintmax_t fileSize = std::filesystem::file_size(sourcePath, error);
+    if (error)
+        return false;
+
+    writeTime = static_cast<int64_t>(lastWriteTime.time_since_epoch().count());
+    byteSize  = static_cast<uint64_t>(fileSize);
+    return true;
+}
+
+CookedMesh::CookedMesh() :
+    m_File(),
+    m_Header(nullptr)
+{
+}
+
+CookedMesh::~CookedMesh()
+{
+    Close();
+}
+
+bool CookedMesh::Write(const std::string& path, const MeshData& meshData, const std::string& sourcePath, ShaderChannel channels)
+{
+    CookedMeshHeader header;
+    header.magic        = k_Magic;
+    header.version      = k_Version;
+    header.vertexStride = sizeof(Vertex);
+    header.vertexCount  = static_cast<uint32_t>(meshData.vertices.size());
+    header.indexType    = static_cast<uint32_t>(meshData.indexType);
+    header.indexCount   = meshData.indexCount;
+    header.channels     = static_cast<uint32_t>(channels);
+    header.subMeshCount = static_cast<uint32_t>(meshData.subMeshes.size());
+
+    if (GetSourceStamp(sourcePath, header.sourceWriteTime, header.sourceByteSize) == false)
+        return false;
+
+    header.vertexByteOffset = AlignUp(sizeof(CookedMeshHeader), k_StreamAlignment);
+    header.vertexByteSize   = meshData.vertices.size() * sizeof(Vertex);
+    header.indexByteOffset  = AlignUp(header.vertexByteOffset + header.vertexByteSize, k_StreamAlignment);
+    header.indexByteSize    = meshData.indices.size();
+
+    header.subMeshByteOffset = AlignUp(header.indexByteOffset + header.indexByteSize, k_StreamAlignment);
+    header.subMeshByteSize   = meshData.subMeshes.size() * sizeof(renderer::SubMesh);
+
+    std::vector<uint8_t> fileData(header.subMeshByteOffset + header.subMeshByteSize, 0);
+    std::memcpy(fileData.data(), &header, sizeof(header));
+    if (meshData.vertices.empty() == false)
+        std::memcpy(fileData.data() + header.vertexByteOffset, meshData.vertices.data(), header.vertexByteSize);
+    if (meshData.indices.empty() == false)
+        std::memcpy(fileData.data() + header.indexByteOffset, meshData.indices.data(), header.indexByteSize);
+    if (meshData.subMeshes.empty() == false)
+        std::memcpy(fileData.data() + header.subMeshByteOffset, meshData.subMeshes.data(), header.subMeshByteSize);
+
+    // written next to it and moved over, so a reader never maps a file that is half written. Every write has a temp
+    // file of its own, writers of the same path only race on the rename, which replaces the file as a whole.
+    static std::atomic<uint32_t> s_WriteCount = 0;
+    size_t threadHash    = std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::string tempPath = path + "." + std::to_string(threadHash) + "." + std::to_string(s_WriteCount.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        file.write(reinterpret_cast<const char*>(fileData.data()), static_cast<std::streamsize>(fileData.size()));
+        if (!file.good())
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+std::string CookedMesh::GetCookedPath(const std::string& sourcePath, int meshIndex, ShaderChannel channels)
+{
+    // Open rejects other channels, so they can not share a file
+    std::string extension = meshIndex == 0 ? "" : "." + std::to_string(meshIndex);
+    if (channels != ShaderChannel::Default)
+        extension += ".c" + std::to_string(static_cast<uint32_t>(channels));
+
+    std::filesystem::path cookedPath = sourcePath;
+    cookedPath.replace_extension(extension + ".gmesh");
+    return cookedPath.generic_string();
+}
+
+bool CookedMesh::Open(const std::string& path, const std::string& sourcePath, ShaderChannel channels)
+{
+    Close();
+
+    m_File = MapFile(path.c_str());
+    if (m_File.data == nullptr)
+        return false;
+
+    const auto* header      = static_cast<const CookedMeshHeader*>(m_File.data);
+    const uint64_t fileSize = m_File.size;
+
+    bool valid = fileSize >= sizeof(CookedMeshHeader)
+              && header->magic == k_Magic
+              && header->version == k_Version
+              && header->vertexStride == sizeof(Vertex)
+              && header->channels == static_cast<uint32_t>(channels)
+              && header->vertexByteSize == static_cast<uint64_t>(header->vertexCount) * sizeof(Vertex)
+              && header->indexByteSize == static_cast<uint64_t>(header->indexCount) * GetIndexTypeSize(static_cast<IndexType>(header->indexType))
+              && header->vertexByteOffset % k_StreamAlignment == 0
+              && header->subMeshByteSize == static_cast<uint64_t>(header->subMeshCount) * sizeof(renderer::SubMesh)
+              && header->indexByteOffset % k_StreamAlignment == 0
+              && header->subMeshByteOffset % k_StreamAlignment == 0
+              && header->vertexByteOffset >= sizeof(CookedMeshHeader)
+              && header->vertexByteOffset <= fileSize && header->vertexByteSize <= fileSize - header->vertexByteOffset
+              && header->indexByteOffset <= fileSize && header->indexByteSize <= fileSize - header->indexByteOffset
+              && header->subMeshByteOffset <= fileSize && header->subMeshByteSize <= fileSize - header->subMeshByteOffset;
+
+    if (valid && sourcePath.empty() == false)
+    {
+        int64_t writeTime = 0;
+        uint64_t byteSize = 0;
+        valid = GetSourceStamp(sourcePath, writeTime, byteSize)
+             && header->sourceWriteTime == writeTime
+             && header->sourceByteSize == byteSize;
+    }
+
+    if (valid == false)
+    {
+        UnmapFile(m_File);
+        return false;
+    }
+
+    m_Header = header;
+    return true;
+}
+
+void CookedMesh::Close()
+{
+    UnmapFile(m_File);
+    m_Header = nullptr;
+}
+
+MeshDataView CookedMesh::GetView() const
+{
+    if (m_Header == nullptr)
+        return {};
+
+    const auto* fileData = static_cast<const uint8_t*>(m_File.data);
+
+    return {
+        .vertices   = {reinterpret_cast<const Vertex*>(fileData + m_Header->vertexByteOffset), m_Header->vertexCount},
+        .indices    = {fileData + m_Header->indexByteOffset, static_cast<size_t>(m_Header->indexByteSize)},
+        .indexType  = static_cast<IndexType>(m_Header->indexType),
+        .indexCount = m_Header->indexCount,
+        .subMeshes  = {reinterpret_cast<const renderer::SubMesh*>(fileData + m_Header->subMeshByteOffset), m_Header->subMeshCount},
+    };
+}
+} // namespace gore::gfx
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Prefix.h"
+#include "Export.h"
+
+#include "Platform/MappedFile.h"
+#include "Rendering/Utils/GeometryUtils.h"
+
+#include <string>
+
+namespace gore::gfx
+{
+// Start of a cooked mesh file. The vertex stream follows at vertexByteOffset in the layout of Vertex, the index
+// stream at indexByteOffset and the SubMesh table at subMeshByteOffset, all aligned to CookedMesh::k_StreamAlignment.
+struct CookedMeshHeader final
+{
+    uint32_t magic        = 0;
+    uint32_t version      = 0;
+    uint32_t vertexStride = 0;
+    uint32_t vertexCount  = 0;
+    uint32_t indexType    = 0;
+    uint32_t indexCount   = 0;
+    uint32_t channels     = 0;
+    uint32_t subMeshCount = 0;
+
+    // the file the mesh was cooked from, the cooked mesh is not used once it changed
+    int64_t sourceWriteTime = 0;
+    uint64_t sourceByteSize = 0;
+
+    uint64_t vertexByteOffset  = 0;
+    uint64_t vertexByteSize    = 0;
+    uint64_t indexByteOffset   = 0;
+    uint64_t indexByteSize     = 0;
+    uint64_t subMeshByteOffset = 0;
+    uint64_t subMeshByteSize   = 0;
+};
+
+static_assert(sizeof(CookedMeshHeader) == 96);
+
+// A mesh written the way the upload path reads it, so loading it is mapping the file. Nothing is parsed or
+// converted, GetView points into the mapping for as long as the CookedMesh is open.
+ENGINE_CLASS(CookedMesh) final
+{
+public:
+    static constexpr uint32_t k_Magic           = 0x48534D47; // GMSH
+    static constexpr uint32_t k_Version         = 2;
+    static constexpr uint32_t k_StreamAlignment = 64;
+
+    CookedMesh();
+    ~CookedMesh();
+
+    NON_COPYABLE(CookedMesh);
+
+    // sourcePath is the file meshData was built from
+    static bool Write(const std::string& path, const MeshData& meshData, const std::string& sourcePath, ShaderChannel channels = ShaderChannel::Default);
+    // Where the cooked mesh of meshIndex in a glTF file is looked for, each set of channels is cooked to its own file
+    [[nodiscard]] static std::string GetCookedPath(const std::string& sourcePath, int meshIndex = 0, ShaderChannel channels = ShaderChannel::Default);
+
+    // Fails when the file is not a cooked mesh of this version with these channels, or sourcePath changed since it
+    // was cooked. An empty sourcePath is not checked.
+    bool Open(const std::string& path, const std::string& sourcePath = {}, ShaderChannel channels = ShaderChannel::Default);
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const { return m_Header != nullptr; }
+    [[nodiscard]] MeshDataView GetView() const;
+
+private:
+    MappedFile m_File;
+    const CookedMeshHeader* m_Header;
+};
+} // namespace gore::gfx
@@ -0,0 +1,192 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Utilities/AssetLoader.h"
+#include "Utilities/CookedMesh.h"
+#include "Utilities/GLTFLoader.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace gore::test
+{
+using namespace gore::gfx;
+
+static const std::filesystem::path k_ResourceFolder = TEST_RESOURCE_FOLDER;
+
+static std::filesystem::path MakeTempFolder(const char* name)
+{
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(folder);
+    std::filesystem::create_directories(folder);
+    return folder;
+}
+
+static MeshData MakeTriangle()
+{
+    MeshData meshData;
+    meshData.vertices = {
+        {Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector2(0.0f, 0.0f)},
+        {Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector2(1.0f, 0.0f)},
+        {Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector2(0.0f, 1.0f)},
+    };
+
+    const uint16_t indices[] = {0, 1, 2};
+    meshData.indices.resize(sizeof(indices));
+    std::memcpy(meshData.indices.data(), indices, sizeof(indices));
+    meshData.indexType  = IndexType::UINT16;
+    meshData.indexCount = 3;
+    meshData.subMeshes  = {{.vertexOffset = 0, .vertexCount = 3, .indexOffset = 0, .indexCount = 3}};
+    return meshData;
+}
+
+TEST_CASE("Cooked meshes map what was written", "[CookedMesh]")
+{
+    std::filesystem::path folder = MakeTempFolder("gore_cooked_mesh_test");
+    std::string sourcePath       = (folder / "triangle.gltf").generic_string();
+    std::ofstream(sourcePath) << "{}";
+
+    std::string cookedPath = CookedMesh::GetCookedPath(sourcePath);
+    REQUIRE(cookedPath == (folder / "triangle.gmesh").generic_string());
+    REQUIRE(CookedMesh::GetCookedPath(sourcePath, 2) == (folder / "triangle.2.gmesh").generic_string());
+    REQUIRE(CookedMesh::GetCookedPath(sourcePath, 0, ShaderChannel::Position) != cookedPath);
+    REQUIRE(CookedMesh::GetCookedPath(sourcePath, 2, ShaderChannel::Position) != CookedMesh::GetCookedPath(sourcePath, 0, ShaderChannel::Position));
+
+    MeshData meshData = MakeTriangle();
+    REQUIRE(CookedMesh::Write(cookedPath, meshData, sourcePath));
+
+    CookedMesh cookedMesh;
+    REQUIRE(cookedMesh.Open(cookedPath, sourcePath));
+
+    MeshDataView view = cookedMesh.GetView();
+    REQUIRE(view.vertices.size() == 3);
+    REQUIRE(view.indexType == IndexType::UINT16);
+    REQUIRE(view.indexCount == 3);
+    REQUIRE(std::memcmp(view.vertices.data(), meshData.vertices.data(), 3 * sizeof(Vertex)) == 0);
+    REQUIRE(std::memcmp(view.indices.data(), meshData.indices.data(), meshData.indices.size()) == 0);
+    REQUIRE(view.subMeshes.size() == 1);
+    REQUIRE(view.subMeshes[0].vertexCount == 3);
+    REQUIRE(view.subMeshes[0].indexCount == 3);
+
+    // the mapping is page aligned, so are the streams in it
+    REQUIRE(reinterpret_cast<uintptr_t>(view.vertices.data()) % CookedMesh::k_StreamAlignment == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(view.indices.data()) % CookedMesh::k_StreamAlignment == 0);
+
+    SECTION("A cooked mesh is not used once its source changed")
+    {
+        cookedMesh.Close();
+        std::ofstream(sourcePath, std::ios::app) << " ";
+
+        REQUIRE(cookedMesh.Open(cookedPath, sourcePath) == false);
+        REQUIRE(cookedMesh.IsOpen() == false);
+        REQUIRE(cookedMesh.GetView().vertices.empty());
+
+        // without its source it is used as it is
+        REQUIRE(cookedMesh.Open(cookedPath));
+    }
+
+    SECTION("Other channels are another mesh")
+    {
+        REQUIRE(cookedMesh.Open(cookedPath, sourcePath, ShaderChannel::Position) == false);
+    }
+
+    SECTION("Files that are not whole cooked meshes are refused")
+    {
+        cookedMesh.Close();
+        std::filesystem::resize_file(cookedPath, std::filesystem::file_size(cookedPath) - 1);
+        REQUIRE(cookedMesh.Open(cookedPath) == false);
+
+        // long enough to hold a header
+        std::ofstream(cookedPath, std::ios::binary | std::ios::trunc) << std::string(256, 'x');
+        REQUIRE(cookedMesh.Open(cookedPath) == false);
+
+        REQUIRE(cookedMesh.Open((folder / "missing.gmesh").generic_string()) == false);
+    }
+
+    cookedMesh.Close();
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("The asset loader cooks glTF meshes and maps them from then on", "[CookedMesh][AssetLoader]")
+{
+    std::filesystem::path folder = MakeTempFolder("gore_cooked_mesh_asset_test");
+    std::string sourcePath       = (folder / "rock.gltf").generic_string();
+    std::filesystem::copy_file(k_ResourceFolder / "gltf" / "rock.gltf", sourcePath);
+
+    MeshData gltfData;
+    {
+        AssetLoader assetLoader(nullptr, {.cookMeshes = true});
+        std::shared_ptr<MeshAsset> asset = assetLoader.RequestMesh(sourcePath);
+        REQUIRE(assetLoader.Wait(*asset));
+        REQUIRE(asset->cookedMesh.IsOpen() == false);
+        REQUIRE(std::filesystem::exists(CookedMesh::GetCookedPath(sourcePath)));
+
+        gltfData = asset->data;
+    }
+
+    AssetLoader assetLoader(nullptr);
+    std::shared_ptr<MeshAsset> asset = assetLoader.RequestMesh(sourcePath);
+    REQUIRE(assetLoader.Wait(*asset));
+    REQUIRE(asset->cookedMesh.IsOpen());
+    REQUIRE(asset->data.vertices.empty());
+
+    MeshDataView view = asset->GetView();
+    REQUIRE(view.vertices.size() == gltfData.vertices.size());
+    REQUIRE(view.indexType == gltfData.indexType);
+    REQUIRE(view.indexCount == gltfData.indexCount);
+    REQUIRE(std::memcmp(view.vertices.data(), gltfData.vertices.data(), view.vertices.size_bytes()) == 0);
+    REQUIRE(std::memcmp(view.indices.data(), gltfData.indices.data(), view.indices.size_bytes()) == 0);
+    REQUIRE(view.subMeshes.size() == gltfData.subMeshes.size());
+
+    asset.reset();
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("Cooked mesh load benchmark", "[CookedMesh][.benchmark]")
+{
+    std::filesystem::path folder = MakeTempFolder("gore_cooked_mesh_benchmark");
+
+    for (const char* name : {"teapot", "rock"})
+    {
+        std::string sourcePath = (k_ResourceFolder / "gltf" / (std::string(name) + ".gltf")).generic_string();
+        std::string cookedPath = (folder / (std::string(name) + ".gmesh")).generic_string();
+
+        MeshData meshData;
+        GLTFLoader gltfLoader;
+        REQUIRE(gltfLoader.LoadMesh(meshData, sourcePath));
+        REQUIRE(CookedMesh::Write(cookedPath, meshData, sourcePath));
+
+        BENCHMARK(std::string("ASCII glTF, ") + name)
+        {
+            MeshData loaded;
+            GLTFLoader loader;
+            loader.LoadMesh(loaded, sourcePath);
+            return loaded.vertices.size();
+        };
+
+        // the pages are only read in once the upload path copies from them, which is touching each of them once
+        BENCHMARK(std::string("Cooked, ") + name)
+        {
+            CookedMesh cookedMesh;
+            cookedMesh.Open(cookedPath, sourcePath);
+
+            MeshDataView view       = cookedMesh.GetView();
+            const auto* vertexBytes = reinterpret_cast<const uint8_t*>(view.vertices.data());
+            uint64_t sum            = 0;
+            for (size_t i = 0; i < view.vertices.size_bytes(); i += 4096)
+                sum += vertexBytes[i];
+            for (size_t i = 0; i < view.indices.size(); i += 4096)
+                sum += view.indices[i];
+            return sum;
+        };
+    }
+
+    std::filesystem::remove_all(folder);
+}
+
+} // namespace gore::test
+#endif
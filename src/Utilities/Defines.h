@@ -38,6 +38,11 @@
     [[nodiscard]] TYPE Get##NAME() const { return m_##NAME; } \
     void Set##NAME(TYPE NAME) { m_##NAME = NAME; }
 
+// Same as GETTER_SETTER, but calls ON_CHANGED() after the value has been set
+#define GETTER_SETTER_NOTIFY(TYPE, NAME, ON_CHANGED) \
+    [[nodiscard]] TYPE Get##NAME() const { return m_##NAME; } \
+    void Set##NAME(TYPE NAME) { m_##NAME = NAME; ON_CHANGED(); }
+
 #define GETTER_SETTER_REF(TYPE, NAME) \
     [[nodiscard]] TYPE& Get##NAME() { return m_##NAME; } \
     void Set##NAME(const TYPE& NAME) { m_##NAME = NAME; }
@@ -1,13 +1,17 @@
 #define TINYGLTF_IMPLEMENTATION
 #include "GLTFLoader.h"
 
-#include "Rendering/Components/MeshRenderer.h"
-#include "Rendering/RenderContext.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
 
 namespace gore::gfx
 {
-GLTFLoader::GLTFLoader(RenderContext& rtx) :
-    m_RenderContext(rtx)
+using renderer::SubMesh;
+
+GLTFLoader::GLTFLoader()
 {
 }
 
@@ -15,15 +19,15 @@ GLTFLoader::~GLTFLoader()
 {
 }
 
-bool GLTFLoader::LoadMesh(MeshRenderer& mesh, const std::string& path, int meshIndex, ShaderChannel channels)
+bool GLTFLoader::LoadModel(tinygltf::Model& model, const std::string& path)
 {
     std::string error;
     std::string warning;
 
-    tinygltf::Model model;
-
     tinygltf::TinyGLTF gltf;
-    bool importResult = gltf.LoadASCIIFromFile(&model, &error, &warning, path);
+    bool isBinary     = std::filesystem::path(path).extension() == ".glb";
+    bool importResult = isBinary ? gltf.LoadBinaryFromFile(&model, &error, &warning, path)
+                                 : gltf.LoadASCIIFromFile(&model, &error, &warning, path);
     if (importResult == false)
     {
         LOG_STREAM(ERROR) << "Failed to load GLTF file: " << path << std::endl;
@@ -42,163 +46,465 @@ bool GLTFLoader::LoadMesh(MeshRenderer& mesh, const std::string& path, int meshI
         LOG_STREAM(WARNING) << warning << std::endl;
     }
 
-    auto pos             = path.find_last_of('/');
-    std::string meshName = path.substr(pos + 1, path.size() - pos - 1);
+    return true;
+}
+
+// Where the elements of an accessor are in its buffer. Elements are stride bytes apart, which is more than their size
+// when the buffer view interleaves several attributes.
+struct AccessorData final
+{
+    const uint8_t* data = nullptr;
+    size_t count        = 0;
+    size_t stride       = 0;
+    int componentType   = 0;
+    int componentSize   = 0;
+};
+
+// Fails for accessors of another type and for those that do not fit in their buffer view
+static bool GetAccessorData(const tinygltf::Model& model, int accessorIndex, int type, AccessorData& accessorData)
+{
+    if (accessorIndex < 0 || accessorIndex >= static_cast<int>(model.accessors.size()))
+        return false;
+
+    // sparse accessors without a buffer view are not supported
+    const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+    if (accessor.type != type || accessor.bufferView < 0 || accessor.bufferView >= static_cast<int>(model.bufferViews.size()))
+        return false;
+
+    const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+    if (bufferView.buffer < 0 || bufferView.buffer >= static_cast<int>(model.buffers.size()))
+        return false;
+
+    const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+
+    int componentSize  = tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(accessor.componentType));
+    int componentCount = tinygltf::GetNumComponentsInType(static_cast<uint32_t>(accessor.type));
+    int stride         = accessor.ByteStride(bufferView);
+    if (componentSize <= 0 || componentCount <= 0 || stride <= 0)
+        return false;
+
+    size_t elementSize = static_cast<size_t>(componentSize) * componentCount;
+    size_t byteSize    = accessor.count == 0 ? 0 : (accessor.count - 1) * stride + elementSize;
+    if (bufferView.byteOffset > buffer.data.size() || bufferView.byteLength > buffer.data.size() - bufferView.byteOffset
+        || accessor.byteOffset > bufferView.byteLength || byteSize > bufferView.byteLength - accessor.byteOffset)
+        return false;
 
-    return CreateMeshFromGLTF(mesh, model, meshIndex, meshName, channels);
+    accessorData.data          = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+    accessorData.count         = accessor.count;
+    accessorData.stride        = static_cast<size_t>(stride);
+    accessorData.componentType = accessor.componentType;
+    accessorData.componentSize = componentSize;
+    return true;
 }
 
-static GraphicsFormat GetIndexDataFormat(const tinygltf::Accessor& accessor)
+// Attributes are floats or, for texture coordinates, normalized unsigned integers
+static float ReadFloatComponent(const uint8_t* data, int componentType)
 {
-    switch (accessor.componentType)
+    switch (componentType)
     {
-        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-            return GraphicsFormat::R8_UINT;
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+        {
+            float value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
         case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-            return GraphicsFormat::R16_UINT;
-        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-            return GraphicsFormat::R32_UINT;
+        {
+            uint16_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value / 65535.0f;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return data[0] / 255.0f;
         default:
-            assert(false);
-            return GraphicsFormat::Undefined;
+            return 0.0f;
     }
 }
 
-bool GLTFLoader::CreateMeshFromGLTF(MeshRenderer& mesh, const tinygltf::Model& model, int meshIndex, const std::string& name, ShaderChannel channels)
+static bool IsFloatComponentType(int componentType)
 {
-    // FIXME: only support default vertex now
-    assert(channels == ShaderChannel::Default);
+    return componentType == TINYGLTF_COMPONENT_TYPE_FLOAT
+        || componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT
+        || componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+}
 
-    assert(meshIndex >= 0 && meshIndex < model.meshes.size());
+// Calls write(i, values) with the components of every element of a VEC2 or VEC3 attribute
+template <int ComponentCount, typename WriteFunc>
+static bool ReadAttribute(const tinygltf::Model& model, int accessorIndex, size_t vertexCount, WriteFunc&& write)
+{
+    static_assert(ComponentCount == 2 || ComponentCount == 3);
 
-    auto& gltfPrimitive = model.meshes[meshIndex].primitives[0];
+    AccessorData accessorData;
+    int type = ComponentCount == 2 ? TINYGLTF_TYPE_VEC2 : TINYGLTF_TYPE_VEC3;
+    if (GetAccessorData(model, accessorIndex, type, accessorData) == false
+        || accessorData.count != vertexCount
+        || IsFloatComponentType(accessorData.componentType) == false)
+        return false;
 
-    const float* pos     = nullptr;
-    const float* normals = nullptr;
-    const float* uvs     = nullptr;
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const uint8_t* element = accessorData.data + i * accessorData.stride;
 
-    bool needPosition = HasFlag(channels, ShaderChannel::Position);
-    bool hasPosition  = gltfPrimitive.attributes.find("POSITION") != gltfPrimitive.attributes.end();
-    assert(needPosition && hasPosition);
+        float values[ComponentCount];
+        for (int c = 0; c < ComponentCount; ++c)
+            values[c] = ReadFloatComponent(element + c * accessorData.componentSize, accessorData.componentType);
 
-    const tinygltf::Accessor& accessor = model.accessors[gltfPrimitive.attributes.find("POSITION")->second];
+        write(i, values);
+    }
 
-    int vertexCount = accessor.count;
-    mesh.SetVertexCount(vertexCount);
+    return true;
+}
 
-    const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-    const tinygltf::Buffer& buffer         = model.buffers[bufferView.buffer];
+static bool ReadIndex(const uint8_t* data, int componentType, uint32_t& index)
+{
+    switch (componentType)
+    {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            index = data[0];
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        {
+            uint16_t value;
+            std::memcpy(&value, data, sizeof(value));
+            index = value;
+            return true;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            std::memcpy(&index, data, sizeof(index));
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Adds a primitive as a sub-mesh of meshData. Its indices are collected 32 bit in indices until WriteIndices knows
+// the size all of them fit in.
+static bool AppendPrimitive(MeshData& meshData, std::vector<uint32_t>& indices, const tinygltf::Model& model, const tinygltf::Primitive& primitive, ShaderChannel channels)
+{
+    // points, lines and strips would need pipelines of their own
+    if (primitive.mode != -1 && primitive.mode != TINYGLTF_MODE_TRIANGLES)
+    {
+        LOG_STREAM(WARNING) << "Skipping GLTF primitive that is not a triangle list, mode " << primitive.mode << std::endl;
+        return true;
+    }
+
+    auto position = primitive.attributes.find("POSITION");
+    if (position == primitive.attributes.end())
+        return false;
+
+    AccessorData positionData;
+    if (GetAccessorData(model, position->second, TINYGLTF_TYPE_VEC3, positionData) == false)
+        return false;
+
+    size_t vertexCount = positionData.count;
+    size_t firstVertex = meshData.vertices.size();
+    meshData.vertices.resize(firstVertex + vertexCount, Vertex{k_DefaultPosition, k_DefaultNormal, k_DefaultUV});
+    Vertex* vertices = meshData.vertices.data() + firstVertex;
+
+    bool readPosition = ReadAttribute<3>(model, position->second, vertexCount, [vertices](size_t i, const float* values)
+    {
+        vertices[i].position = Vector3(values[0], values[1], values[2]);
+    });
 
-    pos = reinterpret_cast<const float*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
+    if (readPosition == false)
+        return false;
 
-    bool hasNormals = gltfPrimitive.attributes.find("NORMAL") != gltfPrimitive.attributes.end();
-    if (hasNormals)
+    // channels that are not asked for or that the primitive does not have keep their defaults
+    auto normal = primitive.attributes.find("NORMAL");
+    if (HasFlag(channels, ShaderChannel::Normal) && normal != primitive.attributes.end())
     {
-        const tinygltf::Accessor& accessor     = model.accessors[gltfPrimitive.attributes.find("NORMAL")->second];
-        const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-        const tinygltf::Buffer& buffer         = model.buffers[bufferView.buffer];
+        bool readNormal = ReadAttribute<3>(model, normal->second, vertexCount, [vertices](size_t i, const float* values)
+        {
+            vertices[i].normal = Vector3(values[0], values[1], values[2]);
+        });
 
-        normals = reinterpret_cast<const float*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
+        if (readNormal == false)
+            return false;
     }
 
-    bool hasUVs = gltfPrimitive.attributes.find("TEXCOORD_0") != gltfPrimitive.attributes.end();
-    if (hasUVs)
+    auto uv = primitive.attributes.find("TEXCOORD_0");
+    if (HasFlag(channels, ShaderChannel::UV0) && uv != primitive.attributes.end())
     {
-        const tinygltf::Accessor& accessor     = model.accessors[gltfPrimitive.attributes.find("TEXCOORD_0")->second];
-        const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-        const tinygltf::Buffer& buffer         = model.buffers[bufferView.buffer];
+        bool readUV = ReadAttribute<2>(model, uv->second, vertexCount, [vertices](size_t i, const float* values)
+        {
+            vertices[i].uv = Vector2(values[0], values[1]);
+        });
 
-        uvs = reinterpret_cast<const float*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
+        if (readUV == false)
+            return false;
     }
 
-    std::vector<Vertex> vertexData;
-    vertexData.reserve(vertexCount);
+    SubMesh subMesh;
+    subMesh.vertexOffset = static_cast<uint32_t>(firstVertex);
+    subMesh.vertexCount  = static_cast<uint32_t>(vertexCount);
+    subMesh.indexOffset  = static_cast<uint32_t>(indices.size());
 
-    for (int i = 0; i < vertexCount; ++i)
+    if (primitive.indices >= 0)
     {
-        Vertex vertex;
-        vertex.position = Vector3(pos[0], pos[1], pos[2]);
-        pos += 3;
+        AccessorData indexData;
+        if (GetAccessorData(model, primitive.indices, TINYGLTF_TYPE_SCALAR, indexData) == false)
+            return false;
 
-        if (hasNormals)
+        indices.reserve(indices.size() + indexData.count);
+        for (size_t i = 0; i < indexData.count; ++i)
         {
-            vertex.normal = Vector3(normals[0], normals[1], normals[2]);
-            normals += 3;
-        }
-        else
-        {
-            vertex.normal = k_DefaultNormal;
-        }
+            uint32_t index = 0;
+            if (ReadIndex(indexData.data + i * indexData.stride, indexData.componentType, index) == false || index >= vertexCount)
+                return false;
 
-        if (hasUVs)
-        {
-            vertex.uv = Vector2(uvs[0], uvs[1]);
-            uvs += 2;
+            indices.push_back(index);
         }
-        else
+    }
+    else
+    {
+        // drawn without indices in glTF, every sub-mesh is drawn indexed here
+        indices.reserve(indices.size() + vertexCount);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(vertexCount); ++i)
+            indices.push_back(i);
+    }
+
+    subMesh.indexCount = static_cast<uint32_t>(indices.size()) - subMesh.indexOffset;
+    meshData.subMeshes.push_back(subMesh);
+    return true;
+}
+
+static bool AppendMesh(MeshData& meshData, std::vector<uint32_t>& indices, const tinygltf::Model& model, const tinygltf::Mesh& mesh, ShaderChannel channels)
+{
+    for (const tinygltf::Primitive& primitive : mesh.primitives)
+    {
+        if (AppendPrimitive(meshData, indices, model, primitive, channels) == false)
+            return false;
+    }
+
+    return true;
+}
+
+// The indices are collected 32 bit, NarrowIndices makes them 16 bit unless one sub-mesh has more vertices than 16 bit
+// indices can address
+static void WriteIndices(MeshData& meshData, const std::vector<uint32_t>& indices)
+{
+    meshData.indexCount = static_cast<uint32_t>(indices.size());
+    meshData.indices.clear();
+
+    if (indices.empty())
+    {
+        meshData.indexType = IndexType::None;
+        return;
+    }
+
+    meshData.indexType = IndexType::UINT32;
+    meshData.indices.resize(indices.size() * sizeof(uint32_t));
+    std::memcpy(meshData.indices.data(), indices.data(), meshData.indices.size());
+
+    NarrowIndices(meshData);
+}
+
+// The rotation of a matrix whose columns are the rotated x, y and z axes
+static Quaternion GetRotationFromAxes(const double axes[3][3])
+{
+    // element r of column c is axes[c][r]
+    double m00 = axes[0][0], m01 = axes[1][0], m02 = axes[2][0];
+    double m10 = axes[0][1], m11 = axes[1][1], m12 = axes[2][1];
+    double m20 = axes[0][2], m21 = axes[1][2], m22 = axes[2][2];
+
+    double x, y, z, w;
+    double trace = m00 + m11 + m22;
+    if (trace > 0.0)
+    {
+        double s = 2.0 * std::sqrt(trace + 1.0);
+        w        = 0.25 * s;
+        x        = (m21 - m12) / s;
+        y        = (m02 - m20) / s;
+        z        = (m10 - m01) / s;
+    }
+    else if (m00 > m11 && m00 > m22)
+    {
+        double s = 2.0 * std::sqrt(1.0 + m00 - m11 - m22);
+        w        = (m21 - m12) / s;
+        x        = 0.25 * s;
+        y        = (m01 + m10) / s;
+        z        = (m02 + m20) / s;
+    }
+    else if (m11 > m22)
+    {
+        double s = 2.0 * std::sqrt(1.0 + m11 - m00 - m22);
+        w        = (m02 - m20) / s;
+        x        = (m01 + m10) / s;
+        y        = 0.25 * s;
+        z        = (m12 + m21) / s;
+    }
+    else
+    {
+        double s = 2.0 * std::sqrt(1.0 + m22 - m00 - m11);
+        w        = (m10 - m01) / s;
+        x        = (m02 + m20) / s;
+        y        = (m12 + m21) / s;
+        z        = 0.25 * s;
+    }
+
+    return Quaternion(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z), static_cast<float>(w)).Normalized();
+}
+
+// A node has either a matrix or a translation, rotation and scale. The matrix is column major and scales before it
+// rotates, so the lengths of its first three columns are the scale. A mirroring matrix has a negative determinant,
+// its mirror goes to the x scale, which also flips the x axis so the rest is a proper rotation.
+static void ReadNodeTransform(const tinygltf::Node& node, SceneNodeData& nodeData)
+{
+    if (node.matrix.size() == 16)
+    {
+        const std::vector<double>& matrix = node.matrix;
+
+        const double* x    = &matrix[0];
+        const double* y    = &matrix[4];
+        const double* z    = &matrix[8];
+        double determinant = x[0] * (y[1] * z[2] - y[2] * z[1]) - y[0] * (x[1] * z[2] - x[2] * z[1]) + z[0] * (x[1] * y[2] - x[2] * y[1]);
+
+        double axes[3][3];
+        double scale[3];
+        for (int c = 0; c < 3; ++c)
         {
-            vertex.uv = k_DefaultUV;
+            const double* column = &matrix[c * 4];
+            scale[c]             = std::sqrt(column[0] * column[0] + column[1] * column[1] + column[2] * column[2]);
+            if (c == 0 && determinant < 0.0)
+                scale[c] = -scale[c];
+            for (int r = 0; r < 3; ++r)
+                axes[c][r] = scale[c] != 0.0 ? column[r] / scale[c] : (r == c ? 1.0 : 0.0);
         }
 
-        vertexData.push_back(vertex);
+        nodeData.translation = Vector3(static_cast<float>(matrix[12]), static_cast<float>(matrix[13]), static_cast<float>(matrix[14]));
+        nodeData.rotation    = GetRotationFromAxes(axes);
+        nodeData.scale       = Vector3(static_cast<float>(scale[0]), static_cast<float>(scale[1]), static_cast<float>(scale[2]));
+        return;
     }
 
-    std::string vertexBufferName = name + "_VertexBuffer";
+    if (node.translation.size() == 3)
+        nodeData.translation = Vector3(static_cast<float>(node.translation[0]), static_cast<float>(node.translation[1]), static_cast<float>(node.translation[2]));
 
-    BufferHandle vertexBuffer = m_RenderContext.CreateBuffer({
-        .debugName = vertexBufferName.c_str(),
-        .byteSize  = (uint32_t)(vertexData.size() * sizeof(Vertex)),
-        .usage     = BufferUsage::Vertex,
-        .data      = vertexData.data(),
-    });
+    if (node.rotation.size() == 4)
+        nodeData.rotation = Quaternion(static_cast<float>(node.rotation[0]), static_cast<float>(node.rotation[1]), static_cast<float>(node.rotation[2]), static_cast<float>(node.rotation[3]));
+
+    if (node.scale.size() == 3)
+        nodeData.scale = Vector3(static_cast<float>(node.scale[0]), static_cast<float>(node.scale[1]), static_cast<float>(node.scale[2]));
+}
+
+bool GLTFLoader::LoadMesh(MeshData& meshData, const std::string& path, int meshIndex, ShaderChannel channels)
+{
+    tinygltf::Model model;
+    if (LoadModel(model, path) == false)
+        return false;
 
-    IndexType indexType = IndexType::None;
-    std::vector<uint8_t> indexData;
-    if (gltfPrimitive.indices >= 0)
+    if (meshIndex < 0 || meshIndex >= static_cast<int>(model.meshes.size()))
     {
-        const tinygltf::Accessor& accessor     = model.accessors[gltfPrimitive.indices];
-        const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-        const tinygltf::Buffer& buffer         = model.buffers[bufferView.buffer];
+        LOG_STREAM(ERROR) << "GLTF file has no mesh " << meshIndex << ": " << path << std::endl;
+        return false;
+    }
+
+    meshData = {};
+
+    std::vector<uint32_t> indices;
+    if (AppendMesh(meshData, indices, model, model.meshes[meshIndex], channels) == false || meshData.subMeshes.empty())
+    {
+        LOG_STREAM(ERROR) << "Failed to read mesh " << meshIndex << " of GLTF file: " << path << std::endl;
+        return false;
+    }
+
+    WriteIndices(meshData, indices);
+    return true;
+}
 
-        mesh.SetIndexCount(accessor.count);
+bool GLTFLoader::LoadScene(SceneData& sceneData, const std::string& path, ShaderChannel channels)
+{
+    tinygltf::Model model;
+    if (LoadModel(model, path) == false)
+        return false;
 
-        const void* data = &buffer.data[bufferView.byteOffset + accessor.byteOffset];
-        size_t size      = accessor.count * accessor.ByteStride(bufferView);
+    sceneData = {};
 
-        auto format = GetIndexDataFormat(accessor);
-        // Convert UINT8 to UINT16
-        if (format == GraphicsFormat::R8_UINT)
+    // the roots of the default scene, or every node that is nobody's child in a file without scenes
+    std::vector<int> roots;
+    if (model.scenes.empty() == false)
+    {
+        bool hasDefaultScene = model.defaultScene >= 0 && model.defaultScene < static_cast<int>(model.scenes.size());
+        roots                = model.scenes[hasDefaultScene ? model.defaultScene : 0].nodes;
+    }
+    else
+    {
+        std::vector<bool> isChild(model.nodes.size(), false);
+        for (const tinygltf::Node& node : model.nodes)
         {
-            format = GraphicsFormat::R16_UINT;
-            indexData.resize(size * 2);
-            for (size_t i = 0; i < size; ++i)
+            for (int child : node.children)
             {
-                indexData[i * 2]     = ((uint8_t*)data)[i];
-                indexData[i * 2 + 1] = 0;
+                if (child >= 0 && child < static_cast<int>(model.nodes.size()))
+                    isChild[child] = true;
             }
         }
-        else
+
+        for (int i = 0; i < static_cast<int>(model.nodes.size()); ++i)
         {
-            indexData.resize(size);
-            memcpy(indexData.data(), data, size);
+            if (isChild[i] == false)
+                roots.push_back(i);
         }
-
-        indexType   = GetIndexTypeByGraphicsFormat(format);
     }
 
-    BufferHandle indexBuffer = m_RenderContext.CreateBuffer({
-        .debugName = (name + "_IndexBuffer").c_str(),
-        .byteSize  = (uint32_t)(indexData.size() * GetIndexTypeSize(indexType)),
-        .usage     = BufferUsage::Index,
-        .data      = indexData.data(),
-    });
+    // a glTF mesh is added the first time a node uses it, the nodes after that share its sub-meshes
+    std::vector<int> sceneMeshIndices(model.meshes.size(), -1);
+    std::vector<bool> visited(model.nodes.size(), false);
+    std::vector<uint32_t> indices;
+
+    // depth first, so parents are added before their children. Each entry is a glTF node and its parent in sceneData.
+    std::vector<std::pair<int, int>> pendingNodes;
+    for (auto root = roots.rbegin(); root != roots.rend(); ++root)
+        pendingNodes.emplace_back(*root, -1);
+
+    while (pendingNodes.empty() == false)
+    {
+        auto [nodeIndex, parent] = pendingNodes.back();
+        pendingNodes.pop_back();
+
+        // a node reached a second time would have two parents
+        if (nodeIndex < 0 || nodeIndex >= static_cast<int>(model.nodes.size()) || visited[nodeIndex])
+            continue;
+
+        visited[nodeIndex] = true;
+
+        const tinygltf::Node& node = model.nodes[nodeIndex];
+
+        SceneNodeData nodeData;
+        nodeData.name   = node.name;
+        nodeData.parent = parent;
+        ReadNodeTransform(node, nodeData);
+
+        if (node.mesh >= 0 && node.mesh < static_cast<int>(model.meshes.size()))
+        {
+            int& sceneMeshIndex = sceneMeshIndices[node.mesh];
+            if (sceneMeshIndex < 0)
+            {
+                SceneMeshData meshData;
+                meshData.firstSubMesh = static_cast<uint32_t>(sceneData.geometry.subMeshes.size());
+
+                if (AppendMesh(sceneData.geometry, indices, model, model.meshes[node.mesh], channels) == false)
+                {
+                    LOG_STREAM(ERROR) << "Failed to read mesh " << node.mesh << " of GLTF file: " << path << std::endl;
+                    return false;
+                }
 
-    mesh.SetVertexBuffer(vertexBuffer);
-    mesh.SetVertexCount(vertexCount);
+                meshData.subMeshCount = static_cast<uint32_t>(sceneData.geometry.subMeshes.size()) - meshData.firstSubMesh;
+
+                sceneMeshIndex = static_cast<int>(sceneData.meshes.size());
+                sceneData.meshes.push_back(meshData);
+            }
 
-    mesh.SetIndexBuffer(indexBuffer);
-    mesh.SetIndexType(indexType);
+            nodeData.mesh = sceneMeshIndex;
+        }
+
+        int sceneNodeIndex = static_cast<int>(sceneData.nodes.size());
+        sceneData.nodes.push_back(std::move(nodeData));
+
+        for (auto child = node.children.rbegin(); child != node.children.rend(); ++child)
+            pendingNodes.emplace_back(*child, sceneNodeIndex);
+    }
 
+    WriteIndices(sceneData.geometry, indices);
     return true;
 }
-} // namespace gore::gfx
\ No newline at end of file
+} // namespace gore::gfx
@@ -7,28 +7,56 @@
 #define TINYGLTF_NO_EXTERNAL_IMAGE
 #include <tiny_gltf.h>
 
+#include "Math/Quaternion.h"
+#include "Math/Vector3.h"
 #include "Rendering/Utils/GeometryUtils.h"
-#include "Rendering/Components/MeshRenderer.h"
 
-#include <memory>
+#include <string>
+#include <vector>
 
 namespace gore::gfx
 {
-using namespace gore::renderer;
+// A glTF mesh in SceneData, its primitives are the sub-meshes firstSubMesh to firstSubMesh + subMeshCount
+struct SceneMeshData final
+{
+    uint32_t firstSubMesh = 0;
+    uint32_t subMeshCount = 0;
+};
 
-class RenderContext;
+// A glTF node, parents come before their children in SceneData::nodes
+struct SceneNodeData final
+{
+    std::string name;
+    int parent = -1;
+    int mesh   = -1;
+
+    Vector3 translation = Vector3::Zero;
+    Quaternion rotation = Quaternion::Identity;
+    Vector3 scale       = Vector3::One;
+};
 
+// The default scene of a glTF file. The primitives of all its meshes are sub-meshes of one MeshData, so the whole
+// scene is copied to the GPU at once. A mesh used by several nodes is only in it once.
+struct SceneData final
+{
+    MeshData geometry;
+    std::vector<SceneMeshData> meshes;
+    std::vector<SceneNodeData> nodes;
+};
+
+// Only builds the vertex and index data on the CPU, so it can run on any thread. RenderContext copies it to the GPU.
+// Files ending in .glb are read as binary glTF. Channels a primitive does not have are filled with their defaults.
 ENGINE_CLASS(GLTFLoader)
 {
 public:
-    GLTFLoader(RenderContext & rtx);
+    GLTFLoader();
     ~GLTFLoader();
 
-    [[nodiscard]] bool LoadMesh(MeshRenderer & mesh, const std::string& path, int meshIndex = 0, ShaderChannel channels = ShaderChannel::Default);
+    // Every primitive of the mesh becomes a sub-mesh
+    [[nodiscard]] bool LoadMesh(MeshData & meshData, const std::string& path, int meshIndex = 0, ShaderChannel channels = ShaderChannel::Default);
+    [[nodiscard]] bool LoadScene(SceneData & sceneData, const std::string& path, ShaderChannel channels = ShaderChannel::Default);
 
 private:
-    [[nodiscard]] bool CreateMeshFromGLTF(MeshRenderer & mesh, const tinygltf::Model& model, int meshIndex, const std::string& name, ShaderChannel channels);
-
-    RenderContext & m_RenderContext;
+    [[nodiscard]] bool LoadModel(tinygltf::Model & model, const std::string& path);
 };
-} // namespace gore::gfx
\ No newline at end of file
+} // namespace gore::gfx
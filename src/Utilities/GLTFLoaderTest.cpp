@@ -0,0 +1,221 @@
+#include "Test/TestPrefix.h"
+
+#ifdef ENABLE_TEST
+#include "Utilities/GLTFLoader.h"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace gore::test
+{
+using namespace gore::gfx;
+
+static const std::filesystem::path k_ResourceFolder = TEST_RESOURCE_FOLDER;
+
+template <typename T>
+static void AppendBytes(std::vector<uint8_t>& bytes, const T& value)
+{
+    const auto* data = reinterpret_cast<const uint8_t*>(&value);
+    bytes.insert(bytes.end(), data, data + sizeof(T));
+}
+
+// Two primitives in one mesh: three vertices with interleaved positions and uvs, indexed with bytes, and three
+// positions without indices. The mesh is used by a child node with a matrix, by a second root and by a mirrored root.
+static void WriteTestScene(const std::string& path)
+{
+    std::vector<uint8_t> bin;
+    const float interleaved[] = {
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f, 1.0f,
+    };
+    for (float value : interleaved)
+        AppendBytes(bin, value);
+
+    for (uint8_t index : {uint8_t(0), uint8_t(1), uint8_t(2), uint8_t(0)})
+        AppendBytes(bin, index);
+
+    const float positions[] = {
+        0.0f, 0.0f, 1.0f,
+        1.0f, 0.0f, 1.0f,
+        0.0f, 1.0f, 1.0f,
+    };
+    for (float value : positions)
+        AppendBytes(bin, value);
+
+    std::string json = R"({
+        "asset": {"version": "2.0"},
+        "scene": 0,
+        "scenes": [{"nodes": [0, 2, 3]}],
+        "nodes": [
+            {"name": "Root", "children": [1], "translation": [1, 2, 3]},
+            {"name": "Child", "mesh": 0, "matrix": [0, 2, 0, 0, -2, 0, 0, 0, 0, 0, 2, 0, 0, 0, 5, 1]},
+            {"name": "Other", "mesh": 0, "rotation": [0, 0, 0.7071068, 0.7071068]},
+            {"name": "Mirrored", "mesh": 0, "matrix": [0, -2, 0, 0, -2, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 1]}
+        ],
+        "meshes": [{"primitives": [
+            {"attributes": {"POSITION": 0, "TEXCOORD_0": 1}, "indices": 2},
+            {"attributes": {"POSITION": 3}}
+        ]}],
+        "buffers": [{"byteLength": 100}],
+        "bufferViews": [
+            {"buffer": 0, "byteOffset": 0, "byteLength": 60, "byteStride": 20},
+            {"buffer": 0, "byteOffset": 60, "byteLength": 3},
+            {"buffer": 0, "byteOffset": 64, "byteLength": 36}
+        ],
+        "accessors": [
+            {"bufferView": 0, "byteOffset": 0, "componentType": 5126, "count": 3, "type": "VEC3", "min": [0, 0, 0], "max": [1, 1, 0]},
+            {"bufferView": 0, "byteOffset": 12, "componentType": 5126, "count": 3, "type": "VEC2"},
+            {"bufferView": 1, "componentType": 5121, "count": 3, "type": "SCALAR"},
+            {"bufferView": 2, "componentType": 5126, "count": 3, "type": "VEC3", "min": [0, 0, 1], "max": [1, 1, 1]}
+        ]
+    })";
+    while (json.size() % 4 != 0)
+        json += ' ';
+
+    REQUIRE(bin.size() == 100);
+
+    std::vector<uint8_t> glb;
+    AppendBytes(glb, uint32_t(0x46546C67)); // glTF
+    AppendBytes(glb, uint32_t(2));
+    AppendBytes(glb, uint32_t(12 + 8 + json.size() + 8 + bin.size()));
+    AppendBytes(glb, uint32_t(json.size()));
+    AppendBytes(glb, uint32_t(0x4E4F534A)); // JSON
+    glb.insert(glb.end(), json.begin(), json.end());
+    AppendBytes(glb, uint32_t(bin.size()));
+    AppendBytes(glb, uint32_t(0x004E4942)); // BIN
+    glb.insert(glb.end(), bin.begin(), bin.end());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(glb.data()), static_cast<std::streamsize>(glb.size()));
+}
+
+static uint16_t GetIndex16(const MeshData& meshData, size_t i)
+{
+    uint16_t index;
+    std::memcpy(&index, meshData.indices.data() + i * sizeof(uint16_t), sizeof(index));
+    return index;
+}
+
+// the normal of a Vertex is not 8 byte aligned, which the SIMD loads of Vector3::operator== want
+static bool IsSameNormal(const Vector3& normal1, const Vector3& normal2)
+{
+    return normal1.x == normal2.x && normal1.y == normal2.y && normal1.z == normal2.z;
+}
+
+static bool IsSameUV(const Vector2& uv1, const Vector2& uv2)
+{
+    return uv1.x == uv2.x && uv1.y == uv2.y;
+}
+
+static bool IsSameRotation(const Quaternion& q1, const Quaternion& q2)
+{
+    return std::abs(q1.Dot(q2)) > 0.9999f;
+}
+
+TEST_CASE("Binary glTF scenes keep their node hierarchy and merge the primitives of a mesh", "[GLTFLoader]")
+{
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / "gore_gltf_loader_test";
+    std::filesystem::remove_all(folder);
+    std::filesystem::create_directories(folder);
+
+    std::string path = (folder / "scene.glb").generic_string();
+    WriteTestScene(path);
+
+    SceneData sceneData;
+    GLTFLoader gltfLoader;
+    REQUIRE(gltfLoader.LoadScene(sceneData, path));
+
+    // depth first from the roots of the scene
+    REQUIRE(sceneData.nodes.size() == 4);
+    REQUIRE(sceneData.nodes[0].name == "Root");
+    REQUIRE(sceneData.nodes[0].parent == -1);
+    REQUIRE(sceneData.nodes[0].mesh == -1);
+    REQUIRE(sceneData.nodes[0].translation == Vector3(1.0f, 2.0f, 3.0f));
+    REQUIRE(sceneData.nodes[1].name == "Child");
+    REQUIRE(sceneData.nodes[1].parent == 0);
+    REQUIRE(sceneData.nodes[2].name == "Other");
+    REQUIRE(sceneData.nodes[2].parent == -1);
+
+    // the matrix is a 90 degree turn around z, scaled by 2 and moved along z
+    const Quaternion quarterTurn(0.0f, 0.0f, 0.7071068f, 0.7071068f);
+    REQUIRE(sceneData.nodes[1].translation == Vector3(0.0f, 0.0f, 5.0f));
+    REQUIRE(sceneData.nodes[1].scale == Vector3(2.0f, 2.0f, 2.0f));
+    REQUIRE(IsSameRotation(sceneData.nodes[1].rotation, quarterTurn));
+    REQUIRE(IsSameRotation(sceneData.nodes[2].rotation, quarterTurn));
+
+    // the same turn after a mirror along x, which stays in the scale
+    REQUIRE(sceneData.nodes[3].name == "Mirrored");
+    REQUIRE(sceneData.nodes[3].scale == Vector3(-2.0f, 2.0f, 2.0f));
+    REQUIRE(IsSameRotation(sceneData.nodes[3].rotation, quarterTurn));
+
+    // both nodes share the mesh, its primitives are in the geometry once
+    REQUIRE(sceneData.meshes.size() == 1);
+    REQUIRE(sceneData.nodes[1].mesh == 0);
+    REQUIRE(sceneData.nodes[2].mesh == 0);
+    REQUIRE(sceneData.meshes[0].firstSubMesh == 0);
+    REQUIRE(sceneData.meshes[0].subMeshCount == 2);
+
+    const MeshData& geometry = sceneData.geometry;
+    REQUIRE(geometry.subMeshes.size() == 2);
+    REQUIRE(geometry.subMeshes[0].vertexOffset == 0);
+    REQUIRE(geometry.subMeshes[0].vertexCount == 3);
+    REQUIRE(geometry.subMeshes[0].indexOffset == 0);
+    REQUIRE(geometry.subMeshes[0].indexCount == 3);
+    REQUIRE(geometry.subMeshes[1].vertexOffset == 3);
+    REQUIRE(geometry.subMeshes[1].vertexCount == 3);
+    REQUIRE(geometry.subMeshes[1].indexOffset == 3);
+    REQUIRE(geometry.subMeshes[1].indexCount == 3);
+
+    // the uvs are read with the stride of the interleaved buffer view, the second primitive has none
+    REQUIRE(geometry.vertices.size() == 6);
+    REQUIRE(geometry.vertices[1].position == Vector3(1.0f, 0.0f, 0.0f));
+    REQUIRE(IsSameUV(geometry.vertices[1].uv, Vector2(1.0f, 0.0f)));
+    REQUIRE(IsSameUV(geometry.vertices[2].uv, Vector2(0.0f, 1.0f)));
+    REQUIRE(IsSameNormal(geometry.vertices[2].normal, k_DefaultNormal));
+    REQUIRE(geometry.vertices[4].position == Vector3(1.0f, 0.0f, 1.0f));
+    REQUIRE(IsSameUV(geometry.vertices[4].uv, k_DefaultUV));
+
+    // byte indices are widened, the primitive without indices gets its own, both count from their first vertex
+    REQUIRE(geometry.indexType == IndexType::UINT16);
+    REQUIRE(geometry.indexCount == 6);
+    for (uint16_t i = 0; i < 6; ++i)
+        REQUIRE(GetIndex16(geometry, i) == i % 3);
+
+    SECTION("A mesh of a binary file loads with all its primitives")
+    {
+        MeshData meshData;
+        REQUIRE(gltfLoader.LoadMesh(meshData, path));
+        REQUIRE(meshData.subMeshes.size() == 2);
+        REQUIRE(meshData.vertices.size() == 6);
+        REQUIRE(meshData.indices == geometry.indices);
+
+        REQUIRE(gltfLoader.LoadMesh(meshData, path, 1) == false);
+    }
+
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("Meshes of one primitive are one sub-mesh", "[GLTFLoader]")
+{
+    MeshData meshData;
+    GLTFLoader gltfLoader;
+    REQUIRE(gltfLoader.LoadMesh(meshData, (k_ResourceFolder / "gltf" / "cube.gltf").generic_string()));
+
+    REQUIRE(meshData.subMeshes.size() == 1);
+    REQUIRE(meshData.subMeshes[0].vertexCount == meshData.vertices.size());
+    REQUIRE(meshData.subMeshes[0].indexCount == meshData.indexCount);
+    REQUIRE(meshData.indices.size() == meshData.indexCount * sizeof(uint16_t));
+
+    SceneData sceneData;
+    REQUIRE(gltfLoader.LoadScene(sceneData, (k_ResourceFolder / "gltf" / "cube.gltf").generic_string()));
+    REQUIRE(sceneData.nodes.size() == 1);
+    REQUIRE(sceneData.meshes.size() == 1);
+    REQUIRE(sceneData.geometry.vertices.size() == meshData.vertices.size());
+}
+} // namespace gore::test
+#endif
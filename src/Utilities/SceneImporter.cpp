@@ -0,0 +1,119 @@
+#include "SceneImporter.h"
+
+#include "FileSystem/FileSystem.h"
+
+#include "Object/GameObject.h"
+#include "Object/Transform.h"
+#include "Scene/Scene.h"
+
+#include "Rendering/RenderContext.h"
+#include "Rendering/Components/MeshRenderer.h"
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace gore::gfx
+{
+SceneImporter::SceneImporter(RenderContext& renderContext) :
+    m_RenderContext(renderContext),
+    m_Compression()
+{
+}
+
+SceneImporter::~SceneImporter()
+{
+}
+
+GameObject* SceneImporter::Import(Scene& scene, const std::string& name, const renderer::Material* material)
+{
+    static const std::filesystem::path kGLTFFolder = FileSystem::GetResourceFolder() / "GLTF";
+
+    SceneData sceneData;
+    GLTFLoader gltfLoader;
+    if (gltfLoader.LoadScene(sceneData, (kGLTFFolder / name).generic_string()) == false)
+        return nullptr;
+
+    return Instantiate(scene, sceneData, std::filesystem::path(name).stem().string(), material);
+}
+
+GameObject* SceneImporter::Instantiate(Scene& scene, const SceneData& sceneData, const std::string& rootName, const renderer::Material* material)
+{
+    const MeshData& geometry      = sceneData.geometry;
+    VertexLayout layout           = CreateVertexLayout(ShaderChannel::Default, m_Compression);
+    MeshGeometryLocation location = m_RenderContext.UploadMeshGeometry(geometry.GetView(), layout);
+
+    if (layout.IsVertex() == false)
+    {
+        VertexCompressionStats stats = GetVertexCompressionStats(static_cast<uint32_t>(geometry.vertices.size()), layout);
+        if (stats.packedByteSize < stats.vertexByteSize)
+        {
+            LOG_STREAM(INFO) << "Packed vertices of " << rootName << " from " << stats.vertexByteSize << " to "
+                             << stats.packedByteSize << " bytes, " << stats.GetSavedRatio() * 100.0f << "% less to fetch"
+                             << std::endl;
+        }
+    }
+
+    GameObject* root = scene.NewObject(rootName);
+
+    std::vector<GameObject*> gameObjects(sceneData.nodes.size(), nullptr);
+    for (size_t i = 0; i < sceneData.nodes.size(); ++i)
+    {
+        const SceneNodeData& node = sceneData.nodes[i];
+
+        GameObject* gameObject = scene.NewObject(node.name.empty() ? rootName + "_" + std::to_string(i) : node.name);
+        gameObjects[i]         = gameObject;
+
+        // parents come before their children, so the parent is already made
+        Transform* parent    = node.parent >= 0 ? gameObjects[node.parent]->GetTransform() : root->GetTransform();
+        Transform* transform = gameObject->GetTransform();
+        transform->SetParent(parent, false);
+        transform->SetLocalTQS(TQS(node.translation, node.rotation, node.scale));
+
+        if (node.mesh < 0 || sceneData.meshes[node.mesh].subMeshCount == 0)
+            continue;
+
+        const SceneMeshData& mesh = sceneData.meshes[node.mesh];
+        std::span<const SubMesh> subMeshes(geometry.subMeshes.data() + mesh.firstSubMesh, mesh.subMeshCount);
+
+        // the sub-meshes of a mesh are next to each other, the renderer starts at the first one
+        const SubMesh& first = subMeshes.front();
+        const SubMesh& last  = subMeshes.back();
+
+        std::vector<SubMesh> rendererSubMeshes;
+        rendererSubMeshes.reserve(subMeshes.size());
+        for (const SubMesh& subMesh : subMeshes)
+        {
+            rendererSubMeshes.push_back({
+                .vertexOffset = subMesh.vertexOffset - first.vertexOffset,
+                .vertexCount  = subMesh.vertexCount,
+                .indexOffset  = subMesh.indexOffset - first.indexOffset,
+                .indexCount   = subMesh.indexCount,
+            });
+        }
+
+        MeshRenderer* meshRenderer = gameObject->AddComponent<MeshRenderer>();
+
+        meshRenderer->SetGeometry(location.geometry);
+        meshRenderer->SetVertexBuffer(location.vertexBuffer);
+        meshRenderer->SetVertexCount(last.vertexOffset + last.vertexCount - first.vertexOffset);
+        meshRenderer->SetVertexOffset(location.vertexOffset + first.vertexOffset);
+
+        meshRenderer->SetIndexBuffer(location.indexBuffer);
+        meshRenderer->SetIndexType(geometry.indexType);
+        meshRenderer->SetIndexCount(last.indexOffset + last.indexCount - first.indexOffset);
+        meshRenderer->SetIndexOffset(location.indexOffset + first.indexOffset);
+
+        meshRenderer->SetSubMeshes(std::move(rendererSubMeshes));
+
+        meshRenderer->SetPositionScale(location.positionScale);
+        meshRenderer->SetPositionOffset(location.positionOffset);
+        meshRenderer->SetVertexLayout(layout);
+
+        if (material != nullptr)
+            meshRenderer->SetMaterial(*material);
+    }
+
+    return root;
+}
+} // namespace gore::gfx
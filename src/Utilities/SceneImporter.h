@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Prefix.h"
+#include "Export.h"
+
+#include "Utilities/GLTFLoader.h"
+#include "Rendering/Utils/VertexLayout.h"
+
+#include <string>
+
+namespace gore
+{
+class GameObject;
+class Scene;
+} // namespace gore
+
+namespace gore::renderer
+{
+class Material;
+} // namespace gore::renderer
+
+namespace gore::gfx
+{
+class RenderContext;
+
+// Turns a glTF scene into game objects: one per node, parented the way the nodes are, with a MeshRenderer on every
+// node that has a mesh. The geometry of the whole scene is copied to the GPU with one vertex and one index allocation,
+// the renderers and their sub-meshes point into them.
+ENGINE_CLASS(SceneImporter) final
+{
+public:
+    explicit SceneImporter(RenderContext& renderContext);
+    ~SceneImporter();
+
+    NON_COPYABLE(SceneImporter);
+
+    // How the vertices of the scenes imported from now on are packed, nothing is compressed by default
+    GETTER_SETTER(VertexCompressionDesc, Compression)
+
+    // Loads a .gltf or .glb file from the GLTF resource folder, returns the game object the root nodes are parented
+    // to or nullptr when the file could not be loaded
+    GameObject* Import(Scene& scene, const std::string& name, const renderer::Material* material = nullptr);
+    // sceneData can be loaded on any thread, only this has to run on the render thread
+    GameObject* Instantiate(Scene& scene, const SceneData& sceneData, const std::string& rootName, const renderer::Material* material = nullptr);
+
+private:
+    RenderContext& m_RenderContext;
+    VertexCompressionDesc m_Compression;
+};
+} // namespace gore::gfx